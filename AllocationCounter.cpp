@@ -0,0 +1,83 @@
+// AllocationCounter.cpp
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> g_heapAllocations(0);
+static thread_local uint64_t t_heapAllocations = 0;
+
+// Shared slow path for every replaced operator new.
+static void* countedAllocate(std::size_t size)
+{
+	g_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+	++t_heapAllocations;
+	return std::malloc(size == 0 ? 1 : size); // operator new must return a unique pointer even for size 0
+}
+
+uint64_t getHeapAllocationCount()
+{
+	return g_heapAllocations.load(std::memory_order_relaxed);
+}
+
+uint64_t getThreadHeapAllocationCount()
+{
+	return t_heapAllocations;
+}
+
+// --- Global operator new/delete replacements ---
+
+void* operator new(std::size_t size)
+{
+	void* ptr = countedAllocate(size);
+	if (!ptr)
+	{
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return countedAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return countedAllocate(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+	std::free(ptr);
+}
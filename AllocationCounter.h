@@ -0,0 +1,18 @@
+// AllocationCounter.h
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <cstdint>
+
+// AllocationCounter.cpp replaces the global operator new/delete with thin wrappers
+// around malloc/free that count every heap allocation. This is how we confirm the
+// receive path really runs allocation-free at steady state: sample the counter
+// before and after a stretch of packets and compare.
+
+// Total heap allocations made by all threads since the program started.
+uint64_t getHeapAllocationCount();
+
+// Heap allocations made by the calling thread only.
+uint64_t getThreadHeapAllocationCount();
+
+#endif // ALLOCATION_COUNTER_H
@@ -0,0 +1,62 @@
+// ApplicationStage.cpp
+#include "ApplicationStage.h"
+#include <utility>
+
+ApplicationStage::ApplicationStage(size_t capacity, OverflowPolicy policy, Handler handler) :
+	m_ring(capacity, policy),
+	m_handler(std::move(handler))
+{
+	m_thread = std::thread(&ApplicationStage::handlerLoop, this);
+}
+
+ApplicationStage::~ApplicationStage()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_stopping.store(true);
+	}
+	m_wakeup.notify_one();
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+}
+
+bool ApplicationStage::post(const ApplicationRecord& record)
+{
+	bool accepted = m_ring.push(record);
+
+	// The handler sets m_sleeping before its final empty-check, so either it sees
+	// this record or we see it parked. The fences on both sides rule out each
+	// missing the other's write.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (m_sleeping.load())
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_wakeup.notify_one();
+	}
+	return accepted;
+}
+
+void ApplicationStage::handlerLoop()
+{
+	ApplicationRecord record;
+	while (true)
+	{
+		while (m_ring.pop(record))
+		{
+			m_handler(record);
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_sleeping.store(true);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		m_wakeup.wait(lock, [this]() { return !m_ring.empty() || m_stopping.load(); });
+		m_sleeping.store(false);
+
+		if (m_stopping.load() && m_ring.empty())
+		{
+			break;
+		}
+	}
+}
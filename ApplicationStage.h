@@ -0,0 +1,68 @@
+// ApplicationStage.h
+#ifndef APPLICATION_STAGE_H
+#define APPLICATION_STAGE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "MessageRing.h"
+#include "NetworkManager.h" // sockaddr_in
+#include "TdlMessages.h"
+
+// --- Application Record ---
+// One received message that needs application-level handling, copied out of the
+// receive buffer so the socket stage can recycle the buffer at once. Fixed size,
+// so records can live in a preallocated ring.
+struct ApplicationRecord
+{
+	uint8_t messageType = 0;      // TdlMessageType of the message this came from
+	uint32_t sourceNodeId = 0;
+	sockaddr_in senderAddress = {};
+	uint16_t textLength = 0;      // TEXT_MESSAGE_TYPE: valid bytes in 'text'
+	char text[MAX_TEXT_MSG_LENGTH] = { 0 };
+};
+
+// --- Application Stage ---
+// The handler half of the receive pipeline. The socket stage (reactor or receive
+// workers) post()s records into a lock-free MessageRing; one handler thread pops
+// them and runs the slow parts (console output, logging, user callbacks). A slow
+// handler therefore only ever fills the ring; it can't hold up the socket and
+// cause kernel-side drops. Overflows are counted, per the ring's OverflowPolicy.
+class ApplicationStage
+{
+public:
+	using Handler = std::function<void(const ApplicationRecord& record)>;
+
+	ApplicationStage(size_t capacity, OverflowPolicy policy, Handler handler);
+	~ApplicationStage(); // Handles what is still queued, then joins the thread
+
+	// Called from the socket stage. Lock-free and never blocks; returns false if
+	// the record was dropped.
+	bool post(const ApplicationRecord& record);
+
+	MessageRingCounters getCounters() const { return m_ring.getCounters(); }
+
+	// Disable copy and assignment
+	ApplicationStage(const ApplicationStage&) = delete;
+	ApplicationStage& operator=(const ApplicationStage&) = delete;
+
+private:
+	void handlerLoop();
+
+	MessageRing<ApplicationRecord> m_ring;
+	Handler m_handler;
+
+	// Only used to park the handler thread when the ring is empty. post() touches
+	// the mutex only when 'm_sleeping' says the handler is (about to be) parked.
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wakeup;
+	std::atomic<bool> m_sleeping{ false };
+	std::atomic<bool> m_stopping{ false };
+
+	std::thread m_thread;
+};
+
+#endif // APPLICATION_STAGE_H
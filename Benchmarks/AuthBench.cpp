@@ -0,0 +1,113 @@
+// AuthBench.cpp
+// What --auth-key costs per datagram: sealing on send, and verifying a received
+// batch one datagram at a time against MessageAuthenticator::verifyBatch().
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "Benchmarks.h"
+#include "../MessageAuth.h"
+#include "../Transport.h"
+
+static volatile uint64_t g_authSink = 0;
+
+static const size_t AUTH_ROUNDS = 100000; // Batches of Transport::MAX_BATCH_SIZE
+
+// Prints one results row.
+static void printRow(const char* name, size_t bytes, double nsPerDatagram)
+{
+	std::cout << std::setw(28) << std::left << name << std::right << std::setw(8) << bytes
+		<< std::fixed << std::setprecision(2) << std::setw(14) << nsPerDatagram << "\n";
+	recordResult("auth", name, 0, 1, nsPerDatagram);
+}
+
+// One batch of sealed datagrams of 'payloadSize' bytes each, as it would come off the socket.
+struct SealedBatch
+{
+	std::vector<std::vector<uint8_t>> buffers;
+	const uint8_t* data[Transport::MAX_BATCH_SIZE];
+	size_t sizes[Transport::MAX_BATCH_SIZE];
+};
+
+static void fillBatch(const MessageAuthenticator& authenticator, size_t payloadSize, SealedBatch& batch)
+{
+	batch.buffers.assign(Transport::MAX_BATCH_SIZE, std::vector<uint8_t>(payloadSize + MessageAuthenticator::TRAILER_SIZE));
+	for (size_t i = 0; i < Transport::MAX_BATCH_SIZE; ++i)
+	{
+		for (size_t b = 0; b < payloadSize; ++b)
+		{
+			batch.buffers[i][b] = static_cast<uint8_t>(i * 31 + b);
+		}
+		batch.sizes[i] = authenticator.seal(batch.buffers[i].data(), payloadSize, batch.buffers[i].size(), static_cast<uint32_t>(1 + i), 1000 + i, 2000 + i);
+		batch.data[i] = batch.buffers[i].data();
+	}
+}
+
+static double benchSeal(const MessageAuthenticator& authenticator, size_t payloadSize)
+{
+	std::vector<uint8_t> buffer(payloadSize + MessageAuthenticator::TRAILER_SIZE);
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < AUTH_ROUNDS * Transport::MAX_BATCH_SIZE; ++i)
+	{
+		buffer[0] = static_cast<uint8_t>(i);
+		g_authSink = g_authSink + authenticator.seal(buffer.data(), payloadSize, buffer.size(), 1, i, i);
+	}
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (AUTH_ROUNDS * Transport::MAX_BATCH_SIZE);
+}
+
+// Baseline: each datagram's tag recomputed on its own.
+static double benchVerifyOneByOne(const MessageAuthenticator& authenticator, const SealedBatch& batch)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (size_t round = 0; round < AUTH_ROUNDS; ++round)
+	{
+		for (size_t i = 0; i < Transport::MAX_BATCH_SIZE; ++i)
+		{
+			uint64_t expected;
+			memcpy(&expected, batch.data[i] + batch.sizes[i] - MessageAuthenticator::TAG_SIZE, sizeof(expected));
+			g_authSink = g_authSink + (authenticator.tag(batch.data[i], batch.sizes[i] - MessageAuthenticator::TAG_SIZE) == expected);
+		}
+	}
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (AUTH_ROUNDS * Transport::MAX_BATCH_SIZE);
+}
+
+static double benchVerifyBatch(const MessageAuthenticator& authenticator, const SealedBatch& batch)
+{
+	bool results[Transport::MAX_BATCH_SIZE];
+	uint32_t sources[Transport::MAX_BATCH_SIZE];
+	uint64_t sequences[Transport::MAX_BATCH_SIZE];
+	uint64_t sealedTimes[Transport::MAX_BATCH_SIZE];
+	auto start = std::chrono::steady_clock::now();
+	for (size_t round = 0; round < AUTH_ROUNDS; ++round)
+	{
+		authenticator.verifyBatch(batch.data, batch.sizes, Transport::MAX_BATCH_SIZE, results, sources, sequences, sealedTimes);
+		g_authSink = g_authSink + results[round % Transport::MAX_BATCH_SIZE];
+	}
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (AUTH_ROUNDS * Transport::MAX_BATCH_SIZE);
+}
+
+void runAuthBench()
+{
+	MessageAuthenticator authenticator(MessageKey{ 0x0706050403020100ull, 0x0F0E0D0C0B0A0908ull });
+
+	std::cout << std::setw(28) << std::left << "operation" << std::right << std::setw(8) << "bytes"
+		<< std::setw(14) << "ns/datagram" << "\n";
+
+	// A compact position report, a raw one, and a coalesced frame of a node's tick.
+	static const size_t PAYLOAD_SIZES[] = { 21, 40, 120 };
+	static const char* const SEAL_NAMES[] = { "seal 21 B", "seal 40 B", "seal 120 B" };
+	static const char* const SINGLE_NAMES[] = { "verify 21 B one by one", "verify 40 B one by one", "verify 120 B one by one" };
+	static const char* const BATCH_NAMES[] = { "verify 21 B batched", "verify 40 B batched", "verify 120 B batched" };
+	SealedBatch batch;
+	for (size_t i = 0; i < sizeof(PAYLOAD_SIZES) / sizeof(PAYLOAD_SIZES[0]); ++i)
+	{
+		fillBatch(authenticator, PAYLOAD_SIZES[i], batch);
+		size_t sealedSize = batch.sizes[0];
+		printRow(SEAL_NAMES[i], sealedSize, benchSeal(authenticator, PAYLOAD_SIZES[i]));
+		printRow(SINGLE_NAMES[i], sealedSize, benchVerifyOneByOne(authenticator, batch));
+		printRow(BATCH_NAMES[i], sealedSize, benchVerifyBatch(authenticator, batch));
+	}
+}
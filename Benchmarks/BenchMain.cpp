@@ -0,0 +1,116 @@
+// BenchMain.cpp
+// Usage: BasicTDLBench [--results=PATH] [benchmark names...]   (no names = run everything)
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Benchmarks.h"
+#include "../Logger.h"
+
+struct BenchmarkEntry
+{
+	const char* name;
+	void (*run)();
+};
+
+static const BenchmarkEntry g_benchmarks[] = {
+	{ "nodetable", runNodeTableBench },
+	{ "codec", runCodecBench },
+	{ "nodemanager", runNodeManagerBench },
+	{ "contention", runContentionBench },
+	{ "spatial", runSpatialBench },
+	{ "dispatch", runDispatchBench },
+	{ "auth", runAuthBench },
+	{ "scan", runScanBench },
+};
+
+// --- Results ---
+struct BenchResult
+{
+	std::string benchmark;
+	std::string name;
+	size_t nodes;
+	size_t threads;
+	double nsPerOp;
+};
+
+static std::vector<BenchResult> g_results;
+
+void recordResult(const char* benchmark, const char* name, size_t nodes, size_t threads, double nsPerOp)
+{
+	g_results.push_back(BenchResult{ benchmark, name, nodes, threads, nsPerOp });
+}
+
+static bool writeResults(const std::string& path)
+{
+	FILE* file = fopen(path.c_str(), "w");
+	if (file == nullptr)
+	{
+		return false;
+	}
+	for (const BenchResult& result : g_results)
+	{
+		// Names are fixed strings chosen by the benchmarks; only quotes need escaping.
+		std::string name;
+		for (char c : result.name)
+		{
+			if (c == '"' || c == '\\')
+			{
+				name += '\\';
+			}
+			name += c;
+		}
+		fprintf(file, "{\"benchmark\":\"%s\",\"name\":\"%s\",\"nodes\":%zu,\"threads\":%zu,\"nsPerOp\":%.3f}\n",
+			result.benchmark.c_str(), name.c_str(), result.nodes, result.threads, result.nsPerOp);
+	}
+	bool ok = !ferror(file);
+	fclose(file);
+	return ok;
+}
+
+int main(int argc, char* argv[])
+{
+	// The code under test logs (e.g. every node added); keep only warnings and errors.
+	Logger::instance().setMinimumLevel(LogLevel::Warning);
+
+	std::string resultsPath;
+	std::vector<const char*> names;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strncmp(argv[i], "--results=", 10) == 0)
+		{
+			resultsPath = argv[i] + 10;
+		}
+		else
+		{
+			names.push_back(argv[i]);
+		}
+	}
+
+	for (const BenchmarkEntry& bench : g_benchmarks)
+	{
+		bool selected = names.empty();
+		for (size_t i = 0; i < names.size() && !selected; ++i)
+		{
+			selected = (strcmp(names[i], bench.name) == 0);
+		}
+		if (selected)
+		{
+			std::cout << "\n=== " << bench.name << " ===" << std::endl;
+			bench.run();
+		}
+	}
+
+	if (!resultsPath.empty())
+	{
+		if (!writeResults(resultsPath))
+		{
+			std::cerr << "Could not write results to " << resultsPath << std::endl;
+			return 1;
+		}
+		std::cout << "\nWrote " << g_results.size() << " results to " << resultsPath << std::endl;
+	}
+	return 0;
+}
@@ -0,0 +1,29 @@
+// Benchmarks.h
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <cstddef>
+
+// Each benchmark lives in its own .cpp file and prints its own results table.
+// BenchMain.cpp runs them all, or just the ones named on the command line.
+
+void runNodeTableBench();   // NodeTableBench.cpp
+void runCodecBench();       // CodecBench.cpp
+void runNodeManagerBench(); // NodeManagerBench.cpp
+void runContentionBench();  // NodeManagerBench.cpp
+void runSpatialBench();     // NodeManagerBench.cpp
+void runDispatchBench();    // DispatchBench.cpp
+void runAuthBench();        // AuthBench.cpp
+void runScanBench();        // ScanBench.cpp
+
+// Machine-readable results: alongside its table, every benchmark reports each
+// measurement here. BenchMain writes them out as JSON lines with --results=PATH,
+// one object per measurement, so runs can be diffed to catch regressions.
+//   benchmark  which runXxxBench() produced it
+//   name       what was measured (operation / variant)
+//   nodes      node population (0 if not applicable)
+//   threads    writer threads (1 for single-threaded measurements)
+//   nsPerOp    mean cost of one operation
+void recordResult(const char* benchmark, const char* name, size_t nodes, size_t threads, double nsPerOp);
+
+#endif // BENCHMARKS_H
@@ -0,0 +1,117 @@
+// CodecBench.cpp
+// Compares the raw struct memcpy path against the TdlCodec compact encodings:
+// bytes on the wire per message and encode + decode cost.
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "Benchmarks.h"
+#include "../TdlCodec.h"
+#include "../TdlMessages.h"
+
+static volatile double g_codecSink = 0.0;
+
+static const size_t CODEC_ITERATIONS = 5000000;
+
+// Prints one results row.
+static void printRow(const char* name, size_t bytes, double nsPerMessage)
+{
+	std::cout << std::setw(28) << std::left << name << std::right << std::setw(8) << bytes
+		<< std::fixed << std::setprecision(2) << std::setw(14) << nsPerMessage << "\n";
+	recordResult("codec", name, 0, 1, nsPerMessage);
+}
+
+// Baseline: what the receiver does today (memcpy the struct in and out of a buffer).
+static double benchRawPosition(const std::vector<PositionReport>& reports)
+{
+	uint8_t wire[sizeof(PositionReport)];
+	PositionReport decoded;
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < CODEC_ITERATIONS; ++i)
+	{
+		memcpy(wire, &reports[i % reports.size()], sizeof(PositionReport));
+		memcpy(&decoded, wire, sizeof(PositionReport));
+		g_codecSink = g_codecSink + decoded.latitude;
+	}
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / CODEC_ITERATIONS;
+}
+
+static double benchCompactPosition(const std::vector<PositionReport>& reports, bool fixedPoint, size_t& bytes)
+{
+	uint8_t wire[TdlCodec::MAX_ENCODED_SIZE];
+	PositionReport decoded;
+	bytes = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < CODEC_ITERATIONS; ++i)
+	{
+		bytes = TdlCodec::encode(reports[i % reports.size()], fixedPoint, wire, sizeof(wire));
+		TdlCodec::decode(wire, bytes, decoded);
+		g_codecSink = g_codecSink + decoded.latitude;
+	}
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / CODEC_ITERATIONS;
+}
+
+static double benchRawText(const TextMessage& message)
+{
+	uint8_t wire[sizeof(TextMessage)];
+	TextMessage decoded;
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < CODEC_ITERATIONS; ++i)
+	{
+		memcpy(wire, &message, sizeof(TextMessage));
+		memcpy(&decoded, wire, sizeof(TextMessage));
+		g_codecSink = g_codecSink + decoded.text[0];
+	}
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / CODEC_ITERATIONS;
+}
+
+static double benchCompactText(const TextMessage& message, size_t& bytes)
+{
+	uint8_t wire[TdlCodec::MAX_ENCODED_SIZE];
+	TextMessage decoded;
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < CODEC_ITERATIONS; ++i)
+	{
+		bytes = TdlCodec::encode(message, wire, sizeof(wire));
+		TdlCodec::decode(wire, bytes, decoded);
+		g_codecSink = g_codecSink + decoded.text[0];
+	}
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / CODEC_ITERATIONS;
+}
+
+void runCodecBench()
+{
+	// A spread of realistic reports from small node IDs.
+	std::vector<PositionReport> reports(256);
+	for (size_t i = 0; i < reports.size(); ++i)
+	{
+		reports[i].header.sourceNodeId = static_cast<uint32_t>(1 + i % 100);
+		reports[i].header.sequenceNumber = static_cast<uint32_t>(5000 + i); // A few minutes into a sender's life
+		reports[i].header.sendTimeUs = 0x9E3779B9u + static_cast<uint32_t>(i) * 100000;
+		reports[i].latitude = 50.0 + i * 0.0137;
+		reports[i].longitude = -1.0 + i * 0.0071;
+		reports[i].altitude = 100.0 + i;
+	}
+
+	TextMessage hello;
+	hello.header.sourceNodeId = 7;
+	hello.header.sequenceNumber = 5000;
+	hello.header.sendTimeUs = 0x9E3779B9u;
+	strcpy(hello.text, "hi");
+
+	std::cout << std::setw(28) << std::left << "encoding" << std::right << std::setw(8) << "bytes"
+		<< std::setw(14) << "ns/msg" << "\n";
+
+	size_t bytes = 0;
+	printRow("PositionReport raw memcpy", sizeof(PositionReport), benchRawPosition(reports));
+	double ns = benchCompactPosition(reports, false, bytes);
+	printRow("PositionReport compact f64", bytes, ns);
+	ns = benchCompactPosition(reports, true, bytes);
+	printRow("PositionReport fixed-point", bytes, ns);
+	printRow("TextMessage \"hi\" raw", sizeof(TextMessage), benchRawText(hello));
+	ns = benchCompactText(hello, bytes);
+	printRow("TextMessage \"hi\" compact", bytes, ns);
+}
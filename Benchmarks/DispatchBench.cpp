@@ -0,0 +1,134 @@
+// DispatchBench.cpp
+// The receive-side parse + dispatch path (PacketDispatcher::processPacket, as the
+// reactor and the receive workers call it), per wire format, with the NodeManager
+// updates included. Packets sit in real PacketPool slots, as they do when received.
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "Benchmarks.h"
+#include "../ApplicationStage.h"
+#include "../MessageFrame.h"
+#include "../NodeManager.h"
+#include "../PacketDispatcher.h"
+#include "../PacketPool.h"
+#include "../TdlCodec.h"
+#include "../TdlMessages.h"
+
+static const size_t DISPATCH_SOURCES = 1000;
+static const size_t DISPATCH_ITERATIONS = 2000000;
+static volatile uint32_t g_dispatchSink = 0;
+
+// Copies 'size' bytes into a fresh pool slot, as if they had just been received.
+static ReceivedPacket makePacket(PacketPool& pool, const void* bytes, size_t size)
+{
+	ReceivedPacket packet;
+	packet.buffer = pool.acquire();
+	memcpy(packet.buffer.data(), bytes, size);
+	packet.size = size;
+	packet.senderAddress.sin_family = AF_INET;
+	return packet;
+}
+
+// Builds a coalesced frame the way MessageAggregator does.
+static size_t buildFrame(uint8_t* frame, const uint8_t* const* records, const size_t* sizes, size_t count)
+{
+	memset(frame, 0, 2048);
+	frame[0] = MessageFrame::FRAME_MAGIC;
+	frame[1] = MessageFrame::FRAME_VERSION;
+	frame[2] = static_cast<uint8_t>(count);
+	frame[3] = static_cast<uint8_t>(count >> 8);
+	size_t cursor = MessageFrame::HEADER_SIZE;
+	for (size_t i = 0; i < count; ++i)
+	{
+		size_t offset = MessageFrame::recordOffsetAfter(cursor);
+		frame[offset - 2] = static_cast<uint8_t>(sizes[i]);
+		frame[offset - 1] = static_cast<uint8_t>(sizes[i] >> 8);
+		memcpy(frame + offset, records[i], sizes[i]);
+		cursor = offset + sizes[i];
+	}
+	return cursor;
+}
+
+static double benchDispatch(const PacketDispatcher& dispatcher, const std::vector<ReceivedPacket>& packets)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < DISPATCH_ITERATIONS; ++i)
+	{
+		dispatcher.processPacket(packets[i % packets.size()]);
+	}
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / DISPATCH_ITERATIONS;
+}
+
+static double benchPeek(const std::vector<ReceivedPacket>& packets)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < DISPATCH_ITERATIONS; ++i)
+	{
+		uint32_t sourceNodeId = 0;
+		PacketDispatcher::peekSourceNodeId(packets[i % packets.size()].view(), sourceNodeId);
+		g_dispatchSink = g_dispatchSink + sourceNodeId;
+	}
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / DISPATCH_ITERATIONS;
+}
+
+static void printRow(const char* name, double nsPerPacket)
+{
+	std::cout << std::setw(32) << std::left << name << std::right << std::fixed << std::setprecision(2)
+		<< std::setw(14) << nsPerPacket << "\n";
+	recordResult("dispatch", name, DISPATCH_SOURCES, 1, nsPerPacket);
+}
+
+void runDispatchBench()
+{
+	NodeManager nodeManager(0xFFFFFFFFu);
+	ApplicationStage applicationStage(1024, OverflowPolicy::DropNewest, [](const ApplicationRecord&) {});
+	PacketDispatcher dispatcher(nodeManager, applicationStage);
+
+	// One packet of each kind per source, in pool slots like the real receive path.
+	PacketPool pool(DISPATCH_SOURCES * 6, 2048);
+	std::vector<ReceivedPacket> rawPositions, rawHeartbeats, rawTexts, compactPositions, frames;
+	uint8_t encoded[TdlCodec::MAX_ENCODED_SIZE];
+	uint8_t encodedHeartbeat[TdlCodec::MAX_ENCODED_SIZE];
+	uint8_t frame[2048];
+	for (size_t i = 0; i < DISPATCH_SOURCES; ++i)
+	{
+		uint32_t id = static_cast<uint32_t>(1000 + i);
+		PositionReport report;
+		report.header.sourceNodeId = id;
+		report.latitude = 50.0 + i * 0.001;
+		report.longitude = -1.0 + i * 0.001;
+		report.altitude = 100.0;
+		HeartbeatMessage heartbeat;
+		heartbeat.header.sourceNodeId = id;
+		TextMessage text;
+		text.header.sourceNodeId = id;
+		strcpy(text.text, "bench");
+
+		rawPositions.push_back(makePacket(pool, &report, sizeof(report)));
+		rawHeartbeats.push_back(makePacket(pool, &heartbeat, sizeof(heartbeat)));
+		rawTexts.push_back(makePacket(pool, &text, sizeof(text)));
+
+		size_t positionSize = TdlCodec::encode(report, true, encoded, sizeof(encoded));
+		compactPositions.push_back(makePacket(pool, encoded, positionSize));
+
+		size_t heartbeatSize = TdlCodec::encode(heartbeat, encodedHeartbeat, sizeof(encodedHeartbeat));
+		const uint8_t* records[] = { encoded, encodedHeartbeat };
+		size_t sizes[] = { positionSize, heartbeatSize };
+		frames.push_back(makePacket(pool, frame, buildFrame(frame, records, sizes, 2)));
+
+		nodeManager.updateNodePosition(report); // Measure steady state, not first-contact inserts
+	}
+
+	std::cout << DISPATCH_SOURCES << " known sources, " << DISPATCH_ITERATIONS << " packets per row\n";
+	std::cout << std::setw(32) << std::left << "packet" << std::right << std::setw(14) << "ns/packet" << "\n";
+	printRow("raw PositionReport", benchDispatch(dispatcher, rawPositions));
+	printRow("raw HeartbeatMessage", benchDispatch(dispatcher, rawHeartbeats));
+	printRow("raw TextMessage (to app stage)", benchDispatch(dispatcher, rawTexts));
+	printRow("compact fixed-point position", benchDispatch(dispatcher, compactPositions));
+	printRow("frame (position + heartbeat)", benchDispatch(dispatcher, frames));
+	printRow("peekSourceNodeId (frame)", benchPeek(frames));
+}
@@ -0,0 +1,305 @@
+// NodeManagerBench.cpp
+// NodeManager's public hot paths over synthetic node populations (100 to 100k),
+// and the same update path under contention: 1-16 writer threads plus a reader
+// that keeps publishing and taking snapshots; then the spatial queries against
+// the copy-and-scan they replace.
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "Benchmarks.h"
+#include "../NodeManager.h"
+#include "../TdlMessages.h"
+
+static volatile size_t g_nodeManagerSink = 0;
+
+static const uint32_t BENCH_SELF_NODE_ID = 0xFFFFFFFFu; // Never generated as a peer ID
+
+// Generates 'count' distinct, non-sequential node IDs.
+static std::vector<uint32_t> makePeerIds(size_t count, std::mt19937& rng)
+{
+	std::vector<uint32_t> ids;
+	ids.reserve(count);
+	std::unordered_set<uint32_t> seen;
+	std::uniform_int_distribution<uint32_t> dist(1, 0xFFFFFFF0u);
+	while (ids.size() < count)
+	{
+		uint32_t id = dist(rng);
+		if (seen.insert(id).second)
+		{
+			ids.push_back(id);
+		}
+	}
+	return ids;
+}
+
+// Position reports from random members of 'ids', generated up front so the timed
+// loop measures only NodeManager.
+static std::vector<PositionReport> makeReports(const std::vector<uint32_t>& ids, size_t count, std::mt19937& rng)
+{
+	std::vector<PositionReport> reports(count);
+	std::uniform_int_distribution<size_t> pick(0, ids.size() - 1);
+	for (size_t i = 0; i < count; ++i)
+	{
+		reports[i].header.sourceNodeId = ids[pick(rng)];
+		reports[i].latitude = 50.0 + (i % 1000) * 0.0001;
+		reports[i].longitude = -1.0 + (i % 1000) * 0.0001;
+		reports[i].altitude = 100.0;
+	}
+	return reports;
+}
+
+static std::unique_ptr<NodeManager> makePopulatedManager(const std::vector<uint32_t>& ids)
+{
+	std::unique_ptr<NodeManager> manager = std::make_unique<NodeManager>(BENCH_SELF_NODE_ID);
+	PositionReport report;
+	for (uint32_t id : ids)
+	{
+		report.header.sourceNodeId = id;
+		manager->updateNodePosition(report);
+	}
+	return manager;
+}
+
+static double nsSince(std::chrono::steady_clock::time_point start, size_t operations)
+{
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / operations;
+}
+
+static void printRow(size_t nodes, const char* name, double nsPerOp)
+{
+	std::cout << std::setw(10) << nodes << "  " << std::setw(28) << std::left << name << std::right
+		<< std::fixed << std::setprecision(2) << std::setw(14) << nsPerOp << "\n";
+	recordResult("nodemanager", name, nodes, 1, nsPerOp);
+}
+
+void runNodeManagerBench()
+{
+	const size_t nodeCounts[] = { 100, 1000, 10000, 100000 };
+	const size_t updates = 1000000;
+	std::mt19937 rng(4242);
+
+	std::cout << std::setw(10) << "nodes" << "  " << std::setw(28) << std::left << "operation" << std::right
+		<< std::setw(14) << "ns/op" << "\n";
+
+	for (size_t nodes : nodeCounts)
+	{
+		std::vector<uint32_t> ids = makePeerIds(nodes, rng);
+		std::vector<PositionReport> reports = makeReports(ids, updates, rng);
+		std::unique_ptr<NodeManager> manager = makePopulatedManager(ids);
+
+		// --- Per-packet updates (all nodes already known) ---
+		auto start = std::chrono::steady_clock::now();
+		for (const PositionReport& report : reports)
+		{
+			manager->updateNodePosition(report);
+		}
+		printRow(nodes, "updateNodePosition", nsSince(start, reports.size()));
+
+		start = std::chrono::steady_clock::now();
+		for (const PositionReport& report : reports)
+		{
+			manager->updateLastHeardTime(report.header.sourceNodeId);
+		}
+		printRow(nodes, "updateLastHeardTime", nsSince(start, reports.size()));
+
+		// --- Periodic work ---
+		const size_t sweeps = 200;
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < sweeps; ++i)
+		{
+			manager->pruneTimeouts(std::chrono::seconds(3600)); // Nothing is due
+		}
+		printRow(nodes, "pruneTimeouts (none due)", nsSince(start, sweeps));
+
+		const size_t copies = nodes >= 100000 ? 20 : 200;
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < copies; ++i)
+		{
+			g_nodeManagerSink = g_nodeManagerSink + manager->getNodeList().size();
+		}
+		printRow(nodes, "getNodeList", nsSince(start, copies));
+
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < copies; ++i)
+		{
+			manager->updateLastHeardTime(ids[i % ids.size()]); // Something changed, so a new epoch is built
+			manager->publishSnapshot();
+		}
+		printRow(nodes, "publishSnapshot (changed)", nsSince(start, copies));
+
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < updates; ++i)
+		{
+			g_nodeManagerSink = g_nodeManagerSink + manager->getSnapshot()->nodes.size();
+		}
+		printRow(nodes, "getSnapshot", nsSince(start, updates));
+
+		// --- Mass expiry: every node times out in one sweep (cost per removed node) ---
+		// Wait past two wheel ticks so every node is in a bucket the sweep reaches.
+		std::this_thread::sleep_for(NodeManager::TIMEOUT_WHEEL_TICK * 2);
+		start = std::chrono::steady_clock::now();
+		manager->pruneTimeouts(std::chrono::seconds(0));
+		printRow(nodes, "pruneTimeouts (per expiry)", nsSince(start, nodes));
+		g_nodeManagerSink = g_nodeManagerSink + manager->getNodeList().size();
+	}
+}
+
+void runContentionBench()
+{
+	const size_t nodes = 10000;
+	const size_t updatesPerWriter = 500000;
+	const size_t writerCounts[] = { 1, 2, 4, 8, 16 };
+	std::mt19937 rng(777);
+
+	std::vector<uint32_t> ids = makePeerIds(nodes, rng);
+	// One shared traffic stream; each writer walks it from a different offset.
+	std::vector<PositionReport> traffic = makeReports(ids, updatesPerWriter, rng);
+
+	std::cout << nodes << " nodes, " << updatesPerWriter << " updates per writer, 1 snapshot reader\n";
+	std::cout << std::setw(10) << "writers" << std::setw(16) << "ns/update" << std::setw(16) << "Mupdates/s"
+		<< std::setw(18) << "snapshots/s" << "\n";
+
+	for (size_t writers : writerCounts)
+	{
+		std::unique_ptr<NodeManager> manager = makePopulatedManager(ids);
+		std::atomic<bool> startFlag{ false };
+		std::atomic<size_t> writersDone{ 0 };
+		size_t snapshotsTaken = 0;
+
+		// The reader plays the display thread: publish (single writer of snapshots) and read.
+		std::thread reader([&]()
+			{
+				while (!startFlag.load()) {}
+				while (writersDone.load() < writers)
+				{
+					manager->publishSnapshot();
+					g_nodeManagerSink = g_nodeManagerSink + manager->getSnapshot()->nodes.size();
+					++snapshotsTaken;
+				}
+			});
+
+		std::vector<std::thread> threads;
+		for (size_t w = 0; w < writers; ++w)
+		{
+			threads.emplace_back([&, w]()
+				{
+					while (!startFlag.load()) {}
+					size_t offset = (w * traffic.size()) / 16;
+					for (size_t i = 0; i < traffic.size(); ++i)
+					{
+						manager->updateNodePosition(traffic[(offset + i) % traffic.size()]);
+					}
+					writersDone.fetch_add(1);
+				});
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		startFlag.store(true);
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		reader.join();
+
+		size_t totalUpdates = writers * updatesPerWriter;
+		double nsPerUpdate = seconds * 1e9 / totalUpdates; // Wall time per update across all writers
+		std::cout << std::setw(10) << writers << std::fixed << std::setprecision(2)
+			<< std::setw(16) << nsPerUpdate << std::setw(16) << (totalUpdates / seconds / 1e6)
+			<< std::setw(18) << (snapshotsTaken / seconds) << "\n";
+		recordResult("contention", "updateNodePosition", nodes, writers, nsPerUpdate);
+		recordResult("contention", "snapshot reader ns/snapshot", nodes, writers,
+			snapshotsTaken ? seconds * 1e9 / snapshotsTaken : 0.0);
+	}
+}
+
+void runSpatialBench()
+{
+	const size_t nodeCounts[] = { 1000, 10000, 100000 };
+	const double radiusMeters = 10000.0;
+	const size_t nearestCount = 10;
+	const size_t queries = 2000;
+	std::mt19937 rng(9001);
+
+	std::cout << std::setw(10) << "nodes" << "  " << std::setw(28) << std::left << "query" << std::right
+		<< std::setw(14) << "ns/query" << std::setw(12) << "hits" << "\n";
+
+	for (size_t nodes : nodeCounts)
+	{
+		// A swarm spread over a 5 x 5 degree box (roughly 550 x 350 km at this latitude).
+		std::vector<uint32_t> ids = makePeerIds(nodes, rng);
+		std::uniform_real_distribution<double> latitudes(48.0, 53.0);
+		std::uniform_real_distribution<double> longitudes(-3.5, 1.5);
+		NodeManager manager(BENCH_SELF_NODE_ID);
+		PositionReport report;
+		for (uint32_t id : ids)
+		{
+			report.header.sourceNodeId = id;
+			report.latitude = latitudes(rng);
+			report.longitude = longitudes(rng);
+			manager.updateNodePosition(report);
+		}
+
+		std::vector<std::pair<double, double>> points(queries);
+		for (auto& point : points)
+		{
+			point = { latitudes(rng), longitudes(rng) };
+		}
+
+		auto printQuery = [&](const char* name, double nsPerQuery, size_t hits)
+			{
+				std::cout << std::setw(10) << nodes << "  " << std::setw(28) << std::left << name << std::right
+					<< std::fixed << std::setprecision(2) << std::setw(14) << nsPerQuery
+					<< std::setw(12) << hits / queries << "\n";
+				recordResult("spatial", name, nodes, 1, nsPerQuery);
+			};
+
+		// --- Indexed queries ---
+		std::vector<uint32_t> found;
+		size_t indexedHits = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (const auto& point : points)
+		{
+			indexedHits += manager.findNodesWithin(point.first, point.second, radiusMeters, found);
+		}
+		printQuery("findNodesWithin (10 km)", nsSince(start, queries), indexedHits);
+
+		size_t nearestHits = 0;
+		start = std::chrono::steady_clock::now();
+		for (const auto& point : points)
+		{
+			nearestHits += manager.findNearestNodes(point.first, point.second, nearestCount, found);
+		}
+		printQuery("findNearestNodes (10)", nsSince(start, queries), nearestHits);
+
+		// --- What consumers did before: copy everything, then scan it ---
+		size_t scanHits = 0;
+		const size_t scanQueries = nodes >= 100000 ? queries / 20 : queries;
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < scanQueries; ++i)
+		{
+			for (const NodeInfo& node : manager.getNodeList())
+			{
+				if (SpatialGrid::distanceMeters(points[i].first, points[i].second,
+					node.lastPosition.latitude, node.lastPosition.longitude) <= radiusMeters)
+				{
+					++scanHits;
+				}
+			}
+		}
+		printQuery("getNodeList + scan (10 km)", nsSince(start, scanQueries), scanHits * (queries / scanQueries));
+
+		if (scanQueries == queries && scanHits != indexedHits)
+		{
+			std::cout << "  MISMATCH: index found " << indexedHits << ", scan found " << scanHits << "\n";
+		}
+	}
+}
@@ -0,0 +1,122 @@
+// NodeTableBench.cpp
+// Compares per-packet lookup/update throughput of the flat NodeTable against the
+// std::map<uint32_t, NodeInfo> it replaced, at 1k, 10k and 100k nodes.
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "Benchmarks.h"
+#include "../NodeTable.h"
+#include "../TdlMessages.h"
+
+// Keeps the optimizer from throwing the benchmark loops away.
+static volatile double g_nodeTableSink = 0.0;
+
+// Generates 'count' distinct, non-sequential node IDs.
+static std::vector<uint32_t> makeNodeIds(size_t count, std::mt19937& rng)
+{
+	std::vector<uint32_t> ids;
+	ids.reserve(count);
+	std::map<uint32_t, bool> seen;
+	std::uniform_int_distribution<uint32_t> dist(1, 0xFFFFFFF0u);
+	while (ids.size() < count)
+	{
+		uint32_t id = dist(rng);
+		if (seen.emplace(id, true).second)
+		{
+			ids.push_back(id);
+		}
+	}
+	return ids;
+}
+
+// Simulated stream of incoming packets: which node each one is from.
+static std::vector<uint32_t> makeTraffic(const std::vector<uint32_t>& ids, size_t packets, std::mt19937& rng)
+{
+	std::vector<uint32_t> traffic(packets);
+	std::uniform_int_distribution<size_t> pick(0, ids.size() - 1);
+	for (uint32_t& id : traffic)
+	{
+		id = ids[pick(rng)];
+	}
+	return traffic;
+}
+
+// Same work NodeManager does per PositionReport: find the node, write position + time.
+static double benchMap(const std::vector<uint32_t>& ids, const std::vector<uint32_t>& traffic)
+{
+	std::map<uint32_t, NodeInfo> nodeMap;
+	auto now = std::chrono::steady_clock::now();
+	for (uint32_t id : ids)
+	{
+		nodeMap[id] = NodeInfo(id, now);
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t id : traffic)
+	{
+		auto it = nodeMap.find(id);
+		it->second.lastPosition.latitude += 0.001;
+		it->second.lastPosition.longitude += 0.001;
+		it->second.lastPosition.altitude += 1.0;
+		it->second.lastHeardTime = now;
+	}
+	auto elapsed = std::chrono::steady_clock::now() - start;
+
+	g_nodeTableSink = g_nodeTableSink + nodeMap.begin()->second.lastPosition.latitude;
+	return std::chrono::duration<double, std::nano>(elapsed).count() / traffic.size();
+}
+
+static double benchNodeTable(const std::vector<uint32_t>& ids, const std::vector<uint32_t>& traffic)
+{
+	NodeTable table(ids.size());
+	auto now = NodeTable::toTicks(std::chrono::steady_clock::now());
+	for (uint32_t id : ids)
+	{
+		table.lastHeardTicks(table.insert(id)) = now;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t id : traffic)
+	{
+		uint32_t slot = table.find(id);
+		table.latitude(slot) += 0.001;
+		table.longitude(slot) += 0.001;
+		table.altitude(slot) += 1.0;
+		table.lastHeardTicks(slot) = now;
+	}
+	auto elapsed = std::chrono::steady_clock::now() - start;
+
+	g_nodeTableSink = g_nodeTableSink + table.latitude(0);
+	return std::chrono::duration<double, std::nano>(elapsed).count() / traffic.size();
+}
+
+void runNodeTableBench()
+{
+	const size_t nodeCounts[] = { 1000, 10000, 100000 };
+	const size_t packets = 5000000;
+	std::mt19937 rng(12345);
+
+	std::cout << "Per-packet lookup + update cost (" << packets << " packets, uniform random sources)\n";
+	std::cout << std::setw(10) << "nodes" << std::setw(16) << "std::map ns" << std::setw(16) << "NodeTable ns"
+		<< std::setw(10) << "speedup" << "\n";
+
+	for (size_t nodes : nodeCounts)
+	{
+		std::vector<uint32_t> ids = makeNodeIds(nodes, rng);
+		std::vector<uint32_t> traffic = makeTraffic(ids, packets, rng);
+
+		double mapNs = benchMap(ids, traffic);
+		double tableNs = benchNodeTable(ids, traffic);
+
+		std::cout << std::setw(10) << nodes << std::fixed << std::setprecision(2)
+			<< std::setw(16) << mapNs << std::setw(16) << tableNs
+			<< std::setw(9) << (mapNs / tableNs) << "x\n";
+		recordResult("nodetable", "std::map", nodes, 1, mapNs);
+		recordResult("nodetable", "NodeTable", nodes, 1, tableNs);
+	}
+}
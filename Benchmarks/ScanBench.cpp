@@ -0,0 +1,176 @@
+// ScanBench.cpp
+// ScanKernels over NodeTable-shaped columns: each kernel's scalar loop against the
+// dispatching version (AVX2 or NEON when built with it), then the NodeManager bulk
+// queries built on them against scanning a getNodeList() copy, as callers did before.
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "Benchmarks.h"
+#include "../NodeManager.h"
+#include "../NodeTable.h"
+#include "../ScanKernels.h"
+#include "../SpatialGrid.h"
+
+static volatile double g_scanSink = 0.0;
+
+static const size_t SCAN_SLOTS = 100000;
+static const size_t SCAN_ROUNDS = 200;
+
+// Prints one results row; 'perSlot' is ns for one slot.
+static void printRow(size_t slots, const char* name, double perSlot)
+{
+	std::cout << std::setw(10) << slots << "  " << std::setw(40) << std::left << name << std::right
+		<< std::fixed << std::setprecision(3) << std::setw(12) << perSlot << "\n";
+	recordResult("scan", name, slots, 1, perSlot);
+}
+
+// ns per slot for 'rounds' passes of 'pass' over 'slots' slots.
+template <typename Pass>
+static double timePasses(size_t slots, size_t rounds, Pass&& pass)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (size_t round = 0; round < rounds; ++round)
+	{
+		pass(round);
+	}
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (rounds * slots);
+}
+
+static void benchKernels(std::mt19937& rng)
+{
+	std::uniform_real_distribution<double> latitudes(48.0, 53.0);
+	std::uniform_real_distribution<double> longitudes(-3.5, 1.5);
+	std::uniform_int_distribution<int64_t> ticks(0, 1000000);
+	std::vector<double> lat(SCAN_SLOTS), lon(SCAN_SLOTS), meters(SCAN_SLOTS);
+	std::vector<int64_t> heard(SCAN_SLOTS);
+	std::vector<uint64_t> mask(ScanKernels::maskWords(SCAN_SLOTS));
+	for (size_t i = 0; i < SCAN_SLOTS; ++i)
+	{
+		lat[i] = latitudes(rng);
+		lon[i] = longitudes(rng);
+		heard[i] = ticks(rng);
+	}
+
+	// Each pass nudges its query so no round can be hoisted out of the loop.
+	auto sumMeters = [&]() { g_scanSink = g_scanSink + meters[SCAN_SLOTS / 2]; };
+	auto sumMask = [&]() { g_scanSink = g_scanSink + static_cast<double>(mask[mask.size() / 2]); };
+
+	printRow(SCAN_SLOTS, "flatEarthDistances (scalar)", timePasses(SCAN_SLOTS, SCAN_ROUNDS, [&](size_t round)
+		{
+			ScanKernels::flatEarthDistancesScalar(lat.data(), lon.data(), SCAN_SLOTS, 50.0 + round * 1e-3, -1.0, meters.data());
+			sumMeters();
+		}));
+	printRow(SCAN_SLOTS, "flatEarthDistances", timePasses(SCAN_SLOTS, SCAN_ROUNDS, [&](size_t round)
+		{
+			ScanKernels::flatEarthDistances(lat.data(), lon.data(), SCAN_SLOTS, 50.0 + round * 1e-3, -1.0, meters.data());
+			sumMeters();
+		}));
+	printRow(SCAN_SLOTS, "haversineDistances (scalar)", timePasses(SCAN_SLOTS, SCAN_ROUNDS, [&](size_t round)
+		{
+			ScanKernels::haversineDistancesScalar(lat.data(), lon.data(), SCAN_SLOTS, 50.0 + round * 1e-3, -1.0, meters.data());
+			sumMeters();
+		}));
+	printRow(SCAN_SLOTS, "haversineDistances", timePasses(SCAN_SLOTS, SCAN_ROUNDS, [&](size_t round)
+		{
+			ScanKernels::haversineDistances(lat.data(), lon.data(), SCAN_SLOTS, 50.0 + round * 1e-3, -1.0, meters.data());
+			sumMeters();
+		}));
+	printRow(SCAN_SLOTS, "heardBeforeMask (scalar)", timePasses(SCAN_SLOTS, SCAN_ROUNDS, [&](size_t round)
+		{
+			ScanKernels::heardBeforeMaskScalar(heard.data(), SCAN_SLOTS, 500000 + round, mask.data());
+			sumMask();
+		}));
+	printRow(SCAN_SLOTS, "heardBeforeMask", timePasses(SCAN_SLOTS, SCAN_ROUNDS, [&](size_t round)
+		{
+			ScanKernels::heardBeforeMask(heard.data(), SCAN_SLOTS, 500000 + round, mask.data());
+			sumMask();
+		}));
+	printRow(SCAN_SLOTS, "boundingBoxMask (scalar)", timePasses(SCAN_SLOTS, SCAN_ROUNDS, [&](size_t round)
+		{
+			ScanKernels::boundingBoxMaskScalar(lat.data(), lon.data(), SCAN_SLOTS, 49.0, 51.0 + round * 1e-4, -2.0, 0.0, mask.data());
+			sumMask();
+		}));
+	printRow(SCAN_SLOTS, "boundingBoxMask", timePasses(SCAN_SLOTS, SCAN_ROUNDS, [&](size_t round)
+		{
+			ScanKernels::boundingBoxMask(lat.data(), lon.data(), SCAN_SLOTS, 49.0, 51.0 + round * 1e-4, -2.0, 0.0, mask.data());
+			sumMask();
+		}));
+}
+
+static void benchQueries(std::mt19937& rng)
+{
+	const size_t queryRounds = 20;
+	std::uniform_real_distribution<double> latitudes(48.0, 53.0);
+	std::uniform_real_distribution<double> longitudes(-3.5, 1.5);
+	NodeManager manager(0xFFFFFFFFu);
+	PositionReport report;
+	for (uint32_t id = 1; id <= SCAN_SLOTS; ++id)
+	{
+		report.header.sourceNodeId = id * 2654435761u; // Spread over the shards
+		report.latitude = latitudes(rng);
+		report.longitude = longitudes(rng);
+		manager.updateNodePosition(report);
+	}
+
+	// --- Before: copy every node out, then test each one ---
+	std::vector<NodeDistance> distances;
+	std::vector<uint32_t> ids;
+	printRow(SCAN_SLOTS, "getNodeList + distanceMeters loop", timePasses(SCAN_SLOTS, queryRounds, [&](size_t round)
+		{
+			distances.clear();
+			for (const NodeInfo& node : manager.getNodeList())
+			{
+				if (node.hasPosition)
+				{
+					distances.push_back({ node.nodeId,
+						SpatialGrid::distanceMeters(50.0 + round * 1e-3, -1.0, node.lastPosition.latitude, node.lastPosition.longitude) });
+				}
+			}
+			g_scanSink = g_scanSink + distances.size();
+		}));
+	printRow(SCAN_SLOTS, "getNodeList + age loop", timePasses(SCAN_SLOTS, queryRounds, [&](size_t)
+		{
+			ids.clear();
+			auto now = std::chrono::steady_clock::now();
+			for (const NodeInfo& node : manager.getNodeList())
+			{
+				if (now - node.lastHeardTime >= std::chrono::milliseconds(1))
+				{
+					ids.push_back(node.nodeId);
+				}
+			}
+			g_scanSink = g_scanSink + ids.size();
+		}));
+
+	// --- After: the bulk scans ---
+	printRow(SCAN_SLOTS, "getDistancesFrom (flat earth)", timePasses(SCAN_SLOTS, queryRounds, [&](size_t round)
+		{
+			g_scanSink = g_scanSink + manager.getDistancesFrom(50.0 + round * 1e-3, -1.0, DistanceFormula::FlatEarth, distances);
+		}));
+	printRow(SCAN_SLOTS, "getDistancesFrom (haversine)", timePasses(SCAN_SLOTS, queryRounds, [&](size_t round)
+		{
+			g_scanSink = g_scanSink + manager.getDistancesFrom(50.0 + round * 1e-3, -1.0, DistanceFormula::Haversine, distances);
+		}));
+	printRow(SCAN_SLOTS, "findNodesInBox (2 x 2 deg)", timePasses(SCAN_SLOTS, queryRounds, [&](size_t round)
+		{
+			g_scanSink = g_scanSink + manager.findNodesInBox(49.0, 51.0 + round * 1e-4, -2.0, 0.0, ids);
+		}));
+	printRow(SCAN_SLOTS, "findNodesNotHeardFor", timePasses(SCAN_SLOTS, queryRounds, [&](size_t)
+		{
+			g_scanSink = g_scanSink + manager.findNodesNotHeardFor(std::chrono::milliseconds(1), ids);
+		}));
+}
+
+void runScanBench()
+{
+	std::mt19937 rng(4242);
+	std::cout << "Scan kernels: " << ScanKernels::instructionSet() << "\n";
+	std::cout << std::setw(10) << "slots" << "  " << std::setw(40) << std::left << "scan" << std::right
+		<< std::setw(12) << "ns/slot" << "\n";
+	benchKernels(rng);
+	benchQueries(rng);
+}
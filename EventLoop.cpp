@@ -0,0 +1,97 @@
+// EventLoop.cpp
+#include "EventLoop.h"
+#include <utility>
+#include "Logger.h"
+#include "Transport.h"
+
+EventLoop::EventLoop(Transport& transport) :
+	m_transport(transport)
+{
+}
+
+void EventLoop::addTimer(std::chrono::milliseconds interval, TimerCallback callback)
+{
+	Timer timer;
+	timer.interval = interval;
+	timer.nextDeadline = std::chrono::steady_clock::time_point::min(); // Due on the first pass
+	timer.callback = std::move(callback);
+	m_timers.push_back(std::move(timer));
+}
+
+void EventLoop::setReadableHandler(std::function<void()> handler)
+{
+	m_onReadable = std::move(handler);
+}
+
+std::chrono::steady_clock::time_point EventLoop::runDueTimers(std::chrono::steady_clock::time_point now)
+{
+	auto earliest = std::chrono::steady_clock::time_point::max();
+	for (Timer& timer : m_timers)
+	{
+		if (now >= timer.nextDeadline)
+		{
+			timer.callback(now);
+			++m_timerFirings;
+
+			// Advance from the old deadline, not from 'now', so the period stays exact.
+			timer.nextDeadline = (timer.nextDeadline == std::chrono::steady_clock::time_point::min())
+				? now + timer.interval
+				: timer.nextDeadline + timer.interval;
+			if (timer.nextDeadline <= now)
+			{
+				timer.nextDeadline = now + timer.interval; // Fell behind: skip the missed firings
+			}
+		}
+		if (timer.nextDeadline < earliest)
+		{
+			earliest = timer.nextDeadline;
+		}
+	}
+	return earliest;
+}
+
+bool EventLoop::run()
+{
+	TDL_LOG_INFO << "[EventLoop] Running with " << m_timers.size() << " timers.";
+
+	while (!m_stopRequested.load(std::memory_order_acquire))
+	{
+		auto now = std::chrono::steady_clock::now();
+		auto nextDeadline = runDueTimers(now);
+
+		// Sleep until the next timer, rounded up so we never wake just short of it and spin.
+		int timeoutMs = -1;
+		if (nextDeadline != std::chrono::steady_clock::time_point::max())
+		{
+			auto remaining = std::chrono::ceil<std::chrono::milliseconds>(nextDeadline - std::chrono::steady_clock::now());
+			timeoutMs = remaining.count() > 0 ? static_cast<int>(remaining.count()) : 0;
+		}
+
+		switch (m_transport.waitForEvents(timeoutMs))
+		{
+		case Transport::WaitResult::Readable:
+			++m_readableEvents;
+			if (m_onReadable)
+			{
+				m_onReadable();
+			}
+			break;
+		case Transport::WaitResult::Woken:
+		case Transport::WaitResult::Timeout:
+			break; // Loop around: re-check the stop flag and the timers
+		case Transport::WaitResult::Error:
+			TDL_LOG_ERROR << "[EventLoop] Waiting for network events failed. Stopping.";
+			return false;
+		}
+	}
+
+	TDL_LOG_INFO << "[EventLoop] Stopped after " << m_readableEvents << " receive wakeups and "
+		<< m_timerFirings << " timer firings.";
+	return true;
+}
+
+void EventLoop::stop()
+{
+	m_stopRequested.store(true, std::memory_order_release);
+	m_transport.wakeup();
+}
@@ -0,0 +1,71 @@
+// EventLoop.h
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+class Transport;
+
+// --- Event Loop ---
+// A single-threaded reactor around Transport::waitForEvents(). One thread
+// sleeps until the transport has datagrams, a timer is due, or stop() is
+// called, so there is no polling interval and no fixed sleep anywhere: receive
+// latency is the kernel wakeup, and timers fire at their deadline.
+//
+// Everything registered here runs on the thread that called run().
+class EventLoop
+{
+public:
+	using TimerCallback = std::function<void(std::chrono::steady_clock::time_point now)>;
+
+	explicit EventLoop(Transport& transport);
+
+	// Registers a periodic timer. It first fires on the first pass of run(), then
+	// every 'interval' after that. Deadlines are absolute, so a slow callback does
+	// not make the timer drift; if it falls a whole interval behind, missed
+	// firings are skipped rather than replayed back to back.
+	void addTimer(std::chrono::milliseconds interval, TimerCallback callback);
+
+	// Called whenever the transport has datagrams waiting. The handler should drain it
+	// with receiveBatch(..., false /* don't wait */).
+	void setReadableHandler(std::function<void()> handler);
+
+	// Runs until stop() is called. Returns false if waiting failed outright.
+	bool run();
+
+	// Asks run() to return. Safe from any thread (wakes the loop if it is asleep).
+	void stop();
+
+	// --- Counters ---
+	uint64_t getReadableEvents() const { return m_readableEvents; }
+	uint64_t getTimerFirings() const { return m_timerFirings; }
+
+	// Disable copy and assignment
+	EventLoop(const EventLoop&) = delete;
+	EventLoop& operator=(const EventLoop&) = delete;
+
+private:
+	struct Timer
+	{
+		std::chrono::steady_clock::duration interval;
+		std::chrono::steady_clock::time_point nextDeadline;
+		TimerCallback callback;
+	};
+
+	// Fires every due timer; returns the earliest deadline still pending.
+	std::chrono::steady_clock::time_point runDueTimers(std::chrono::steady_clock::time_point now);
+
+	Transport& m_transport;
+	std::vector<Timer> m_timers;
+	std::function<void()> m_onReadable;
+	std::atomic<bool> m_stopRequested{ false };
+
+	uint64_t m_readableEvents = 0;
+	uint64_t m_timerFirings = 0;
+};
+
+#endif // EVENT_LOOP_H
@@ -0,0 +1,182 @@
+// LoadGenerator.cpp
+#include "LoadGenerator.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include "MessageSequencer.h"
+#include "TdlCodec.h"
+#include "TdlMessages.h"
+#include "Transport.h"
+
+static constexpr double TWO_PI = 6.28318530717958647692;
+static constexpr double SWARM_RADIUS_DEGREES = 0.5;   // Virtual nodes circle within about 50 km of the origin
+static constexpr double LAPS_PER_SECOND = 0.01;        // One lap every 100 s: plenty of motion per report
+static constexpr double MAX_BACKLOG_SECONDS = 0.1;     // Fall further behind than this and the excess is skipped
+
+LoadGenerator::LoadGenerator(Transport& transport, const LoadProfile& profile) :
+	m_transport(transport),
+	m_profile(profile)
+{
+	m_profile.threads = std::max<size_t>(1, std::min(m_profile.threads, std::max<size_t>(1, m_profile.virtualNodes)));
+	m_counters = std::make_unique<SenderCounters[]>(m_profile.threads);
+	m_nextSequence.assign(m_profile.virtualNodes, 1);
+}
+
+LoadGenerator::~LoadGenerator()
+{
+	stop();
+}
+
+void LoadGenerator::start()
+{
+	if (m_running.exchange(true) || m_profile.virtualNodes == 0 || m_profile.messagesPerSecond <= 0.0)
+	{
+		return;
+	}
+	for (size_t i = 0; i < m_profile.threads; ++i)
+	{
+		m_threads.emplace_back(&LoadGenerator::senderThreadFunc, this, i);
+	}
+}
+
+void LoadGenerator::stop()
+{
+	m_running.store(false);
+	for (std::thread& thread : m_threads)
+	{
+		thread.join();
+	}
+	m_threads.clear();
+}
+
+LoadGeneratorCounters LoadGenerator::getCounters() const
+{
+	LoadGeneratorCounters total;
+	for (size_t i = 0; i < m_profile.threads; ++i)
+	{
+		const SenderCounters& counters = m_counters[i];
+		total.positionsSent += counters.positionsSent.load(std::memory_order_relaxed);
+		total.heartbeatsSent += counters.heartbeatsSent.load(std::memory_order_relaxed);
+		total.textsSent += counters.textsSent.load(std::memory_order_relaxed);
+		total.sendFailures += counters.sendFailures.load(std::memory_order_relaxed);
+		total.behindSchedule += counters.behindSchedule.load(std::memory_order_relaxed);
+	}
+	return total;
+}
+
+// --- Sender Thread ---
+void LoadGenerator::senderThreadFunc(size_t senderIndex)
+{
+	SenderCounters& counters = m_counters[senderIndex];
+
+	// This thread's slice of the virtual nodes.
+	size_t firstNode = m_profile.virtualNodes * senderIndex / m_profile.threads;
+	size_t nodeCount = m_profile.virtualNodes * (senderIndex + 1) / m_profile.threads - firstNode;
+
+	double rate = m_profile.messagesPerSecond / static_cast<double>(m_profile.threads);
+	uint64_t maxBacklog = std::max<uint64_t>(1, static_cast<uint64_t>(rate * MAX_BACKLOG_SECONDS));
+
+	// xorshift64: cheap, deterministic per thread, and good enough to pick a message type.
+	uint64_t randomState = 0x9E3779B97F4A7C15ull ^ (senderIndex + 1);
+
+	auto start = std::chrono::steady_clock::now();
+	uint64_t scheduled = 0; // Messages whose deadline has been dealt with (sent or skipped)
+	while (m_running.load(std::memory_order_relaxed))
+	{
+		double elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		uint64_t due = static_cast<uint64_t>(elapsedSeconds * rate);
+
+		// If sending itself is the bottleneck, don't try to catch up forever.
+		if (due > scheduled + maxBacklog)
+		{
+			counters.behindSchedule.fetch_add(due - scheduled - maxBacklog, std::memory_order_relaxed);
+			scheduled = due - maxBacklog;
+		}
+
+		for (; scheduled < due; ++scheduled)
+		{
+			randomState ^= randomState << 13;
+			randomState ^= randomState >> 7;
+			randomState ^= randomState << 17;
+			double roll = static_cast<double>(randomState >> 11) * (1.0 / 9007199254740992.0); // [0, 1)
+
+			uint32_t nodeId = m_profile.firstNodeId + static_cast<uint32_t>(firstNode + scheduled % nodeCount);
+			sendOne(counters, nodeId, scheduled, roll, elapsedSeconds);
+		}
+
+		// Sleep to the next message's deadline, not a fixed interval.
+		std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+			std::chrono::duration<double>(static_cast<double>(scheduled + 1) / rate)));
+	}
+}
+
+void LoadGenerator::sendOne(SenderCounters& counters, uint32_t nodeId, uint64_t sequence, double roll, double elapsedSeconds)
+{
+	uint8_t encoded[TdlCodec::MAX_ENCODED_SIZE];
+	const void* bytes = nullptr;
+	size_t size = 0;
+	MessageType type = POSITION_REPORT_TYPE;
+	std::atomic<uint64_t>* sentCounter = nullptr;
+
+	double totalShare = m_profile.positionShare + m_profile.heartbeatShare + m_profile.textShare;
+	double pick = roll * totalShare;
+
+	// Every virtual node numbers its messages like a real one would.
+	uint32_t nodeIndex = nodeId - m_profile.firstNodeId;
+	MessageHeader header;
+	header.sourceNodeId = nodeId;
+	header.sequenceNumber = m_nextSequence[nodeIndex]++;
+	header.sendTimeUs = MessageSequencer::wallClockMicros();
+
+	PositionReport report;
+	HeartbeatMessage heartbeat;
+	TextMessage text;
+	if (pick < m_profile.positionShare)
+	{
+		header.messageType = POSITION_REPORT_TYPE;
+		report.header = header;
+		// Each node has its own phase on the circle, so neighbours don't overlap.
+		double angle = TWO_PI * (elapsedSeconds * LAPS_PER_SECOND + static_cast<double>(nodeIndex) / static_cast<double>(m_profile.virtualNodes));
+		report.latitude = 50.0 + SWARM_RADIUS_DEGREES * std::cos(angle);
+		report.longitude = -1.0 + SWARM_RADIUS_DEGREES * std::sin(angle);
+		report.altitude = 100.0 + static_cast<double>(nodeIndex % 1000);
+
+		bytes = &report;
+		size = m_profile.compactWire ? TdlCodec::encode(report, true /* fixed-point */, encoded, sizeof(encoded)) : sizeof(report);
+		sentCounter = &counters.positionsSent;
+	}
+	else if (pick < m_profile.positionShare + m_profile.heartbeatShare)
+	{
+		type = HEARTBEAT_TYPE;
+		header.messageType = type;
+		heartbeat.header = header;
+		bytes = &heartbeat;
+		size = m_profile.compactWire ? TdlCodec::encode(heartbeat, encoded, sizeof(encoded)) : sizeof(heartbeat);
+		sentCounter = &counters.heartbeatsSent;
+	}
+	else
+	{
+		type = TEXT_MESSAGE_TYPE;
+		header.messageType = type;
+		text.header = header;
+		snprintf(text.text, MAX_TEXT_MSG_LENGTH, "Load test message %llu from node %u",
+			static_cast<unsigned long long>(sequence), nodeId);
+		bytes = &text;
+		size = m_profile.compactWire ? TdlCodec::encode(text, encoded, sizeof(encoded)) : sizeof(text);
+		sentCounter = &counters.textsSent;
+	}
+
+	if (m_profile.compactWire)
+	{
+		bytes = encoded;
+	}
+	if (size > 0 && m_transport.sendOnChannel(type, bytes, size))
+	{
+		sentCounter->fetch_add(1, std::memory_order_relaxed);
+	}
+	else
+	{
+		counters.sendFailures.fetch_add(1, std::memory_order_relaxed);
+	}
+}
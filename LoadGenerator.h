@@ -0,0 +1,91 @@
+// LoadGenerator.h
+#ifndef LOAD_GENERATOR_H
+#define LOAD_GENERATOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+class Transport;
+
+// --- Load Profile ---
+// What the generator pretends to be: how many nodes, how much traffic in total,
+// and in what mix. Shares are relative weights and need not add up to one.
+struct LoadProfile
+{
+	size_t virtualNodes = 1000;       // Distinct node IDs to send as
+	uint32_t firstNodeId = 100000;    // IDs are firstNodeId .. firstNodeId + virtualNodes - 1
+	double messagesPerSecond = 10000; // Offered load, summed over every sender thread
+	size_t threads = 1;               // Sender threads; each owns an equal slice of the nodes
+
+	double positionShare = 0.75;
+	double heartbeatShare = 0.23;
+	double textShare = 0.02;
+
+	bool compactWire = false;         // Encode with TdlCodec instead of sending raw structs
+};
+
+// --- Load Generator Counters ---
+struct LoadGeneratorCounters
+{
+	uint64_t positionsSent = 0;
+	uint64_t heartbeatsSent = 0;
+	uint64_t textsSent = 0;
+	uint64_t sendFailures = 0;   // sendBroadcast() said no
+	uint64_t behindSchedule = 0; // Messages skipped because the senders could not keep up with the offered rate
+};
+
+// --- Load Generator ---
+// Simulates a large swarm from one process: each sender thread walks its slice of
+// virtual node IDs round-robin and broadcasts a position report, heartbeat or text
+// message for each, paced against absolute deadlines so the offered rate holds
+// regardless of how long individual sends take. Positions move along a circle per
+// node so the receive side sees realistic updates rather than the same bytes.
+//
+// Point it at the real NetworkManager to load a LAN, or at a LoopbackTransport to
+// drive this process's own receive pipeline until it saturates.
+class LoadGenerator
+{
+public:
+	LoadGenerator(Transport& transport, const LoadProfile& profile);
+	~LoadGenerator(); // Stops the senders
+
+	void start();
+	void stop();
+
+	const LoadProfile& getProfile() const { return m_profile; }
+	LoadGeneratorCounters getCounters() const;
+
+	// Disable copy and assignment (threads hold a pointer back to this object)
+	LoadGenerator(const LoadGenerator&) = delete;
+	LoadGenerator& operator=(const LoadGenerator&) = delete;
+
+private:
+	// Counters are per sender so threads never share a cache line.
+	struct alignas(64) SenderCounters
+	{
+		std::atomic<uint64_t> positionsSent{ 0 };
+		std::atomic<uint64_t> heartbeatsSent{ 0 };
+		std::atomic<uint64_t> textsSent{ 0 };
+		std::atomic<uint64_t> sendFailures{ 0 };
+		std::atomic<uint64_t> behindSchedule{ 0 };
+	};
+
+	void senderThreadFunc(size_t senderIndex);
+
+	// Sends one message of the type 'roll' (in [0, 1)) picks for 'nodeId'.
+	void sendOne(SenderCounters& counters, uint32_t nodeId, uint64_t sequence, double roll, double elapsedSeconds);
+
+	Transport& m_transport;
+	LoadProfile m_profile;
+
+	std::atomic<bool> m_running{ false };
+	std::unique_ptr<SenderCounters[]> m_counters;
+	std::vector<uint32_t> m_nextSequence; // Per virtual node; each is only ever written by the thread owning its slice
+	std::vector<std::thread> m_threads;
+};
+
+#endif // LOAD_GENERATOR_H
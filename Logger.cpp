@@ -0,0 +1,286 @@
+// Logger.cpp
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// --- LogCallSite ---
+
+bool LogCallSite::allow()
+{
+	int64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+
+	// Start a new window once a second. Whoever wins the CAS resets the count;
+	// racing callers may let a line or two extra through, which is fine.
+	int64_t windowStart = m_windowStartMs.load(std::memory_order_relaxed);
+	if (nowMs - windowStart >= 1000 &&
+		m_windowStartMs.compare_exchange_strong(windowStart, nowMs, std::memory_order_relaxed))
+	{
+		m_linesInWindow.store(0, std::memory_order_relaxed);
+	}
+
+	if (m_linesInWindow.fetch_add(1, std::memory_order_relaxed) < LOG_LINES_PER_SECOND_PER_SITE)
+	{
+		return true;
+	}
+	m_suppressed.fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
+
+// --- LogLine ---
+
+LogLine::LogLine(LogLevel level, LogCallSite* callSite, bool report) :
+	m_callSite(callSite)
+{
+	m_record.level = level;
+	m_record.report = report;
+}
+
+LogLine::~LogLine()
+{
+	if (m_callSite)
+	{
+		uint32_t suppressed = m_callSite->takeSuppressed();
+		if (suppressed > 0)
+		{
+			*this << " (" << suppressed << " similar lines suppressed)";
+		}
+	}
+	Logger::instance().submit(m_record);
+}
+
+// Once a piece doesn't fit, nothing after it is kept either, so a truncated line
+// is always a prefix of the real one.
+LogLine& LogLine::operator<<(std::string_view text)
+{
+	while (!text.empty() && !m_truncated)
+	{
+		size_t room = sizeof(m_record.args) - m_record.length;
+		if (room < 3) // Tag, length and at least one byte
+		{
+			m_truncated = true;
+			break;
+		}
+		size_t count = std::min({ text.size(), room - 2, size_t(255) });
+		m_record.args[m_record.length] = static_cast<uint8_t>(LogArg::Text);
+		m_record.args[m_record.length + 1] = static_cast<uint8_t>(count);
+		memcpy(m_record.args + m_record.length + 2, text.data(), count);
+		m_record.length = static_cast<uint16_t>(m_record.length + 2 + count);
+		text.remove_prefix(count);
+	}
+	return *this;
+}
+
+LogLine& LogLine::operator<<(double value)
+{
+	return appendWord(LogArg::Double, &value);
+}
+
+LogLine& LogLine::appendWord(LogArg tag, const void* word)
+{
+	if (m_truncated || sizeof(m_record.args) - m_record.length < 9)
+	{
+		m_truncated = true;
+		return *this;
+	}
+	m_record.args[m_record.length] = static_cast<uint8_t>(tag);
+	memcpy(m_record.args + m_record.length + 1, word, 8);
+	m_record.length = static_cast<uint16_t>(m_record.length + 9);
+	return *this;
+}
+
+// --- Logger ---
+
+Logger& Logger::instance()
+{
+	static Logger logger;
+	return logger;
+}
+
+Logger::Logger() :
+	m_ring(LOG_QUEUE_SIZE, OverflowPolicy::DropNewest)
+{
+	m_thread = std::thread(&Logger::writerLoop, this);
+}
+
+Logger::~Logger()
+{
+	m_stopping.store(true);
+	{
+		std::lock_guard<std::mutex> lock(m_wakeupMutex);
+	}
+	m_wakeup.notify_one();
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+
+	uint64_t dropped = getDroppedCount();
+	if (dropped > 0)
+	{
+		fprintf(stderr, "[Logger] %llu log lines dropped (queue full).\n", static_cast<unsigned long long>(dropped));
+	}
+}
+
+bool Logger::submit(LogRecord& record)
+{
+	if (record.level < m_minimumLevel.load(std::memory_order_relaxed))
+	{
+		return true;
+	}
+	record.sequence = m_nextSequence.fetch_add(1, std::memory_order_relaxed);
+	bool queued = true;
+	if (record.report)
+	{
+		std::lock_guard<std::mutex> lock(m_reportMutex);
+		m_reports.push_back(record);
+		m_reportsQueued.store(m_reports.size(), std::memory_order_release);
+	}
+	else
+	{
+		queued = m_ring.push(record);
+	}
+	wakeWriter();
+	return queued;
+}
+
+// Producers only pay for a lock when the writer is actually asleep. The fences
+// pair with the writer's in writerLoop(): either it sees this record before it
+// sleeps, or we see it idle and wake it. Taking m_wakeupMutex first means the
+// notify can't land between its last check and its wait.
+void Logger::wakeWriter()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (m_writerIdle.load(std::memory_order_relaxed))
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_wakeupMutex);
+		}
+		m_wakeup.notify_one();
+	}
+}
+
+void Logger::flush()
+{
+	// The writer only lets go of the mutex between batches, so once we hold it
+	// nothing is half-written and we can drain the rest ourselves.
+	std::lock_guard<std::mutex> lock(m_writeMutex);
+	writeQueued();
+}
+
+bool Logger::takeReports()
+{
+	if (m_reportsQueued.load(std::memory_order_acquire) == 0)
+	{
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(m_reportMutex);
+	m_reportBatch.clear(); // Only ever called once the batch is written, so its capacity goes back to m_reports
+	m_reportNext = 0;
+	m_reportBatch.swap(m_reports);
+	m_reportsQueued.store(0, std::memory_order_relaxed);
+	return !m_reportBatch.empty();
+}
+
+void Logger::writeRecord(const LogRecord& record)
+{
+	// Each 9-byte number formats to at most 26 characters, so the widest possible
+	// line fits with room to spare.
+	char line[4 * LOG_RECORD_ARGS_SIZE];
+	size_t used = 0;
+	size_t offset = 0;
+	while (offset < record.length)
+	{
+		LogArg tag = static_cast<LogArg>(record.args[offset++]);
+		if (tag == LogArg::Text)
+		{
+			size_t count = record.args[offset++];
+			memcpy(line + used, record.args + offset, count);
+			used += count;
+			offset += count;
+			continue;
+		}
+		int length = 0;
+		if (tag == LogArg::Double)
+		{
+			double value;
+			memcpy(&value, record.args + offset, sizeof(value));
+			length = snprintf(line + used, sizeof(line) - used, "%g", value); // Same default format as std::ostream
+		}
+		else if (tag == LogArg::Signed)
+		{
+			long long value;
+			memcpy(&value, record.args + offset, sizeof(value));
+			length = snprintf(line + used, sizeof(line) - used, "%lld", value);
+		}
+		else
+		{
+			unsigned long long value;
+			memcpy(&value, record.args + offset, sizeof(value));
+			length = snprintf(line + used, sizeof(line) - used, "%llu", value);
+		}
+		used += length > 0 ? static_cast<size_t>(length) : 0;
+		offset += 8;
+	}
+	line[used++] = '\n';
+
+	FILE* stream = (record.level == LogLevel::Info) ? stdout : stderr;
+	fwrite(line, 1, used, stream);
+	m_written.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Logger::writeQueued()
+{
+	uint64_t writtenBefore = m_written.load(std::memory_order_relaxed);
+
+	// Reports numbered before 'sequence' go out first. Each time the batch runs
+	// out, look again: a report logged just before the ring record in hand must
+	// already be queued by the time we could pop that record.
+	auto writeReportsBefore = [this](uint64_t sequence)
+		{
+			while ((m_reportNext < m_reportBatch.size() || takeReports()) && m_reportBatch[m_reportNext].sequence < sequence)
+			{
+				writeRecord(m_reportBatch[m_reportNext++]);
+			}
+		};
+
+	LogRecord record;
+	while (m_ring.pop(record))
+	{
+		writeReportsBefore(record.sequence);
+		writeRecord(record);
+	}
+	writeReportsBefore(UINT64_MAX);
+
+	if (m_written.load(std::memory_order_relaxed) != writtenBefore)
+	{
+		// One flush per batch instead of std::endl's one per line.
+		fflush(stdout);
+		fflush(stderr);
+	}
+}
+
+void Logger::writerLoop()
+{
+	while (true)
+	{
+		bool stopping = m_stopping.load(); // Read first, so everything logged before the stop is written
+		{
+			std::lock_guard<std::mutex> lock(m_writeMutex);
+			writeQueued();
+		}
+		if (stopping)
+		{
+			break;
+		}
+
+		// Sleep until a producer or shutdown wakes us; see wakeWriter().
+		std::unique_lock<std::mutex> lock(m_wakeupMutex);
+		m_writerIdle.store(true, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		m_wakeup.wait(lock, [this] { return hasQueued() || m_stopping.load(); });
+		m_writerIdle.store(false, std::memory_order_relaxed);
+	}
+}
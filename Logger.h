@@ -0,0 +1,196 @@
+// Logger.h
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "MessageRing.h"
+
+// --- Asynchronous Logging ---
+// Call sites encode a line's pieces into a fixed-size record on their own stack
+// (no heap, no stream lock, no number formatting): text is copied, and numbers
+// are stored as their raw 8 bytes for the background thread to format. The
+// record goes into a lock-free MessageRing and the caller carries on. The writer
+// thread formats and writes the records in order, flushing once per batch
+// rather than once per line. If the ring is full the line is dropped and
+// counted; logging never blocks the caller.
+//
+//   TDL_LOG_INFO << "[NodeMgr] Added new Node ID " << nodeId;
+//
+// The TDL_LOG_* macros are rate limited per call site (LOG_LINES_PER_SECOND_PER_SITE),
+// so a churn storm produces a handful of lines and a "suppressed" count, not a
+// flood. TDL_LOG_REPORT is for output the user asked for (node list, shutdown
+// statistics, received text): it is never throttled, and it goes through an
+// unbounded queue instead of the ring, so a report is never cut short however
+// many lines it has. Every record is numbered as it is submitted, and the writer
+// interleaves the two queues by that number, so a thread's lines come out in the
+// order it logged them.
+
+enum class LogLevel : uint8_t
+{
+	Info,    // stdout
+	Warning, // stderr
+	Error    // stderr
+};
+
+#define LOG_RECORD_ARGS_SIZE 240        // Encoded pieces of one line; longer lines are truncated
+#define LOG_QUEUE_SIZE 4096             // Records waiting for the writer thread (reports aside)
+#define LOG_LINES_PER_SECOND_PER_SITE 20
+
+// How each piece of a line is encoded in LogRecord::args: a tag byte, then for
+// Text a length byte and that many bytes, and for the rest 8 raw bytes.
+enum class LogArg : uint8_t
+{
+	Text,
+	Signed,
+	Unsigned,
+	Double
+};
+
+// One line, as queued for the writer thread. Only the first 'length' bytes of
+// 'args' mean anything.
+struct LogRecord
+{
+	LogLevel level = LogLevel::Info;
+	bool report = false;   // From TDL_LOG_REPORT: queued unbounded
+	uint16_t length = 0;
+	uint64_t sequence = 0; // Submission order across both queues
+	uint8_t args[LOG_RECORD_ARGS_SIZE];
+};
+
+// --- Per-Call-Site Rate Limit ---
+// One lives (as a function-local static) at every TDL_LOG_* call site.
+class LogCallSite
+{
+public:
+	// True if this call site may log another line in the current one-second window.
+	bool allow();
+	// Lines dropped by allow() since the last call; resets the count.
+	uint32_t takeSuppressed() { return m_suppressed.exchange(0, std::memory_order_relaxed); }
+
+private:
+	std::atomic<int64_t> m_windowStartMs{ INT64_MIN / 2 };
+	std::atomic<uint32_t> m_linesInWindow{ 0 };
+	std::atomic<uint32_t> m_suppressed{ 0 };
+};
+
+// --- Log Line ---
+// Builds one record with operator<< and submits it when destroyed.
+class LogLine
+{
+public:
+	// 'report' sends the line to the unbounded report queue, as TDL_LOG_REPORT does.
+	explicit LogLine(LogLevel level, LogCallSite* callSite = nullptr, bool report = false);
+	~LogLine();
+
+	static LogLine report() { return LogLine(LogLevel::Info, nullptr, true); }
+
+	LogLine& operator<<(std::string_view text);
+	LogLine& operator<<(const char* text) { return *this << std::string_view(text ? text : "(null)"); }
+	LogLine& operator<<(const std::string& text) { return *this << std::string_view(text); }
+	LogLine& operator<<(char c) { return *this << std::string_view(&c, 1); }
+	LogLine& operator<<(bool value) { return *this << (value ? "true" : "false"); }
+	LogLine& operator<<(double value);
+
+	template <typename Integer, typename = std::enable_if_t<std::is_integral_v<Integer>>>
+	LogLine& operator<<(Integer value)
+	{
+		if constexpr (std::is_signed_v<Integer>)
+		{
+			return appendSigned(static_cast<long long>(value));
+		}
+		else
+		{
+			return appendUnsigned(static_cast<unsigned long long>(value));
+		}
+	}
+
+	// Disable copy and assignment
+	LogLine(const LogLine&) = delete;
+	LogLine& operator=(const LogLine&) = delete;
+
+private:
+	LogLine& appendSigned(long long value) { return appendWord(LogArg::Signed, &value); }
+	LogLine& appendUnsigned(unsigned long long value) { return appendWord(LogArg::Unsigned, &value); }
+	LogLine& appendWord(LogArg tag, const void* word); // 8 bytes
+
+	LogRecord m_record;
+	LogCallSite* m_callSite;
+	bool m_truncated = false;
+};
+
+// --- Logger ---
+// The process-wide queue and writer thread. Created on first use.
+class Logger
+{
+public:
+	static Logger& instance();
+
+	// Numbers and queues a record. Lock-free for all but reports, and then wakes
+	// the writer if it is idle. Returns false if it was dropped (queue full);
+	// reports never are.
+	bool submit(LogRecord& record);
+
+	// Blocks until everything queued so far has been written and flushed.
+	void flush();
+
+	// Records below this level are discarded at submit() (not counted as dropped).
+	// Tools such as the benchmarks use it to keep their own output readable.
+	void setMinimumLevel(LogLevel level) { m_minimumLevel.store(level, std::memory_order_relaxed); }
+
+	uint64_t getWrittenCount() const { return m_written.load(std::memory_order_relaxed); }
+	uint64_t getDroppedCount() const { return m_ring.getCounters().droppedNewest; }
+
+	// Disable copy and assignment
+	Logger(const Logger&) = delete;
+	Logger& operator=(const Logger&) = delete;
+
+private:
+	Logger();
+	~Logger(); // Writes whatever is still queued
+
+	void writerLoop();
+	void writeQueued();   // Call with m_writeMutex held
+	bool takeReports();   // Swaps queued reports into m_reportBatch; false if there were none
+	void writeRecord(const LogRecord& record);
+	bool hasQueued() const { return !m_ring.empty() || m_reportsQueued.load(std::memory_order_acquire) != 0; }
+	void wakeWriter();
+
+	MessageRing<LogRecord> m_ring;
+	std::atomic<uint64_t> m_nextSequence{ 0 };
+
+	std::mutex m_reportMutex;              // Guards m_reports
+	std::vector<LogRecord> m_reports;
+	std::atomic<size_t> m_reportsQueued{ 0 }; // m_reports.size(), readable without the lock
+
+	// Writer thread (or flush()) only, under m_writeMutex.
+	std::vector<LogRecord> m_reportBatch;
+	size_t m_reportNext = 0;
+
+	std::mutex m_writeMutex;               // Held by the writer while it drains; flush() waits on it
+	std::mutex m_wakeupMutex;              // Pairs with m_wakeup; never held while writing
+	std::condition_variable m_wakeup;
+	std::atomic<bool> m_writerIdle{ false }; // Producers only signal while the writer sleeps
+	std::atomic<bool> m_stopping{ false };
+	std::atomic<LogLevel> m_minimumLevel{ LogLevel::Info };
+	std::atomic<uint64_t> m_written{ 0 };
+	std::thread m_thread;
+};
+
+#define TDL_LOG(level) \
+	if (static LogCallSite tdlLogCallSite; !tdlLogCallSite.allow()) {} else LogLine(level, &tdlLogCallSite)
+
+#define TDL_LOG_INFO TDL_LOG(LogLevel::Info)
+#define TDL_LOG_WARNING TDL_LOG(LogLevel::Warning)
+#define TDL_LOG_ERROR TDL_LOG(LogLevel::Error)
+#define TDL_LOG_REPORT LogLine::report()
+
+#endif // LOGGER_H
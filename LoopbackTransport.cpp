@@ -0,0 +1,131 @@
+// LoopbackTransport.cpp
+#include "LoopbackTransport.h"
+#include <cstring>
+#include <utility>
+#include "Metrics.h"
+
+// Room for a full queue on top of what the receiver and its workers may hold.
+LoopbackTransport::LoopbackTransport(size_t queueCapacity, uint16_t port, int receiveTimeoutMs, size_t heldPackets) :
+	m_packetPool(queueCapacity + poolSlotsFor(heldPackets), DATAGRAM_SIZE),
+	m_queue(queueCapacity > 0 ? queueCapacity : 1),
+	m_receiveTimeoutMs(receiveTimeoutMs)
+{
+	m_senderAddress.sin_family = AF_INET;
+	m_senderAddress.sin_port = htons(port);
+	m_senderAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+}
+
+bool LoopbackTransport::sendBroadcast(const void* data, size_t size)
+{
+	if (size == 0 || size > DATAGRAM_SIZE)
+	{
+		Metrics::increment(MetricCounter::SendFailures);
+		return false;
+	}
+	Metrics::increment(MetricCounter::PacketsSent);
+	Metrics::increment(MetricCounter::BytesSent, size);
+
+	// Copy outside the lock; a full pool is a drop, same as a full queue.
+	PacketBuffer buffer = m_packetPool.acquire();
+	if (!buffer)
+	{
+		m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+		Metrics::increment(MetricCounter::PacketsDropped);
+		return true; // The "network" accepted it; the receiver just never sees it
+	}
+	memcpy(buffer.data(), data, size);
+
+	bool wasEmpty = false;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_count == m_queue.size())
+		{
+			m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+			Metrics::increment(MetricCounter::PacketsDropped);
+			return true; // 'buffer' goes back to the pool on the way out
+		}
+
+		ReceivedPacket& slot = m_queue[(m_head + m_count) % m_queue.size()];
+		slot.buffer = std::move(buffer);
+		slot.size = size;
+		wasEmpty = (m_count == 0);
+		++m_count;
+		if (m_count > m_queueHighWater.load(std::memory_order_relaxed))
+		{
+			m_queueHighWater.store(m_count, std::memory_order_relaxed);
+		}
+	}
+	if (wasEmpty)
+	{
+		m_readable.notify_one(); // Only an empty queue can have a sleeping receiver
+	}
+	return true;
+}
+
+size_t LoopbackTransport::receiveBatch(ReceivedPacket* packets, size_t maxPackets, bool wait)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (wait && m_count == 0)
+	{
+		m_readable.wait_for(lock, std::chrono::milliseconds(m_receiveTimeoutMs), [this]()
+			{
+				return m_count > 0;
+			});
+	}
+
+	size_t filled = 0;
+	auto receivedAt = std::chrono::steady_clock::now();
+	while (filled < maxPackets && m_count > 0)
+	{
+		ReceivedPacket& slot = m_queue[m_head];
+		packets[filled].buffer = std::move(slot.buffer); // Returns the caller's old slot to the pool
+		packets[filled].size = slot.size;
+		packets[filled].senderAddress = m_senderAddress;
+		packets[filled].receivedAt = receivedAt;
+		m_head = (m_head + 1) % m_queue.size();
+		--m_count;
+		++filled;
+	}
+	lock.unlock();
+
+	m_deliveredCount.fetch_add(filled, std::memory_order_relaxed);
+	return filled;
+}
+
+Transport::WaitResult LoopbackTransport::waitForEvents(int timeoutMs)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	auto ready = [this]()
+		{
+			return m_count > 0 || m_wakePending;
+		};
+	if (timeoutMs < 0)
+	{
+		m_readable.wait(lock, ready);
+	}
+	else
+	{
+		m_readable.wait_for(lock, std::chrono::milliseconds(timeoutMs), ready);
+	}
+
+	// Datagrams first; a pending wakeup stays pending for the next call.
+	if (m_count > 0)
+	{
+		return WaitResult::Readable;
+	}
+	if (m_wakePending)
+	{
+		m_wakePending = false;
+		return WaitResult::Woken;
+	}
+	return WaitResult::Timeout;
+}
+
+void LoopbackTransport::wakeup()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_wakePending = true;
+	}
+	m_readable.notify_one();
+}
@@ -0,0 +1,74 @@
+// LoopbackTransport.h
+#ifndef LOOPBACK_TRANSPORT_H
+#define LOOPBACK_TRANSPORT_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "PacketPool.h"
+#include "Transport.h"
+
+// --- Loopback Transport ---
+// An in-memory Transport: every sendBroadcast() lands straight in this process's
+// own receive queue, as if the datagram had looped back through the network.
+// It lets the load generator drive the real receive pipeline (EventLoop, workers,
+// NodeManager) at rates a LAN of real nodes never could, with no socket in between.
+//
+// The receive queue has a fixed capacity and behaves like a socket receive buffer:
+// when it is full the new datagram is dropped and counted, so the point where the
+// pipeline saturates shows up as a rising drop count rather than unbounded memory.
+class LoopbackTransport : public Transport
+{
+public:
+	// 'port' only fills in the sender address the receive side sees (127.0.0.1:port).
+	// 'heldPackets' sizes the pool for what the receiver keeps downstream (see Transport::poolSlotsFor()).
+	LoopbackTransport(size_t queueCapacity, uint16_t port, int receiveTimeoutMs = 1000, size_t heldPackets = 0);
+
+	bool isInitialized() const override { return true; }
+
+	// Copies the datagram into a pool slot and queues it. Safe from any thread.
+	bool sendBroadcast(const void* data, size_t size) override;
+
+	size_t receiveBatch(ReceivedPacket* packets, size_t maxPackets, bool wait = true) override;
+
+	PacketPool& getPacketPool() override { return m_packetPool; }
+
+	WaitResult waitForEvents(int timeoutMs) override;
+	void wakeup() override;
+
+	// Datagrams handed to receiveBatch() / dropped because the queue (or pool) was full.
+	uint64_t getDeliveredCount() const { return m_deliveredCount.load(std::memory_order_relaxed); }
+	uint64_t getDroppedCount() const { return m_droppedCount.load(std::memory_order_relaxed); }
+
+	// Deepest the receive queue has been.
+	size_t getQueueHighWater() const { return m_queueHighWater.load(std::memory_order_relaxed); }
+
+	// Disable copy and assignment (pool handles point back at this object)
+	LoopbackTransport(const LoopbackTransport&) = delete;
+	LoopbackTransport& operator=(const LoopbackTransport&) = delete;
+
+private:
+	static constexpr size_t DATAGRAM_SIZE = 2048; // Same slot size as the UDP receive path
+
+	// Declared before the queue so it outlives every buffer handle.
+	PacketPool m_packetPool;
+
+	std::mutex m_mutex;                 // Protects everything below up to the counters
+	std::condition_variable m_readable; // Signalled when the queue becomes non-empty or wakeup() is called
+	std::vector<ReceivedPacket> m_queue; // Fixed ring of queued datagrams
+	size_t m_head = 0;
+	size_t m_count = 0;
+	bool m_wakePending = false;
+
+	sockaddr_in m_senderAddress = {};
+	int m_receiveTimeoutMs = 0;
+
+	std::atomic<uint64_t> m_deliveredCount{ 0 };
+	std::atomic<uint64_t> m_droppedCount{ 0 };
+	std::atomic<size_t> m_queueHighWater{ 0 };
+};
+
+#endif // LOOPBACK_TRANSPORT_H
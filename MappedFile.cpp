@@ -0,0 +1,82 @@
+// MappedFile.cpp
+#include "MappedFile.h"
+#if defined(__linux__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& path)
+{
+#if defined(_WIN32)
+	m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	LARGE_INTEGER fileSize = {};
+	if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &fileSize))
+	{
+		m_errorCode = GetLastError();
+		return;
+	}
+	if (fileSize.QuadPart == 0)
+	{
+		return; // Nothing to map (and a zero-length mapping is an error on Windows)
+	}
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	const void* view = m_mapping ? MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!view)
+	{
+		m_errorCode = GetLastError();
+		return;
+	}
+	m_size = static_cast<size_t>(fileSize.QuadPart);
+#elif defined(__linux__)
+	m_fd = open(path.c_str(), O_RDONLY);
+	struct stat info = {};
+	if (m_fd < 0 || fstat(m_fd, &info) != 0)
+	{
+		m_errorCode = static_cast<unsigned long>(errno);
+		return;
+	}
+	if (info.st_size == 0)
+	{
+		return;
+	}
+	void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, m_fd, 0);
+	if (view == MAP_FAILED)
+	{
+		m_errorCode = static_cast<unsigned long>(errno);
+		return;
+	}
+	m_size = static_cast<size_t>(info.st_size);
+	madvise(view, m_size, MADV_SEQUENTIAL); // Every reader here walks the file front to back
+#endif
+	m_data = static_cast<const uint8_t*>(view);
+}
+
+MappedFile::~MappedFile()
+{
+#if defined(_WIN32)
+	if (m_data)
+	{
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mapping)
+	{
+		CloseHandle(m_mapping);
+	}
+	if (m_file != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_file);
+	}
+#elif defined(__linux__)
+	if (m_data)
+	{
+		munmap(const_cast<uint8_t*>(m_data), m_size);
+	}
+	if (m_fd >= 0)
+	{
+		close(m_fd);
+	}
+#endif
+}
@@ -0,0 +1,46 @@
+// MappedFile.h
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#if defined(_WIN32)
+#include <windows.h> // HANDLE
+#endif
+
+// --- Mapped File ---
+// A whole file mapped read-only, for loaders that want to read it in place instead
+// of copying it through read() calls (capture replay, checkpoint warm start). An
+// empty or missing file simply isn't open; errorCode() says why for the log.
+class MappedFile
+{
+public:
+	explicit MappedFile(const std::string& path);
+	~MappedFile();
+
+	bool isOpen() const { return m_data != nullptr; }
+	const uint8_t* data() const { return m_data; }
+	size_t size() const { return m_size; }
+
+	// GetLastError() / errno from the failed step, 0 if the file was merely empty.
+	unsigned long errorCode() const { return m_errorCode; }
+
+	// Disable copy and assignment (owns the mapping)
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+private:
+	const uint8_t* m_data = nullptr;
+	size_t m_size = 0;
+	unsigned long m_errorCode = 0;
+
+#if defined(_WIN32)
+	HANDLE m_file = INVALID_HANDLE_VALUE;
+	HANDLE m_mapping = nullptr;
+#elif defined(__linux__)
+	int m_fd = -1;
+#endif
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,490 @@
+// MessageAuth.cpp
+#include "MessageAuth.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#include "Metrics.h"
+#include "PacketDispatcher.h" // peekSourceNodeId()
+
+// --- SipHash-2-4 ---
+static inline uint64_t rotateLeft(uint64_t value, int bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t loadWord(const uint8_t* data)
+{
+	uint64_t word;
+	memcpy(&word, data, sizeof(word)); // Little-endian hosts only, like the raw wire format
+	return word;
+}
+
+static inline void sipRound(uint64_t& v0, uint64_t& v1, uint64_t& v2, uint64_t& v3)
+{
+	v0 += v1; v1 = rotateLeft(v1, 13); v1 ^= v0; v0 = rotateLeft(v0, 32);
+	v2 += v3; v3 = rotateLeft(v3, 16); v3 ^= v2;
+	v0 += v3; v3 = rotateLeft(v3, 21); v3 ^= v0;
+	v2 += v1; v1 = rotateLeft(v1, 17); v1 ^= v2; v2 = rotateLeft(v2, 32);
+}
+
+MessageAuthenticator::HashState MessageAuthenticator::initialState() const
+{
+	return HashState{ m_key[0] ^ 0x736f6d6570736575ull, m_key[1] ^ 0x646f72616e646f6dull,
+		m_key[0] ^ 0x6c7967656e657261ull, m_key[1] ^ 0x7465646279746573ull };
+}
+
+void MessageAuthenticator::absorb(HashState& state, uint64_t word)
+{
+	state.v3 ^= word;
+	sipRound(state.v0, state.v1, state.v2, state.v3);
+	sipRound(state.v0, state.v1, state.v2, state.v3);
+	state.v0 ^= word;
+}
+
+// 'tail' is the last size % 8 bytes of the input; 'size' is the whole input's length.
+uint64_t MessageAuthenticator::finish(HashState& state, const uint8_t* tail, size_t size)
+{
+	uint64_t last = static_cast<uint64_t>(size) << 56;
+	for (size_t i = 0; i < (size & 7); ++i)
+	{
+		last |= static_cast<uint64_t>(tail[i]) << (8 * i);
+	}
+	absorb(state, last);
+	state.v2 ^= 0xFF;
+	for (int round = 0; round < 4; ++round)
+	{
+		sipRound(state.v0, state.v1, state.v2, state.v3);
+	}
+	return state.v0 ^ state.v1 ^ state.v2 ^ state.v3;
+}
+
+uint64_t MessageAuthenticator::tag(const uint8_t* data, size_t size) const
+{
+	HashState state = initialState();
+	size_t blocks = size / 8;
+	for (size_t block = 0; block < blocks; ++block)
+	{
+		absorb(state, loadWord(data + block * 8));
+	}
+	return finish(state, data + blocks * 8, size);
+}
+
+bool MessageAuthenticator::parseKey(const std::string& hex, MessageKey& key)
+{
+	if (hex.size() != 32)
+	{
+		return false;
+	}
+	MessageKey parsed{};
+	for (size_t i = 0; i < hex.size(); ++i)
+	{
+		char c = hex[i];
+		int nibble = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+		if (nibble < 0)
+		{
+			return false;
+		}
+		// Byte order as written: the first 16 digits are the first 8 key bytes, little-endian as SipHash reads them.
+		size_t byte = i / 2;
+		parsed[byte / 8] |= static_cast<uint64_t>(nibble) << (8 * (byte % 8) + ((i % 2) ? 0 : 4));
+	}
+	key = parsed;
+	return true;
+}
+
+size_t MessageAuthenticator::seal(uint8_t* buffer, size_t size, size_t capacity, uint32_t sourceNodeId, uint64_t sequence,
+	uint64_t sealedAtUs) const
+{
+	if (capacity < TRAILER_SIZE || size > capacity - TRAILER_SIZE)
+	{
+		return 0;
+	}
+	uint8_t* trailer = buffer + size;
+	for (int i = 0; i < 4; ++i)
+	{
+		trailer[i] = static_cast<uint8_t>(sourceNodeId >> (8 * i));
+	}
+	for (int i = 0; i < 8; ++i)
+	{
+		trailer[4 + i] = static_cast<uint8_t>(sequence >> (8 * i));
+		trailer[12 + i] = static_cast<uint8_t>(sealedAtUs >> (8 * i));
+	}
+	trailer[20] = AUTH_VERSION;
+	trailer[21] = AUTH_MAGIC;
+	uint64_t value = tag(buffer, size + TRAILER_SIZE - TAG_SIZE);
+	memcpy(trailer + TRAILER_SIZE - TAG_SIZE, &value, TAG_SIZE);
+	return size + TRAILER_SIZE;
+}
+
+// --- Lockstep Lanes (AVX2) ---
+// BATCH_LANES SipHash states side by side, one 256-bit register per state word,
+// so a SIPROUND is a handful of vector instructions for all four lanes. Without
+// AVX2, four scalar states don't fit the general registers and interleaving them
+// only adds spills, so that build hashes one datagram at a time.
+#if defined(__AVX2__)
+namespace
+{
+	struct HashLanes
+	{
+		__m256i v0, v1, v2, v3;
+	};
+}
+
+static inline __m256i rotateLanes(__m256i value, int bits)
+{
+	return _mm256_or_si256(_mm256_slli_epi64(value, bits), _mm256_srli_epi64(value, 64 - bits));
+}
+
+static inline void sipRoundLanes(HashLanes& s)
+{
+	s.v0 = _mm256_add_epi64(s.v0, s.v1); s.v1 = rotateLanes(s.v1, 13); s.v1 = _mm256_xor_si256(s.v1, s.v0);
+	s.v0 = _mm256_shuffle_epi32(s.v0, _MM_SHUFFLE(2, 3, 0, 1)); // Rotate by 32: swap each lane's halves
+	s.v2 = _mm256_add_epi64(s.v2, s.v3); s.v3 = rotateLanes(s.v3, 16); s.v3 = _mm256_xor_si256(s.v3, s.v2);
+	s.v0 = _mm256_add_epi64(s.v0, s.v3); s.v3 = rotateLanes(s.v3, 21); s.v3 = _mm256_xor_si256(s.v3, s.v0);
+	s.v2 = _mm256_add_epi64(s.v2, s.v1); s.v1 = rotateLanes(s.v1, 17); s.v1 = _mm256_xor_si256(s.v1, s.v2);
+	s.v2 = _mm256_shuffle_epi32(s.v2, _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+static inline void absorbLanes(HashLanes& s, __m256i words)
+{
+	s.v3 = _mm256_xor_si256(s.v3, words);
+	sipRoundLanes(s);
+	sipRoundLanes(s);
+	s.v0 = _mm256_xor_si256(s.v0, words);
+}
+
+// Tags for up to BATCH_LANES inputs at once ('count' real ones; the rest repeat input 0).
+static void tagLanes(const uint64_t initial[4], const uint8_t* const* input, const size_t* sizes, size_t count, uint64_t* tags)
+{
+	const uint8_t* lanes[MessageAuthenticator::BATCH_LANES];
+	size_t laneSizes[MessageAuthenticator::BATCH_LANES];
+	size_t commonBlocks = SIZE_MAX;
+	for (size_t lane = 0; lane < MessageAuthenticator::BATCH_LANES; ++lane)
+	{
+		lanes[lane] = input[lane < count ? lane : 0];
+		laneSizes[lane] = sizes[lane < count ? lane : 0];
+		commonBlocks = std::min(commonBlocks, laneSizes[lane] / 8);
+	}
+	HashLanes s{ _mm256_set1_epi64x(static_cast<long long>(initial[0])), _mm256_set1_epi64x(static_cast<long long>(initial[1])),
+		_mm256_set1_epi64x(static_cast<long long>(initial[2])), _mm256_set1_epi64x(static_cast<long long>(initial[3])) };
+
+	// --- The blocks every lane has ---
+	for (size_t block = 0; block < commonBlocks; ++block)
+	{
+		absorbLanes(s, _mm256_set_epi64x(static_cast<long long>(loadWord(lanes[3] + block * 8)), static_cast<long long>(loadWord(lanes[2] + block * 8)),
+			static_cast<long long>(loadWord(lanes[1] + block * 8)), static_cast<long long>(loadWord(lanes[0] + block * 8))));
+	}
+
+	// --- Each lane's remaining blocks ---
+	// Only where sizes differ by 8 bytes or more; a batch of like datagrams shares every block.
+	alignas(32) uint64_t v[4][MessageAuthenticator::BATCH_LANES];
+	_mm256_store_si256(reinterpret_cast<__m256i*>(v[0]), s.v0);
+	_mm256_store_si256(reinterpret_cast<__m256i*>(v[1]), s.v1);
+	_mm256_store_si256(reinterpret_cast<__m256i*>(v[2]), s.v2);
+	_mm256_store_si256(reinterpret_cast<__m256i*>(v[3]), s.v3);
+	alignas(32) uint64_t last[MessageAuthenticator::BATCH_LANES];
+	for (size_t lane = 0; lane < MessageAuthenticator::BATCH_LANES; ++lane)
+	{
+		size_t blocks = laneSizes[lane] / 8;
+		for (size_t block = commonBlocks; block < blocks; ++block)
+		{
+			uint64_t word = loadWord(lanes[lane] + block * 8);
+			v[3][lane] ^= word;
+			sipRound(v[0][lane], v[1][lane], v[2][lane], v[3][lane]);
+			sipRound(v[0][lane], v[1][lane], v[2][lane], v[3][lane]);
+			v[0][lane] ^= word;
+		}
+		const uint8_t* tail = lanes[lane] + blocks * 8;
+		last[lane] = static_cast<uint64_t>(laneSizes[lane]) << 56;
+		for (size_t b = 0; b < (laneSizes[lane] & 7); ++b)
+		{
+			last[lane] |= static_cast<uint64_t>(tail[b]) << (8 * b);
+		}
+	}
+	s.v0 = _mm256_load_si256(reinterpret_cast<const __m256i*>(v[0]));
+	s.v1 = _mm256_load_si256(reinterpret_cast<const __m256i*>(v[1]));
+	s.v2 = _mm256_load_si256(reinterpret_cast<const __m256i*>(v[2]));
+	s.v3 = _mm256_load_si256(reinterpret_cast<const __m256i*>(v[3]));
+
+	// --- Finalisation: for short datagrams, most of the work ---
+	absorbLanes(s, _mm256_load_si256(reinterpret_cast<const __m256i*>(last)));
+	s.v2 = _mm256_xor_si256(s.v2, _mm256_set1_epi64x(0xFF));
+	for (int round = 0; round < 4; ++round)
+	{
+		sipRoundLanes(s);
+	}
+	__m256i result = _mm256_xor_si256(_mm256_xor_si256(s.v0, s.v1), _mm256_xor_si256(s.v2, s.v3));
+	alignas(32) uint64_t out[MessageAuthenticator::BATCH_LANES];
+	_mm256_store_si256(reinterpret_cast<__m256i*>(out), result);
+	for (size_t lane = 0; lane < count; ++lane)
+	{
+		tags[lane] = out[lane];
+	}
+}
+#endif
+
+void MessageAuthenticator::verifyBatch(const uint8_t* const* data, const size_t* sizes, size_t count, bool* results, uint32_t* sourceNodeIds,
+	uint64_t* sequences, uint64_t* sealedTimesUs) const
+{
+	// Gathered in groups of BATCH_LANES datagrams that at least look sealed.
+	const uint8_t* input[BATCH_LANES];
+	size_t hashed[BATCH_LANES];
+	size_t indices[BATCH_LANES];
+	size_t laneCount = 0;
+#if defined(__AVX2__)
+	HashState state = initialState();
+	const uint64_t initial[4] = { state.v0, state.v1, state.v2, state.v3 };
+#endif
+	for (size_t i = 0; i < count; ++i)
+	{
+		results[i] = false;
+		if (sizes[i] > TRAILER_SIZE && data[i][sizes[i] - TAG_SIZE - 1] == AUTH_MAGIC && data[i][sizes[i] - TAG_SIZE - 2] == AUTH_VERSION)
+		{
+			input[laneCount] = data[i];
+			hashed[laneCount] = sizes[i] - TAG_SIZE;
+			indices[laneCount++] = i;
+		}
+		if (laneCount < BATCH_LANES && i + 1 < count)
+		{
+			continue;
+		}
+
+		uint64_t tags[BATCH_LANES];
+#if defined(__AVX2__)
+		if (laneCount > 1)
+		{
+			tagLanes(initial, input, hashed, laneCount, tags);
+		}
+		else
+#endif
+		for (size_t lane = 0; lane < laneCount; ++lane)
+		{
+			tags[lane] = tag(input[lane], hashed[lane]);
+		}
+
+		for (size_t lane = 0; lane < laneCount; ++lane)
+		{
+			size_t index = indices[lane];
+			uint64_t received;
+			memcpy(&received, input[lane] + hashed[lane], TAG_SIZE);
+			results[index] = tags[lane] == received; // One 64-bit compare: no early exit to time
+
+			const uint8_t* trailer = input[lane] + hashed[lane] - (TRAILER_SIZE - TAG_SIZE);
+			sourceNodeIds[index] = static_cast<uint32_t>(trailer[0]) | (static_cast<uint32_t>(trailer[1]) << 8)
+				| (static_cast<uint32_t>(trailer[2]) << 16) | (static_cast<uint32_t>(trailer[3]) << 24);
+			sequences[index] = 0;
+			sealedTimesUs[index] = 0;
+			for (int b = 0; b < 8; ++b)
+			{
+				sequences[index] |= static_cast<uint64_t>(trailer[4 + b]) << (8 * b);
+				sealedTimesUs[index] |= static_cast<uint64_t>(trailer[12 + b]) << (8 * b);
+			}
+		}
+		laneCount = 0;
+	}
+}
+
+// --- Replay Filter ---
+ReplayFilter::ReplayFilter() :
+	m_sets(new Set[SET_COUNT])
+{
+}
+
+bool ReplayFilter::accept(uint32_t sourceNodeId, uint64_t sequence, uint64_t sealedAtUs, uint64_t nowUs)
+{
+	if (sealedAtUs > nowUs + MAX_CLOCK_SKEW_US || sealedAtUs + MAX_CLOCK_SKEW_US < nowUs)
+	{
+		return false;
+	}
+	Set& set = m_sets[(sourceNodeId * 2654435761u) >> (32 - SET_BITS)];
+	Window* window = nullptr;
+	for (Window& way : set.ways)
+	{
+		if (way.used && way.sourceNodeId == sourceNodeId)
+		{
+			window = &way;
+			break;
+		}
+	}
+
+	if (!window)
+	{
+		if (sealedAtUs <= set.floorUs)
+		{
+			return false; // Perhaps a replay from before this sender's window was evicted
+		}
+		// An empty way, else the one that has gone longest without a new datagram.
+		window = &set.ways[0];
+		for (Window& way : set.ways)
+		{
+			if (!way.used || (window->used && way.newestSealedUs < window->newestSealedUs))
+			{
+				window = &way;
+			}
+		}
+		if (window->used)
+		{
+			set.floorUs = std::max(set.floorUs, window->newestSealedUs);
+		}
+		*window = Window{ sourceNodeId, true, sequence, 1, sealedAtUs };
+		return true;
+	}
+
+	if (sequence > window->highest)
+	{
+		uint64_t shift = sequence - window->highest;
+		window->seen = shift < WINDOW ? (window->seen << shift) | 1 : 1;
+		window->highest = sequence;
+	}
+	else
+	{
+		uint64_t age = window->highest - sequence;
+		if (age >= WINDOW || (window->seen & (uint64_t(1) << age)))
+		{
+			return false; // Too old to tell, or seen already
+		}
+		window->seen |= uint64_t(1) << age;
+	}
+	window->newestSealedUs = std::max(window->newestSealedUs, sealedAtUs);
+	return true;
+}
+
+// --- Per-Source Rate Limiter ---
+SourceRateLimiter::SourceRateLimiter(uint32_t datagramsPerSecond) :
+	m_ratePerSecond(datagramsPerSecond),
+	m_burstMicro(static_cast<int64_t>(datagramsPerSecond) * 1000000),
+	m_buckets(new Bucket[TABLE_SIZE])
+{
+}
+
+bool SourceRateLimiter::allow(uint32_t sourceNodeId, std::chrono::steady_clock::time_point now)
+{
+	Bucket& bucket = m_buckets[(sourceNodeId * 2654435761u) >> (32 - TABLE_BITS)]; // Fibonacci hashing spreads sequential IDs
+	int64_t nowUs = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+	if (!bucket.used)
+	{
+		bucket.used = true;
+		bucket.tokensMicro = m_burstMicro;
+		bucket.lastRefillUs = nowUs;
+	}
+	bucket.sourceNodeId = sourceNodeId; // A colliding sender takes over what is left, so it is charged below like any other
+	if (nowUs > bucket.lastRefillUs)
+	{
+		// Microseconds times tokens per second is micro-tokens.
+		bucket.tokensMicro = std::min(m_burstMicro, bucket.tokensMicro + (nowUs - bucket.lastRefillUs) * m_ratePerSecond);
+		bucket.lastRefillUs = nowUs;
+	}
+	if (bucket.tokensMicro < 1000000)
+	{
+		return false;
+	}
+	bucket.tokensMicro -= 1000000;
+	return true;
+}
+
+// --- Authenticated Transport ---
+static uint64_t wallClockUs()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+// Seeding from the clock keeps a restarted node above its last run's sequences,
+// as long as that run sealed fewer datagrams than it lasted microseconds.
+AuthenticatedTransport::AuthenticatedTransport(std::unique_ptr<Transport> inner, const MessageKey& key, uint32_t selfNodeId,
+	uint32_t datagramsPerSecond) :
+	m_inner(std::move(inner)),
+	m_authenticator(key),
+	m_selfNodeId(selfNodeId),
+	m_nextSequence(wallClockUs()),
+	m_rateLimiter(datagramsPerSecond)
+{
+}
+
+size_t AuthenticatedTransport::seal(const void* data, size_t size, uint8_t* sealed)
+{
+	if (size > MAX_SEALED_SIZE - MessageAuthenticator::TRAILER_SIZE)
+	{
+		Metrics::increment(MetricCounter::SendFailures);
+		return 0;
+	}
+	memcpy(sealed, data, size);
+
+	// The load generator sends as its virtual nodes, so label each datagram with the
+	// node it actually speaks for.
+	uint32_t sourceNodeId = m_selfNodeId;
+	PacketDispatcher::peekSourceNodeId(PacketView{ sealed, size }, sourceNodeId);
+	return m_authenticator.seal(sealed, size, MAX_SEALED_SIZE, sourceNodeId,
+		m_nextSequence.fetch_add(1, std::memory_order_relaxed), wallClockUs());
+}
+
+bool AuthenticatedTransport::sendBroadcast(const void* data, size_t size)
+{
+	uint8_t sealed[MAX_SEALED_SIZE];
+	size_t sealedSize = seal(data, size, sealed);
+	return sealedSize != 0 && m_inner->sendBroadcast(sealed, sealedSize);
+}
+
+bool AuthenticatedTransport::sendOnChannel(MessageType type, const void* data, size_t size)
+{
+	uint8_t sealed[MAX_SEALED_SIZE];
+	size_t sealedSize = seal(data, size, sealed);
+	return sealedSize != 0 && m_inner->sendOnChannel(type, sealed, sealedSize);
+}
+
+// Everything rejected is moved behind the datagrams that pass, so every entry
+// still owns its pool slot for the next call. A batch with rejections comes back
+// short, which ends the caller's drain pass early; the transport is still
+// readable, so the reactor is straight back for the rest.
+size_t AuthenticatedTransport::receiveBatch(ReceivedPacket* packets, size_t maxPackets, bool wait)
+{
+	size_t received = m_inner->receiveBatch(packets, std::min(maxPackets, MAX_BATCH_SIZE), wait);
+	for (size_t i = 0; i < received; ++i)
+	{
+		m_batchData[i] = packets[i].buffer.data();
+		m_batchSizes[i] = packets[i].size;
+	}
+	m_authenticator.verifyBatch(m_batchData.data(), m_batchSizes.data(), received, m_batchValid.data(), m_batchSources.data(),
+		m_batchSequences.data(), m_batchSealedTimes.data());
+	uint64_t nowUs = wallClockUs();
+
+	size_t kept = 0;
+	for (size_t i = 0; i < received; ++i)
+	{
+		if (!m_batchValid[i])
+		{
+			Metrics::increment(MetricCounter::AuthFailures);
+			continue;
+		}
+		// The tag covers the trailer's sender, but the handlers believe the header's:
+		// they must agree, or a node's datagrams could be charged to another. Only now
+		// is the datagram known to be longer than its trailer.
+		uint32_t headerNodeId = m_batchSources[i];
+		PacketDispatcher::peekSourceNodeId(PacketView{ packets[i].buffer.data(), packets[i].size - MessageAuthenticator::TRAILER_SIZE }, headerNodeId);
+		if (headerNodeId != m_batchSources[i])
+		{
+			Metrics::increment(MetricCounter::AuthFailures);
+			continue;
+		}
+		if (!m_replayFilter.accept(m_batchSources[i], m_batchSequences[i], m_batchSealedTimes[i], nowUs))
+		{
+			Metrics::increment(MetricCounter::ReplaysRejected);
+			continue;
+		}
+		if (!m_rateLimiter.allow(m_batchSources[i], packets[i].receivedAt))
+		{
+			Metrics::increment(MetricCounter::RateLimited);
+			continue;
+		}
+		packets[i].size -= MessageAuthenticator::TRAILER_SIZE;
+		if (kept != i)
+		{
+			std::swap(packets[kept], packets[i]);
+		}
+		++kept;
+	}
+	return kept;
+}
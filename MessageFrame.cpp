@@ -0,0 +1,77 @@
+// MessageFrame.cpp
+#include "MessageFrame.h"
+#include <cstring>
+#include "Transport.h"
+
+MessageAggregator::MessageAggregator(Transport& transport, std::chrono::milliseconds maxDelay, size_t maxFrameSize, MessageType channel) :
+	m_transport(transport),
+	m_maxDelay(maxDelay),
+	m_maxFrameSize(maxFrameSize < MAX_FRAME_BUFFER ? maxFrameSize : MAX_FRAME_BUFFER),
+	m_channel(channel)
+{
+	m_frame[0] = MessageFrame::FRAME_MAGIC;
+	m_frame[1] = MessageFrame::FRAME_VERSION;
+}
+
+bool MessageAggregator::add(const void* message, size_t size)
+{
+	size_t offset = MessageFrame::recordOffsetAfter(m_frameSize);
+	bool sent = true;
+
+	// Size flush: send what we have if this message would push the frame past the limit.
+	if (offset + size > m_maxFrameSize && m_recordCount > 0)
+	{
+		sent = flush();
+		offset = MessageFrame::recordOffsetAfter(m_frameSize);
+	}
+	if (offset + size > m_maxFrameSize || size == 0 || size > 0xFFFF)
+	{
+		return false; // Can never fit in a frame
+	}
+
+	if (m_recordCount == 0)
+	{
+		m_oldestPending = std::chrono::steady_clock::now();
+	}
+
+	// Zero the alignment filler so frames are deterministic on the wire.
+	memset(m_frame + m_frameSize, 0, offset - m_frameSize);
+	m_frame[offset - 2] = static_cast<uint8_t>(size);
+	m_frame[offset - 1] = static_cast<uint8_t>(size >> 8);
+	memcpy(m_frame + offset, message, size);
+
+	m_frameSize = offset + size;
+	++m_recordCount;
+	return sent;
+}
+
+bool MessageAggregator::flushIfDue(std::chrono::steady_clock::time_point now)
+{
+	if (m_recordCount == 0 || now - m_oldestPending < m_maxDelay)
+	{
+		return true;
+	}
+	return flush();
+}
+
+bool MessageAggregator::flush()
+{
+	if (m_recordCount == 0)
+	{
+		return true;
+	}
+
+	m_frame[2] = static_cast<uint8_t>(m_recordCount);
+	m_frame[3] = static_cast<uint8_t>(m_recordCount >> 8);
+	bool sent = m_transport.sendOnChannel(m_channel, m_frame, m_frameSize);
+	if (sent)
+	{
+		++m_framesSent;
+		m_messagesSent += m_recordCount;
+	}
+
+	// Start a fresh frame either way; a failed frame is dropped like a failed sendto.
+	m_frameSize = MessageFrame::HEADER_SIZE;
+	m_recordCount = 0;
+	return sent;
+}
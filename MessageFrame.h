@@ -0,0 +1,123 @@
+// MessageFrame.h
+#ifndef MESSAGE_FRAME_H
+#define MESSAGE_FRAME_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "PacketPool.h"  // PacketView for the records handed to the reader callback
+#include "TdlMessages.h" // MessageType for the channel a frame is sent on
+
+class Transport;
+
+// --- Multi-Message Frames ---
+// A frame packs several messages (raw structs or compact encodings, each starting
+// with its own header) into one datagram, so a node's heartbeat, position and text
+// share a single sendto and a single UDP/IP header.
+//
+//   byte 0       FRAME_MAGIC (distinct from raw message types and TdlCodec::COMPACT_MAGIC)
+//   byte 1       FRAME_VERSION
+//   bytes 2..3   record count, uint16 little-endian
+//   records      each record starts on an 8-byte boundary (so raw structs can be read
+//                in place), and its uint16 little-endian length sits in the two bytes
+//                just before it. The first record therefore starts at offset 8.
+struct MessageFrame
+{
+	static constexpr uint8_t FRAME_MAGIC = 0xF7;
+	static constexpr uint8_t FRAME_VERSION = 1;
+	static constexpr size_t HEADER_SIZE = 4;
+	static constexpr size_t RECORD_ALIGNMENT = 8;
+
+	// Offset of the record that follows a record (or the header) ending at 'cursor'.
+	static size_t recordOffsetAfter(size_t cursor)
+	{
+		return (cursor + 2 + RECORD_ALIGNMENT - 1) & ~(RECORD_ALIGNMENT - 1);
+	}
+
+	static bool isFrame(const uint8_t* data, size_t size)
+	{
+		return size >= HEADER_SIZE && data[0] == FRAME_MAGIC && data[1] == FRAME_VERSION;
+	}
+
+	// Calls onRecord(PacketView) for every record in the frame, in order.
+	// Returns false if the frame is malformed (records before the bad one are still delivered).
+	template <typename Callback>
+	static bool forEachRecord(const uint8_t* data, size_t size, Callback&& onRecord)
+	{
+		if (!isFrame(data, size))
+		{
+			return false;
+		}
+		size_t recordCount = static_cast<size_t>(data[2]) | (static_cast<size_t>(data[3]) << 8);
+		size_t cursor = HEADER_SIZE;
+		for (size_t i = 0; i < recordCount; ++i)
+		{
+			size_t offset = recordOffsetAfter(cursor);
+			if (offset > size)
+			{
+				return false;
+			}
+			size_t length = static_cast<size_t>(data[offset - 2]) | (static_cast<size_t>(data[offset - 1]) << 8);
+			if (length == 0 || length > size - offset)
+			{
+				return false;
+			}
+			onRecord(PacketView{ data + offset, length });
+			cursor = offset + length;
+		}
+		return true;
+	}
+};
+
+// --- Message Aggregator ---
+// Send-side coalescing: messages are appended to a pending frame, which is sent
+// when the next message would not fit (size flush) or when the oldest pending
+// message has waited 'maxDelay' (deadline flush, driven by flushIfDue()).
+class MessageAggregator
+{
+public:
+	// Keep frames comfortably under a typical 1500-byte Ethernet MTU.
+	static constexpr size_t DEFAULT_MAX_FRAME_SIZE = 1400;
+
+	// Frames go out with Transport::sendOnChannel(channel, ...). The default channel
+	// (type 0) is plain broadcast; give each aggregator its own message type when the
+	// transport routes types to different multicast groups.
+	MessageAggregator(Transport& transport, std::chrono::milliseconds maxDelay,
+		size_t maxFrameSize = DEFAULT_MAX_FRAME_SIZE, MessageType channel = static_cast<MessageType>(0));
+
+	// Queues one encoded message. May first send the pending frame if this one would
+	// not fit. Returns false only if a send failed or the message can never fit.
+	bool add(const void* message, size_t size);
+
+	// Sends the pending frame if its oldest message has waited long enough.
+	bool flushIfDue(std::chrono::steady_clock::time_point now);
+
+	// Sends the pending frame now (no-op if empty).
+	bool flush();
+
+	// --- Counters ---
+	uint64_t getFramesSent() const { return m_framesSent; }
+	uint64_t getMessagesSent() const { return m_messagesSent; }
+
+	// Disable copy and assignment
+	MessageAggregator(const MessageAggregator&) = delete;
+	MessageAggregator& operator=(const MessageAggregator&) = delete;
+
+private:
+	static constexpr size_t MAX_FRAME_BUFFER = 2048;
+
+	Transport& m_transport;
+	std::chrono::milliseconds m_maxDelay;
+	size_t m_maxFrameSize;
+	MessageType m_channel;
+
+	uint8_t m_frame[MAX_FRAME_BUFFER] = {};
+	size_t m_frameSize = MessageFrame::HEADER_SIZE; // Bytes used, including the header
+	size_t m_recordCount = 0;
+	std::chrono::steady_clock::time_point m_oldestPending;
+
+	uint64_t m_framesSent = 0;
+	uint64_t m_messagesSent = 0;
+};
+
+#endif // MESSAGE_FRAME_H
@@ -0,0 +1,197 @@
+// MessageRegistry.h
+#ifndef MESSAGE_REGISTRY_H
+#define MESSAGE_REGISTRY_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "PacketPool.h" // PacketView
+#include "SocketPlatform.h" // sockaddr_in
+#include "TdlCodec.h"
+#include "TdlMessages.h"
+
+// --- Message Traits ---
+// What the receive path needs to know about one message struct, all at compile
+// time: its MessageType, the exact size of its raw wire form, and a name for logs.
+// The defaults come from the struct itself (MESSAGE_TYPE, MESSAGE_NAME, sizeof);
+// specialise this for a message whose raw wire size differs from its struct.
+template <typename Message>
+struct MessageTraits
+{
+	static_assert(std::is_trivially_copyable<Message>::value, "Raw messages are read straight out of receive buffers");
+
+	static constexpr MessageType TYPE = Message::MESSAGE_TYPE;
+	static constexpr size_t WIRE_SIZE = sizeof(Message);
+	static constexpr const char* NAME = Message::MESSAGE_NAME;
+};
+
+template <typename... Messages>
+struct MessageList
+{
+};
+
+// Every message this build understands. Adding a type means listing it here,
+// giving it TdlCodec encode/decode overloads, and giving each handler an
+// onMessage() overload for it; forgetting the last one is a compile error.
+using RegisteredMessages = MessageList<PositionReport, HeartbeatMessage, TextMessage, SyncRequest, SyncResponse, TextNack>;
+
+// --- Dispatch Table ---
+// A dense table indexed by MessageType, built at compile time from a MessageList.
+// Each entry holds the type's wire size and two plain function pointers: one that
+// hands a raw struct message straight out of the receive buffer to
+// handler.onMessage(const Message&, const sockaddr_in&), and one that decodes the
+// compact form onto the stack first. Dispatch is one bounds check, one size check
+// and one indirect call, whatever the number of types; nothing is virtual and the
+// handler's overloads are resolved when the table is built.
+//
+// Only a message that passed those checks reaches handler.admit(const
+// MessageHeader&), which may still turn it away (a duplicate) before onMessage().
+// So nothing the handler tracks per sender is touched by a malformed message.
+enum class DispatchResult
+{
+	Handled,
+	UnknownType,  // No registered message has this type
+	SizeMismatch  // Known type, but the bytes don't have its size (or don't decode)
+};
+
+template <typename Handler, typename List>
+class MessageDispatchTable;
+
+template <typename Handler, typename... Messages>
+class MessageDispatchTable<Handler, MessageList<Messages...>>
+{
+public:
+	static constexpr uint32_t MAX_TYPE = [] {
+		uint32_t types[] = { static_cast<uint32_t>(MessageTraits<Messages>::TYPE)... };
+		uint32_t highest = 0;
+		for (uint32_t type : types)
+		{
+			highest = type > highest ? type : highest;
+		}
+		return highest;
+	}();
+
+	// The raw struct form, already bounds-checked to hold a MessageHeader.
+	static DispatchResult dispatchRaw(const Handler& handler, uint32_t type, PacketView view, const sockaddr_in& senderAddress)
+	{
+		const Entry* entry = find(type);
+		if (!entry)
+		{
+			return DispatchResult::UnknownType;
+		}
+		if (view.size != entry->wireSize)
+		{
+			return DispatchResult::SizeMismatch;
+		}
+		entry->raw(handler, view, senderAddress);
+		return DispatchResult::Handled;
+	}
+
+	// The compact form (see TdlCodec.h); 'type' comes from its decoded header.
+	static DispatchResult dispatchCompact(const Handler& handler, uint32_t type, PacketView view, const sockaddr_in& senderAddress)
+	{
+		const Entry* entry = find(type);
+		if (!entry)
+		{
+			return DispatchResult::UnknownType;
+		}
+		return entry->compact(handler, view, senderAddress) ? DispatchResult::Handled : DispatchResult::SizeMismatch;
+	}
+
+	static size_t wireSizeOf(uint32_t type)
+	{
+		const Entry* entry = find(type);
+		return entry ? entry->wireSize : 0;
+	}
+
+	static const char* nameOf(uint32_t type)
+	{
+		const Entry* entry = find(type);
+		return entry ? entry->name : "Unknown";
+	}
+
+private:
+	using RawThunk = void (*)(const Handler& handler, PacketView view, const sockaddr_in& senderAddress);
+	using CompactThunk = bool (*)(const Handler& handler, PacketView view, const sockaddr_in& senderAddress);
+
+	struct Entry
+	{
+		const char* name = nullptr;
+		size_t wireSize = 0;
+		RawThunk raw = nullptr;         // Null for type numbers nothing is registered under
+		CompactThunk compact = nullptr;
+	};
+
+	static constexpr bool typesAreDistinct()
+	{
+		uint32_t types[] = { static_cast<uint32_t>(MessageTraits<Messages>::TYPE)... };
+		for (size_t i = 0; i < sizeof...(Messages); ++i)
+		{
+			if (types[i] == 0)
+			{
+				return false; // Zero is a default-constructed header, never a real type
+			}
+			for (size_t j = i + 1; j < sizeof...(Messages); ++j)
+			{
+				if (types[i] == types[j])
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	template <typename Message>
+	static void invokeRaw(const Handler& handler, PacketView view, const sockaddr_in& senderAddress)
+	{
+		// dispatchRaw() has checked the size, so the struct can be read in place.
+		const Message& message = *view.as<Message>();
+		if (handler.admit(message.header))
+		{
+			handler.onMessage(message, senderAddress);
+		}
+	}
+
+	template <typename Message>
+	static bool invokeCompact(const Handler& handler, PacketView view, const sockaddr_in& senderAddress)
+	{
+		Message message;
+		if (!TdlCodec::decode(view.data, view.size, message))
+		{
+			return false;
+		}
+		if (handler.admit(message.header))
+		{
+			handler.onMessage(message, senderAddress);
+		}
+		return true;
+	}
+
+	static constexpr std::array<Entry, MAX_TYPE + 1> buildEntries()
+	{
+		// The compact header carries the type in one byte, and the table is dense.
+		static_assert(MAX_TYPE <= 0xFF, "Message types must fit the compact header's type byte");
+		static_assert(typesAreDistinct(), "Registered messages need distinct, non-zero MessageTypes");
+
+		std::array<Entry, MAX_TYPE + 1> entries{};
+		((entries[MessageTraits<Messages>::TYPE] = Entry{ MessageTraits<Messages>::NAME, MessageTraits<Messages>::WIRE_SIZE,
+			&invokeRaw<Messages>, &invokeCompact<Messages> }), ...);
+		return entries;
+	}
+
+	static const std::array<Entry, MAX_TYPE + 1> s_entries;
+
+	static const Entry* find(uint32_t type)
+	{
+		return (type <= MAX_TYPE && s_entries[type].raw) ? &s_entries[type] : nullptr;
+	}
+};
+
+// Defined outside the class: buildEntries() can only run once the class is complete.
+template <typename Handler, typename... Messages>
+constexpr std::array<typename MessageDispatchTable<Handler, MessageList<Messages...>>::Entry, MessageDispatchTable<Handler, MessageList<Messages...>>::MAX_TYPE + 1>
+	MessageDispatchTable<Handler, MessageList<Messages...>>::s_entries = MessageDispatchTable<Handler, MessageList<Messages...>>::buildEntries();
+
+#endif // MESSAGE_REGISTRY_H
@@ -0,0 +1,196 @@
+// MessageRing.h
+#ifndef MESSAGE_RING_H
+#define MESSAGE_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// --- Overflow Policy ---
+// What a bounded queue does when something arrives while it is full.
+enum class OverflowPolicy
+{
+	DropNewest, // Reject the new item; what is queued keeps its order (default)
+	DropOldest  // Evict the oldest queued item to make room; the queue favours fresh data
+};
+
+// --- Message Ring Counters ---
+struct MessageRingCounters
+{
+	uint64_t pushed = 0;         // Accepted records
+	uint64_t popped = 0;         // Records handed to the consumer
+	uint64_t droppedNewest = 0;  // Rejected because the ring was full (DropNewest)
+	uint64_t droppedOldest = 0;  // Evicted to make room (DropOldest)
+};
+
+// --- Message Ring ---
+// Bounded lock-free queue of fixed-size records (Vyukov's array queue). Every cell
+// carries a sequence number that tells producers and consumers whether it is free
+// or filled for their lap of the ring, so push and pop are one CAS on a shared
+// index plus a copy: no locks, no allocation after construction, and neither side
+// can be stalled by the other.
+//
+// Safe for any number of producers and consumers, so it covers the SPSC case
+// (reactor -> handler) and MPSC (several receive workers -> handler) alike.
+// T must be copy-assignable; records are copied in and out.
+template <typename T>
+class MessageRing
+{
+public:
+	// 'capacity' is rounded up to a power of two.
+	explicit MessageRing(size_t capacity, OverflowPolicy policy = OverflowPolicy::DropNewest) :
+		m_policy(policy)
+	{
+		size_t rounded = 2;
+		while (rounded < capacity)
+		{
+			rounded <<= 1;
+		}
+		m_mask = rounded - 1;
+		m_cells.reset(new Cell[rounded]);
+		for (size_t i = 0; i < rounded; ++i)
+		{
+			m_cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	// Queues a copy of 'record'. Never blocks. Returns false only if the record was
+	// dropped (DropNewest on a full ring).
+	bool push(const T& record)
+	{
+		while (true)
+		{
+			if (tryPush(record))
+			{
+				m_pushed.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+			if (m_policy == OverflowPolicy::DropNewest)
+			{
+				m_droppedNewest.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+
+			// DropOldest: act as a consumer for one record, then try again. If the
+			// real consumer got there first, the retry simply finds the free cell.
+			T evicted;
+			if (tryPop(evicted))
+			{
+				m_droppedOldest.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// Takes the oldest record into 'out'. Returns false if the ring is empty.
+	bool pop(T& out)
+	{
+		if (!tryPop(out))
+		{
+			return false;
+		}
+		m_popped.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	// Approximate when producers or consumers are active.
+	bool empty() const
+	{
+		return m_enqueuePos.load(std::memory_order_acquire) == m_dequeuePos.load(std::memory_order_acquire);
+	}
+
+	size_t capacity() const { return m_mask + 1; }
+	OverflowPolicy getPolicy() const { return m_policy; }
+
+	MessageRingCounters getCounters() const
+	{
+		MessageRingCounters counters;
+		counters.pushed = m_pushed.load(std::memory_order_relaxed);
+		counters.popped = m_popped.load(std::memory_order_relaxed);
+		counters.droppedNewest = m_droppedNewest.load(std::memory_order_relaxed);
+		counters.droppedOldest = m_droppedOldest.load(std::memory_order_relaxed);
+		return counters;
+	}
+
+	// Disable copy and assignment
+	MessageRing(const MessageRing&) = delete;
+	MessageRing& operator=(const MessageRing&) = delete;
+
+private:
+	struct Cell
+	{
+		std::atomic<size_t> sequence{ 0 }; // == position: free for that push; == position + 1: filled
+		T value;
+	};
+
+	bool tryPush(const T& record)
+	{
+		size_t position = m_enqueuePos.load(std::memory_order_relaxed);
+		while (true)
+		{
+			Cell& cell = m_cells[position & m_mask];
+			size_t sequence = cell.sequence.load(std::memory_order_acquire);
+			intptr_t lap = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+			if (lap == 0)
+			{
+				if (m_enqueuePos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					cell.value = record;
+					cell.sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (lap < 0)
+			{
+				return false; // Full: this cell still holds last lap's record
+			}
+			else
+			{
+				position = m_enqueuePos.load(std::memory_order_relaxed); // Another producer won; catch up
+			}
+		}
+	}
+
+	bool tryPop(T& out)
+	{
+		size_t position = m_dequeuePos.load(std::memory_order_relaxed);
+		while (true)
+		{
+			Cell& cell = m_cells[position & m_mask];
+			size_t sequence = cell.sequence.load(std::memory_order_acquire);
+			intptr_t lap = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+			if (lap == 0)
+			{
+				if (m_dequeuePos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					out = cell.value;
+					cell.sequence.store(position + m_mask + 1, std::memory_order_release); // Free for next lap
+					return true;
+				}
+			}
+			else if (lap < 0)
+			{
+				return false; // Empty: this cell has not been filled yet
+			}
+			else
+			{
+				position = m_dequeuePos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	OverflowPolicy m_policy;
+	size_t m_mask = 0;
+	std::unique_ptr<Cell[]> m_cells;
+
+	// Producer and consumer indices on separate cache lines.
+	alignas(64) std::atomic<size_t> m_enqueuePos{ 0 };
+	alignas(64) std::atomic<size_t> m_dequeuePos{ 0 };
+
+	alignas(64) std::atomic<uint64_t> m_pushed{ 0 };
+	std::atomic<uint64_t> m_popped{ 0 };
+	std::atomic<uint64_t> m_droppedNewest{ 0 };
+	std::atomic<uint64_t> m_droppedOldest{ 0 };
+};
+
+#endif // MESSAGE_RING_H
@@ -0,0 +1,43 @@
+// MessageSequencer.h
+#ifndef MESSAGE_SEQUENCER_H
+#define MESSAGE_SEQUENCER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "TdlMessages.h"
+
+// --- Message Sequencer ---
+// Stamps outgoing headers with the next sequence number and the send time. One
+// sequencer per source node ID, shared by everything that sends as that node
+// (the send timer, NodeSync...), so the receiver sees one unbroken sequence
+// whatever the message types. Thread-safe.
+class MessageSequencer
+{
+public:
+	void stamp(MessageHeader& header)
+	{
+		uint32_t sequence = m_next.fetch_add(1, std::memory_order_relaxed);
+		if (sequence == 0)
+		{
+			sequence = m_next.fetch_add(1, std::memory_order_relaxed); // 0 means "not sequenced"; skip it on wrap
+		}
+		header.sequenceNumber = sequence;
+		header.sendTimeUs = wallClockMicros();
+	}
+
+	// The sender's half of a one-way latency measurement. Only the low 32 bits go on
+	// the wire: the receiver subtracts modulo 2^32, which is exact for any delay
+	// under half the wrap (about 35 minutes). Needs the two clocks to be in sync
+	// (NTP/PTP); the difference includes any offset between them.
+	static uint32_t wallClockMicros()
+	{
+		auto sinceEpoch = std::chrono::system_clock::now().time_since_epoch();
+		return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(sinceEpoch).count());
+	}
+
+private:
+	std::atomic<uint32_t> m_next{ 1 };
+};
+
+#endif // MESSAGE_SEQUENCER_H
@@ -0,0 +1,282 @@
+// Metrics.cpp
+#include "Metrics.h"
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Logger.h"
+
+static constexpr size_t COUNTER_COUNT = static_cast<size_t>(MetricCounter::COUNT);
+static constexpr size_t HISTOGRAM_COUNT = static_cast<size_t>(MetricHistogram::COUNT);
+
+// --- Per-Thread Blocks ---
+// One per thread that has ever recorded anything. Blocks are never freed, so the
+// counts of threads that have exited still show up in every report.
+struct alignas(64) ThreadMetrics
+{
+	std::array<std::atomic<uint64_t>, COUNTER_COUNT> counters{};
+	std::array<LatencyHistogram, HISTOGRAM_COUNT> histograms;
+};
+
+static std::mutex& registryMutex()
+{
+	static std::mutex mutex;
+	return mutex;
+}
+
+static std::vector<std::unique_ptr<ThreadMetrics>>& registry()
+{
+	static std::vector<std::unique_ptr<ThreadMetrics>> blocks;
+	return blocks;
+}
+
+static ThreadMetrics& localMetrics()
+{
+	thread_local ThreadMetrics* local = nullptr;
+	if (local == nullptr)
+	{
+		// First record on this thread: the only time the registry is locked by a writer.
+		std::unique_ptr<ThreadMetrics> block = std::make_unique<ThreadMetrics>();
+		local = block.get();
+		std::lock_guard<std::mutex> lock(registryMutex());
+		registry().push_back(std::move(block));
+	}
+	return *local;
+}
+
+// Single-writer increment: a plain load and store, no locked instruction.
+static void bump(std::atomic<uint64_t>& value, uint64_t amount)
+{
+	value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+// --- LatencyHistogram ---
+
+static unsigned highestBit(uint64_t value)
+{
+	unsigned bit = 0;
+	for (unsigned step = 32; step > 0; step >>= 1)
+	{
+		if (value >> (bit + step))
+		{
+			bit += step;
+		}
+	}
+	return bit;
+}
+
+size_t LatencyHistogram::bucketIndex(uint64_t valueNs)
+{
+	if (valueNs < SUB_BUCKETS)
+	{
+		return static_cast<size_t>(valueNs);
+	}
+	unsigned magnitude = highestBit(valueNs);
+	if (magnitude > MAX_MAGNITUDE)
+	{
+		return BUCKET_COUNT - 1;
+	}
+	// Group 1 holds [16, 32), group 2 [32, 64), ...; the bits below the top one pick the sub-bucket.
+	size_t group = magnitude - SUB_BUCKET_BITS + 1;
+	size_t subBucket = static_cast<size_t>((valueNs >> (magnitude - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+	return group * SUB_BUCKETS + subBucket;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index)
+{
+	if (index < SUB_BUCKETS)
+	{
+		return index;
+	}
+	size_t group = index / SUB_BUCKETS;
+	uint64_t subBucket = index % SUB_BUCKETS;
+	unsigned shift = static_cast<unsigned>(group - 1);
+	return ((SUB_BUCKETS + subBucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t valueNs)
+{
+	bump(m_buckets[bucketIndex(valueNs)], 1);
+}
+
+void LatencyHistogram::mergeInto(std::array<uint64_t, BUCKET_COUNT>& total) const
+{
+	for (size_t i = 0; i < BUCKET_COUNT; ++i)
+	{
+		total[i] += m_buckets[i].load(std::memory_order_relaxed);
+	}
+}
+
+// --- Metrics ---
+
+void Metrics::increment(MetricCounter counter, uint64_t amount)
+{
+	bump(localMetrics().counters[static_cast<size_t>(counter)], amount);
+}
+
+uint64_t Metrics::threadCount(MetricCounter counter)
+{
+	return localMetrics().counters[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+}
+
+void Metrics::recordLatency(MetricHistogram histogram, uint64_t valueNs)
+{
+	localMetrics().histograms[static_cast<size_t>(histogram)].record(valueNs);
+}
+
+// Reduces merged bucket counts to a count, a few percentiles and the maximum.
+static HistogramSummary summarize(const std::array<uint64_t, LatencyHistogram::BUCKET_COUNT>& buckets)
+{
+	HistogramSummary summary;
+	for (uint64_t count : buckets)
+	{
+		summary.count += count;
+	}
+	if (summary.count == 0)
+	{
+		return summary;
+	}
+
+	// Rank of each percentile, rounded up (so p99 of 10 samples is the 10th).
+	uint64_t rank50 = (summary.count * 50 + 99) / 100;
+	uint64_t rank90 = (summary.count * 90 + 99) / 100;
+	uint64_t rank99 = (summary.count * 99 + 99) / 100;
+	uint64_t seen = 0;
+	for (size_t i = 0; i < buckets.size(); ++i)
+	{
+		if (buckets[i] == 0)
+		{
+			continue;
+		}
+		uint64_t before = seen;
+		seen += buckets[i];
+		uint64_t upper = LatencyHistogram::bucketUpperBound(i);
+		if (before < rank50 && seen >= rank50) summary.p50Ns = upper;
+		if (before < rank90 && seen >= rank90) summary.p90Ns = upper;
+		if (before < rank99 && seen >= rank99) summary.p99Ns = upper;
+		summary.maxNs = upper;
+	}
+	return summary;
+}
+
+MetricsSnapshot Metrics::snapshot()
+{
+	MetricsSnapshot result;
+	std::lock_guard<std::mutex> lock(registryMutex());
+
+	for (const std::unique_ptr<ThreadMetrics>& block : registry())
+	{
+		for (size_t i = 0; i < COUNTER_COUNT; ++i)
+		{
+			result.counters[i] += block->counters[i].load(std::memory_order_relaxed);
+		}
+	}
+
+	std::array<uint64_t, LatencyHistogram::BUCKET_COUNT> merged;
+	for (size_t h = 0; h < HISTOGRAM_COUNT; ++h)
+	{
+		merged.fill(0);
+		for (const std::unique_ptr<ThreadMetrics>& block : registry())
+		{
+			block->histograms[h].mergeInto(merged);
+		}
+		result.histograms[h] = summarize(merged);
+	}
+	return result;
+}
+
+void Metrics::dump()
+{
+	MetricsSnapshot metrics = snapshot();
+
+	TDL_LOG_REPORT << "\n===== Metrics =====";
+	for (size_t i = 0; i < COUNTER_COUNT; ++i)
+	{
+		TDL_LOG_REPORT << "  " << counterName(static_cast<MetricCounter>(i)) << ": " << metrics.counters[i];
+	}
+	for (size_t h = 0; h < HISTOGRAM_COUNT; ++h)
+	{
+		const HistogramSummary& summary = metrics.histograms[h];
+		TDL_LOG_REPORT << "  " << histogramName(static_cast<MetricHistogram>(h)) << " (us): n=" << summary.count
+			<< " p50=" << summary.p50Ns / 1000.0 << " p90=" << summary.p90Ns / 1000.0
+			<< " p99=" << summary.p99Ns / 1000.0 << " max=" << summary.maxNs / 1000.0;
+	}
+	TDL_LOG_REPORT << "===================";
+}
+
+bool Metrics::exportJsonLine(const std::string& path)
+{
+	MetricsSnapshot metrics = snapshot();
+
+	FILE* file = fopen(path.c_str(), "a");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	long long timestampMs = static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count());
+	fprintf(file, "{\"timestampMs\":%lld,\"counters\":{", timestampMs);
+	for (size_t i = 0; i < COUNTER_COUNT; ++i)
+	{
+		fprintf(file, "%s\"%s\":%llu", i ? "," : "", counterName(static_cast<MetricCounter>(i)),
+			static_cast<unsigned long long>(metrics.counters[i]));
+	}
+	fprintf(file, "},\"histogramsNs\":{");
+	for (size_t h = 0; h < HISTOGRAM_COUNT; ++h)
+	{
+		const HistogramSummary& summary = metrics.histograms[h];
+		fprintf(file, "%s\"%s\":{\"count\":%llu,\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,\"max\":%llu}",
+			h ? "," : "", histogramName(static_cast<MetricHistogram>(h)),
+			static_cast<unsigned long long>(summary.count), static_cast<unsigned long long>(summary.p50Ns),
+			static_cast<unsigned long long>(summary.p90Ns), static_cast<unsigned long long>(summary.p99Ns),
+			static_cast<unsigned long long>(summary.maxNs));
+	}
+	fprintf(file, "}}\n");
+
+	bool ok = !ferror(file);
+	fclose(file);
+	return ok;
+}
+
+const char* Metrics::counterName(MetricCounter counter)
+{
+	switch (counter)
+	{
+		case MetricCounter::PacketsReceived: return "PacketsReceived";
+		case MetricCounter::BytesReceived: return "BytesReceived";
+		case MetricCounter::PacketsDropped: return "PacketsDropped";
+		case MetricCounter::MalformedPackets: return "MalformedPackets";
+		case MetricCounter::SizeMismatches: return "SizeMismatches";
+		case MetricCounter::UnknownMessageTypes: return "UnknownMessageTypes";
+		case MetricCounter::PacketsSent: return "PacketsSent";
+		case MetricCounter::BytesSent: return "BytesSent";
+		case MetricCounter::SendFailures: return "SendFailures";
+		case MetricCounter::NodesAdded: return "NodesAdded";
+		case MetricCounter::NodesTimedOut: return "NodesTimedOut";
+		case MetricCounter::NodesRejected: return "NodesRejected";
+		case MetricCounter::SequenceGaps: return "SequenceGaps";
+		case MetricCounter::MessagesReordered: return "MessagesReordered";
+		case MetricCounter::DuplicateMessages: return "DuplicateMessages";
+		case MetricCounter::StalePositionsRejected: return "StalePositionsRejected";
+		case MetricCounter::InvalidPositions: return "InvalidPositions";
+		case MetricCounter::AuthFailures: return "AuthFailures";
+		case MetricCounter::ReplaysRejected: return "ReplaysRejected";
+		case MetricCounter::RateLimited: return "RateLimited";
+		default: return "Unknown";
+	}
+}
+
+const char* Metrics::histogramName(MetricHistogram histogram)
+{
+	switch (histogram)
+	{
+		case MetricHistogram::ReceiveToUpdate: return "ReceiveToUpdate";
+		case MetricHistogram::ShardLockWait: return "ShardLockWait";
+		case MetricHistogram::ShardLockHold: return "ShardLockHold";
+		case MetricHistogram::PruneDuration: return "PruneDuration";
+		case MetricHistogram::SendTickJitter: return "SendTickJitter";
+		case MetricHistogram::OneWayLatency: return "OneWayLatency";
+		default: return "Unknown";
+	}
+}
@@ -0,0 +1,148 @@
+// Metrics.h
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// --- Metrics ---
+// Always-on, low-overhead counters and latency histograms. Every thread records
+// into its own block (relaxed atomics, written by that thread only, so no cache
+// line is ever shared between writers); a reader merges all blocks when it wants
+// a report. Recording is one or two uncontended stores; nothing locks or allocates
+// after a thread's first use.
+//
+//   Metrics::increment(MetricCounter::SendFailures);
+//   Metrics::recordLatency(MetricHistogram::PruneDuration, elapsed);
+
+enum class MetricCounter : size_t
+{
+	PacketsReceived,
+	BytesReceived,
+	PacketsDropped,       // Lost between the socket and the handlers (full queues)
+	MalformedPackets,     // Too small, or a bad frame
+	SizeMismatches,       // Known message type with the wrong length
+	UnknownMessageTypes,  // Well-formed header, but a type this build has no handler for
+	PacketsSent,
+	BytesSent,
+	SendFailures,
+	NodesAdded,
+	NodesTimedOut,
+	NodesRejected,          // New nodes turned away because the table was at --max-nodes
+	SequenceGaps,           // Sequence numbers skipped by any sender; minus MessagesReordered, that is the loss
+	MessagesReordered,      // Arrived after a higher-numbered message from the same sender
+	DuplicateMessages,      // Dropped: a sequence number already seen, or a whole window behind
+	StalePositionsRejected, // Position reports older than the position already stored
+	InvalidPositions,       // Position reports with a non-finite or off-Earth latitude, longitude or altitude
+	AuthFailures,           // With --auth-key: datagrams with a missing or wrong tag, or a header naming another sender
+	ReplaysRejected,        // With --auth-key: authenticated, but a sequence already seen or too far from our clock
+	RateLimited,            // With --auth-key: authenticated, but over their sender's rate
+	COUNT
+};
+
+enum class MetricHistogram : size_t
+{
+	ReceiveToUpdate,      // Datagram dequeued from the socket -> node table updated
+	ShardLockWait,        // Waiting to acquire a NodeManager shard lock
+	ShardLockHold,        // Holding a NodeManager shard lock
+	PruneDuration,        // One pruneTimeouts() sweep
+	SendTickJitter,       // How far a send tick strayed from its nominal period
+	OneWayLatency,        // Sender's wall clock at send -> ours at receive (needs synced clocks)
+	COUNT
+};
+
+// --- Latency Histogram ---
+// HDR-style log-linear buckets over nanoseconds: values below SUB_BUCKETS get
+// their own bucket, and every power of two above is split into SUB_BUCKETS equal
+// parts, so any recorded value is reported within ~6% (1/16). Covers values below
+// 2^(MAX_MAGNITUDE + 1) ns (about 36 minutes); larger ones land in the last bucket.
+class LatencyHistogram
+{
+public:
+	static constexpr unsigned SUB_BUCKET_BITS = 4;
+	static constexpr uint64_t SUB_BUCKETS = 1ull << SUB_BUCKET_BITS;
+	static constexpr unsigned MAX_MAGNITUDE = 40;
+	static constexpr size_t BUCKET_COUNT = (MAX_MAGNITUDE - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+	// Single writer: only the owning thread calls record().
+	void record(uint64_t valueNs);
+
+	// Adds this histogram's counts into 'total' (any thread).
+	void mergeInto(std::array<uint64_t, BUCKET_COUNT>& total) const;
+
+	static size_t bucketIndex(uint64_t valueNs);
+	static uint64_t bucketUpperBound(size_t index); // Largest value that maps to 'index'
+
+private:
+	std::array<std::atomic<uint64_t>, BUCKET_COUNT> m_buckets{};
+};
+
+// Merged view of one histogram.
+struct HistogramSummary
+{
+	uint64_t count = 0;
+	uint64_t p50Ns = 0;
+	uint64_t p90Ns = 0;
+	uint64_t p99Ns = 0;
+	uint64_t maxNs = 0;
+};
+
+// Merged view of everything.
+struct MetricsSnapshot
+{
+	std::array<uint64_t, static_cast<size_t>(MetricCounter::COUNT)> counters{};
+	std::array<HistogramSummary, static_cast<size_t>(MetricHistogram::COUNT)> histograms{};
+};
+
+class Metrics
+{
+public:
+	static void increment(MetricCounter counter, uint64_t amount = 1);
+	static void recordLatency(MetricHistogram histogram, uint64_t valueNs);
+	static void recordLatency(MetricHistogram histogram, std::chrono::steady_clock::duration elapsed)
+	{
+		recordLatency(histogram, elapsed.count() > 0
+			? static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) : 0);
+	}
+
+	// The calling thread's own count, without the other threads' (cheap: no lock).
+	static uint64_t threadCount(MetricCounter counter);
+
+	// Merges every thread's block. Safe to call from any thread at any time.
+	static MetricsSnapshot snapshot();
+
+	// Prints a snapshot through the logger.
+	static void dump();
+
+	// Appends a snapshot as one JSON line to 'path'. Returns false if the file can't be written.
+	static bool exportJsonLine(const std::string& path);
+
+	static const char* counterName(MetricCounter counter);
+	static const char* histogramName(MetricHistogram histogram);
+};
+
+// --- Scoped Latency ---
+// Records the time from construction to destruction into one histogram.
+class ScopedLatency
+{
+public:
+	explicit ScopedLatency(MetricHistogram histogram) :
+		m_histogram(histogram),
+		m_start(std::chrono::steady_clock::now())
+	{
+	}
+	~ScopedLatency() { Metrics::recordLatency(m_histogram, std::chrono::steady_clock::now() - m_start); }
+
+	ScopedLatency(const ScopedLatency&) = delete;
+	ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+private:
+	MetricHistogram m_histogram;
+	std::chrono::steady_clock::time_point m_start;
+};
+
+#endif // METRICS_H
@@ -1,37 +1,55 @@
 // NetworkManager.cpp
 #include "NetworkManager.h"
-#include <iostream>
 #include <stdexcept> // Could use for exceptions on critical init failure
+#include <cerrno>
+#include <utility>
+#include "Logger.h"
+#include "Metrics.h"
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/time.h> // timeval, for SO_RCVTIMEO
+#include <unistd.h>
+#endif
 
-#pragma comment(lib, "Ws2_32.lib") // Link Winsock library
-
-NetworkManager::NetworkManager(uint16_t port, const char* broadcastAddress, int receiveTimeoutMs) :
-	m_port(port)
+// Undoes WSAStartup() on a failed setup; nothing to undo on POSIX.
+static void cleanupWinsock()
 {
+#if defined(_WIN32)
+	WSACleanup();
+#endif
+}
 
+NetworkManager::NetworkManager(uint16_t port, const char* broadcastAddress, int receiveTimeoutMs, size_t heldPackets) :
+	m_port(port),
+	m_receiveTimeoutMs(receiveTimeoutMs),
+	m_packetPool(poolSlotsFor(heldPackets), RECEIVE_BUFFER_SIZE)
+{
+#if defined(_WIN32)
 	// 1. Initialize Winsock
 	int iResult = WSAStartup(MAKEWORD(2, 2), &m_wsaData);
 	if (iResult != 0)
 	{
-		std::cerr << "[NetMgr] WSAStartup failed: " << iResult << std::endl;
+		TDL_LOG_ERROR << "[NetMgr] WSAStartup failed: " << iResult;
 		return; // m_initialized remains false
 	}
+#endif
 
 	// --- Setup Send Socket ---
 	m_sendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
 	if (m_sendSocket == INVALID_SOCKET)
 	{
-		std::cerr << "[NetMgr] Send socket creation failed: " << WSAGetLastError() << std::endl;
-		WSACleanup();
+		TDL_LOG_ERROR << "[NetMgr] Send socket creation failed: " << lastSocketError();
+		cleanupWinsock();
 		return;
 	}
 
-	BOOL broadcastOption = TRUE;
+	int broadcastOption = 1;
 	if (setsockopt(m_sendSocket, SOL_SOCKET, SO_BROADCAST, (char*)&broadcastOption, sizeof(broadcastOption)) == SOCKET_ERROR)
 	{
-		std::cerr << "[NetMgr] setsockopt(SO_BROADCAST) failed: " << WSAGetLastError() << std::endl;
+		TDL_LOG_ERROR << "[NetMgr] setsockopt(SO_BROADCAST) failed: " << lastSocketError();
 		closesocket(m_sendSocket);
-		WSACleanup();
+		cleanupWinsock();
 		return;
 	}
 
@@ -40,9 +58,9 @@ NetworkManager::NetworkManager(uint16_t port, const char* broadcastAddress, int
 	m_broadcastAddr.sin_port = htons(m_port);
 	if (inet_pton(AF_INET, broadcastAddress, &m_broadcastAddr.sin_addr) != 1)
 	{
-		std::cerr << "[NetMgr] inet_pton failed for broadcast address: " << WSAGetLastError() << std::endl;
+		TDL_LOG_ERROR << "[NetMgr] inet_pton failed for broadcast address: " << lastSocketError();
 		closesocket(m_sendSocket);
-		WSACleanup();
+		cleanupWinsock();
 		return;
 	}
 
@@ -51,20 +69,31 @@ NetworkManager::NetworkManager(uint16_t port, const char* broadcastAddress, int
 	m_recvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
 	if (m_recvSocket == INVALID_SOCKET)
 	{
-		std::cerr << "[NetMgr] Receive socket creation failed: " << WSAGetLastError() << std::endl;
+		TDL_LOG_ERROR << "[NetMgr] Receive socket creation failed: " << lastSocketError();
 		closesocket(m_sendSocket); // Clean up send socket too
-		WSACleanup();
+		cleanupWinsock();
 		return;
 	}
 
-	BOOL reuseAddr = TRUE;
+	int reuseAddr = 1;
 	setsockopt(m_recvSocket, SOL_SOCKET, SO_REUSEADDR, (char*)&reuseAddr, sizeof(reuseAddr)); // Optional, often helpful
+#if defined(SO_REUSEPORT)
+	// Lets several processes on one host bind the TDL port at once (co-located
+	// nodes, or one receiver per core); each still gets every broadcast.
+	setsockopt(m_recvSocket, SOL_SOCKET, SO_REUSEPORT, (char*)&reuseAddr, sizeof(reuseAddr));
+#endif
 
-	// Set receive timeout
+	// Set receive timeout (a DWORD of milliseconds for Winsock, a timeval for POSIX)
+#if defined(_WIN32)
 	DWORD timeout = static_cast<DWORD>(receiveTimeoutMs);
+#else
+	timeval timeout = {};
+	timeout.tv_sec = receiveTimeoutMs / 1000;
+	timeout.tv_usec = (receiveTimeoutMs % 1000) * 1000;
+#endif
 	if (setsockopt(m_recvSocket, SOL_SOCKET, SO_RCVTIMEO, (char*)&timeout, sizeof(timeout)) == SOCKET_ERROR)
 	{
-		std::cerr << "[NetMgr] setsockopt(SO_RCVTIMEO) failed: " << WSAGetLastError() << std::endl;
+		TDL_LOG_ERROR << "[NetMgr] setsockopt(SO_RCVTIMEO) failed: " << lastSocketError();
 		// Continue anyway? Or treat as fatal? Let's continue for now.
 	}
 
@@ -74,24 +103,110 @@ NetworkManager::NetworkManager(uint16_t port, const char* broadcastAddress, int
 	recvAddr.sin_family = AF_INET;
 	recvAddr.sin_port = htons(m_port);
 	recvAddr.sin_addr.s_addr = INADDR_ANY;
-	if (bind(m_recvSocket, (SOCKADDR*)&recvAddr, sizeof(recvAddr)) == SOCKET_ERROR)
+	if (bind(m_recvSocket, (sockaddr*)&recvAddr, sizeof(recvAddr)) == SOCKET_ERROR)
 	{
-		std::cerr << "[NetMgr] Bind failed: " << WSAGetLastError() << std::endl;
+		TDL_LOG_ERROR << "[NetMgr] Bind failed: " << lastSocketError();
 		closesocket(m_recvSocket);
 		closesocket(m_sendSocket);
-		WSACleanup();
+		cleanupWinsock();
 		return;
 	}
 
+	// --- Setup Batched Receive Path ---
+#if defined(_WIN32)
+	// Associate the receive socket with a completion port and keep a ring of
+	// overlapped receives posted, so datagrams land in our buffers while we are busy
+	// and a single GetQueuedCompletionStatusEx call can harvest many of them.
+	m_completionPort = CreateIoCompletionPort(reinterpret_cast<HANDLE>(m_recvSocket), nullptr, 0, 1);
+	if (m_completionPort == nullptr)
+	{
+		TDL_LOG_ERROR << "[NetMgr] CreateIoCompletionPort failed: " << GetLastError();
+		closesocket(m_recvSocket);
+		closesocket(m_sendSocket);
+		cleanupWinsock();
+		return;
+	}
+
+	m_receiveRing.resize(MAX_BATCH_SIZE);
+	for (ReceiveSlot& slot : m_receiveRing)
+	{
+		if (!postReceive(slot))
+		{
+			TDL_LOG_ERROR << "[NetMgr] Failed to post initial overlapped receive.";
+			break; // Keep whatever slots did get posted
+		}
+	}
+#elif defined(__linux__)
+	m_msgHeaders.resize(MAX_BATCH_SIZE);
+	m_iovecs.resize(MAX_BATCH_SIZE);
+
+	// One epoll set watches the receive socket and a wakeup eventfd, so the event
+	// loop can sleep until there is either traffic or something for it to do.
+	m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+	m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	bool pollReady = m_epollFd >= 0 && m_wakeFd >= 0;
+	if (!pollReady)
+	{
+		TDL_LOG_ERROR << "[NetMgr] epoll/eventfd setup failed: " << errno;
+	}
+	else
+	{
+		epoll_event socketEvent = {};
+		socketEvent.events = EPOLLIN;
+		socketEvent.data.fd = m_recvSocket;
+		epoll_event wakeEvent = {};
+		wakeEvent.events = EPOLLIN;
+		wakeEvent.data.fd = m_wakeFd;
+		if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_recvSocket, &socketEvent) != 0 ||
+			epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &wakeEvent) != 0)
+		{
+			TDL_LOG_ERROR << "[NetMgr] epoll_ctl failed: " << errno;
+			pollReady = false;
+		}
+	}
+	if (!pollReady)
+	{
+		// Without them waitForEvents() can never report traffic: fail like a bind would.
+		// Handles are reset so the destructor doesn't close them a second time.
+		if (m_epollFd >= 0)
+		{
+			close(m_epollFd);
+			m_epollFd = -1;
+		}
+		if (m_wakeFd >= 0)
+		{
+			close(m_wakeFd);
+			m_wakeFd = -1;
+		}
+		closesocket(m_recvSocket);
+		closesocket(m_sendSocket);
+		m_recvSocket = INVALID_SOCKET;
+		m_sendSocket = INVALID_SOCKET;
+		cleanupWinsock();
+		return;
+	}
+#endif
+
+	// A receiver that ran out of buffers is woken as soon as one comes back.
+	m_packetPool.setReplenishedCallback([this]() { wakeup(); });
+
 	// If all steps succeeded
 	m_initialized = true;
-	std::cout << "[NetMgr] Network Manager Initialized. Port: " << m_port
-		<< ", Broadcast: " << broadcastAddress << std::endl;
+	TDL_LOG_INFO << "[NetMgr] Network Manager Initialized. Port: " << m_port
+		<< ", Broadcast: " << broadcastAddress;
 }
 
 NetworkManager::~NetworkManager()
 {
-	std::cout << "[NetMgr] Cleaning up..." << std::endl;
+	TDL_LOG_INFO << "[NetMgr] Cleaning up...";
+	m_packetPool.setReplenishedCallback(nullptr); // The ring's buffers go back below, after the port is closed
+	for (size_t type = 0; type < MAX_CHANNELS; ++type)
+	{
+		if (m_channels[type].joined)
+		{
+			changeMembership(static_cast<MessageType>(type), false); // Tell the switches right away
+		}
+	}
 	if (m_sendSocket != INVALID_SOCKET)
 	{
 		closesocket(m_sendSocket);
@@ -100,11 +215,48 @@ NetworkManager::~NetworkManager()
 	{
 		closesocket(m_recvSocket);
 	}
+#if defined(_WIN32)
+	if (m_completionPort != nullptr)
+	{
+		// Closing the socket aborts the posted receives, but the kernel still owns
+		// their buffers until each completion has been dequeued.
+		// Completions stashed by waitForEvents() have already been dequeued.
+		m_pendingReceives -= m_readyCount - m_readyNext;
+		OVERLAPPED_ENTRY entries[MAX_BATCH_SIZE];
+		while (m_pendingReceives > 0)
+		{
+			ULONG removed = 0;
+			if (!GetQueuedCompletionStatusEx(m_completionPort, entries, MAX_BATCH_SIZE, &removed, 1000, FALSE))
+			{
+				break; // Nothing more arrived within a second; give up rather than hang
+			}
+			for (ULONG i = 0; i < removed && m_pendingReceives > 0; ++i)
+			{
+				if (entries[i].lpCompletionKey != WAKEUP_COMPLETION_KEY)
+				{
+					--m_pendingReceives;
+				}
+			}
+		}
+		CloseHandle(m_completionPort);
+	}
+#elif defined(__linux__)
+	if (m_epollFd >= 0)
+	{
+		close(m_epollFd);
+	}
+	if (m_wakeFd >= 0)
+	{
+		close(m_wakeFd);
+	}
+#endif
+#if defined(_WIN32)
 	if (m_initialized)
 	{ // Only call WSACleanup if WSAStartup succeeded
 		WSACleanup();
-		std::cout << "[NetMgr] Winsock Cleaned up." << std::endl;
+		TDL_LOG_INFO << "[NetMgr] Winsock Cleaned up.";
 	}
+#endif
 }
 
 bool NetworkManager::isInitialized() const
@@ -113,6 +265,20 @@ bool NetworkManager::isInitialized() const
 }
 
 bool NetworkManager::sendBroadcast(const void* data, size_t size)
+{
+	return sendTo(m_broadcastAddr, data, size);
+}
+
+bool NetworkManager::sendOnChannel(MessageType type, const void* data, size_t size)
+{
+	if (type < MAX_CHANNELS && m_channels[type].hasGroup)
+	{
+		return sendTo(m_channels[type].groupAddr, data, size);
+	}
+	return sendTo(m_broadcastAddr, data, size);
+}
+
+bool NetworkManager::sendTo(const sockaddr_in& destination, const void* data, size_t size)
 {
 	if (!m_initialized || m_sendSocket == INVALID_SOCKET)
 	{
@@ -123,75 +289,518 @@ bool NetworkManager::sendBroadcast(const void* data, size_t size)
 		static_cast<const char*>(data), // Cast data pointer
 		static_cast<int>(size),         // Cast size
 		0,
-		(SOCKADDR*)&m_broadcastAddr,
-		sizeof(m_broadcastAddr));
+		(const sockaddr*)&destination,
+		sizeof(destination));
 
 	if (bytesSent == SOCKET_ERROR)
 	{
-		std::cerr << "[NetMgr] sendto failed: " << WSAGetLastError() << std::endl;
+		TDL_LOG_ERROR << "[NetMgr] sendto failed: " << lastSocketError();
+		Metrics::increment(MetricCounter::SendFailures);
 		return false;
 	}
+	Metrics::increment(MetricCounter::PacketsSent);
+	Metrics::increment(MetricCounter::BytesSent, static_cast<uint64_t>(bytesSent));
 	if (bytesSent != static_cast<int>(size))
 	{
-		std::cerr << "[NetMgr] Warning: sendto sent " << bytesSent << " bytes, but expected " << size << std::endl;
+		TDL_LOG_WARNING << "[NetMgr] Warning: sendto sent " << bytesSent << " bytes, but expected " << size;
 		// Return true anyway, as some data was sent? Or false? Let's return true for now.
 	}
 	return true;
 }
 
+// --- Multicast Channels ---
+static constexpr int MULTICAST_TTL = 1; // Stay on the local segment, like the broadcasts they replace
+
+bool NetworkManager::setChannelGroup(MessageType type, const char* groupAddress)
+{
+	if (!m_initialized || type >= MAX_CHANNELS)
+	{
+		return false;
+	}
+	Channel& channel = m_channels[type];
+	bool wasJoined = channel.joined;
+	if (wasJoined)
+	{
+		changeMembership(type, false); // Never stay in a group we no longer route to
+	}
+
+	if (groupAddress == nullptr)
+	{
+		channel.hasGroup = false;
+		return true;
+	}
+
+	sockaddr_in groupAddr = {};
+	groupAddr.sin_family = AF_INET;
+	groupAddr.sin_port = htons(m_port);
+	if (inet_pton(AF_INET, groupAddress, &groupAddr.sin_addr) != 1 || (ntohl(groupAddr.sin_addr.s_addr) >> 28) != 0xE)
+	{
+		TDL_LOG_ERROR << "[NetMgr] Not a multicast group address: " << groupAddress;
+		channel.hasGroup = false;
+		return false;
+	}
+
+	if (!m_multicastConfigured)
+	{
+		// Keep multicast on the local segment and hear our own sends, as with broadcast.
+		int ttl = MULTICAST_TTL;
+		int loop = 1;
+		if (setsockopt(m_sendSocket, IPPROTO_IP, IP_MULTICAST_TTL, (char*)&ttl, sizeof(ttl)) == SOCKET_ERROR ||
+			setsockopt(m_sendSocket, IPPROTO_IP, IP_MULTICAST_LOOP, (char*)&loop, sizeof(loop)) == SOCKET_ERROR)
+		{
+			TDL_LOG_WARNING << "[NetMgr] setsockopt(IP_MULTICAST_TTL/LOOP) failed: " << lastSocketError();
+		}
+		m_multicastConfigured = true;
+	}
+
+	channel.groupAddr = groupAddr;
+	channel.hasGroup = true;
+	TDL_LOG_INFO << "[NetMgr] Message type " << static_cast<uint32_t>(type) << " -> multicast group " << groupAddress;
+	return wasJoined ? changeMembership(type, true) : true;
+}
+
+bool NetworkManager::joinChannel(MessageType type)
+{
+	if (type >= MAX_CHANNELS || !m_channels[type].hasGroup)
+	{
+		return false;
+	}
+	return m_channels[type].joined || changeMembership(type, true);
+}
+
+bool NetworkManager::leaveChannel(MessageType type)
+{
+	if (type >= MAX_CHANNELS || !m_channels[type].joined)
+	{
+		return false;
+	}
+	return changeMembership(type, false);
+}
+
+bool NetworkManager::changeMembership(MessageType type, bool join)
+{
+	Channel& channel = m_channels[type];
+
+	// Several types may share a group, but a socket can only be a member once:
+	// join on the first channel that needs the group, leave with the last.
+	for (size_t other = 0; other < MAX_CHANNELS; ++other)
+	{
+		if (other != type && m_channels[other].joined &&
+			m_channels[other].groupAddr.sin_addr.s_addr == channel.groupAddr.sin_addr.s_addr)
+		{
+			channel.joined = join;
+			return true;
+		}
+	}
+
+	ip_mreq membership = {};
+	membership.imr_multiaddr = channel.groupAddr.sin_addr;
+	membership.imr_interface.s_addr = htonl(INADDR_ANY); // Let the routing table pick the interface
+	if (setsockopt(m_recvSocket, IPPROTO_IP, join ? IP_ADD_MEMBERSHIP : IP_DROP_MEMBERSHIP,
+		(char*)&membership, sizeof(membership)) == SOCKET_ERROR)
+	{
+		TDL_LOG_ERROR << "[NetMgr] setsockopt(" << (join ? "IP_ADD_MEMBERSHIP" : "IP_DROP_MEMBERSHIP") << ") failed: " << lastSocketError();
+		return false;
+	}
+	channel.joined = join;
+	return true;
+}
+
 std::optional<ReceivedPacket> NetworkManager::receive()
 {
-	if (!m_initialized || m_recvSocket == INVALID_SOCKET)
+	// A single receive is just a batch of one, so both APIs share the same
+	// buffers (and on Windows, the same posted overlapped ring).
+	ReceivedPacket packet;
+	if (receiveBatch(&packet, 1) == 0)
 	{
 		return std::nullopt;
 	}
+	return std::make_optional(std::move(packet)); // Move the packet into optional
+}
 
-	// Use a stack buffer or member buffer if preferred over heap allocation?
-	// std::vector is convenient but has potential overhead. Let's use vector for now.
-	std::vector<uint8_t> buffer(RECEIVE_BUFFER_SIZE);
-	sockaddr_in senderAddr = {};
-	int senderAddrSize = sizeof(senderAddr);
+#if defined(_WIN32)
 
-	int bytesReceived = recvfrom(m_recvSocket,
-		reinterpret_cast<char*>(buffer.data()), // Get pointer to vector data
-		static_cast<int>(buffer.size()),        // Max size
-		0,
-		(SOCKADDR*)&senderAddr,
-		&senderAddrSize);
+// (Re)posts one overlapped receive into the given ring slot.
+bool NetworkManager::postReceive(ReceiveSlot& slot)
+{
+	if (!slot.buffer)
+	{
+		slot.buffer = m_packetPool.acquire();
+		if (!slot.buffer)
+		{
+			return false; // Pool exhausted; repostIdleSlots() will retry later
+		}
+	}
+
+	slot.overlapped = {};
+	slot.wsaBuf.buf = reinterpret_cast<char*>(slot.buffer.data());
+	slot.wsaBuf.len = static_cast<ULONG>(slot.buffer.capacity());
+	slot.senderAddrSize = sizeof(slot.senderAddr);
+	slot.flags = 0;
 
-	if (bytesReceived == SOCKET_ERROR)
+	int result = WSARecvFrom(m_recvSocket, &slot.wsaBuf, 1, nullptr, &slot.flags,
+		(SOCKADDR*)&slot.senderAddr, &slot.senderAddrSize, &slot.overlapped, nullptr);
+	if (result == SOCKET_ERROR && lastSocketError() != WSA_IO_PENDING)
 	{
-		int error = WSAGetLastError();
-		if (error == WSAETIMEDOUT)
+		TDL_LOG_ERROR << "[NetMgr] WSARecvFrom failed: " << lastSocketError();
+		return false;
+	}
+
+	// Either completed immediately or pending: in both cases the completion is queued to the port.
+	slot.posted = true;
+	++m_pendingReceives;
+	return true;
+}
+
+// Re-arms any ring slots that could not be posted earlier because the pool was empty.
+void NetworkManager::repostIdleSlots()
+{
+	if (m_pendingReceives == m_receiveRing.size())
+	{
+		return;
+	}
+	for (ReceiveSlot& slot : m_receiveRing)
+	{
+		if (!slot.posted && !postReceive(slot))
+		{
+			break;
+		}
+	}
+}
+
+// Turns one dequeued receive completion back into a packet (if it carried data)
+// and re-posts its ring slot. Returns true if 'packet' was filled.
+bool NetworkManager::harvestCompletion(const OVERLAPPED_ENTRY& entry, ReceivedPacket& packet)
+{
+	ReceiveSlot& slot = *reinterpret_cast<ReceiveSlot*>(entry.lpOverlapped);
+	slot.posted = false;
+	--m_pendingReceives;
+
+	DWORD bytesReceived = 0;
+	DWORD flags = 0;
+	if (!WSAGetOverlappedResult(m_recvSocket, &slot.overlapped, &bytesReceived, FALSE, &flags))
+	{
+		int error = lastSocketError();
+		if (error == WSAEMSGSIZE)
 		{
-			// Timeout is expected, return empty optional
-			return std::nullopt;
+			// Bigger than a pool slot: the kernel kept only its start, so drop it.
+			Metrics::increment(MetricCounter::MalformedPackets);
 		}
 		// Ignore connection reset errors common with UDP
-		if (error == WSAECONNRESET)
+		else if (error == WSAECONNRESET)
+		{
+			TDL_LOG_WARNING << "[NetMgr] Warning: WSARecvFrom reported WSAECONNRESET.";
+		}
+		else if (error != WSA_OPERATION_ABORTED)
 		{
-			std::cerr << "[NetMgr] Warning: recvfrom reported WSAECONNRESET." << std::endl;
-			return std::nullopt; // Treat as non-fatal, no data received
+			TDL_LOG_ERROR << "[NetMgr] WSARecvFrom completion failed: " << error;
 		}
+		bytesReceived = 0;
+	}
 
-		// Other errors
-		std::cerr << "[NetMgr] recvfrom failed: " << error << std::endl;
-		return std::nullopt;
+	bool filled = false;
+	if (bytesReceived > 0)
+	{
+		// Zero-copy hand-off: the filled pool slot moves to the caller and the
+		// caller's previous slot (if it had one) goes back into the ring.
+		std::swap(packet.buffer, slot.buffer);
+		packet.size = bytesReceived;
+		packet.senderAddress = slot.senderAddr;
+		packet.receivedAt = std::chrono::steady_clock::now();
+		filled = true;
 	}
 
-	if (bytesReceived == 0)
+	postReceive(slot); // Hand the slot straight back to the kernel
+	return filled;
+}
+
+size_t NetworkManager::receiveBatch(ReceivedPacket* packets, size_t maxPackets, bool wait)
+{
+	if (!m_initialized || m_completionPort == nullptr || packets == nullptr || maxPackets == 0)
 	{
-		// Unlikely with UDP, but handle it
-		return std::nullopt;
+		return 0;
 	}
 
-	// Shrink buffer to actual received size
-	buffer.resize(bytesReceived);
+	size_t filled = 0;
 
-	// Create and return the packet
-	ReceivedPacket packet;
-	packet.data = std::move(buffer); // Efficiently move data into the struct
-	packet.senderAddress = senderAddr;
+	// Completions that waitForEvents() already dequeued go out first, in order.
+	while (m_readyNext < m_readyCount && filled < maxPackets)
+	{
+		if (harvestCompletion(m_readyEntries[m_readyNext++], packets[filled]))
+		{
+			++filled;
+		}
+	}
+	if (m_readyNext == m_readyCount)
+	{
+		m_readyNext = m_readyCount = 0;
+	}
 
-	return std::make_optional(std::move(packet)); // Move the packet into optional
-}
\ No newline at end of file
+	repostIdleSlots();
+	if (filled == maxPackets)
+	{
+		return filled;
+	}
+
+	OVERLAPPED_ENTRY entries[MAX_BATCH_SIZE];
+	size_t room = maxPackets - filled;
+	ULONG wanted = static_cast<ULONG>(room < MAX_BATCH_SIZE ? room : MAX_BATCH_SIZE);
+	ULONG removed = 0;
+
+	// One kernel call dequeues every completion that is ready (waiting only for the
+	// first, and not at all if we already have packets or the caller asked not to).
+	DWORD timeout = (wait && filled == 0) ? static_cast<DWORD>(m_receiveTimeoutMs) : 0;
+	if (!GetQueuedCompletionStatusEx(m_completionPort, entries, wanted, &removed, timeout, FALSE))
+	{
+		DWORD error = GetLastError();
+		if (error != WAIT_TIMEOUT)
+		{
+			TDL_LOG_ERROR << "[NetMgr] GetQueuedCompletionStatusEx failed: " << error;
+		}
+		return filled;
+	}
+
+	for (ULONG i = 0; i < removed; ++i)
+	{
+		if (entries[i].lpCompletionKey == WAKEUP_COMPLETION_KEY)
+		{
+			m_wakePending = true; // Not ours; report it from the next waitForEvents()
+			continue;
+		}
+		if (harvestCompletion(entries[i], packets[filled]))
+		{
+			++filled;
+		}
+	}
+
+	return filled;
+}
+
+NetworkManager::WaitResult NetworkManager::waitForEvents(int timeoutMs)
+{
+	if (!m_initialized || m_completionPort == nullptr)
+	{
+		return WaitResult::Error;
+	}
+	if (m_wakePending)
+	{
+		m_wakePending = false;
+		return WaitResult::Woken;
+	}
+	if (m_readyNext < m_readyCount)
+	{
+		return WaitResult::Readable; // Still holding completions from last time
+	}
+
+	// The completion port already is our readiness queue: waiting on it *is* waiting
+	// for the socket. Whatever we dequeue is stashed for the next receiveBatch().
+	repostIdleSlots();
+	OVERLAPPED_ENTRY entries[MAX_BATCH_SIZE];
+	ULONG removed = 0;
+	DWORD timeout = (timeoutMs < 0) ? INFINITE : static_cast<DWORD>(timeoutMs);
+	if (!GetQueuedCompletionStatusEx(m_completionPort, entries, MAX_BATCH_SIZE, &removed, timeout, FALSE))
+	{
+		DWORD error = GetLastError();
+		if (error == WAIT_TIMEOUT)
+		{
+			return WaitResult::Timeout;
+		}
+		TDL_LOG_ERROR << "[NetMgr] GetQueuedCompletionStatusEx failed: " << error;
+		return WaitResult::Error;
+	}
+
+	bool woken = false;
+	m_readyNext = m_readyCount = 0;
+	for (ULONG i = 0; i < removed; ++i)
+	{
+		if (entries[i].lpCompletionKey == WAKEUP_COMPLETION_KEY)
+		{
+			woken = true;
+		}
+		else
+		{
+			m_readyEntries[m_readyCount++] = entries[i];
+		}
+	}
+
+	if (m_readyCount > 0)
+	{
+		m_wakePending = woken; // Data first; the wakeup is reported on the next call
+		return WaitResult::Readable;
+	}
+	return woken ? WaitResult::Woken : WaitResult::Timeout;
+}
+
+void NetworkManager::wakeup()
+{
+	if (m_completionPort != nullptr)
+	{
+		PostQueuedCompletionStatus(m_completionPort, 0, WAKEUP_COMPLETION_KEY, nullptr);
+	}
+}
+
+#elif defined(__linux__)
+
+size_t NetworkManager::receiveBatch(ReceivedPacket* packets, size_t maxPackets, bool wait)
+{
+	if (!m_initialized || m_recvSocket == INVALID_SOCKET || packets == nullptr || maxPackets == 0)
+	{
+		return 0;
+	}
+
+	size_t wanted = maxPackets < MAX_BATCH_SIZE ? maxPackets : MAX_BATCH_SIZE;
+
+	// Point each scatter entry straight at a pool slot owned by the caller's packet.
+	for (size_t i = 0; i < wanted; ++i)
+	{
+		if (!packets[i].buffer)
+		{
+			packets[i].buffer = m_packetPool.acquire();
+			if (!packets[i].buffer)
+			{
+				wanted = i; // Pool exhausted: receive into what we have
+				break;
+			}
+		}
+		packets[i].size = 0;
+
+		m_iovecs[i].iov_base = packets[i].buffer.data();
+		m_iovecs[i].iov_len = packets[i].buffer.capacity();
+
+		msghdr& hdr = m_msgHeaders[i].msg_hdr;
+		hdr = {};
+		hdr.msg_name = &packets[i].senderAddress;
+		hdr.msg_namelen = sizeof(packets[i].senderAddress);
+		hdr.msg_iov = &m_iovecs[i];
+		hdr.msg_iovlen = 1;
+		m_msgHeaders[i].msg_len = 0;
+	}
+
+	if (wanted == 0)
+	{
+		// Pool empty: stop polling the socket until a buffer comes back.
+		if (!m_receivePaused && setReceivePolled(false))
+		{
+			m_receivePaused = true;
+		}
+		return 0;
+	}
+
+	// MSG_WAITFORONE: block (up to SO_RCVTIMEO) for the first datagram only.
+	// MSG_DONTWAIT: the event loop already knows the socket is readable; never block.
+	int flags = wait ? MSG_WAITFORONE : MSG_DONTWAIT;
+	int received = recvmmsg(m_recvSocket, m_msgHeaders.data(), static_cast<unsigned int>(wanted), flags, nullptr);
+	if (received <= 0)
+	{
+		if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+		{
+			TDL_LOG_ERROR << "[NetMgr] recvmmsg failed: " << errno;
+		}
+		return 0;
+	}
+
+	// Record each datagram's size, compacting out any empty or truncated ones.
+	auto receivedAt = std::chrono::steady_clock::now();
+	size_t filled = 0;
+	for (int i = 0; i < received; ++i)
+	{
+		unsigned int length = m_msgHeaders[i].msg_len;
+		if (length == 0)
+		{
+			continue;
+		}
+		if (m_msgHeaders[i].msg_hdr.msg_flags & MSG_TRUNC)
+		{
+			// Bigger than a pool slot: only its start was copied, so it can't be parsed.
+			Metrics::increment(MetricCounter::MalformedPackets);
+			continue;
+		}
+		if (filled != static_cast<size_t>(i))
+		{
+			std::swap(packets[filled], packets[i]);
+		}
+		packets[filled].size = length;
+		packets[filled].receivedAt = receivedAt;
+		++filled;
+	}
+
+	return filled;
+}
+
+NetworkManager::WaitResult NetworkManager::waitForEvents(int timeoutMs)
+{
+	if (!m_initialized || m_epollFd < 0)
+	{
+		return WaitResult::Error;
+	}
+	if (m_wakePending)
+	{
+		m_wakePending = false;
+		return WaitResult::Woken;
+	}
+	if (m_receivePaused && m_packetPool.available() > 0 && setReceivePolled(true))
+	{
+		m_receivePaused = false;
+	}
+
+	epoll_event events[2];
+	int count = epoll_wait(m_epollFd, events, 2, timeoutMs);
+	if (count < 0)
+	{
+		if (errno == EINTR)
+		{
+			return WaitResult::Timeout; // Interrupted by a signal: let the caller re-check its timers
+		}
+		TDL_LOG_ERROR << "[NetMgr] epoll_wait failed: " << errno;
+		return WaitResult::Error;
+	}
+
+	bool readable = false;
+	bool woken = false;
+	for (int i = 0; i < count; ++i)
+	{
+		if (events[i].data.fd == m_wakeFd)
+		{
+			uint64_t value = 0;
+			ssize_t drained = read(m_wakeFd, &value, sizeof(value)); // Reset the eventfd counter
+			(void)drained;
+			woken = true;
+		}
+		else
+		{
+			readable = true;
+		}
+	}
+
+	if (readable)
+	{
+		m_wakePending = woken; // Data first; the wakeup is reported on the next call
+		return WaitResult::Readable;
+	}
+	return woken ? WaitResult::Woken : WaitResult::Timeout;
+}
+
+bool NetworkManager::setReceivePolled(bool polled)
+{
+	epoll_event socketEvent = {};
+	socketEvent.events = polled ? EPOLLIN : 0;
+	socketEvent.data.fd = m_recvSocket;
+	if (epoll_ctl(m_epollFd, EPOLL_CTL_MOD, m_recvSocket, &socketEvent) != 0)
+	{
+		TDL_LOG_ERROR << "[NetMgr] epoll_ctl(MOD) failed: " << errno;
+		return false;
+	}
+	return true;
+}
+
+void NetworkManager::wakeup()
+{
+	if (m_wakeFd >= 0)
+	{
+		uint64_t one = 1;
+		ssize_t written = write(m_wakeFd, &one, sizeof(one));
+		(void)written; // Only fails if the counter would overflow, i.e. a wakeup is already pending
+	}
+}
+
+#endif
@@ -2,38 +2,83 @@
 #ifndef NETWORK_MANAGER_H
 #define NETWORK_MANAGER_H
 
-#include <winsock2.h>
-#include <ws2tcpip.h>
 #include <vector>
+#include <chrono>
 #include <optional>   // To return optional received data
 #include <cstdint>
+#include <cstddef>
+#include "PacketPool.h"
+#include "SocketPlatform.h"
+#include "Transport.h"
 
-// Forward declaration if needed, or include TdlMessages.h if sizes are needed here
-// (Better to keep dependencies minimal in headers)
+#if defined(__linux__)
+#include <sys/socket.h> // recvmmsg / mmsghdr for the batched receive path
+#elif !defined(_WIN32)
+#error "NetworkManager's batched receive path needs Winsock (Windows) or recvmmsg/epoll (Linux)"
+#endif
 
-// Structure to hold received packet details
-struct ReceivedPacket
+// --- Network Manager ---
+// The UDP broadcast Transport: one send socket, one receive socket bound to the TDL port.
+class NetworkManager : public Transport
 {
-	std::vector<uint8_t> data; // Use uint8_t for byte buffer
-	sockaddr_in senderAddress;
-};
+public:
+	// 'heldPackets' sizes the packet pool for what the receiver keeps downstream
+	// (see Transport::poolSlotsFor()).
+	NetworkManager(uint16_t port, const char* broadcastAddress, int receiveTimeoutMs = 1000, size_t heldPackets = 0);
 
+	~NetworkManager() override;
 
-class NetworkManager
-{
-public:
-	NetworkManager(uint16_t port, const char* broadcastAddress, int receiveTimeoutMs = 1000);
+	bool isInitialized() const override;
+
+	bool sendBroadcast(const void* data, size_t size) override;
 
-	~NetworkManager();
+	// --- Multicast Channels ---
+	// Each message type can be given its own multicast group. Sends of that type go
+	// to the group instead of the broadcast address, and only receivers that joined
+	// the group get them: the NIC and kernel drop the rest before we ever parse them.
+	// Types without a group keep using broadcast, so mixed networks still interoperate.
+	static constexpr size_t MAX_CHANNELS = 8; // Message type values below this can have a group
 
-	bool isInitialized() const;
+	// Routes sends of 'type' to 'groupAddress' (a 224.0.0.0/4 address, same port).
+	// nullptr reverts the type to broadcast (leaving the old group first if joined).
+	bool setChannelGroup(MessageType type, const char* groupAddress);
 
-	bool sendBroadcast(const void* data, size_t size);
+	// IGMP join/leave on the receive socket for the group configured for 'type'.
+	bool joinChannel(MessageType type);
+	bool leaveChannel(MessageType type);
+
+	// Sends to the type's group if it has one, otherwise broadcasts.
+	bool sendOnChannel(MessageType type, const void* data, size_t size) override;
 
 	// Attempt to receive a packet (blocks up to the configured timeout)
 	// Returns the received packet if successful, std::nullopt on timeout or error.
 	std::optional<ReceivedPacket> receive();
 
+	// Attempt to receive up to 'maxPackets' datagrams with a single kernel call
+	// (recvmmsg on Linux, GetQueuedCompletionStatusEx over a ring of overlapped
+	// WSARecvFrom buffers on Windows). Blocks up to the configured timeout for the
+	// first datagram, then takes whatever else is already queued without waiting.
+	// The caller owns the 'packets' array and should reuse it between calls: packets
+	// keep their pool slot between calls (or take a fresh one from the pool), so
+	// steady-state receives neither allocate nor copy.
+	// With 'wait' false it never blocks: it returns only what is already queued
+	// (the mode the event-driven receive loop uses after waitForEvents()).
+	// Returns the number of packets filled in (0 on timeout or error).
+	size_t receiveBatch(ReceivedPacket* packets, size_t maxPackets, bool wait = true) override;
+
+	// The pool every received datagram lives in. Exposed for its usage counters.
+	PacketPool& getPacketPool() override { return m_packetPool; }
+
+	// --- Event-Driven Receive ---
+	// Blocks until the receive socket has data, wakeup() is called, or 'timeoutMs'
+	// passes (-1 waits forever). This is the reactor primitive EventLoop is built on:
+	// epoll over the socket plus an eventfd on Linux, and the receive ring's
+	// completion port on Windows. Call it (and receiveBatch) from one thread only.
+	WaitResult waitForEvents(int timeoutMs) override;
+
+	// Makes the current (or next) waitForEvents() call return Woken. Safe from any thread.
+	void wakeup() override;
+
 	// Disable copy and assignment
 	NetworkManager(const NetworkManager&) = delete;
 	NetworkManager& operator=(const NetworkManager&) = delete;
@@ -44,9 +89,73 @@ private:
 	SOCKET m_recvSocket = INVALID_SOCKET;
 	sockaddr_in m_broadcastAddr = {};
 	uint16_t m_port = 0;
+#if defined(_WIN32)
 	WSADATA m_wsaData = {}; // Store WSAData
+#endif
+	int m_receiveTimeoutMs = 0;
+	bool m_wakePending = false; // A wakeup was seen while reporting something else (receive thread only)
+
+	bool sendTo(const sockaddr_in& destination, const void* data, size_t size);
+	bool changeMembership(MessageType type, bool join);
+
+	// Per-type multicast routing; configure before traffic starts.
+	struct Channel
+	{
+		sockaddr_in groupAddr = {};
+		bool hasGroup = false;
+		bool joined = false;
+	};
+	Channel m_channels[MAX_CHANNELS];
+	bool m_multicastConfigured = false; // TTL and loopback set on the send socket
 
 	static constexpr size_t RECEIVE_BUFFER_SIZE = 2048; // Internal buffer size for recvfrom
+
+	// Declared before the receive ring so it outlives every buffer handle.
+	PacketPool m_packetPool;
+
+#if defined(_WIN32)
+	// One posted overlapped receive. The OVERLAPPED must stay the first member so a
+	// completion entry can be mapped straight back to its slot.
+	struct ReceiveSlot
+	{
+		WSAOVERLAPPED overlapped = {};
+		WSABUF wsaBuf = {};
+		sockaddr_in senderAddr = {};
+		int senderAddrSize = sizeof(sockaddr_in);
+		DWORD flags = 0;
+		PacketBuffer buffer;   // Pool slot the kernel is receiving into
+		bool posted = false;
+	};
+
+	bool postReceive(ReceiveSlot& slot);
+	void repostIdleSlots();
+	bool harvestCompletion(const OVERLAPPED_ENTRY& entry, ReceivedPacket& packet);
+
+	// Completion key used by wakeup(); real receives complete with key 0.
+	static constexpr ULONG_PTR WAKEUP_COMPLETION_KEY = 1;
+
+	HANDLE m_completionPort = nullptr;   // IOCP the receive ring completes into
+	std::vector<ReceiveSlot> m_receiveRing; // Preallocated ring of posted receives
+	size_t m_pendingReceives = 0;        // How many ring slots are currently posted
+
+	// Receive completions dequeued by waitForEvents() but not yet handed out.
+	OVERLAPPED_ENTRY m_readyEntries[MAX_BATCH_SIZE] = {};
+	size_t m_readyCount = 0;
+	size_t m_readyNext = 0;
+#elif defined(__linux__)
+	int m_epollFd = -1;  // Watches the receive socket and the wakeup eventfd
+	int m_wakeFd = -1;   // eventfd written by wakeup()
+
+	// While the pool is empty the socket is taken out of the epoll set, so the
+	// reactor sleeps instead of spinning on a readable socket it has no buffer for.
+	// The pool's replenished callback wakes it to put the socket back.
+	bool m_receivePaused = false;
+	bool setReceivePolled(bool polled);
+
+	// Scratch headers for recvmmsg, sized once to MAX_BATCH_SIZE.
+	std::vector<mmsghdr> m_msgHeaders;
+	std::vector<iovec> m_iovecs;
+#endif
 };
 
 #endif // NETWORK_MANAGER_H
\ No newline at end of file
@@ -1,12 +1,138 @@
 // NodeManager.cpp
 #include "NodeManager.h" // Include the corresponding header file
-#include <iostream>      // For printing output (e.g., timeouts, list)
-#include <vector>        // Used in pruneTimeouts and getNodeList
+#include <vector>        // Used in getNodeList
+#include <algorithm>     // std::sort for getNodeList
+#include <cmath>         // std::cos for spatial query boxes
+#include <cstdio>        // Checkpoint files
+#include <cstring>       // memcpy out of a mapped checkpoint
+#include "Logger.h"      // Asynchronous output (e.g., timeouts, list)
+#include "MappedFile.h"  // Checkpoint warm start
+#include "MessageSequencer.h" // Receive time for one-way latency
+#include "Metrics.h"     // Lock wait/hold and prune timings
+#include "ScanKernels.h" // Vectorized column scans for the bulk queries
+#if defined(_WIN32)
+#include <windows.h>     // MoveFileExA, to replace a checkpoint atomically
+#endif
 
 // Constructor: Initializes the NodeManager with the ID of the node it belongs to.
-NodeManager::NodeManager(uint32_t selfNodeId) : m_selfNodeId(selfNodeId)
+NodeManager::NodeManager(uint32_t selfNodeId, size_t maxNodes) :
+    m_selfNodeId(selfNodeId),
+    m_maxNodes(maxNodes),
+    m_publishedSnapshot(std::make_shared<NodeSnapshot>()) // Readers always get a valid (empty) snapshot
 {
-    // Constructor body can be empty if initialization is done in the initializer list.
+    if (maxNodes == 0)
+    {
+        return; // Unbounded: every shard grows as its nodes arrive
+    }
+
+    // Preallocate every per-slot structure for a full shard, so nothing on the
+    // add / time out path ever allocates.
+    size_t shardCapacity = std::min(maxNodes, 2 * ((maxNodes + NUM_SHARDS - 1) / NUM_SHARDS));
+    for (Shard& shard : m_shards)
+    {
+        shard.table.setCapacity(shardCapacity);
+        shard.timeouts.reserveSlots(shardCapacity);
+        shard.positions.reserveSlots(shardCapacity);
+        shard.dirtyFlags.assign(shardCapacity, 0);
+        shard.dirtySlots.reserve(shardCapacity);
+        shard.timedOutIds.reserve(shardCapacity);
+    }
+}
+
+// Scoped shard lock that also records how long it waited for the mutex and how
+// long it then held it (MetricHistogram::ShardLockWait / ShardLockHold).
+class MeasuredLock
+{
+public:
+    explicit MeasuredLock(std::mutex& mutex) : m_mutex(mutex)
+    {
+        auto start = std::chrono::steady_clock::now();
+        m_mutex.lock();
+        m_acquired = std::chrono::steady_clock::now();
+        Metrics::recordLatency(MetricHistogram::ShardLockWait, m_acquired - start);
+    }
+    ~MeasuredLock()
+    {
+        auto held = std::chrono::steady_clock::now() - m_acquired;
+        m_mutex.unlock();
+        Metrics::recordLatency(MetricHistogram::ShardLockHold, held);
+    }
+
+    MeasuredLock(const MeasuredLock&) = delete;
+    MeasuredLock& operator=(const MeasuredLock&) = delete;
+
+private:
+    std::mutex& m_mutex;
+    std::chrono::steady_clock::time_point m_acquired;
+};
+
+// Maps a node ID to its shard. Node IDs are often small and sequential, so they are
+// mixed with a multiplicative (Fibonacci) hash first and the top bits pick the shard.
+NodeManager::Shard& NodeManager::shardFor(uint32_t nodeId)
+{
+    return m_shards[shardIndexOf(nodeId)];
+}
+
+uint32_t NodeManager::insertNode(Shard& shard, uint32_t nodeId)
+{
+    // Claim room in the total first; a full shard gives it back.
+    if (m_maxNodes != 0 && m_nodeCount.fetch_add(1, std::memory_order_relaxed) >= m_maxNodes)
+    {
+        m_nodeCount.fetch_sub(1, std::memory_order_relaxed);
+        Metrics::increment(MetricCounter::NodesRejected);
+        return NodeTable::INVALID_SLOT;
+    }
+    uint32_t slot = shard.table.insert(nodeId);
+    if (slot == NodeTable::INVALID_SLOT)
+    {
+        m_nodeCount.fetch_sub(1, std::memory_order_relaxed);
+        Metrics::increment(MetricCounter::NodesRejected);
+    }
+    else if (m_maxNodes == 0)
+    {
+        // Unbounded: grow the grid with the table now, not on the node's first position report.
+        shard.positions.reserveSlots(static_cast<size_t>(slot) + 1);
+    }
+    return slot;
+}
+
+// Accumulates change flags for one slot. The first change since the last publish
+// queues the slot; later ones only OR in their flags, so a busy node stays one entry.
+void NodeManager::markDirty(Shard& shard, uint32_t slot, uint8_t flags)
+{
+    if (slot >= shard.dirtyFlags.size())
+    {
+        shard.dirtyFlags.resize(static_cast<size_t>(slot) + 1, 0); // Grows with the table only
+    }
+    if (shard.dirtyFlags[slot] == 0)
+    {
+        shard.dirtySlots.push_back(slot);
+    }
+    shard.dirtyFlags[slot] |= flags;
+}
+
+// Builds a standalone NodeInfo from the columns of one table slot.
+NodeInfo NodeManager::makeNodeInfo(const NodeTable& table, uint32_t slot)
+{
+    NodeInfo info(table.meta(slot).nodeId, NodeTable::fromTicks(table.lastHeardTicks(slot)));
+    info.lastPosition.latitude = table.latitude(slot);
+    info.lastPosition.longitude = table.longitude(slot);
+    info.lastPosition.altitude = table.altitude(slot);
+    info.hasPosition = table.meta(slot).hasPosition;
+    info.stale = table.meta(slot).stale;
+    info.link = table.link(slot).stats;
+    return info;
+}
+
+// Whether a position off the network is somewhere on (or near) the Earth. Raw
+// reports carry plain doubles, so NaN, infinity or 1e300 can arrive; nothing
+// downstream (grid cells, sync's fixed point) is defined for those.
+static bool isPlausiblePosition(double latitude, double longitude, double altitude)
+{
+    constexpr double MAX_ALTITUDE_METERS = 1.0e6; // Well inside sync's int32 centimetres
+    return std::isfinite(latitude) && std::isfinite(longitude) && std::isfinite(altitude)
+        && latitude >= -90.0 && latitude <= 90.0 && longitude >= -180.0 && longitude <= 180.0
+        && std::fabs(altitude) <= MAX_ALTITUDE_METERS;
 }
 
 // Updates the position details for a specific node.
@@ -18,138 +144,920 @@ void NodeManager::updateNodePosition(const PositionReport& report)
     {
         return;
     }
+    if (!isPlausiblePosition(report.latitude, report.longitude, report.altitude))
+    {
+        Metrics::increment(MetricCounter::InvalidPositions);
+        return;
+    }
 
-    auto now = std::chrono::steady_clock::now(); // Get the current time.
+    auto now = NodeTable::toTicks(std::chrono::steady_clock::now()); // Get the current time.
+
+    Shard& shard = shardFor(report.header.sourceNodeId);
 
     // --- Critical Section Start ---
-    // Lock the mutex to prevent other threads from accessing m_nodeMap concurrently.
-    // The lock_guard automatically unlocks the mutex when it goes out of scope (at the end of this function).
-    std::lock_guard<std::mutex> lock(m_mutex);
+    // Lock the shard's mutex to prevent other threads from accessing its table concurrently.
+    // Only this one shard is locked; nodes in other shards can be updated in parallel.
+    // The MeasuredLock automatically unlocks the mutex when it goes out of scope (at the end of this function).
+    MeasuredLock lock(shard.mutex);
 
-    // Try to find the node in our map using its ID.
-    auto it = m_nodeMap.find(report.header.sourceNodeId);
+    // Try to find the node in the shard's table using its ID.
+    uint32_t slot = shard.table.find(report.header.sourceNodeId);
+    uint8_t changeFlags = NODE_POSITION_UPDATED | NODE_HEARD;
+
+    // An older report than the one stored arrived late; the stored position is newer.
+    if (slot != NodeTable::INVALID_SLOT && report.header.sequenceNumber != 0)
+    {
+        uint32_t storedSequence = shard.table.link(slot).lastPositionSequence;
+        if (storedSequence != 0 && static_cast<int32_t>(report.header.sequenceNumber - storedSequence) <= 0)
+        {
+            Metrics::increment(MetricCounter::StalePositionsRejected);
+            return;
+        }
+    }
 
-    if (it == m_nodeMap.end())
+    if (slot == NodeTable::INVALID_SLOT)
     {
-        // Node not found in the map. This is the first time we've heard from it
+        changeFlags |= NODE_ADDED;
+        // Node not found. This is the first time we've heard from it
         // (or at least the first time with a PositionReport). Add a new entry.
-        NodeInfo newNodeInfo(report.header.sourceNodeId, now); // Create basic info with current time.
-        newNodeInfo.updatePosition(report); // Update its position data.
-        m_nodeMap[report.header.sourceNodeId] = newNodeInfo; // Add it to the map.
-        std::cout << "[NodeMgr] Added new Node ID " << report.header.sourceNodeId << " from PositionReport." << std::endl;
+        slot = insertNode(shard, report.header.sourceNodeId);
+        if (slot == NodeTable::INVALID_SLOT)
+        {
+            return; // Table full
+        }
+        TDL_LOG_INFO << "[NodeMgr] Added new Node ID " << report.header.sourceNodeId << " from PositionReport.";
+        Metrics::increment(MetricCounter::NodesAdded);
+    }
+
+    // Store the position data and the last heard time (we just received a position report).
+    // Only the hot columns are written; nothing else about the node is touched.
+    shard.table.latitude(slot) = report.latitude;
+    shard.table.longitude(slot) = report.longitude;
+    shard.table.altitude(slot) = report.altitude;
+    shard.table.lastHeardTicks(slot) = now;
+    shard.table.meta(slot).hasPosition = true;
+    shard.table.meta(slot).stale = false; // Heard from again since the checkpoint
+    shard.table.link(slot).lastPositionSequence = report.header.sequenceNumber;
+    shard.positions.update(slot, report.latitude, report.longitude); // Re-files it only if it changed cell
+    shard.timeouts.schedule(slot, now); // Push its expiry out (no-op if still in the same wheel tick)
+    markChanged(shard);
+    markDirty(shard, slot, changeFlags);
+    // --- Critical Section End (Mutex automatically unlocked) ---
+}
+
+// Follows one sender's sequence numbers with a 64-message window, like IPsec replay
+// protection: a jump forward counts the skipped numbers as lost, and a number
+// behind the highest is either a duplicate (its bit is already set) or a late
+// arrival that fills one of those gaps. Duplicates, and anything a whole window
+// behind (which can't be told from one), are rejected. A number behind the
+// highest but sent *later* (by the sender's own clock) means the sender
+// restarted its sequence.
+bool NodeManager::trackSequence(NodeTable::LinkState& link, const MessageHeader& header, uint32_t receiveTimeUs)
+{
+    constexpr uint32_t WINDOW = 64;
+    uint32_t sequence = header.sequenceNumber;
+    if (sequence == 0)
+    {
+        return true; // Not sequenced
+    }
+
+    NodeLinkStats& stats = link.stats;
+    int32_t ahead = static_cast<int32_t>(sequence - link.highestSequence);
+    bool restarted = link.highestSequence != 0 && ahead < 0 && header.sendTimeUs != 0
+        && static_cast<int32_t>(header.sendTimeUs - link.newestSendTimeUs) > 0;
+    if (link.highestSequence == 0 || restarted)
+    {
+        stats.restarts += restarted ? 1 : 0;
+        link.highestSequence = sequence;
+        link.newestSendTimeUs = header.sendTimeUs;
+        link.recentMask = 1;
+        link.lastPositionSequence = 0; // Its next report is the newest, whatever its number
+        ++stats.received;
+    }
+    else if (ahead > 0)
+    {
+        uint32_t skipped = static_cast<uint32_t>(ahead) - 1;
+        stats.lost += skipped;
+        Metrics::increment(MetricCounter::SequenceGaps, skipped);
+        link.recentMask = static_cast<uint32_t>(ahead) < WINDOW ? (link.recentMask << ahead) | 1 : 1;
+        link.highestSequence = sequence;
+        if (static_cast<int32_t>(header.sendTimeUs - link.newestSendTimeUs) > 0)
+        {
+            link.newestSendTimeUs = header.sendTimeUs; // A repaired text keeps its original, older send time
+        }
+        ++stats.received;
     }
     else
     {
-        // Node found! Update its stored position data and its last heard time.
-        // 'it->second' refers to the NodeInfo object stored in the map.
-        it->second.updatePosition(report);
-        it->second.lastHeardTime = now; // Update timestamp since we received a position report.
-        // Optional: Log the update.
-        // std::cout << "[NodeMgr] Updated position for Node ID: " << report.header.sourceNodeId << std::endl;
+        uint32_t behind = static_cast<uint32_t>(-static_cast<int64_t>(ahead));
+        if (behind >= WINDOW || (link.recentMask & (1ull << behind)))
+        {
+            // Seen already, or too far behind to tell: either way it is dropped, so
+            // a duplicated or replayed message is never applied twice.
+            ++stats.duplicates;
+            Metrics::increment(MetricCounter::DuplicateMessages);
+            return false;
+        }
+        link.recentMask |= 1ull << behind;
+        stats.lost -= stats.lost ? 1 : 0;
+        ++stats.reordered;
+        ++stats.received;
+        Metrics::increment(MetricCounter::MessagesReordered);
     }
-    // --- Critical Section End (Mutex automatically unlocked) ---
+
+    if (header.sendTimeUs != 0)
+    {
+        int32_t latencyUs = static_cast<int32_t>(receiveTimeUs - header.sendTimeUs); // Modulo 2^32, so the wrap cancels out
+        if (stats.latencySamples == 0)
+        {
+            stats.latencyMinUs = stats.latencyMaxUs = stats.latencyAvgUs = latencyUs;
+        }
+        else
+        {
+            stats.latencyMinUs = std::min(stats.latencyMinUs, latencyUs);
+            stats.latencyMaxUs = std::max(stats.latencyMaxUs, latencyUs);
+            stats.latencyAvgUs += static_cast<int32_t>((static_cast<int64_t>(latencyUs) - stats.latencyAvgUs) / 16);
+        }
+        ++stats.latencySamples;
+        if (latencyUs >= 0)
+        {
+            Metrics::recordLatency(MetricHistogram::OneWayLatency, static_cast<uint64_t>(latencyUs) * 1000);
+        }
+    }
+    return true;
 }
 
 // Updates only the 'lastHeardTime' for a node. Used when any message type is received.
 // If the node isn't known, it adds it to the list (without position info initially).
 void NodeManager::updateLastHeardTime(uint32_t nodeId)
 {
+    MessageHeader header; // Not sequenced: only the last heard time changes
+    header.sourceNodeId = nodeId;
+    updateLastHeardTime(header);
+}
+
+bool NodeManager::updateLastHeardTime(const MessageHeader& header)
+{
+    uint32_t nodeId = header.sourceNodeId;
     // Ignore messages supposedly from our own node ID.
     if (nodeId == m_selfNodeId)
     {
-        return;
+        return true;
     }
 
-    auto now = std::chrono::steady_clock::now(); // Get the current time.
+    auto now = NodeTable::toTicks(std::chrono::steady_clock::now()); // Get the current time.
+    uint32_t receiveTimeUs = header.sendTimeUs != 0 ? MessageSequencer::wallClockMicros() : 0;
+
+    Shard& shard = shardFor(nodeId);
 
     // --- Critical Section Start ---
-    std::lock_guard<std::mutex> lock(m_mutex);
+    MeasuredLock lock(shard.mutex);
 
-    // Try to find the node in our map.
-    auto it = m_nodeMap.find(nodeId);
+    // Try to find the node in its shard's table.
+    uint32_t slot = shard.table.find(nodeId);
+    uint8_t changeFlags = NODE_HEARD;
 
-    if (it != m_nodeMap.end())
+    if (slot == NodeTable::INVALID_SLOT)
     {
-        // Node exists in the map. Just update its lastHeardTime.
-        it->second.lastHeardTime = now;
+        changeFlags |= NODE_ADDED;
+        // Node doesn't exist in our list yet (e.g., we received a Heartbeat first).
+        // Create a basic entry for it. Position will be default.
+        slot = insertNode(shard, nodeId);
+        if (slot == NodeTable::INVALID_SLOT)
+        {
+            return true; // Table full; the message itself may still be of use
+        }
+        TDL_LOG_INFO << "[NodeMgr] Added new Node ID " << nodeId << " from generic message.";
+        Metrics::increment(MetricCounter::NodesAdded);
     }
-    else
+
+    // A duplicate says nothing new about the node, not even that it is still there.
+    if (!trackSequence(shard.table.link(slot), header, receiveTimeUs))
     {
-        // Node doesn't exist in our list yet (e.g., we received a Heartbeat first).
-        // Create a basic entry for it with the current time. Position will be default.
-        NodeInfo newNodeInfo(nodeId, now);
-        m_nodeMap[nodeId] = newNodeInfo; // Add it to the map.
-        std::cout << "[NodeMgr] Added new Node ID " << nodeId << " from generic message." << std::endl;
+        return false;
     }
+    shard.table.lastHeardTicks(slot) = now;
+    shard.table.meta(slot).stale = false; // Heard from again since the checkpoint
+    shard.timeouts.schedule(slot, now); // Push its expiry out (no-op if still in the same wheel tick)
+    markChanged(shard);
+    markDirty(shard, slot, changeFlags);
     // --- Critical Section End (Mutex automatically unlocked) ---
+    return true;
 }
 
 // Removes nodes from the list if they haven't sent any message within the timeout period.
+// Shards are swept one at a time, so ingest into the other shards carries on meanwhile.
 void NodeManager::pruneTimeouts(std::chrono::seconds timeoutDuration)
 {
+    ScopedLatency sweepTimer(MetricHistogram::PruneDuration);
     auto now = std::chrono::steady_clock::now(); // Get the current time.
-    std::vector<uint32_t> nodesToRemove; // Create a temporary list to store IDs of nodes to remove.
+    // Anything last heard before this point has been silent for longer than the timeout.
+    auto cutoff = NodeTable::toTicks(now - timeoutDuration);
 
-    // --- Critical Section Start ---
-    // We need to lock while iterating through the map.
-    std::lock_guard<std::mutex> lock(m_mutex);
+    // Expired IDs are collected in fixed-size batches on the stack, so the sweep never
+    // allocates, and logging / callbacks happen after the shard lock is released.
+    constexpr size_t EXPIRY_BATCH = 64;
+    uint32_t expiredSlots[EXPIRY_BATCH];
+    uint32_t expiredIds[EXPIRY_BATCH];
 
-    // Iterate through all the nodes currently in our map.
-    // 'pair' contains the node ID (pair.first) and the NodeInfo object (pair.second).
-    for (const auto& pair : m_nodeMap)
+    for (Shard& shard : m_shards)
     {
-        // Calculate how long it's been since we last heard from this node.
-        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - pair.second.lastHeardTime);
-
-        // If the elapsed time is greater than the allowed timeout...
-        if (elapsed > timeoutDuration)
+        size_t expiredCount;
+        do
         {
-            nodesToRemove.push_back(pair.first); // ...mark this node's ID for removal.
-        }
+            {
+                // --- Critical Section Start (this shard only) ---
+                MeasuredLock lock(shard.mutex);
+
+                // The wheel hands back only the slots that are due.
+                expiredCount = shard.timeouts.collectExpired(cutoff, expiredSlots, EXPIRY_BATCH);
+                for (size_t i = 0; i < expiredCount; ++i)
+                {
+                    expiredIds[i] = shard.table.meta(expiredSlots[i]).nodeId;
+                    shard.positions.remove(expiredSlots[i]);
+                    if (expiredSlots[i] < shard.dirtyFlags.size())
+                    {
+                        shard.dirtyFlags[expiredSlots[i]] = 0; // Its pending changes die with it...
+                    }
+                    shard.timedOutIds.push_back(expiredIds[i]); // ...and the feed reports the removal instead
+                    shard.table.erase(expiredSlots[i]); // Remove the entry; other slots are unaffected.
+                }
+                if (m_maxNodes != 0)
+                {
+                    m_nodeCount.fetch_sub(expiredCount, std::memory_order_relaxed);
+                }
+                if (expiredCount > 0)
+                {
+                    markChanged(shard);
+                }
+                // --- Critical Section End (shard mutex automatically unlocked) ---
+            }
+
+            for (size_t i = 0; i < expiredCount; ++i)
+            {
+                TDL_LOG_INFO << "[NodeMgr] Timed out Node ID: " << expiredIds[i];
+                Metrics::increment(MetricCounter::NodesTimedOut);
+                if (m_expiryCallback)
+                {
+                    m_expiryCallback(expiredIds[i]);
+                }
+            }
+        } while (expiredCount == EXPIRY_BATCH); // A full batch means there may be more in this shard
     }
+}
 
-    // --- Critical Section Still Active (within the same lock scope) ---
+// Fills 'out' with a copy of every node, shard by shard, then sorts it by ID.
+void NodeManager::copyNodes(std::vector<NodeInfo>& out)
+{
+    out.clear(); // Keeps the vector's capacity, so a recycled snapshot doesn't reallocate.
 
-    // Now, remove the marked nodes from the actual map.
-    // We do this *after* iterating to avoid issues with modifying the map while looping through it.
-    for (uint32_t nodeIdToRemove : nodesToRemove)
+    for (Shard& shard : m_shards)
     {
-        m_nodeMap.erase(nodeIdToRemove); // Remove the entry with this ID.
-        std::cout << "[NodeMgr] Timed out Node ID: " << nodeIdToRemove << std::endl;
+        // --- Critical Section Start (this shard only) ---
+        MeasuredLock lock(shard.mutex);
+
+        // Rebuild a NodeInfo for each node in the shard's table.
+        for (uint32_t slot = 0; slot < shard.table.slotLimit(); ++slot)
+        {
+            if (shard.table.isOccupied(slot))
+            {
+                out.push_back(makeNodeInfo(shard.table, slot));
+            }
+        }
+        // --- Critical Section End (shard mutex automatically unlocked) ---
     }
-    // --- Critical Section End (Mutex automatically unlocked) ---
+
+    // Shards interleave IDs, so restore the ID order the single map used to give.
+    std::sort(out.begin(), out.end(),
+        [](const NodeInfo& a, const NodeInfo& b) { return a.nodeId < b.nodeId; });
 }
 
 // Creates and returns a copy of the current node list.
-// This is thread-safe because it locks the map during the copy process.
+// This is thread-safe because it locks each shard while copying it.
 std::vector<NodeInfo> NodeManager::getNodeList()
 {
     std::vector<NodeInfo> listCopy; // Create an empty vector to hold the copy.
+    copyNodes(listCopy);
+    return listCopy; // Return the copied list.
+}
 
-    // --- Critical Section Start ---
-    std::lock_guard<std::mutex> lock(m_mutex);
+NodeHandle NodeManager::findNode(uint32_t nodeId)
+{
+    NodeHandle handle;
+    Shard& shard = shardFor(nodeId);
+    MeasuredLock lock(shard.mutex);
+    uint32_t slot = shard.table.find(nodeId);
+    if (slot != NodeTable::INVALID_SLOT)
+    {
+        handle.nodeId = nodeId;
+        handle.slot = slot;
+        handle.generation = shard.table.generation(slot);
+    }
+    return handle;
+}
 
-    listCopy.reserve(m_nodeMap.size()); // Optimize by reserving space in the vector.
-    // Copy each NodeInfo object from the map into the vector.
-    for (const auto& pair : m_nodeMap)
+// The handle's node ID only picks the shard; the slot and generation do the rest.
+bool NodeManager::getNode(const NodeHandle& handle, NodeInfo& out)
+{
+    if (!handle.isValid())
     {
-        listCopy.push_back(pair.second);
+        return false;
     }
-    // --- Critical Section End (Mutex automatically unlocked) ---
+    Shard& shard = shardFor(handle.nodeId);
+    MeasuredLock lock(shard.mutex);
+    const NodeTable& table = shard.table;
+    if (handle.slot >= table.slotLimit() || !table.isOccupied(handle.slot)
+        || table.generation(handle.slot) != handle.generation || table.meta(handle.slot).nodeId != handle.nodeId)
+    {
+        return false; // Timed out (and perhaps replaced) since the handle was made
+    }
+    out = makeNodeInfo(table, handle.slot);
+    return true;
+}
 
-    return listCopy; // Return the copied list.
+// Gathers every positioned node within the radius, one shard at a time. Only the
+// grid cells overlapping the radius's bounding box are visited.
+void NodeManager::collectWithin(double latitude, double longitude, double radiusMeters, std::vector<SpatialHit>& hits)
+{
+    constexpr double DEGREES_TO_RADIANS = 3.14159265358979323846 / 180.0;
+
+    // Bounding box in degrees. Longitude degrees shrink towards the poles, so size
+    // the box for its most poleward edge; near a pole it spans every longitude.
+    double latitudeSpan = radiusMeters / SpatialGrid::METERS_PER_DEGREE;
+    double poleward = std::fabs(latitude) + latitudeSpan;
+    double longitudeSpan = 180.0;
+    if (poleward < 89.0)
+    {
+        longitudeSpan = std::min(180.0, latitudeSpan / std::cos(poleward * DEGREES_TO_RADIANS));
+    }
+
+    for (Shard& shard : m_shards)
+    {
+        // --- Critical Section Start (this shard only) ---
+        MeasuredLock lock(shard.mutex);
+        shard.positions.visitBox(latitude - latitudeSpan, latitude + latitudeSpan,
+            longitude - longitudeSpan, longitude + longitudeSpan, [&](uint32_t slot)
+            {
+                double distance = SpatialGrid::distanceMeters(latitude, longitude,
+                    shard.table.latitude(slot), shard.table.longitude(slot));
+                if (distance <= radiusMeters)
+                {
+                    hits.emplace_back(distance, shard.table.meta(slot).nodeId);
+                }
+            });
+        // --- Critical Section End (shard mutex automatically unlocked) ---
+    }
+}
+
+size_t NodeManager::findNodesWithin(double latitude, double longitude, double radiusMeters, std::vector<uint32_t>& out)
+{
+    std::vector<SpatialHit> hits;
+    collectWithin(latitude, longitude, radiusMeters, hits);
+    std::sort(hits.begin(), hits.end());
+
+    out.clear();
+    for (const SpatialHit& hit : hits)
+    {
+        out.push_back(hit.second);
+    }
+    return out.size();
+}
+
+size_t NodeManager::findNearestNodes(double latitude, double longitude, size_t count, std::vector<uint32_t>& out)
+{
+    out.clear();
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    // Expanding search: nothing outside the radius can beat 'count' hits inside it,
+    // so grow the radius until there are enough (or it covers the whole globe).
+    constexpr double HALF_CIRCUMFERENCE_METERS = 20037508.0;
+    std::vector<SpatialHit> hits;
+    for (double radius = SpatialGrid::CELL_DEGREES * SpatialGrid::METERS_PER_DEGREE;; radius *= 4.0)
+    {
+        hits.clear();
+        collectWithin(latitude, longitude, radius, hits);
+        if (hits.size() >= count || radius >= HALF_CIRCUMFERENCE_METERS)
+        {
+            break;
+        }
+    }
+
+    size_t found = std::min(count, hits.size());
+    std::partial_sort(hits.begin(), hits.begin() + found, hits.end());
+    for (size_t i = 0; i < found; ++i)
+    {
+        out.push_back(hits[i].second);
+    }
+    return found;
+}
+
+// --- Bulk Scans ---
+// Each shard is scanned in full (free slots too: their columns hold zeros), then
+// only the slots the kernel picked are checked against the slot metadata.
+size_t NodeManager::getDistancesFrom(double latitude, double longitude, DistanceFormula formula, std::vector<NodeDistance>& out)
+{
+    out.clear();
+    std::vector<double> meters;
+    for (Shard& shard : m_shards)
+    {
+        // --- Critical Section Start (this shard only) ---
+        MeasuredLock lock(shard.mutex);
+        const NodeTable& table = shard.table;
+        uint32_t limit = table.slotLimit();
+        meters.resize(limit);
+        if (formula == DistanceFormula::Haversine)
+        {
+            ScanKernels::haversineDistances(table.latitudeColumn(), table.longitudeColumn(), limit, latitude, longitude, meters.data());
+        }
+        else
+        {
+            ScanKernels::flatEarthDistances(table.latitudeColumn(), table.longitudeColumn(), limit, latitude, longitude, meters.data());
+        }
+        for (uint32_t slot = 0; slot < limit; ++slot)
+        {
+            if (table.isOccupied(slot) && table.meta(slot).hasPosition)
+            {
+                out.push_back({ table.meta(slot).nodeId, meters[slot] });
+            }
+        }
+        // --- Critical Section End (shard mutex automatically unlocked) ---
+    }
+    return out.size();
 }
 
-// Prints the current list of known nodes to the console.
+size_t NodeManager::findNodesInBox(double minLatitude, double maxLatitude, double minLongitude, double maxLongitude,
+    std::vector<uint32_t>& out)
+{
+    out.clear();
+    std::vector<uint64_t> mask;
+    for (Shard& shard : m_shards)
+    {
+        // --- Critical Section Start (this shard only) ---
+        MeasuredLock lock(shard.mutex);
+        const NodeTable& table = shard.table;
+        uint32_t limit = table.slotLimit();
+        mask.resize(ScanKernels::maskWords(limit));
+        ScanKernels::boundingBoxMask(table.latitudeColumn(), table.longitudeColumn(), limit,
+            minLatitude, maxLatitude, minLongitude, maxLongitude, mask.data());
+        ScanKernels::forEachSetBit(mask.data(), mask.size(), [&](uint32_t slot)
+            {
+                if (table.isOccupied(slot) && table.meta(slot).hasPosition)
+                {
+                    out.push_back(table.meta(slot).nodeId);
+                }
+            });
+        // --- Critical Section End (shard mutex automatically unlocked) ---
+    }
+    return out.size();
+}
+
+size_t NodeManager::findNodesNotHeardFor(std::chrono::milliseconds age, std::vector<uint32_t>& out)
+{
+    static_assert(sizeof(NodeTable::Ticks) == sizeof(int64_t), "last heard ticks must be 64-bit for the scan kernel");
+
+    out.clear();
+    NodeTable::Ticks cutoff = NodeTable::toTicks(std::chrono::steady_clock::now() - age) + 1; // Heard at or before now - age
+    std::vector<uint64_t> mask;
+    for (Shard& shard : m_shards)
+    {
+        // --- Critical Section Start (this shard only) ---
+        MeasuredLock lock(shard.mutex);
+        const NodeTable& table = shard.table;
+        uint32_t limit = table.slotLimit();
+        mask.resize(ScanKernels::maskWords(limit));
+        ScanKernels::heardBeforeMask(reinterpret_cast<const int64_t*>(table.lastHeardColumn()), limit, cutoff, mask.data());
+        ScanKernels::forEachSetBit(mask.data(), mask.size(), [&](uint32_t slot)
+            {
+                if (table.isOccupied(slot))
+                {
+                    out.push_back(table.meta(slot).nodeId);
+                }
+            });
+        // --- Critical Section End (shard mutex automatically unlocked) ---
+    }
+    return out.size();
+}
+
+// Publishes a fresh snapshot if any shard changed since the last one.
+bool NodeManager::publishSnapshot()
+{
+    // Cheap change check first: shard versions are read without taking any lock.
+    uint64_t currentVersion = 0;
+    for (const Shard& shard : m_shards)
+    {
+        currentVersion += shard.version.load(std::memory_order_relaxed);
+    }
+    if (currentVersion == m_publishedVersion)
+    {
+        return false; // Nothing changed; readers keep the current epoch
+    }
+
+    // Double buffering: reuse the previous snapshot's storage once no reader holds it.
+    std::shared_ptr<NodeSnapshot> next;
+    if (m_spareSnapshot && m_spareSnapshot.use_count() == 1)
+    {
+        next = std::move(m_spareSnapshot);
+    }
+    else
+    {
+        next = std::make_shared<NodeSnapshot>();
+    }
+
+    std::shared_ptr<const NodeSnapshot> previous = std::atomic_load(&m_publishedSnapshot);
+    copyNodes(next->nodes);
+    next->epoch = previous->epoch + 1;
+    next->publishedAt = std::chrono::steady_clock::now();
+
+    std::atomic_store(&m_publishedSnapshot, std::shared_ptr<const NodeSnapshot>(next));
+    m_publishedVersion = currentVersion;
+
+    // Keep the one we just replaced around for recycling on the next publish.
+    m_spareSnapshot = std::const_pointer_cast<NodeSnapshot>(previous);
+    return true;
+}
+
+std::shared_ptr<const NodeSnapshot> NodeManager::getSnapshot() const
+{
+    return std::atomic_load(&m_publishedSnapshot);
+}
+
+std::shared_ptr<const NodeSnapshot> NodeManager::getSnapshotIfChanged(uint64_t& lastSeenEpoch) const
+{
+    std::shared_ptr<const NodeSnapshot> snapshot = std::atomic_load(&m_publishedSnapshot);
+    if (snapshot->epoch == lastSeenEpoch)
+    {
+        return nullptr; // Same picture as last time; the caller can skip its work
+    }
+    lastSeenEpoch = snapshot->epoch;
+    return snapshot;
+}
+
+// Collects every shard's dirty set into a new change batch and publishes it.
+uint64_t NodeManager::publishChanges()
+{
+    auto batch = std::make_shared<NodeChangeBatch>();
+
+    for (Shard& shard : m_shards)
+    {
+        // --- Critical Section Start (this shard only) ---
+        MeasuredLock lock(shard.mutex);
+
+        // Removals first: a node that timed out and came back reads in that order.
+        for (uint32_t nodeId : shard.timedOutIds)
+        {
+            NodeChange change;
+            change.nodeId = nodeId;
+            change.flags = NODE_TIMED_OUT;
+            batch->changes.push_back(change);
+        }
+        shard.timedOutIds.clear();
+
+        for (uint32_t slot : shard.dirtySlots)
+        {
+            uint8_t flags = shard.dirtyFlags[slot];
+            if (flags == 0)
+            {
+                continue; // Timed out since, or already taken via an earlier repeat of this slot
+            }
+            shard.dirtyFlags[slot] = 0;
+
+            NodeChange change;
+            change.nodeId = shard.table.meta(slot).nodeId;
+            change.flags = flags;
+            change.info = makeNodeInfo(shard.table, slot);
+            batch->changes.push_back(change);
+        }
+        shard.dirtySlots.clear(); // Keeps its capacity, so steady-state updates never allocate
+        // --- Critical Section End (shard mutex automatically unlocked) ---
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_changeMutex);
+        if (batch->changes.empty())
+        {
+            return m_changeEpoch; // Nothing happened; no new epoch
+        }
+        batch->epoch = ++m_changeEpoch;
+        batch->publishedAt = std::chrono::steady_clock::now();
+        m_changeHistory.push_back(batch);
+        while (m_changeHistory.size() > CHANGE_HISTORY_EPOCHS)
+        {
+            m_changeHistory.pop_front();
+        }
+    }
+
+    if (m_changeCallback)
+    {
+        m_changeCallback(*batch);
+    }
+    return batch->epoch;
+}
+
+bool NodeManager::drainChanges(uint64_t& sinceEpoch, std::vector<NodeChange>& out) const
+{
+    std::lock_guard<std::mutex> lock(m_changeMutex);
+
+    // Complete only if the oldest kept batch directly follows what the consumer has seen.
+    bool complete = m_changeHistory.empty() || m_changeHistory.front()->epoch <= sinceEpoch + 1;
+    for (const std::shared_ptr<const NodeChangeBatch>& batch : m_changeHistory)
+    {
+        if (batch->epoch > sinceEpoch)
+        {
+            out.insert(out.end(), batch->changes.begin(), batch->changes.end());
+        }
+    }
+    sinceEpoch = m_changeEpoch;
+    return complete;
+}
+
+// Prints only what changed since the last call. Nodes that were merely heard from
+// are left out: their entries would only refresh the "last heard" column.
+void NodeManager::printChanges(uint64_t& lastPrintedEpoch)
+{
+    std::vector<NodeChange> changes;
+    if (!drainChanges(lastPrintedEpoch, changes))
+    {
+        TDL_LOG_REPORT << "[NodeMgr] Change feed fell behind; printing the full list.";
+        printNodeList();
+        return;
+    }
+
+    bool printedHeader = false;
+    for (const NodeChange& change : changes)
+    {
+        if ((change.flags & (NODE_ADDED | NODE_POSITION_UPDATED | NODE_TIMED_OUT)) == 0)
+        {
+            continue;
+        }
+        if (!printedHeader)
+        {
+            TDL_LOG_REPORT << "\n===== Node Changes (epoch " << lastPrintedEpoch << ", "
+                << getSnapshot()->nodes.size() << " known) =====";
+            printedHeader = true;
+        }
+
+        LogLine line = LogLine::report(); // One record per change, submitted at the end of the iteration
+        if (change.flags & NODE_TIMED_OUT)
+        {
+            line << "  - Node ID: " << change.nodeId << " timed out";
+            continue;
+        }
+        line << ((change.flags & NODE_ADDED) ? "  + Node ID: " : "  ~ Node ID: ") << change.nodeId
+            << " | Pos (Lat/Lon): ";
+        if (change.flags & NODE_POSITION_UPDATED)
+        {
+            line << change.info.lastPosition.latitude << "/" << change.info.lastPosition.longitude;
+        }
+        else
+        {
+            line << "N/A";
+        }
+    }
+    if (printedHeader)
+    {
+        TDL_LOG_REPORT << "========================================";
+    }
+}
+
+// --- Checkpoints ---
+// File layout: a CheckpointHeader, then nodeCount CheckpointRecords, little-endian
+// as laid out in memory. Ages are relative to savedAtUnixMs: steady_clock readings
+// mean nothing to the next process, so only the wall clock crosses a restart.
+static constexpr uint64_t CHECKPOINT_MAGIC = 0x3145444F4E4C4454ull; // "TDLNODE1" in file byte order
+static constexpr uint32_t CHECKPOINT_VERSION = 1;
+static constexpr uint32_t CHECKPOINT_HAS_POSITION = 0x1;
+
+struct CheckpointHeader
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t nodeCount;
+    int64_t savedAtUnixMs;
+};
+
+struct CheckpointRecord
+{
+    uint32_t nodeId;
+    uint32_t flags;        // CHECKPOINT_HAS_POSITION
+    uint64_t ageMs;        // How long before savedAtUnixMs the node was last heard
+    double latitude;
+    double longitude;
+    double altitude;
+};
+
+static_assert(sizeof(CheckpointHeader) == 24 && sizeof(CheckpointRecord) == 40, "Checkpoint layout is part of the file format");
+
+static int64_t unixMillisecondsNow()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool NodeManager::saveCheckpoint(const std::string& path)
+{
+    auto now = std::chrono::steady_clock::now();
+    std::vector<CheckpointRecord> records;
+
+    for (Shard& shard : m_shards)
+    {
+        // --- Critical Section Start (this shard only) ---
+        MeasuredLock lock(shard.mutex);
+        for (uint32_t slot = 0; slot < shard.table.slotLimit(); ++slot)
+        {
+            if (!shard.table.isOccupied(slot))
+            {
+                continue;
+            }
+            auto age = std::chrono::duration_cast<std::chrono::milliseconds>(now - NodeTable::fromTicks(shard.table.lastHeardTicks(slot)));
+            CheckpointRecord record = {};
+            record.nodeId = shard.table.meta(slot).nodeId;
+            record.flags = shard.table.meta(slot).hasPosition ? CHECKPOINT_HAS_POSITION : 0;
+            record.ageMs = age.count() > 0 ? static_cast<uint64_t>(age.count()) : 0;
+            record.latitude = shard.table.latitude(slot);
+            record.longitude = shard.table.longitude(slot);
+            record.altitude = shard.table.altitude(slot);
+            records.push_back(record);
+        }
+        // --- Critical Section End (shard mutex automatically unlocked) ---
+    }
+
+    CheckpointHeader header = {};
+    header.magic = CHECKPOINT_MAGIC;
+    header.version = CHECKPOINT_VERSION;
+    header.nodeCount = static_cast<uint32_t>(records.size());
+    header.savedAtUnixMs = unixMillisecondsNow();
+
+    // Write a temporary file and swap it in, so a crash mid-write never leaves a torn checkpoint.
+    std::string tempPath = path + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (file == nullptr)
+    {
+        TDL_LOG_ERROR << "[NodeMgr] Could not write checkpoint '" << tempPath << "'.";
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1
+        && (records.empty() || fwrite(records.data(), sizeof(CheckpointRecord), records.size(), file) == records.size());
+    written = (fclose(file) == 0) && written;
+#if defined(_WIN32)
+    written = written && MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    written = written && std::rename(tempPath.c_str(), path.c_str()) == 0;
+#endif
+    if (!written)
+    {
+        TDL_LOG_ERROR << "[NodeMgr] Could not save checkpoint '" << path << "'.";
+        std::remove(tempPath.c_str());
+    }
+    return written;
+}
+
+size_t NodeManager::loadCheckpoint(const std::string& path, std::chrono::seconds maxAge)
+{
+    MappedFile file(path);
+    if (!file.isOpen())
+    {
+        TDL_LOG_INFO << "[NodeMgr] No checkpoint at '" << path << "'; starting empty.";
+        return 0;
+    }
+
+    CheckpointHeader header = {};
+    if (file.size() >= sizeof(header))
+    {
+        memcpy(&header, file.data(), sizeof(header));
+    }
+    // Divided rather than multiplied, so a corrupt count can't overflow a 32-bit size_t.
+    if (header.magic != CHECKPOINT_MAGIC || header.version != CHECKPOINT_VERSION
+        || header.nodeCount > (file.size() - sizeof(header)) / sizeof(CheckpointRecord))
+    {
+        TDL_LOG_WARNING << "[NodeMgr] '" << path << "' is not a checkpoint this build can read; starting empty.";
+        return 0;
+    }
+
+    // Time since the save counts towards every node's age (never negative if the clock stepped back).
+    int64_t sinceSaveMs = unixMillisecondsNow() - header.savedAtUnixMs;
+    uint64_t downtimeMs = sinceSaveMs > 0 ? static_cast<uint64_t>(sinceSaveMs) : 0;
+    uint64_t maxAgeMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(maxAge).count());
+
+    // Records are copied out of the mapping, which promises no alignment.
+    const uint8_t* records = file.data() + sizeof(header);
+    std::vector<SecondHandNode> nodes;
+    nodes.reserve(header.nodeCount);
+    for (uint32_t i = 0; i < header.nodeCount; ++i)
+    {
+        CheckpointRecord record;
+        memcpy(&record, records + static_cast<size_t>(i) * sizeof(record), sizeof(record));
+        uint64_t ageMs = record.ageMs + downtimeMs;
+        if (ageMs > maxAgeMs)
+        {
+            continue; // Too old to be useful
+        }
+        SecondHandNode node;
+        node.nodeId = record.nodeId;
+        node.ageMs = ageMs;
+        node.hasPosition = (record.flags & CHECKPOINT_HAS_POSITION) != 0;
+        node.latitude = record.latitude;
+        node.longitude = record.longitude;
+        node.altitude = record.altitude;
+        nodes.push_back(node);
+    }
+    size_t restored = insertSecondHand(nodes.data(), nodes.size());
+
+    TDL_LOG_INFO << "[NodeMgr] Restored " << restored << " of " << header.nodeCount << " nodes from checkpoint '" << path
+        << "' (saved " << downtimeMs / 1000.0 << " s ago); they stay stale until heard from.";
+    return restored;
+}
+
+// --- Peer Sync ---
+size_t NodeManager::mergeSyncEntries(const SyncEntry* entries, size_t count, std::chrono::seconds maxAge)
+{
+    uint64_t maxAgeMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(maxAge).count());
+    SecondHandNode nodes[MAX_SYNC_ENTRIES];
+    size_t usable = 0;
+    for (size_t i = 0; i < count && i < MAX_SYNC_ENTRIES; ++i)
+    {
+        const SyncEntry& entry = entries[i];
+        if (entry.ageMs > maxAgeMs)
+        {
+            continue; // The neighbour is about to time it out too
+        }
+        SecondHandNode& node = nodes[usable++];
+        node.nodeId = entry.nodeId;
+        node.ageMs = entry.ageMs;
+        node.hasPosition = (entry.flags & SYNC_ENTRY_HAS_POSITION) != 0;
+        node.latitude = entry.latitudeE7 / 1e7;
+        node.longitude = entry.longitudeE7 / 1e7;
+        node.altitude = entry.altitudeCm / 100.0;
+    }
+    return insertSecondHand(nodes, usable);
+}
+
+// Applies second-hand nodes one shard at a time, so each shard is locked once
+// however many there are. Nodes already known (heard first-hand since startup, or
+// from an earlier source) are left alone.
+size_t NodeManager::insertSecondHand(const SecondHandNode* nodes, size_t count)
+{
+    auto now = std::chrono::steady_clock::now();
+    size_t inserted = 0;
+    for (size_t shardIndex = 0; shardIndex < NUM_SHARDS; ++shardIndex)
+    {
+        Shard& shard = m_shards[shardIndex];
+
+        // --- Critical Section Start (this shard only) ---
+        MeasuredLock lock(shard.mutex);
+        size_t insertedBefore = inserted;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const SecondHandNode& node = nodes[i];
+            if (shardIndexOf(node.nodeId) != shardIndex || node.nodeId == m_selfNodeId
+                || shard.table.find(node.nodeId) != NodeTable::INVALID_SLOT)
+            {
+                continue;
+            }
+
+            auto lastHeard = NodeTable::toTicks(now - std::chrono::milliseconds(node.ageMs));
+            uint32_t slot = insertNode(shard, node.nodeId);
+            if (slot == NodeTable::INVALID_SLOT)
+            {
+                continue; // Table full; first-hand nodes may still free room later
+            }
+            shard.table.lastHeardTicks(slot) = lastHeard;
+            shard.table.meta(slot).stale = true;
+            uint8_t changeFlags = NODE_ADDED;
+            if (node.hasPosition && isPlausiblePosition(node.latitude, node.longitude, node.altitude)) // Else known, but not where
+            {
+                shard.table.latitude(slot) = node.latitude;
+                shard.table.longitude(slot) = node.longitude;
+                shard.table.altitude(slot) = node.altitude;
+                shard.table.meta(slot).hasPosition = true;
+                shard.positions.update(slot, node.latitude, node.longitude);
+                changeFlags |= NODE_POSITION_UPDATED;
+            }
+            shard.timeouts.schedule(slot, lastHeard); // Expires when it would have for the original listener
+            markDirty(shard, slot, changeFlags);
+            ++inserted;
+        }
+        if (inserted != insertedBefore)
+        {
+            markChanged(shard);
+        }
+        // --- Critical Section End (shard mutex automatically unlocked) ---
+    }
+    return inserted;
+}
+
+// Prints the latest published snapshot of known nodes to the console.
 void NodeManager::printNodeList()
 {
-    // Get a thread-safe copy of the list first.
-    std::vector<NodeInfo> currentNodes = getNodeList(); // This method handles its own locking.
+    // Read the published snapshot; no shard lock is taken and nothing is copied.
+    std::shared_ptr<const NodeSnapshot> snapshot = getSnapshot();
+    const std::vector<NodeInfo>& currentNodes = snapshot->nodes;
 
     // Don't print anything if the list is empty.
     if (currentNodes.empty())
     {
-        // std::cout << "[NodeMgr] Node list is empty." << std::endl; // Optional: uncomment if you want this message
+        // TDL_LOG_INFO << "[NodeMgr] Node list is empty."; // Optional: uncomment if you want this message
         return;
     }
 
@@ -157,25 +1065,31 @@ void NodeManager::printNodeList()
     auto now = std::chrono::steady_clock::now();
 
     // Print a header for the list.
-    std::cout << "\n===== Known Network Nodes (" << currentNodes.size() << ") =====" << std::endl;
+    TDL_LOG_REPORT << "\n===== Known Network Nodes (" << currentNodes.size() << ") =====";
 
     // Loop through the copied list and print details for each node.
     for (const auto& node : currentNodes)
     {
         auto elapsedSeconds = std::chrono::duration_cast<std::chrono::seconds>(now - node.lastHeardTime).count();
-        std::cout << "  Node ID: " << node.nodeId
+        LogLine line = LogLine::report(); // One record per node, submitted at the end of the iteration
+        line << "  Node ID: " << node.nodeId
             << " | Pos (Lat/Lon): ";
-        // Check if we have valid position data (simple check based on default 0.0 values)
-        if (node.lastPosition.latitude != 0.0 || node.lastPosition.longitude != 0.0)
+        // Check if we have received position data for this node
+        if (node.hasPosition)
         {
-            std::cout << node.lastPosition.latitude << "/" << node.lastPosition.longitude;
+            line << node.lastPosition.latitude << "/" << node.lastPosition.longitude;
         }
         else
         {
-            std::cout << "N/A"; // Print N/A if we haven't received a position report yet.
+            line << "N/A"; // Print N/A if we haven't received a position report yet.
+        }
+        line << " | Last Heard: " << elapsedSeconds << "s ago" << (node.stale ? " (stale)" : "");
+        if (node.link.received > 0)
+        {
+            line << " | Loss: " << node.link.lossRatio() * 100.0 << "% (" << node.link.lost << " lost, "
+                << node.link.reordered << " reordered) | Latency: " << node.link.latencyAvgUs / 1000.0 << " ms";
         }
-        std::cout << " | Last Heard: " << elapsedSeconds << "s ago" << std::endl;
     }
     // Print a footer for the list.
-    std::cout << "========================================" << std::endl;
+    TDL_LOG_REPORT << "========================================";
 }
\ No newline at end of file
@@ -1,43 +1,330 @@
 #ifndef NODE_MANAGER_H
 #define NODE_MANAGER_H
 
-#include <map>            // To store the list of nodes (ID -> NodeInfo)
+#include <array>          // Fixed set of shards
+#include <atomic>         // Per-shard change counters
+#include <memory>         // shared_ptr for published snapshots
 #include <vector>         // To return a list of nodes
 #include <mutex>          // To protect access to the node list from multiple threads
 #include <chrono>         // For time calculations (timeouts)
+#include <deque>          // Recent change batches
+#include <functional>     // For the expiry callback
+#include <string>         // Checkpoint paths
+#include <utility>        // std::pair for spatial query hits
 #include "TdlMessages.h"  // Needs definitions of NodeInfo and PositionReport
+#include "NodeTable.h"    // Flat per-shard storage for the nodes
+#include "TimerWheel.h"   // Per-shard timeout tracking
+#include "SpatialGrid.h"  // Per-shard position index
+
+// The node table is split into NUM_SHARDS independent shards, chosen by a hash of
+// the node ID, each with its own lock. Receive threads updating different nodes
+// rarely contend, and whole-table sweeps (pruning, listing) only ever hold one
+// shard's lock at a time, so they never stall ingest for the whole table.
+
+// An immutable, versioned picture of the whole node table, published by
+// NodeManager::publishSnapshot(). Readers hold it through a shared_ptr for as
+// long as they like; the writer never modifies a snapshot once it is published.
+struct NodeSnapshot
+{
+	uint64_t epoch = 0;                                  // Increases by one with each published snapshot.
+	std::chrono::steady_clock::time_point publishedAt;   // When the writer built it.
+	std::vector<NodeInfo> nodes;                         // Every known node, sorted by node ID.
+};
+
+// --- Change Feed ---
+// What happened to one node since the previous change epoch. Repeated changes
+// between two publishes are merged into a single entry with several flags set, so
+// a node heard 50 times in a second costs one entry, not 50.
+enum NodeChangeFlags : uint8_t
+{
+	NODE_ADDED = 1 << 0,            // First heard from in this epoch
+	NODE_POSITION_UPDATED = 1 << 1, // Sent a PositionReport
+	NODE_HEARD = 1 << 2,            // Sent anything (set along with the two above)
+	NODE_TIMED_OUT = 1 << 3         // Removed by pruneTimeouts(); 'info' is not meaningful
+};
+
+struct NodeChange
+{
+	uint32_t nodeId = 0;
+	uint8_t flags = 0;   // NodeChangeFlags
+	NodeInfo info;       // The node as it was when the epoch was published
+};
+
+// Every change in one epoch, published by NodeManager::publishChanges(). A node's
+// own entries appear in the order they happened (a node that timed out and came
+// back in the same epoch has a NODE_TIMED_OUT entry followed by a NODE_ADDED one).
+struct NodeChangeBatch
+{
+	uint64_t epoch = 0;
+	std::chrono::steady_clock::time_point publishedAt;
+	std::vector<NodeChange> changes;
+};
+
+// Names one node for as long as it stays in the table: the node's shard slot and
+// that slot's generation when the handle was made. Once the node times out the
+// generation moves on, so the handle can never reach a later node in the same slot.
+struct NodeHandle
+{
+	uint32_t nodeId = 0;
+	uint32_t slot = NodeTable::INVALID_SLOT; // INVALID_SLOT: no such node
+	uint32_t generation = 0;
+
+	bool isValid() const { return slot != NodeTable::INVALID_SLOT; }
+};
+
+// One result of NodeManager::getDistancesFrom().
+struct NodeDistance
+{
+	uint32_t nodeId = 0;
+	double meters = 0.0;
+};
+
+enum class DistanceFormula
+{
+	FlatEarth, // Equirectangular, as SpatialGrid uses: fine within a few hundred km
+	Haversine  // Great circle: right at any range, about twice the cost
+};
 
 class NodeManager
 {
 public:
 	// Constructor: Takes the ID of the node this manager belongs to (to ignore self).
-	NodeManager(uint32_t selfNodeId);
+	// With 'maxNodes' set, storage for that many nodes is allocated here, once:
+	// adding and timing out nodes then never touch the heap, and once the table is
+	// full, new nodes are turned away (counted in NodesRejected) until others time
+	// out. Each shard gets room for twice its even share, since IDs never hash
+	// perfectly evenly, and a shared count holds the total to 'maxNodes'.
+	// 0 leaves the table unbounded, growing as nodes arrive.
+	explicit NodeManager(uint32_t selfNodeId, size_t maxNodes = 0);
 
 	// Updates the position information for a node based on a received PositionReport.
-	// Adds the node if it's not already known.
+	// Adds the node if it's not already known. A report numbered below the one whose
+	// position is stored arrived out of order and is ignored (counted in
+	// StalePositionsRejected), so a late packet never rolls a node back. So is one
+	// whose latitude, longitude or altitude is not finite or not on the Earth
+	// (InvalidPositions): it neither adds the node nor counts as hearing from it.
 	void updateNodePosition(const PositionReport& report);
 
 	// Updates only the 'lastHeardTime' for a node when any message is received.
-	// Adds the node (without position info) if it's not already known.
+	// Adds the node (without position info) if it's not already known. The header
+	// form also feeds the node's NodeLinkStats from its sequence number and send
+	// time; call it before updateNodePosition() for the same message. It returns
+	// false for a message whose number was seen already, or is too far behind the
+	// highest to tell: the node is left untouched and the caller should drop it.
+	bool updateLastHeardTime(const MessageHeader& header);
 	void updateLastHeardTime(uint32_t nodeId);
 
 	// Checks the list and removes any nodes that haven't sent a message
-	// within the specified timeout duration.
+	// within the specified timeout duration (to a resolution of TIMEOUT_WHEEL_TICK).
+	// Each shard's timer wheel hands back only the nodes that have expired, so the
+	// cost is proportional to what times out, not to the size of the table.
 	void pruneTimeouts(std::chrono::seconds timeoutDuration);
 
-	// Returns a copy of the current list of known nodes (safe for other threads to use).
+	// Called once for every node removed by pruneTimeouts(), after the shard lock
+	// has been released (so the callback may call back into NodeManager).
+	// Set this before any thread starts calling pruneTimeouts().
+	using ExpiryCallback = std::function<void(uint32_t nodeId)>;
+	void setExpiryCallback(ExpiryCallback callback) { m_expiryCallback = std::move(callback); }
+
+	// Returns a copy of the current list of known nodes (safe for other threads to use),
+	// sorted by node ID. Shards are copied one after another, so the list is not an
+	// atomic picture of the whole table, but every entry is internally consistent.
 	std::vector<NodeInfo> getNodeList();
 
-	// Prints the current list of known nodes and their status to the console.
+	// --- Node Handles ---
+	// findNode() looks a node up once (an invalid handle if it isn't known);
+	// getNode() then reads it straight from its slot, skipping the ID lookup, and
+	// returns false once the node has timed out.
+	NodeHandle findNode(uint32_t nodeId);
+	bool getNode(const NodeHandle& handle, NodeInfo& out);
+
+	// --- Snapshot Publication ---
+	// Builds a new NodeSnapshot and publishes it, but only if something has changed
+	// since the last one. Meant to be called periodically from a single writer thread.
+	// Returns true if a new epoch was published.
+	bool publishSnapshot();
+
+	// Returns the most recently published snapshot (an empty epoch-0 snapshot before
+	// the first publish). Never takes a shard lock, so readers cannot stall ingest.
+	std::shared_ptr<const NodeSnapshot> getSnapshot() const;
+
+	// Like getSnapshot(), but returns nullptr if the published epoch is still
+	// 'lastSeenEpoch'. Otherwise updates 'lastSeenEpoch' and returns the new snapshot.
+	std::shared_ptr<const NodeSnapshot> getSnapshotIfChanged(uint64_t& lastSeenEpoch) const;
+
+	// --- Change Feed ---
+	// Every update marks its node dirty in its shard (under the lock it already
+	// holds); publishChanges() collects the dirty entries into one NodeChangeBatch
+	// per epoch. Consumers then do work proportional to what changed, not to the
+	// size of the table. The last CHANGE_HISTORY_EPOCHS batches are kept.
+	static constexpr size_t CHANGE_HISTORY_EPOCHS = 64;
+
+	// Gathers and publishes the changes since the last call, then hands the batch
+	// to the change callback. Meant to be called periodically from a single writer
+	// thread. Returns the current change epoch (unchanged if nothing happened).
+	uint64_t publishChanges();
+
+	// Appends every change published after 'sinceEpoch' to 'out', oldest epoch first,
+	// and moves 'sinceEpoch' up to the latest epoch. Start a new consumer at 0. Returns
+	// false if some epochs after 'sinceEpoch' were already dropped from the history:
+	// the consumer missed changes and should rebuild its picture from getSnapshot().
+	bool drainChanges(uint64_t& sinceEpoch, std::vector<NodeChange>& out) const;
+
+	// Push-style alternative: called by publishChanges() with every new batch, with
+	// no shard lock held. Set this before any thread starts publishing changes.
+	using ChangeCallback = std::function<void(const NodeChangeBatch& batch)>;
+	void setChangeCallback(ChangeCallback callback) { m_changeCallback = std::move(callback); }
+
+	// Incremental console view: prints what changed since 'lastPrintedEpoch' (and
+	// advances it), falling back to the full printNodeList() when it fell behind.
+	void printChanges(uint64_t& lastPrintedEpoch);
+
+	// --- Checkpoints ---
+	// A restarted node needn't be blind for a whole timeout while broadcasts trickle
+	// back in. saveCheckpoint() writes every known node (ID, position, how long ago it
+	// was heard) to a compact binary file, replacing the previous one atomically; it
+	// locks one shard at a time, like getNodeList(). loadCheckpoint() maps such a file
+	// and bulk-inserts its nodes, one shard lock each, skipping nodes already known
+	// and any whose age (including the time since the save) exceeds 'maxAge'.
+	// Restored nodes keep their real last-heard age, so they expire on schedule unless
+	// heard from, and are marked stale (NodeInfo::stale) until they are.
+	bool saveCheckpoint(const std::string& path);
+	size_t loadCheckpoint(const std::string& path, std::chrono::seconds maxAge); // Returns how many were restored
+
+	// --- Peer Sync ---
+	// Bulk-inserts one SyncResponse chunk the same way as a checkpoint: unknown nodes
+	// only, skipping any the neighbour last heard more than 'maxAge' ago, marked
+	// stale until heard first-hand. Returns how many were added. (NodeSync drives
+	// the protocol; this is only the table side.)
+	size_t mergeSyncEntries(const SyncEntry* entries, size_t count, std::chrono::seconds maxAge);
+
+	// --- Spatial Queries ---
+	// Both look only at nodes that have reported a position, lock one shard at a time
+	// (like getNodeList()), and visit only the grid cells around the point, so their
+	// cost follows the number of nodes nearby rather than the size of the table.
+	// Results replace the contents of 'out'; reuse it to keep its capacity.
+
+	// IDs of every node within 'radiusMeters' of (latitude, longitude), nearest first.
+	size_t findNodesWithin(double latitude, double longitude, double radiusMeters, std::vector<uint32_t>& out);
+
+	// IDs of the 'count' nodes nearest to (latitude, longitude), nearest first
+	// (fewer if fewer nodes have a position).
+	size_t findNearestNodes(double latitude, double longitude, size_t count, std::vector<uint32_t>& out);
+
+	// --- Bulk Scans ---
+	// Whole-table questions, answered with ScanKernels over each shard's columns
+	// (four slots per instruction in AVX2 builds, two on ARM) under one shard lock at a time.
+	// Every slot is scanned, so their cost follows the size of the table; for a
+	// small area around a point, findNodesWithin() through the grid is cheaper.
+	// Results come in no particular order and replace the contents of 'out'.
+
+	// Distance from (latitude, longitude) to every node that has a position.
+	size_t getDistancesFrom(double latitude, double longitude, DistanceFormula formula, std::vector<NodeDistance>& out);
+
+	// IDs of every positioned node inside the box, edges included. The box crosses
+	// the antimeridian when minLongitude > maxLongitude.
+	size_t findNodesInBox(double minLatitude, double maxLatitude, double minLongitude, double maxLongitude,
+		std::vector<uint32_t>& out);
+
+	// IDs of every node not heard from for at least 'age' (positioned or not).
+	size_t findNodesNotHeardFor(std::chrono::milliseconds age, std::vector<uint32_t>& out);
+
+	// Prints the latest published snapshot of known nodes and their status to the console.
 	void printNodeList();
 
 	// Gets the ID of the node that owns this manager instance.
 	uint32_t getSelfNodeId() const { return m_selfNodeId; }
 
+	size_t getMaxNodes() const { return m_maxNodes; } // 0 = unbounded
+
+	static constexpr size_t NUM_SHARDS = 16; // Must be a power of two
+
+	// Index of the shard that owns a node ID. Exposed so receive workers can route
+	// each node to one worker and keep every worker on its own set of shards.
+	static size_t shardIndexOf(uint32_t nodeId)
+	{
+		static_assert((NUM_SHARDS & (NUM_SHARDS - 1)) == 0, "NUM_SHARDS must be a power of two");
+		uint32_t mixed = nodeId * 2654435769u;
+		return (mixed >> 24) & (NUM_SHARDS - 1);
+	}
+
+	// Timer wheel geometry: 512 buckets of 100 ms cover 51.2 s, comfortably more
+	// than NODE_TIMEOUT_SECONDS, which keeps every prune sweep O(expired).
+	static constexpr std::chrono::milliseconds TIMEOUT_WHEEL_TICK{ 100 };
+	static constexpr size_t TIMEOUT_WHEEL_BUCKETS = 512;
+
 private:
+	// One independently locked slice of the node table. Aligned to a cache line so
+	// two shards' locks never share one.
+	struct alignas(64) Shard
+	{
+		NodeTable table;                       // The nodes whose IDs hash to this shard.
+		TimerWheel timeouts{ std::chrono::duration_cast<std::chrono::steady_clock::duration>(TIMEOUT_WHEEL_TICK).count(),
+			TIMEOUT_WHEEL_BUCKETS };           // table slots filed by last heard time.
+		SpatialGrid positions;                 // table slots that have a position, filed by lat/lon cell.
+		std::vector<uint32_t> dirtySlots;      // Slots changed since the last publishChanges() (may repeat).
+		std::vector<uint8_t> dirtyFlags;       // NodeChangeFlags gathered per slot; 0 = clean.
+		std::vector<uint32_t> timedOutIds;     // Nodes removed since the last publishChanges().
+		std::mutex mutex;                      // Protects everything above.
+		std::atomic<uint64_t> version{ 0 };    // Bumped (under the lock) on every change to the shard.
+	};
+
+	// Picks the shard that owns a node ID.
+	Shard& shardFor(uint32_t nodeId);
+
+	// Adds a node to its shard's table (shard locked). Returns INVALID_SLOT, and
+	// counts NodesRejected, if the manager is at maxNodes.
+	uint32_t insertNode(Shard& shard, uint32_t nodeId);
+
+	// Rebuilds the public NodeInfo view of one table slot.
+	static NodeInfo makeNodeInfo(const NodeTable& table, uint32_t slot);
+
+	// Marks a shard as changed (call with the shard locked).
+	static void markChanged(Shard& shard) { shard.version.fetch_add(1, std::memory_order_relaxed); }
+
+	// Records a change to one slot for the change feed (call with the shard locked).
+	static void markDirty(Shard& shard, uint32_t slot, uint8_t flags);
+
+	// Updates a node's link statistics from one message header (shard locked).
+	// Returns false for a duplicate, which changes nothing but the duplicate count.
+	static bool trackSequence(NodeTable::LinkState& link, const MessageHeader& header, uint32_t receiveTimeUs);
+
+	// A node learned from a checkpoint or a neighbour rather than heard directly.
+	struct SecondHandNode
+	{
+		uint32_t nodeId = 0;
+		uint64_t ageMs = 0;  // How long ago its original listener last heard it
+		bool hasPosition = false;
+		double latitude = 0.0;
+		double longitude = 0.0;
+		double altitude = 0.0;
+	};
+	size_t insertSecondHand(const SecondHandNode* nodes, size_t count);
+
+	// Copies every node into 'out' (cleared first) and sorts it by node ID.
+	void copyNodes(std::vector<NodeInfo>& out);
+
+	// Appends (distance, node ID) for every positioned node within 'radiusMeters'.
+	using SpatialHit = std::pair<double, uint32_t>;
+	void collectWithin(double latitude, double longitude, double radiusMeters, std::vector<SpatialHit>& hits);
+
 	uint32_t m_selfNodeId;                     // Store the ID of this node itself.
-	std::map<uint32_t, NodeInfo> m_nodeMap;    // The main data structure: maps a node's ID to its NodeInfo.
-	std::mutex m_mutex;                        // Mutex to ensure only one thread modifies the m_nodeMap at a time.
+	size_t m_maxNodes;                         // 0 = unbounded
+	std::atomic<size_t> m_nodeCount{ 0 };      // Across all shards; only kept when m_maxNodes is set
+	std::array<Shard, NUM_SHARDS> m_shards;    // The node table, partitioned by node ID hash.
+	ExpiryCallback m_expiryCallback;           // Optional hook told about every timed-out node.
+
+	// --- Snapshot state ---
+	// m_publishedSnapshot is only ever read/written with std::atomic_load/atomic_store.
+	std::shared_ptr<const NodeSnapshot> m_publishedSnapshot;
+	std::shared_ptr<NodeSnapshot> m_spareSnapshot;  // The previous snapshot, recycled once readers let go.
+	uint64_t m_publishedVersion = ~0ull;            // Sum of shard versions at the last publish (writer only).
+
+	// --- Change feed state ---
+	mutable std::mutex m_changeMutex;               // Protects m_changeHistory and m_changeEpoch.
+	std::deque<std::shared_ptr<const NodeChangeBatch>> m_changeHistory; // Oldest first.
+	uint64_t m_changeEpoch = 0;
+	ChangeCallback m_changeCallback;
 };
 
 #endif // NODE_MANAGER_H
\ No newline at end of file
@@ -0,0 +1,266 @@
+// NodeSync.cpp
+#include "NodeSync.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include "Logger.h"
+#include "MessageSequencer.h"
+#include "NodeManager.h"
+#include "TdlCodec.h"
+#include "Transport.h"
+
+NodeSync::NodeSync(Transport& transport, NodeManager& nodeManager, MessageSequencer& sequencer, bool compactWire, std::chrono::seconds maxAge) :
+	m_transport(transport),
+	m_nodeManager(nodeManager),
+	m_sequencer(sequencer),
+	m_selfNodeId(nodeManager.getSelfNodeId()),
+	m_compactWire(compactWire),
+	m_maxAge(maxAge)
+{
+}
+
+void NodeSync::startJoin()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_joinState = JoinState::Requesting;
+	m_joinAttempts = 0;
+	m_requestId = 0; // Nothing sent yet: the next tick sends as soon as a neighbour is known
+}
+
+bool NodeSync::isJoinComplete() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_joinState == JoinState::Complete;
+}
+
+NodeSyncCounters NodeSync::getCounters() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_counters;
+}
+
+// --- Receiving ---
+void NodeSync::onRequest(const SyncRequest& request)
+{
+	auto now = std::chrono::steady_clock::now();
+	uint32_t requester = request.header.sourceNodeId;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto last = m_lastRequestFrom.find(requester);
+	if (last != m_lastRequestFrom.end() && now - last->second < REQUEST_RATE_LIMIT)
+	{
+		++m_counters.requestsRateLimited; // A retry arriving early, or a misbehaving peer
+		return;
+	}
+	if (last == m_lastRequestFrom.end() && m_lastRequestFrom.size() >= MAX_TRACKED_REQUESTERS)
+	{
+		// Requester IDs are whatever the datagram claims, so a storm of made-up ones
+		// must not grow the table (or queue an answer) without limit.
+		++m_counters.requestsRateLimited;
+		return;
+	}
+	m_lastRequestFrom[requester] = now;
+	m_pendingRequests.push_back(PendingRequest{ requester, request.requestId });
+}
+
+void NodeSync::onResponse(const SyncResponse& response)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_joinState != JoinState::Requesting || m_requestId == 0 || response.requestId != m_requestId)
+	{
+		return; // An answer to a request this node has since given up on
+	}
+	++m_counters.chunksReceived;
+
+	if (m_chunksSeen.empty())
+	{
+		m_chunksSeen.assign(response.chunkCount, false);
+		m_chunksMissing = response.chunkCount;
+	}
+	if (response.chunkIndex >= m_chunksSeen.size() || m_chunksSeen[response.chunkIndex])
+	{
+		return; // Inconsistent count, or a duplicate
+	}
+	m_chunksSeen[response.chunkIndex] = true;
+	--m_chunksMissing;
+
+	// The NodeManager takes its own shard locks; this mutex only orders the bookkeeping.
+	m_counters.nodesMerged += m_nodeManager.mergeSyncEntries(response.entries, response.entryCount, m_maxAge);
+	if (m_chunksMissing == 0)
+	{
+		m_joinState = JoinState::Complete;
+		TDL_LOG_INFO << "[Sync] Join sync complete from node " << response.header.sourceNodeId << ": "
+			<< m_counters.nodesMerged << " nodes learned in " << m_chunksSeen.size() << " chunk(s).";
+	}
+}
+
+// --- Sending ---
+template <typename Message>
+bool NodeSync::send(Message& message)
+{
+	m_sequencer.stamp(message.header);
+	if (!m_compactWire)
+	{
+		return m_transport.sendOnChannel(Message::MESSAGE_TYPE, &message, sizeof(message));
+	}
+	uint8_t encoded[TdlCodec::MAX_SYNC_ENCODED_SIZE];
+	size_t size = TdlCodec::encode(message, encoded, sizeof(encoded));
+	return size != 0 && m_transport.sendOnChannel(Message::MESSAGE_TYPE, encoded, size);
+}
+
+void NodeSync::tick(std::chrono::steady_clock::time_point now)
+{
+	// --- Answer Neighbours ---
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_takenRequests.swap(m_pendingRequests);
+		// Past REQUEST_RATE_LIMIT an entry no longer holds anyone back.
+		for (auto entry = m_lastRequestFrom.begin(); entry != m_lastRequestFrom.end();)
+		{
+			entry = (now - entry->second >= REQUEST_RATE_LIMIT) ? m_lastRequestFrom.erase(entry) : std::next(entry);
+		}
+	}
+	for (const PendingRequest& request : m_takenRequests)
+	{
+		startAnswer(request, now);
+	}
+	m_takenRequests.clear();
+
+	size_t budget = MAX_CHUNKS_PER_TICK;
+	for (Answer& answer : m_answers)
+	{
+		budget -= sendAnswerChunks(answer, budget);
+	}
+	m_answers.erase(std::remove_if(m_answers.begin(), m_answers.end(),
+		[](const Answer& answer) { return answer.nextChunk == answer.chunkCount; }), m_answers.end());
+
+	// --- Own Join Request ---
+	sendJoinRequest(now);
+}
+
+// Takes a copy of the table for one answer. Nodes learned second-hand are left out,
+// so stale information is never passed on, and so is the requester itself.
+void NodeSync::startAnswer(const PendingRequest& request, std::chrono::steady_clock::time_point now)
+{
+	for (Answer& answer : m_answers)
+	{
+		if (answer.requester == request.requester)
+		{
+			answer.requestId = request.requestId; // It retried: finish the answer under the new ID
+			answer.nextChunk = 0;
+			return;
+		}
+	}
+
+	Answer answer;
+	answer.requester = request.requester;
+	answer.requestId = request.requestId;
+	std::shared_ptr<const NodeSnapshot> snapshot = m_nodeManager.getSnapshot();
+	answer.entries.reserve(snapshot->nodes.size());
+	for (const NodeInfo& node : snapshot->nodes)
+	{
+		if (node.stale || node.nodeId == request.requester)
+		{
+			continue;
+		}
+		auto age = std::chrono::duration_cast<std::chrono::milliseconds>(now - node.lastHeardTime).count();
+		SyncEntry entry;
+		entry.nodeId = node.nodeId;
+		entry.ageMs = age > 0 ? static_cast<uint32_t>(age) : 0;
+		if (node.hasPosition)
+		{
+			entry.latitudeE7 = static_cast<int32_t>(std::lround(node.lastPosition.latitude * 1e7));
+			entry.longitudeE7 = static_cast<int32_t>(std::lround(node.lastPosition.longitude * 1e7));
+			entry.altitudeCm = static_cast<int32_t>(std::lround(node.lastPosition.altitude * 100.0));
+			entry.flags = SYNC_ENTRY_HAS_POSITION;
+		}
+		answer.entries.push_back(entry);
+	}
+	size_t chunks = (answer.entries.size() + MAX_SYNC_ENTRIES - 1) / MAX_SYNC_ENTRIES;
+	answer.chunkCount = static_cast<uint16_t>(std::min<size_t>(std::max<size_t>(chunks, 1), UINT16_MAX)); // Empty still gets one
+	m_answers.push_back(std::move(answer));
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	++m_counters.requestsAnswered;
+}
+
+size_t NodeSync::sendAnswerChunks(Answer& answer, size_t budget)
+{
+	size_t sent = 0;
+	SyncResponse response; // Reused: only the fields that differ per chunk are rewritten
+	response.header.sourceNodeId = m_selfNodeId;
+	response.targetNodeId = answer.requester;
+	response.requestId = answer.requestId;
+	response.chunkCount = answer.chunkCount;
+	while (sent < budget && answer.nextChunk < answer.chunkCount)
+	{
+		size_t first = static_cast<size_t>(answer.nextChunk) * MAX_SYNC_ENTRIES;
+		size_t count = first < answer.entries.size() ? std::min<size_t>(MAX_SYNC_ENTRIES, answer.entries.size() - first) : 0;
+		response.chunkIndex = answer.nextChunk;
+		response.entryCount = static_cast<uint16_t>(count);
+		std::copy_n(answer.entries.data() + first, count, response.entries);
+		if (!send(response))
+		{
+			break; // Try the rest next tick
+		}
+		++answer.nextChunk;
+		++sent;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_counters.chunksSent += sent;
+	return sent;
+}
+
+// Sends (or resends) this node's own request while a join sync is in progress.
+// Each attempt goes to whichever live neighbour was heard most recently, and gets
+// a fresh ID so late chunks of an abandoned attempt are ignored.
+void NodeSync::sendJoinRequest(std::chrono::steady_clock::time_point now)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_joinState != JoinState::Requesting || (m_requestId != 0 && now - m_lastRequestSent < RETRY_INTERVAL))
+		{
+			return;
+		}
+		if (m_joinAttempts == MAX_JOIN_ATTEMPTS)
+		{
+			m_joinState = JoinState::GaveUp;
+			TDL_LOG_WARNING << "[Sync] No complete answer after " << MAX_JOIN_ATTEMPTS << " join requests; learning neighbours as they are heard.";
+			return;
+		}
+	}
+
+	std::shared_ptr<const NodeSnapshot> snapshot = m_nodeManager.getSnapshot();
+	const NodeInfo* target = nullptr;
+	for (const NodeInfo& node : snapshot->nodes)
+	{
+		if (!node.stale && (!target || node.lastHeardTime > target->lastHeardTime))
+		{
+			target = &node;
+		}
+	}
+	if (!target)
+	{
+		return; // Nobody heard yet; doesn't use up an attempt
+	}
+
+	SyncRequest request;
+	request.header.sourceNodeId = m_selfNodeId;
+	request.targetNodeId = target->nodeId;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		++m_joinAttempts;
+		m_requestId = static_cast<uint32_t>(now.time_since_epoch().count()) | 1u; // Never 0, and unlike a restarted node's last ID
+		m_lastRequestSent = now;
+		m_chunksSeen.clear();
+		m_chunksMissing = 0;
+		request.requestId = m_requestId;
+	}
+	if (send(request))
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		++m_counters.requestsSent;
+		TDL_LOG_INFO << "[Sync] Asked node " << request.targetNodeId << " for its node table (attempt " << m_joinAttempts << ").";
+	}
+}
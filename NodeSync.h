@@ -0,0 +1,127 @@
+// NodeSync.h
+#ifndef NODE_SYNC_H
+#define NODE_SYNC_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "TdlMessages.h"
+
+class MessageSequencer;
+class NodeManager;
+class Transport;
+
+struct NodeSyncCounters
+{
+	uint64_t requestsSent = 0;
+	uint64_t requestsAnswered = 0;
+	uint64_t requestsRateLimited = 0; // Same requester again within REQUEST_RATE_LIMIT, or MAX_TRACKED_REQUESTERS already
+	uint64_t chunksSent = 0;
+	uint64_t chunksReceived = 0;      // Chunks of our own current request (duplicates included)
+	uint64_t nodesMerged = 0;         // Unknown nodes added from those chunks
+};
+
+// --- Peer-Assisted State Sync ---
+// A node that has just joined otherwise waits a full send interval per neighbour
+// before its table fills in. With a join sync it instead asks the neighbour it
+// heard most recently for that neighbour's whole table: one SyncRequest, answered
+// with a few SyncResponse chunks of up to MAX_SYNC_ENTRIES nodes each. Learned
+// nodes go in as stale entries, exactly like a checkpoint warm start, and turn
+// live the first time they are heard directly.
+//
+// Chunks go out on the normal transport (broadcast, or the sync group with
+// --mcast) with the requester named in them; every other node drops them on
+// arrival. Only the named neighbour answers a request, so a join costs the
+// network one table's worth of chunks, not one per neighbour.
+//
+// tick() and startJoin() run on the reactor thread; onRequest() and onResponse()
+// may be called from any receive thread.
+class NodeSync
+{
+public:
+	static constexpr size_t MAX_CHUNKS_PER_TICK = 32;  // Spreads a big answer over several send ticks
+	static constexpr unsigned MAX_JOIN_ATTEMPTS = 3;
+	static constexpr std::chrono::milliseconds RETRY_INTERVAL{ 2000 };     // Unanswered (or partly answered) request
+	static constexpr std::chrono::milliseconds REQUEST_RATE_LIMIT{ 1000 }; // Per requester, against request storms
+	static constexpr size_t MAX_TRACKED_REQUESTERS = 256; // Distinct requesters per REQUEST_RATE_LIMIT; more are turned away
+
+	// 'maxAge' drops entries the neighbour is about to time out anyway (the node timeout).
+	// 'sequencer' is the one the rest of this node's traffic is stamped from.
+	NodeSync(Transport& transport, NodeManager& nodeManager, MessageSequencer& sequencer, bool compactWire, std::chrono::seconds maxAge);
+
+	// Asks for a neighbour's table as soon as one has been heard from.
+	void startJoin();
+
+	// Sends due answer chunks and join requests. Call every send tick.
+	void tick(std::chrono::steady_clock::time_point now);
+
+	// Already checked to be addressed to this node.
+	void onRequest(const SyncRequest& request);
+	void onResponse(const SyncResponse& response);
+
+	bool isJoinComplete() const;
+	NodeSyncCounters getCounters() const;
+
+	// Disable copy and assignment
+	NodeSync(const NodeSync&) = delete;
+	NodeSync& operator=(const NodeSync&) = delete;
+
+private:
+	enum class JoinState
+	{
+		Idle,       // No join sync asked for
+		Requesting, // Waiting for a neighbour to hear, or for its answer
+		Complete,
+		GaveUp
+	};
+
+	struct PendingRequest
+	{
+		uint32_t requester = 0;
+		uint32_t requestId = 0;
+	};
+
+	// An answer being sent, possibly over several ticks. The entries are taken once,
+	// so every chunk describes the same table.
+	struct Answer
+	{
+		uint32_t requester = 0;
+		uint32_t requestId = 0;
+		std::vector<SyncEntry> entries;
+		uint16_t chunkCount = 0;
+		uint16_t nextChunk = 0;
+	};
+
+	void startAnswer(const PendingRequest& request, std::chrono::steady_clock::time_point now);
+	size_t sendAnswerChunks(Answer& answer, size_t budget); // Returns chunks sent
+	void sendJoinRequest(std::chrono::steady_clock::time_point now);
+	template <typename Message>
+	bool send(Message& message); // Stamps it first
+
+	Transport& m_transport;
+	NodeManager& m_nodeManager;
+	MessageSequencer& m_sequencer;
+	uint32_t m_selfNodeId;
+	bool m_compactWire;
+	std::chrono::seconds m_maxAge;
+
+	// Reactor thread only.
+	std::vector<Answer> m_answers;
+	std::vector<PendingRequest> m_takenRequests; // Swapped with m_pendingRequests each tick
+
+	mutable std::mutex m_mutex; // Everything below
+	std::vector<PendingRequest> m_pendingRequests;
+	std::unordered_map<uint32_t, std::chrono::steady_clock::time_point> m_lastRequestFrom; // Within REQUEST_RATE_LIMIT only; tick() expires the rest
+	JoinState m_joinState = JoinState::Idle;
+	unsigned m_joinAttempts = 0;
+	uint32_t m_requestId = 0;  // Of the request currently outstanding
+	std::chrono::steady_clock::time_point m_lastRequestSent;
+	std::vector<bool> m_chunksSeen; // By chunk index, for the current request
+	size_t m_chunksMissing = 0;
+	NodeSyncCounters m_counters;
+};
+
+#endif // NODE_SYNC_H
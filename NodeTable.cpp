@@ -0,0 +1,204 @@
+// NodeTable.cpp
+#include "NodeTable.h"
+
+// Smallest power of two that is >= value (and at least 16).
+static size_t roundUpToPowerOfTwo(size_t value)
+{
+	size_t capacity = 16;
+	while (capacity < value)
+	{
+		capacity <<= 1;
+	}
+	return capacity;
+}
+
+NodeTable::NodeTable(size_t expectedNodes)
+{
+	// Keep the index at most half full so probe sequences stay short.
+	size_t indexCapacity = roundUpToPowerOfTwo(expectedNodes * 2);
+	m_indexKeys.assign(indexCapacity, 0);
+	m_indexSlots.assign(indexCapacity, INVALID_SLOT);
+	m_indexMask = indexCapacity - 1;
+
+	m_lastHeardTicks.reserve(expectedNodes);
+	m_latitudes.reserve(expectedNodes);
+	m_longitudes.reserve(expectedNodes);
+	m_altitudes.reserve(expectedNodes);
+	m_occupied.reserve(expectedNodes);
+	m_generations.reserve(expectedNodes);
+	m_meta.reserve(expectedNodes);
+	m_links.reserve(expectedNodes);
+}
+
+void NodeTable::setCapacity(size_t maxNodes)
+{
+	m_capacity = maxNodes;
+
+	// An index already at most half full at capacity never has to grow.
+	size_t indexCapacity = roundUpToPowerOfTwo(maxNodes * 2);
+	if (indexCapacity > m_indexSlots.size())
+	{
+		m_indexKeys.assign(indexCapacity, 0);
+		m_indexSlots.assign(indexCapacity, INVALID_SLOT);
+		m_indexMask = indexCapacity - 1;
+	}
+
+	m_lastHeardTicks.reserve(maxNodes);
+	m_latitudes.reserve(maxNodes);
+	m_longitudes.reserve(maxNodes);
+	m_altitudes.reserve(maxNodes);
+	m_occupied.reserve(maxNodes);
+	m_generations.reserve(maxNodes);
+	m_meta.reserve(maxNodes);
+	m_links.reserve(maxNodes);
+	m_freeSlots.reserve(maxNodes);
+}
+
+size_t NodeTable::bucketFor(uint32_t nodeId) const
+{
+	// Fibonacci hashing: spreads small sequential IDs across the whole index.
+	uint64_t mixed = static_cast<uint64_t>(nodeId) * 0x9E3779B97F4A7C15ull;
+	return static_cast<size_t>(mixed >> 32) & m_indexMask;
+}
+
+uint32_t NodeTable::find(uint32_t nodeId) const
+{
+	for (size_t bucket = bucketFor(nodeId);; bucket = (bucket + 1) & m_indexMask)
+	{
+		uint32_t slot = m_indexSlots[bucket];
+		if (slot == INVALID_SLOT)
+		{
+			return INVALID_SLOT; // Hit an empty bucket: the ID is not in the table
+		}
+		if (m_indexKeys[bucket] == nodeId)
+		{
+			return slot;
+		}
+	}
+}
+
+uint32_t NodeTable::insert(uint32_t nodeId)
+{
+	if (m_capacity != 0 && m_size >= m_capacity)
+	{
+		return INVALID_SLOT;
+	}
+	if ((m_size + 1) * 2 > m_indexSlots.size())
+	{
+		growIndex();
+	}
+
+	// Take a recycled slot if there is one, otherwise extend every column by one.
+	uint32_t slot;
+	if (!m_freeSlots.empty())
+	{
+		slot = m_freeSlots.back();
+		m_freeSlots.pop_back();
+	}
+	else
+	{
+		slot = static_cast<uint32_t>(m_meta.size());
+		m_lastHeardTicks.push_back(0);
+		m_latitudes.push_back(0.0);
+		m_longitudes.push_back(0.0);
+		m_altitudes.push_back(0.0);
+		m_occupied.push_back(0);
+		m_generations.push_back(0);
+		m_meta.emplace_back();
+		m_links.emplace_back();
+	}
+
+	m_lastHeardTicks[slot] = 0;
+	m_latitudes[slot] = 0.0;
+	m_longitudes[slot] = 0.0;
+	m_altitudes[slot] = 0.0;
+	m_occupied[slot] = 1;
+	m_meta[slot] = NodeMeta();
+	m_meta[slot].nodeId = nodeId;
+	m_links[slot] = LinkState();
+
+	size_t bucket = bucketFor(nodeId);
+	while (m_indexSlots[bucket] != INVALID_SLOT)
+	{
+		bucket = (bucket + 1) & m_indexMask;
+	}
+	m_indexKeys[bucket] = nodeId;
+	m_indexSlots[bucket] = slot;
+
+	++m_size;
+	return slot;
+}
+
+void NodeTable::erase(uint32_t slot)
+{
+	if (slot >= m_meta.size() || !m_occupied[slot])
+	{
+		return;
+	}
+
+	uint32_t nodeId = m_meta[slot].nodeId;
+
+	// Find the node's bucket.
+	size_t hole = bucketFor(nodeId);
+	while (m_indexSlots[hole] != slot)
+	{
+		hole = (hole + 1) & m_indexMask;
+	}
+
+	// Backward-shift deletion: pull later entries of the probe run into the hole
+	// so lookups never need tombstones.
+	size_t next = hole;
+	for (;;)
+	{
+		next = (next + 1) & m_indexMask;
+		if (m_indexSlots[next] == INVALID_SLOT)
+		{
+			break;
+		}
+
+		size_t home = bucketFor(m_indexKeys[next]);
+		// The entry at 'next' may move into 'hole' only if its home bucket is not
+		// cyclically within (hole, next].
+		bool homeBetween = (hole <= next) ? (home > hole && home <= next) : (home > hole || home <= next);
+		if (!homeBetween)
+		{
+			m_indexKeys[hole] = m_indexKeys[next];
+			m_indexSlots[hole] = m_indexSlots[next];
+			hole = next;
+		}
+	}
+	m_indexSlots[hole] = INVALID_SLOT;
+
+	m_occupied[slot] = 0;
+	++m_generations[slot]; // Handles to the erased node no longer match
+	m_freeSlots.push_back(slot);
+	--m_size;
+}
+
+void NodeTable::growIndex()
+{
+	std::vector<uint32_t> oldKeys;
+	std::vector<uint32_t> oldSlots;
+	oldKeys.swap(m_indexKeys);
+	oldSlots.swap(m_indexSlots);
+
+	size_t indexCapacity = oldSlots.size() * 2;
+	m_indexKeys.assign(indexCapacity, 0);
+	m_indexSlots.assign(indexCapacity, INVALID_SLOT);
+	m_indexMask = indexCapacity - 1;
+
+	for (size_t i = 0; i < oldSlots.size(); ++i)
+	{
+		if (oldSlots[i] == INVALID_SLOT)
+		{
+			continue;
+		}
+		size_t bucket = bucketFor(oldKeys[i]);
+		while (m_indexSlots[bucket] != INVALID_SLOT)
+		{
+			bucket = (bucket + 1) & m_indexMask;
+		}
+		m_indexKeys[bucket] = oldKeys[i];
+		m_indexSlots[bucket] = oldSlots[i];
+	}
+}
@@ -0,0 +1,134 @@
+// NodeTable.h
+#ifndef NODE_TABLE_H
+#define NODE_TABLE_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "TdlMessages.h" // NodeLinkStats
+
+// --- Node Table ---
+// A cache-friendly replacement for std::map<uint32_t, NodeInfo>.
+//
+// Lookups go through a flat open-addressing index (linear probing over two parallel
+// arrays of node IDs and slot numbers), so finding a node touches one or two cache
+// lines instead of chasing tree pointers. Each node lives in a "slot", and the
+// per-packet hot fields (last heard time, lat/lon/alt) are stored column-wise in
+// contiguous arrays indexed by slot. Colder per-node metadata is kept separately.
+//
+// Slots are stable: erasing a node never moves another one, and freed slots are
+// reused by later inserts. Each slot carries a generation that moves on whenever
+// its node is erased, so (slot, generation) names one node for its whole life and
+// never a later one that reuses the slot. Not thread-safe; NodeManager locks around it.
+//
+// By default every column grows as nodes arrive. setCapacity() instead allocates
+// everything for a fixed number of nodes up front: after that, insert and erase
+// never touch the heap, and memory stays bounded however many nodes come and go.
+class NodeTable
+{
+public:
+	static constexpr uint32_t INVALID_SLOT = 0xFFFFFFFFu;
+
+	// Last heard times are stored as raw steady_clock ticks so scans stay plain integer work.
+	using Ticks = std::chrono::steady_clock::rep;
+
+	static Ticks toTicks(std::chrono::steady_clock::time_point time) { return time.time_since_epoch().count(); }
+	static std::chrono::steady_clock::time_point fromTicks(Ticks ticks)
+	{
+		return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(ticks));
+	}
+
+	// Per-node data that is not touched on every packet.
+	struct NodeMeta
+	{
+		uint32_t nodeId = 0;
+		bool hasPosition = false; // Has a PositionReport ever been received?
+		bool stale = false;       // Learned second-hand (checkpoint or peer sync) and not heard from since
+	};
+
+	// Per-node sequence tracking, updated for every sequenced message but only read
+	// in full by reports, so it gets a column of its own away from the hot fields.
+	struct LinkState
+	{
+		uint32_t highestSequence = 0;      // 0 until a sequenced message arrives
+		uint32_t newestSendTimeUs = 0;     // Latest send time seen in any of its messages
+		uint64_t recentMask = 0;           // Bit i set: highestSequence - i has arrived
+		uint32_t lastPositionSequence = 0; // Of the position currently stored
+		NodeLinkStats stats;
+	};
+
+	explicit NodeTable(size_t expectedNodes = 64);
+
+	// Caps the table at 'maxNodes' and allocates all of its storage now. Call it
+	// while the table is empty. Once full, insert() returns INVALID_SLOT.
+	void setCapacity(size_t maxNodes);
+	size_t capacity() const { return m_capacity; } // 0 = unbounded
+
+	// Returns the slot holding 'nodeId', or INVALID_SLOT if it is not in the table.
+	uint32_t find(uint32_t nodeId) const;
+
+	// Adds a node that is not yet in the table and returns its slot, or INVALID_SLOT
+	// if the table is at its capacity. Hot fields start zeroed; the caller fills them in.
+	uint32_t insert(uint32_t nodeId);
+
+	// Removes the node in 'slot'. Other slots are unaffected.
+	void erase(uint32_t slot);
+
+	size_t size() const { return m_size; }
+
+	// Every occupied slot is below this bound; use it with isOccupied() to walk the table.
+	uint32_t slotLimit() const { return static_cast<uint32_t>(m_meta.size()); }
+	bool isOccupied(uint32_t slot) const { return m_occupied[slot] != 0; }
+
+	// Bumped each time the slot's node is erased.
+	uint32_t generation(uint32_t slot) const { return m_generations[slot]; }
+
+	// --- Hot fields (by slot) ---
+	Ticks& lastHeardTicks(uint32_t slot) { return m_lastHeardTicks[slot]; }
+	double& latitude(uint32_t slot) { return m_latitudes[slot]; }
+	double& longitude(uint32_t slot) { return m_longitudes[slot]; }
+	double& altitude(uint32_t slot) { return m_altitudes[slot]; }
+
+	Ticks lastHeardTicks(uint32_t slot) const { return m_lastHeardTicks[slot]; }
+	double latitude(uint32_t slot) const { return m_latitudes[slot]; }
+	double longitude(uint32_t slot) const { return m_longitudes[slot]; }
+	double altitude(uint32_t slot) const { return m_altitudes[slot]; }
+
+	// Whole columns, slotLimit() entries each (free slots included), for ScanKernels.
+	const Ticks* lastHeardColumn() const { return m_lastHeardTicks.data(); }
+	const double* latitudeColumn() const { return m_latitudes.data(); }
+	const double* longitudeColumn() const { return m_longitudes.data(); }
+
+	// --- Cold fields (by slot) ---
+	NodeMeta& meta(uint32_t slot) { return m_meta[slot]; }
+	const NodeMeta& meta(uint32_t slot) const { return m_meta[slot]; }
+	LinkState& link(uint32_t slot) { return m_links[slot]; }
+	const LinkState& link(uint32_t slot) const { return m_links[slot]; }
+
+private:
+	// Index bucket for a node ID (index capacity is always a power of two).
+	size_t bucketFor(uint32_t nodeId) const;
+	void growIndex();
+
+	// --- Open-addressing index ---
+	std::vector<uint32_t> m_indexKeys;   // Node ID stored in each bucket
+	std::vector<uint32_t> m_indexSlots;  // Slot for each bucket, INVALID_SLOT if the bucket is empty
+	size_t m_indexMask = 0;
+
+	// --- Slot storage (structure of arrays) ---
+	std::vector<Ticks> m_lastHeardTicks;
+	std::vector<double> m_latitudes;
+	std::vector<double> m_longitudes;
+	std::vector<double> m_altitudes;
+	std::vector<uint8_t> m_occupied;
+	std::vector<uint32_t> m_generations;
+	std::vector<NodeMeta> m_meta;
+	std::vector<LinkState> m_links;
+	std::vector<uint32_t> m_freeSlots;   // Erased slots waiting to be reused
+
+	size_t m_size = 0;
+	size_t m_capacity = 0; // 0 = unbounded
+};
+
+#endif // NODE_TABLE_H
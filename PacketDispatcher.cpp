@@ -0,0 +1,241 @@
+// PacketDispatcher.cpp
+#include "PacketDispatcher.h"
+#include <cstring>
+#include "ApplicationStage.h"
+#include "Logger.h"
+#include "MessageFrame.h"
+#include "Metrics.h"
+#include "NodeManager.h"
+#include "NodeSync.h"
+#include "ReliableText.h"
+#include "TdlCodec.h"
+#include "TdlMessages.h"
+
+PacketDispatcher::PacketDispatcher(NodeManager& nodeManager, ApplicationStage& applicationStage, NodeSync* nodeSync,
+	ReliableTextChannel* reliableText) :
+	m_nodeManager(nodeManager),
+	m_applicationStage(applicationStage),
+	m_nodeSync(nodeSync),
+	m_reliableText(reliableText)
+{
+}
+
+// --- Message Handlers ---
+// Called once a message has been validated, whichever wire format it arrived in.
+// These run on the socket stage, so anything slow is handed to the application
+// stage instead of being done here.
+
+void PacketDispatcher::onMessage(const PositionReport& report, const sockaddr_in&) const
+{
+	// For raw messages this reads the fields straight out of the pool slot.
+	m_nodeManager.updateNodePosition(report);
+}
+
+void PacketDispatcher::onMessage(const HeartbeatMessage& heartbeat, const sockaddr_in&) const
+{
+	// Beyond the last-heard update every message gets, it may reveal a lost reliable text.
+	if (m_reliableText)
+	{
+		m_reliableText->onHeartbeat(heartbeat);
+	}
+}
+
+void PacketDispatcher::onMessage(const TextMessage& message, const sockaddr_in& senderAddress) const
+{
+	if (m_reliableText && !m_reliableText->onText(message))
+	{
+		return; // A repair of a reliable text we already have
+	}
+
+	ApplicationRecord record;
+	record.messageType = TEXT_MESSAGE_TYPE;
+	record.sourceNodeId = message.header.sourceNodeId;
+	record.senderAddress = senderAddress;
+
+	// A raw message's buffer is read-only, so bound the text instead of forcing a terminator into it.
+	const void* terminator = memchr(message.text, '\0', MAX_TEXT_MSG_LENGTH);
+	record.textLength = static_cast<uint16_t>(terminator ? static_cast<const char*>(terminator) - message.text : MAX_TEXT_MSG_LENGTH);
+	memcpy(record.text, message.text, record.textLength);
+	if (!m_applicationStage.post(record)) // Lock-free; a full ring drops (and counts) rather than blocks
+	{
+		Metrics::increment(MetricCounter::PacketsDropped);
+	}
+}
+
+// Sync traffic is broadcast but addressed: only the named node acts on it.
+void PacketDispatcher::onMessage(const SyncRequest& request, const sockaddr_in&) const
+{
+	if (m_nodeSync && request.targetNodeId == m_nodeManager.getSelfNodeId())
+	{
+		m_nodeSync->onRequest(request);
+	}
+}
+
+void PacketDispatcher::onMessage(const SyncResponse& response, const sockaddr_in&) const
+{
+	if (!m_nodeSync || response.targetNodeId != m_nodeManager.getSelfNodeId())
+	{
+		return;
+	}
+	if (response.entryCount > MAX_SYNC_ENTRIES || response.chunkIndex >= response.chunkCount)
+	{
+		Metrics::increment(MetricCounter::MalformedPackets); // The decoder checks this for compact chunks; raw ones arrive as sent
+		return;
+	}
+	m_nodeSync->onResponse(response);
+}
+
+void PacketDispatcher::onMessage(const TextNack& nack, const sockaddr_in&) const
+{
+	if (m_reliableText && nack.targetNodeId == m_nodeManager.getSelfNodeId())
+	{
+		m_reliableText->onNack(nack);
+	}
+}
+
+bool PacketDispatcher::admit(const MessageHeader& header) const
+{
+	return m_nodeManager.updateLastHeardTime(header); // False: a duplicate, the first copy was dispatched already
+}
+
+// Counts (and for a wrong size, reports) a message the dispatch table turned down.
+void PacketDispatcher::reportDispatchFailure(DispatchResult result, uint32_t type, size_t size) const
+{
+	if (result == DispatchResult::SizeMismatch)
+	{
+		TDL_LOG_WARNING << "[Receiver] Warning: " << DispatchTable::nameOf(type) << " of " << size
+			<< " bytes (expected " << DispatchTable::wireSizeOf(type) << " raw). Discarding.";
+		Metrics::increment(MetricCounter::SizeMismatches);
+	}
+	else if (result == DispatchResult::UnknownType)
+	{
+		// Most likely a newer peer; counted, not logged, as it may send plenty of them.
+		Metrics::increment(MetricCounter::UnknownMessageTypes);
+	}
+}
+
+// --- Packet Processing ---
+// Decodes one message in the compact wire format (see TdlCodec.h). Messages are
+// unpacked into stack structs; nothing is allocated.
+void PacketDispatcher::processCompactRecord(PacketView view, const sockaddr_in& senderAddress) const
+{
+	MessageHeader header;
+	size_t bodyOffset = 0;
+	if (!TdlCodec::decodeHeader(view.data, view.size, header, bodyOffset))
+	{
+		Metrics::increment(MetricCounter::MalformedPackets);
+		return;
+	}
+
+	// Ignore self
+	if (header.sourceNodeId == m_nodeManager.getSelfNodeId())
+	{
+		return;
+	}
+
+	// The body is decoded and checked before admit() sees the header.
+	DispatchResult result = DispatchTable::dispatchCompact(*this, header.messageType, view, senderAddress);
+	if (result != DispatchResult::Handled)
+	{
+		reportDispatchFailure(result, header.messageType, view.size);
+	}
+}
+
+// Parses one message (a whole datagram, or one record of a frame) in place and
+// applies it to the NodeManager. Raw struct messages are read straight out of the
+// receive pool slot through a PacketView; nothing is copied and nothing is allocated.
+void PacketDispatcher::processRecord(PacketView view, const sockaddr_in& senderAddress) const
+{
+	// Compact-format messages are told apart by their first byte.
+	if (TdlCodec::isCompact(view.data, view.size))
+	{
+		processCompactRecord(view, senderAddress);
+		return;
+	}
+
+	// --- Message Parsing ---
+	// 1. Get header pointer straight from the receive buffer
+	const MessageHeader* header = view.as<MessageHeader>();
+	if (!header)
+	{
+		TDL_LOG_WARNING << "[Receiver] Warning: Received packet too small (" << view.size << " bytes). Discarding.";
+		Metrics::increment(MetricCounter::MalformedPackets);
+		return;
+	}
+
+	// Ignore self - USE NodeManager's self ID
+	if (header->sourceNodeId == m_nodeManager.getSelfNodeId())
+	{
+		return;
+	}
+
+	// 2. Hand it to its type's handler through the dispatch table (see MessageRegistry.h),
+	//    which checks its size and type before admit() updates the last heard time
+	DispatchResult result = DispatchTable::dispatchRaw(*this, header->messageType, view, senderAddress);
+	if (result != DispatchResult::Handled)
+	{
+		reportDispatchFailure(result, header->messageType, view.size);
+	}
+}
+
+// Processes one received datagram: either a single message, or a frame of several
+// coalesced messages (see MessageFrame.h), each dispatched in order.
+void PacketDispatcher::processPacket(const ReceivedPacket& packet) const
+{
+	processDatagram(packet.view(), packet.senderAddress, packet.receivedAt);
+}
+
+void PacketDispatcher::processDatagram(PacketView view, const sockaddr_in& senderAddress, std::chrono::steady_clock::time_point receivedAt) const
+{
+	if (MessageFrame::isFrame(view.data, view.size))
+	{
+		bool wellFormed = MessageFrame::forEachRecord(view.data, view.size, [&](PacketView record)
+			{
+				processRecord(record, senderAddress);
+			});
+		if (!wellFormed)
+		{
+			TDL_LOG_WARNING << "[Receiver] Warning: Malformed message frame (" << view.size << " bytes).";
+			Metrics::increment(MetricCounter::MalformedPackets);
+		}
+	}
+	else
+	{
+		processRecord(view, senderAddress);
+	}
+
+	Metrics::recordLatency(MetricHistogram::ReceiveToUpdate, std::chrono::steady_clock::now() - receivedAt);
+}
+
+// Finds the node a datagram came from without fully parsing it, so it can be
+// routed to a receive worker. For a frame, the first record's sender is used
+// (a frame only ever carries one node's messages). Returns false if unreadable.
+bool PacketDispatcher::peekSourceNodeId(PacketView view, uint32_t& sourceNodeId)
+{
+	if (MessageFrame::isFrame(view.data, view.size))
+	{
+		bool found = false;
+		MessageFrame::forEachRecord(view.data, view.size, [&](PacketView record)
+			{
+				if (!found)
+				{
+					found = peekSourceNodeId(record, sourceNodeId);
+				}
+			});
+		return found;
+	}
+
+	MessageHeader header;
+	size_t bodyOffset = 0;
+	if (TdlCodec::decodeHeader(view.data, view.size, header, bodyOffset))
+	{
+		sourceNodeId = header.sourceNodeId;
+		return true;
+	}
+	if (const MessageHeader* rawHeader = view.as<MessageHeader>())
+	{
+		sourceNodeId = rawHeader->sourceNodeId;
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,70 @@
+// PacketDispatcher.h
+#ifndef PACKET_DISPATCHER_H
+#define PACKET_DISPATCHER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "MessageRegistry.h"
+#include "Transport.h"      // ReceivedPacket, sockaddr_in
+#include "PacketPool.h"     // PacketView
+
+class ApplicationStage;
+class NodeManager;
+class NodeSync;
+class ReliableTextChannel;
+
+// --- Packet Dispatcher ---
+// The socket-stage half of the receive pipeline: parses a received datagram (raw
+// structs, compact encodings or coalesced frames), applies it to the NodeManager,
+// and posts anything that needs slow application handling to the ApplicationStage.
+// Stateless apart from its targets, so the reactor, every receive worker and the
+// benchmarks can all share one instance.
+class PacketDispatcher
+{
+public:
+	// 'nodeSync' and 'reliableText' may be null, in which case sync traffic is
+	// ignored and every text is delivered as it arrives, repeats included.
+	PacketDispatcher(NodeManager& nodeManager, ApplicationStage& applicationStage, NodeSync* nodeSync = nullptr,
+		ReliableTextChannel* reliableText = nullptr);
+
+	// Processes one received datagram. Safe to call from several threads at once.
+	void processPacket(const ReceivedPacket& packet) const;
+
+	// The same for a datagram that isn't in a pool slot (TrafficReplayer reads
+	// captures straight out of their mapping).
+	void processDatagram(PacketView view, const sockaddr_in& senderAddress, std::chrono::steady_clock::time_point receivedAt) const;
+
+	// Finds the node a datagram came from without fully parsing it, so it can be
+	// routed to a receive worker. Returns false if the datagram is unreadable.
+	static bool peekSourceNodeId(PacketView view, uint32_t& sourceNodeId);
+
+private:
+	void processRecord(PacketView view, const sockaddr_in& senderAddress) const;
+	void processCompactRecord(PacketView view, const sockaddr_in& senderAddress) const;
+	void reportDispatchFailure(DispatchResult result, uint32_t type, size_t size) const;
+
+	// --- Message Handlers ---
+	// One overload per registered message, for raw and compact messages alike. The
+	// dispatch table picks them at compile time.
+	using DispatchTable = MessageDispatchTable<PacketDispatcher, RegisteredMessages>;
+	friend DispatchTable;
+
+	// Called for every well-formed message before its handler: updates the sender's
+	// last heard time and sequence tracking. False for a duplicate, which is dropped.
+	bool admit(const MessageHeader& header) const;
+
+	void onMessage(const PositionReport& report, const sockaddr_in& senderAddress) const;
+	void onMessage(const HeartbeatMessage& heartbeat, const sockaddr_in& senderAddress) const;
+	void onMessage(const TextMessage& message, const sockaddr_in& senderAddress) const;
+	void onMessage(const SyncRequest& request, const sockaddr_in& senderAddress) const;
+	void onMessage(const SyncResponse& response, const sockaddr_in& senderAddress) const;
+	void onMessage(const TextNack& nack, const sockaddr_in& senderAddress) const;
+
+	NodeManager& m_nodeManager;
+	ApplicationStage& m_applicationStage;
+	NodeSync* m_nodeSync;
+	ReliableTextChannel* m_reliableText;
+};
+
+#endif // PACKET_DISPATCHER_H
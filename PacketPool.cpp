@@ -0,0 +1,99 @@
+// PacketPool.cpp
+#include "PacketPool.h"
+
+// --- PacketBuffer ---
+
+PacketBuffer::PacketBuffer(PacketBuffer&& other) noexcept :
+	m_pool(other.m_pool),
+	m_slot(other.m_slot),
+	m_data(other.m_data)
+{
+	other.m_pool = nullptr;
+	other.m_data = nullptr;
+}
+
+PacketBuffer& PacketBuffer::operator=(PacketBuffer&& other) noexcept
+{
+	if (this != &other)
+	{
+		reset(); // Give back whatever we held before taking the other slot
+		m_pool = other.m_pool;
+		m_slot = other.m_slot;
+		m_data = other.m_data;
+		other.m_pool = nullptr;
+		other.m_data = nullptr;
+	}
+	return *this;
+}
+
+size_t PacketBuffer::capacity() const
+{
+	return m_pool ? m_pool->slotSize() : 0;
+}
+
+void PacketBuffer::reset()
+{
+	if (m_pool && m_data)
+	{
+		m_pool->release(m_slot);
+	}
+	m_pool = nullptr;
+	m_data = nullptr;
+}
+
+// --- PacketPool ---
+
+// Round slots up to a cache line so neighbouring buffers never share one.
+static size_t roundUpToCacheLine(size_t size)
+{
+	return (size + 63) & ~static_cast<size_t>(63);
+}
+
+PacketPool::PacketPool(size_t slotCount, size_t slotSize) :
+	m_slotCount(slotCount),
+	m_slotSize(roundUpToCacheLine(slotSize)),
+	m_slab(new uint8_t[slotCount * roundUpToCacheLine(slotSize)])
+{
+	m_freeSlots.reserve(m_slotCount);
+	// Push in reverse so the first acquire() hands out slot 0.
+	for (size_t i = m_slotCount; i > 0; --i)
+	{
+		m_freeSlots.push_back(static_cast<uint32_t>(i - 1));
+	}
+}
+
+PacketBuffer PacketPool::acquire()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_freeSlots.empty())
+	{
+		m_exhaustedCount.fetch_add(1, std::memory_order_relaxed);
+		m_starved = true;
+		return PacketBuffer();
+	}
+
+	uint32_t slot = m_freeSlots.back();
+	m_freeSlots.pop_back();
+	return PacketBuffer(this, slot, m_slab.get() + static_cast<size_t>(slot) * m_slotSize);
+}
+
+size_t PacketPool::available()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_freeSlots.size();
+}
+
+void PacketPool::release(uint32_t slot)
+{
+	bool wasStarved = false;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_freeSlots.push_back(slot); // Never reallocates: capacity covers every slot
+		wasStarved = m_starved;
+		m_starved = false;
+	}
+	if (wasStarved && m_onReplenished)
+	{
+		m_onReplenished(); // Outside the lock: it may well acquire() straight away
+	}
+}
@@ -0,0 +1,109 @@
+// PacketPool.h
+#ifndef PACKET_POOL_H
+#define PACKET_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class PacketPool;
+
+// --- Packet View ---
+// A non-owning window onto received bytes. Parsing code reads messages in place
+// through this instead of copying them out of the receive buffer.
+struct PacketView
+{
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+
+	// Returns the bytes as a message struct, or nullptr if the packet is too small.
+	// Pool slots are 16-byte aligned, so this is safe for all the TdlMessages.h structs.
+	template <typename T>
+	const T* as() const
+	{
+		return (size >= sizeof(T)) ? reinterpret_cast<const T*>(data) : nullptr;
+	}
+};
+
+// --- Packet Buffer ---
+// Scoped, move-only handle to one fixed-size slot of a PacketPool.
+// The slot goes back to the pool's free list when the handle is destroyed or reset.
+class PacketBuffer
+{
+public:
+	PacketBuffer() = default;
+	~PacketBuffer() { reset(); }
+
+	PacketBuffer(PacketBuffer&& other) noexcept;
+	PacketBuffer& operator=(PacketBuffer&& other) noexcept;
+
+	PacketBuffer(const PacketBuffer&) = delete;
+	PacketBuffer& operator=(const PacketBuffer&) = delete;
+
+	uint8_t* data() const { return m_data; }
+	size_t capacity() const;
+
+	// True if this handle currently owns a slot.
+	explicit operator bool() const { return m_data != nullptr; }
+
+	// Returns the slot to its pool (no-op if the handle is empty).
+	void reset();
+
+private:
+	friend class PacketPool;
+	PacketBuffer(PacketPool* pool, uint32_t slot, uint8_t* data) : m_pool(pool), m_slot(slot), m_data(data) {}
+
+	PacketPool* m_pool = nullptr;
+	uint32_t m_slot = 0;
+	uint8_t* m_data = nullptr;
+};
+
+// --- Packet Pool ---
+// One contiguous slab carved into equally sized slots, allocated once up front.
+// acquire()/release are O(1) pushes/pops on a preallocated free list, so handing
+// buffers in and out never touches the heap. Safe to use from multiple threads.
+class PacketPool
+{
+public:
+	PacketPool(size_t slotCount, size_t slotSize);
+
+	// Takes a free slot. Returns an empty PacketBuffer if the pool is exhausted.
+	PacketBuffer acquire();
+
+	size_t slotSize() const { return m_slotSize; }
+	size_t slotCount() const { return m_slotCount; }
+
+	// Number of slots currently sitting on the free list.
+	size_t available();
+
+	// How many acquire() calls found the pool empty.
+	uint64_t getExhaustedCount() const { return m_exhaustedCount.load(std::memory_order_relaxed); }
+
+	// Called with the first slot to come back after acquire() found the pool empty,
+	// on whichever thread freed it, so a receiver that stopped for want of buffers
+	// can be woken. Set it before the pool is shared between threads.
+	void setReplenishedCallback(std::function<void()> callback) { m_onReplenished = std::move(callback); }
+
+	// Disable copy and assignment (handles point back at this object)
+	PacketPool(const PacketPool&) = delete;
+	PacketPool& operator=(const PacketPool&) = delete;
+
+private:
+	friend class PacketBuffer;
+	void release(uint32_t slot);
+
+	size_t m_slotCount = 0;
+	size_t m_slotSize = 0;
+	std::unique_ptr<uint8_t[]> m_slab;  // slotCount * slotSize bytes
+	std::vector<uint32_t> m_freeSlots;  // Stack of free slot indices; capacity reserved for every slot
+	std::mutex m_mutex;                 // Protects m_freeSlots and m_starved
+	bool m_starved = false;             // acquire() has failed since the last release
+	std::function<void()> m_onReplenished;
+	std::atomic<uint64_t> m_exhaustedCount{ 0 };
+};
+
+#endif // PACKET_POOL_H
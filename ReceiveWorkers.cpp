@@ -0,0 +1,167 @@
+// ReceiveWorkers.cpp
+#include "ReceiveWorkers.h"
+#include <utility>
+#include "Logger.h"
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Pins the calling thread to one core. Best effort: a failure only costs locality.
+static bool pinCurrentThreadToCore(size_t core)
+{
+#if defined(_WIN32)
+	if (core >= sizeof(ULONG_PTR) * 8)
+	{
+		return false;
+	}
+	return SetThreadAffinityMask(GetCurrentThread(), static_cast<ULONG_PTR>(1) << core) != 0;
+#elif defined(__linux__)
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	CPU_SET(core, &cpus);
+	return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+#else
+	(void)core;
+	return false;
+#endif
+}
+
+ReceiveWorkerPool::ReceiveWorkerPool(size_t workerCount, size_t queueCapacity, PacketHandler handler,
+	OverflowPolicy overflowPolicy, bool pinToCores) :
+	m_handler(std::move(handler)),
+	m_overflowPolicy(overflowPolicy),
+	m_pinToCores(pinToCores)
+{
+	if (workerCount == 0)
+	{
+		workerCount = 1;
+	}
+	if (queueCapacity == 0)
+	{
+		queueCapacity = 1;
+	}
+
+	// Create every worker before starting any thread, so m_workers never changes under them.
+	m_workers.reserve(workerCount);
+	for (size_t i = 0; i < workerCount; ++i)
+	{
+		m_workers.push_back(std::make_unique<Worker>());
+		m_workers.back()->queue.resize(queueCapacity);
+	}
+	for (size_t i = 0; i < workerCount; ++i)
+	{
+		Worker& worker = *m_workers[i];
+		worker.thread = std::thread(&ReceiveWorkerPool::workerLoop, this, std::ref(worker), i);
+	}
+
+	TDL_LOG_INFO << "[RxWorkers] Started " << workerCount << " receive workers (queue " << queueCapacity
+		<< (m_overflowPolicy == OverflowPolicy::DropOldest ? ", drop-oldest" : ", drop-newest")
+		<< (m_pinToCores ? ", pinned)." : ").");
+}
+
+ReceiveWorkerPool::~ReceiveWorkerPool()
+{
+	stop();
+}
+
+bool ReceiveWorkerPool::dispatch(ReceivedPacket& packet, size_t routingKey)
+{
+	Worker& worker = *m_workers[routingKey % m_workers.size()];
+
+	bool wasEmpty = false;
+	{
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		size_t capacity = worker.queue.size();
+		if (worker.count == capacity)
+		{
+			++worker.counters.packetsDropped;
+			if (m_overflowPolicy == OverflowPolicy::DropNewest)
+			{
+				return false;
+			}
+
+			// DropOldest: release the head packet's pool slot and reuse its entry.
+			worker.queue[worker.head].buffer.reset();
+			worker.head = (worker.head + 1) % capacity;
+			--worker.count;
+		}
+
+		// Swap rather than copy: the pool slot moves into the queue, and the queue
+		// entry's (already released) buffer comes back empty.
+		std::swap(worker.queue[(worker.head + worker.count) % capacity], packet);
+		wasEmpty = (worker.count == 0);
+		++worker.count;
+		if (worker.count > worker.counters.queueHighWater)
+		{
+			worker.counters.queueHighWater = worker.count;
+		}
+	}
+
+	if (wasEmpty)
+	{
+		worker.ready.notify_one(); // A busy worker re-checks the queue anyway; only wake sleeping ones
+	}
+	return true;
+}
+
+void ReceiveWorkerPool::stop()
+{
+	for (std::unique_ptr<Worker>& worker : m_workers)
+	{
+		{
+			std::lock_guard<std::mutex> lock(worker->mutex);
+			worker->stopping = true;
+		}
+		worker->ready.notify_one();
+	}
+	for (std::unique_ptr<Worker>& worker : m_workers)
+	{
+		if (worker->thread.joinable())
+		{
+			worker->thread.join();
+		}
+	}
+}
+
+ReceiveWorkerCounters ReceiveWorkerPool::getWorkerCounters(size_t workerIndex) const
+{
+	Worker& worker = *m_workers[workerIndex];
+	std::lock_guard<std::mutex> lock(worker.mutex);
+	return worker.counters;
+}
+
+void ReceiveWorkerPool::workerLoop(Worker& worker, size_t workerIndex)
+{
+	if (m_pinToCores)
+	{
+		size_t cores = std::thread::hardware_concurrency();
+		if (cores == 0 || !pinCurrentThreadToCore(workerIndex % cores))
+		{
+			TDL_LOG_WARNING << "[RxWorkers] Warning: Could not pin worker " << workerIndex << " to a core.";
+		}
+	}
+
+	ReceivedPacket packet;
+	std::unique_lock<std::mutex> lock(worker.mutex);
+	while (true)
+	{
+		worker.ready.wait(lock, [&worker]() { return worker.count > 0 || worker.stopping; });
+		if (worker.count == 0)
+		{
+			break; // Stopping, and everything queued has been handled
+		}
+
+		std::swap(packet, worker.queue[worker.head]);
+		worker.head = (worker.head + 1) % worker.queue.size();
+		--worker.count;
+
+		// Handle the packet without holding the lock, so dispatch() is never held up.
+		lock.unlock();
+		m_handler(packet);
+		packet.buffer.reset(); // Back to the packet pool straight away
+		lock.lock();
+
+		++worker.counters.packetsProcessed;
+	}
+}
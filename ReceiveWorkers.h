@@ -0,0 +1,87 @@
+// ReceiveWorkers.h
+#ifndef RECEIVE_WORKERS_H
+#define RECEIVE_WORKERS_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "MessageRing.h"    // OverflowPolicy
+#include "NetworkManager.h" // ReceivedPacket
+
+// --- Receive Worker Counters ---
+// Snapshot of one worker's activity, for checking that load spreads evenly.
+struct ReceiveWorkerCounters
+{
+	uint64_t packetsProcessed = 0;
+	uint64_t packetsDropped = 0;   // Lost to a full queue (the new packet or, with DropOldest, the oldest one)
+	size_t queueHighWater = 0;     // Deepest the queue has been
+};
+
+// --- Receive Worker Pool ---
+// Spreads packet processing over N threads, each pinned to its own core. The
+// socket is still drained by one thread (the event loop), which hands each packet
+// to a worker chosen by a routing key; packets with the same key always go to the
+// same worker, so per-node ordering is kept. Use the sender's NodeManager shard as
+// the key and each worker ends up owning a disjoint set of shards, so workers do
+// not contend on shard locks either.
+//
+// Packets move into a worker's queue without copying (the pool slot changes owner).
+class ReceiveWorkerPool
+{
+public:
+	using PacketHandler = std::function<void(const ReceivedPacket& packet)>;
+
+	// Starts 'workerCount' threads. 'queueCapacity' packets may wait per worker;
+	// 'overflowPolicy' decides which packet is lost when a queue is full.
+	ReceiveWorkerPool(size_t workerCount, size_t queueCapacity, PacketHandler handler,
+		OverflowPolicy overflowPolicy = OverflowPolicy::DropNewest, bool pinToCores = true);
+	~ReceiveWorkerPool(); // Stops and joins the workers (queued packets are still processed)
+
+	// Hands 'packet' to the worker for 'routingKey'. On success the packet's buffer
+	// moves to the worker and 'packet' is left empty. If that worker's queue is full,
+	// DropNewest returns false (packet dropped and counted) and DropOldest evicts
+	// the oldest queued packet instead. The reactor never blocks here.
+	bool dispatch(ReceivedPacket& packet, size_t routingKey);
+
+	// Processes what is queued, then stops the workers. Called by the destructor.
+	void stop();
+
+	size_t getWorkerCount() const { return m_workers.size(); }
+
+	// The most pool slots such a pool can hold at once: every queue full, plus the
+	// packet each worker is handling. Size the transport's pool for it.
+	static size_t maxHeldPackets(size_t workerCount, size_t queueCapacity) { return workerCount * (queueCapacity + 1); }
+	ReceiveWorkerCounters getWorkerCounters(size_t workerIndex) const;
+
+	// Disable copy and assignment
+	ReceiveWorkerPool(const ReceiveWorkerPool&) = delete;
+	ReceiveWorkerPool& operator=(const ReceiveWorkerPool&) = delete;
+
+private:
+	// One per thread, on its own cache lines so workers don't false-share.
+	struct alignas(64) Worker
+	{
+		std::mutex mutex;                   // Protects the queue and the counters
+		std::condition_variable ready;      // Signalled when the queue becomes non-empty or on stop
+		std::vector<ReceivedPacket> queue;  // Fixed ring of 'queueCapacity' entries
+		size_t head = 0;
+		size_t count = 0;
+		bool stopping = false;
+		ReceiveWorkerCounters counters;
+		std::thread thread;
+	};
+
+	void workerLoop(Worker& worker, size_t workerIndex);
+
+	PacketHandler m_handler;
+	OverflowPolicy m_overflowPolicy;
+	bool m_pinToCores;
+	std::vector<std::unique_ptr<Worker>> m_workers;
+};
+
+#endif // RECEIVE_WORKERS_H
@@ -0,0 +1,329 @@
+// ReliableText.cpp
+#include "ReliableText.h"
+#include <bitset>
+#include "Logger.h"
+#include "MessageSequencer.h"
+#include "TdlCodec.h"
+#include "Transport.h"
+
+static constexpr unsigned TAIL_HEARTBEATS = 3;                                   // After each text...
+static constexpr std::chrono::milliseconds FIRST_TAIL_HEARTBEAT_DELAY{ 200 };    // ...at +200 ms, +600 ms, +1.4 s
+
+ReliableTextChannel::ReliableTextChannel(Transport& transport, MessageSequencer& sequencer, uint32_t selfNodeId, bool compactWire) :
+	m_transport(transport),
+	m_sequencer(sequencer),
+	m_selfNodeId(selfNodeId),
+	m_compactWire(compactWire)
+{
+	m_nacks.reserve(64);
+}
+
+ReliableTextCounters ReliableTextChannel::getCounters() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_counters;
+}
+
+uint32_t ReliableTextChannel::getLastTextSequence() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_lastTextSequence;
+}
+
+template <typename Message>
+bool ReliableTextChannel::send(Message& message)
+{
+	if (!m_compactWire)
+	{
+		return m_transport.sendOnChannel(Message::MESSAGE_TYPE, &message, sizeof(message));
+	}
+	uint8_t encoded[TdlCodec::MAX_ENCODED_SIZE];
+	size_t size = TdlCodec::encode(message, encoded, sizeof(encoded));
+	return size != 0 && m_transport.sendOnChannel(Message::MESSAGE_TYPE, encoded, size);
+}
+
+// --- Sending Side ---
+bool ReliableTextChannel::sendText(TextMessage& message, std::chrono::steady_clock::time_point now)
+{
+	message.header.sourceNodeId = m_selfNodeId;
+	m_sequencer.stamp(message.header);
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (++m_lastTextSequence == 0)
+		{
+			m_lastTextSequence = 1; // 0 means best effort
+		}
+		message.textSequence = m_lastTextSequence;
+		SentText& slot = m_ring[m_lastTextSequence % RING_SIZE]; // Overwrites the oldest
+		slot.message = message;
+		slot.lastRepaired = std::chrono::steady_clock::time_point();
+		slot.retransmitDue = false;
+		m_tailHeartbeatsLeft = TAIL_HEARTBEATS;
+		m_nextTailHeartbeat = now + FIRST_TAIL_HEARTBEAT_DELAY;
+		++m_counters.textsSent;
+	}
+	return send(message);
+}
+
+void ReliableTextChannel::onNack(const TextNack& nack)
+{
+	auto now = std::chrono::steady_clock::now();
+	std::lock_guard<std::mutex> lock(m_mutex);
+	++m_counters.nacksReceived;
+	for (uint32_t bit = 0; bit < RING_SIZE; ++bit)
+	{
+		if ((nack.missingMask & (1ull << bit)) == 0)
+		{
+			continue;
+		}
+		uint32_t sequence = nack.firstSequence + bit;
+		if (sequence == 0)
+		{
+			continue; // Never a text's number; the mask wrapped past UINT32_MAX
+		}
+		SentText& slot = m_ring[sequence % RING_SIZE];
+		if (slot.message.textSequence != sequence)
+		{
+			++m_counters.unrepairable; // Sent too long ago (or never)
+		}
+		else if (now - slot.lastRepaired >= RETRANSMIT_HOLDOFF)
+		{
+			slot.retransmitDue = true; // Other receivers' NACKs for it until RETRANSMIT_HOLDOFF after the repair share it
+		}
+	}
+}
+
+// --- Receiving Side ---
+void ReliableTextChannel::advance(SourceWindow& window, uint32_t sequence)
+{
+	uint32_t ahead = sequence - window.highest;
+	if (ahead >= RING_SIZE)
+	{
+		// Texts that fell out of the window before they could even be NACKed.
+		m_counters.textsAbandoned += ahead - RING_SIZE + std::bitset<64>(~window.received).count();
+		window.received = 0;
+	}
+	else
+	{
+		window.received <<= ahead;
+	}
+	window.highest = sequence;
+}
+
+// Counted in offsets from 'firstSequence' rather than in sequence numbers, so it
+// ends even with the window at UINT32_MAX, and it reaches back across 0 when the
+// sender's numbering has wrapped (0 itself, never sent, is skipped). A new window
+// starts with every bit set, so numbers from before the first text never show as
+// missing.
+uint64_t ReliableTextChannel::missingMask(const SourceWindow& window, uint32_t& firstSequence) const
+{
+	firstSequence = window.highest - static_cast<uint32_t>(RING_SIZE - 1);
+	uint64_t mask = 0;
+	for (uint32_t offset = 0; offset < RING_SIZE; ++offset)
+	{
+		uint32_t age = static_cast<uint32_t>(RING_SIZE - 1) - offset; // How far below the highest
+		if ((window.received & (1ull << age)) == 0 && firstSequence + offset != 0)
+		{
+			mask |= 1ull << offset;
+		}
+	}
+	return mask;
+}
+
+ReliableTextChannel::SourceWindow* ReliableTextChannel::findOrAddSource(uint32_t sourceNodeId, bool& added)
+{
+	auto found = m_sources.find(sourceNodeId);
+	added = found == m_sources.end();
+	if (!added)
+	{
+		return &found->second;
+	}
+	if (m_sources.size() >= MAX_SOURCES)
+	{
+		return nullptr;
+	}
+	return &m_sources[sourceNodeId];
+}
+
+void ReliableTextChannel::forgetSource(uint32_t sourceNodeId)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_sources.erase(sourceNodeId);
+}
+
+bool ReliableTextChannel::onText(const TextMessage& message)
+{
+	if (message.textSequence == 0)
+	{
+		return true; // Best effort: nothing to track
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	bool added = false;
+	SourceWindow* found = findOrAddSource(message.header.sourceNodeId, added);
+	if (!found)
+	{
+		++m_counters.textsUntracked;
+		return true;
+	}
+	SourceWindow& window = *found;
+	int32_t ahead = static_cast<int32_t>(message.textSequence - window.highest);
+	bool newerSend = static_cast<int32_t>(message.header.sendTimeUs - window.newestSendTimeUs) > 0;
+	bool alreadyHave = ahead <= 0 && ahead > -static_cast<int32_t>(RING_SIZE)
+		&& (window.received & (1ull << static_cast<uint32_t>(-ahead))) != 0;
+	if (added || ahead <= -static_cast<int32_t>(RING_SIZE) || (alreadyHave && newerSend))
+	{
+		// First text from this sender, or it restarted its numbering (a number we
+		// already have, sent later than anything before; repairs keep their original
+		// send time). Either way earlier texts were never ours to miss.
+		window.highest = message.textSequence;
+		window.received = ~0ull;
+		window.newestSendTimeUs = message.header.sendTimeUs;
+		window.nackAttempts = 0;
+		return true;
+	}
+	if (newerSend)
+	{
+		window.newestSendTimeUs = message.header.sendTimeUs;
+	}
+	if (ahead > 0)
+	{
+		bool wasComplete = window.received == ~0ull;
+		advance(window, message.textSequence);
+		window.received |= 1;
+		if (wasComplete && window.received != ~0ull)
+		{
+			window.nackAttempts = 0;
+			window.nextNack = std::chrono::steady_clock::now(); // First NACK at the next tick
+		}
+		return true;
+	}
+
+	if (alreadyHave)
+	{
+		++m_counters.duplicatesDropped; // Usually a repair another receiver asked for
+		return false;
+	}
+	window.received |= 1ull << static_cast<uint32_t>(-ahead);
+	++m_counters.textsRepaired;
+	return true;
+}
+
+void ReliableTextChannel::onHeartbeat(const HeartbeatMessage& heartbeat)
+{
+	if (heartbeat.lastTextSequence == 0)
+	{
+		return;
+	}
+	std::lock_guard<std::mutex> lock(m_mutex);
+	bool added = false;
+	SourceWindow* found = findOrAddSource(heartbeat.header.sourceNodeId, added);
+	if (!found)
+	{
+		return;
+	}
+	SourceWindow& window = *found;
+	if (added)
+	{
+		window.highest = heartbeat.lastTextSequence; // Everything up to here predates us
+		window.received = ~0ull;
+		return;
+	}
+	if (static_cast<int32_t>(heartbeat.lastTextSequence - window.highest) > 0)
+	{
+		bool wasComplete = window.received == ~0ull;
+		advance(window, heartbeat.lastTextSequence); // Advertised, not received: its bit stays clear
+		if (wasComplete)
+		{
+			window.nackAttempts = 0;
+			window.nextNack = std::chrono::steady_clock::now();
+		}
+	}
+}
+
+// --- Timer ---
+void ReliableTextChannel::tick(std::chrono::steady_clock::time_point now)
+{
+	// Gather under the lock, send after it, so receive threads are never held up by the socket.
+	std::vector<TextNack>& nacks = m_nacks;
+	nacks.clear();
+	std::array<TextMessage, MAX_RETRANSMITS_PER_TICK> repairs;
+	size_t repairCount = 0;
+	bool tailHeartbeat = false;
+	HeartbeatMessage heartbeat;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// --- NACKs for what we are missing ---
+		for (auto& [sourceNodeId, window] : m_sources)
+		{
+			if (window.received == ~0ull || now < window.nextNack)
+			{
+				continue;
+			}
+			TextNack nack;
+			nack.missingMask = missingMask(window, nack.firstSequence);
+			if (nack.missingMask == 0)
+			{
+				window.received = ~0ull; // Only "missing" 0, skipped as the numbering wrapped
+				continue;
+			}
+			if (window.nackAttempts == MAX_NACK_ATTEMPTS)
+			{
+				m_counters.textsAbandoned += std::bitset<64>(nack.missingMask).count();
+				window.received = ~0ull;
+				continue;
+			}
+			nack.header.sourceNodeId = m_selfNodeId;
+			nack.targetNodeId = sourceNodeId;
+			nacks.push_back(nack);
+			++window.nackAttempts;
+			window.nextNack = now + NACK_RETRY_INTERVAL;
+		}
+
+		// --- Repairs other nodes asked us for ---
+		for (SentText& slot : m_ring)
+		{
+			if (slot.retransmitDue && repairCount < repairs.size())
+			{
+				repairs[repairCount++] = slot.message;
+				slot.retransmitDue = false;
+				slot.lastRepaired = now;
+			}
+		}
+
+		// --- Tail heartbeats, so the loss of the newest text is noticed ---
+		if (m_tailHeartbeatsLeft > 0 && now >= m_nextTailHeartbeat)
+		{
+			tailHeartbeat = true;
+			heartbeat.lastTextSequence = m_lastTextSequence;
+			--m_tailHeartbeatsLeft;
+			m_nextTailHeartbeat = now + FIRST_TAIL_HEARTBEAT_DELAY * (1u << (TAIL_HEARTBEATS - m_tailHeartbeatsLeft));
+		}
+
+		m_counters.nacksSent += nacks.size();
+		m_counters.retransmits += repairCount;
+	}
+
+	for (TextNack& nack : nacks)
+	{
+		m_sequencer.stamp(nack.header);
+		send(nack);
+	}
+	for (size_t i = 0; i < repairCount; ++i)
+	{
+		// A fresh header sequence number, but the original send time: receivers'
+		// latency figures then include the repair delay, and nobody mistakes the
+		// old text sequence for a sender restart.
+		uint32_t originalSendTimeUs = repairs[i].header.sendTimeUs;
+		m_sequencer.stamp(repairs[i].header);
+		repairs[i].header.sendTimeUs = originalSendTimeUs;
+		send(repairs[i]);
+	}
+	if (tailHeartbeat)
+	{
+		heartbeat.header.sourceNodeId = m_selfNodeId;
+		m_sequencer.stamp(heartbeat.header);
+		send(heartbeat);
+	}
+}
@@ -0,0 +1,140 @@
+// ReliableText.h
+#ifndef RELIABLE_TEXT_H
+#define RELIABLE_TEXT_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "TdlMessages.h"
+
+class MessageSequencer;
+class Transport;
+
+struct ReliableTextCounters
+{
+	uint64_t textsSent = 0;
+	uint64_t retransmits = 0;
+	uint64_t nacksReceived = 0;
+	uint64_t unrepairable = 0;   // NACKed texts already gone from the retransmit ring
+	uint64_t nacksSent = 0;
+	uint64_t textsRepaired = 0;  // Arrived after we had noticed they were missing
+	uint64_t textsAbandoned = 0; // Still missing after MAX_NACK_ATTEMPTS
+	uint64_t duplicatesDropped = 0;
+	uint64_t textsUntracked = 0; // Reliable texts from new senders while MAX_SOURCES were already followed
+};
+
+// --- Reliable Text Channel ---
+// NACK-based reliable delivery for TextMessages, in the style of NORM/PGM: the
+// sender numbers its reliable texts and keeps the last RING_SIZE of them; each
+// receiver follows every sender's numbers with a RING_SIZE-wide window and asks
+// for exactly the ones it is missing. Nothing is acknowledged, so a text that
+// arrives costs the network nothing extra; only loss costs a NACK and a repair.
+//
+// A receiver can only see a gap once something later arrives, so heartbeats carry
+// the sender's newest text sequence, and the sender sends a few extra heartbeats
+// soon after each text to catch the loss of the last one quickly.
+//
+// NACKs and repairs are broadcast. The sender repeats a given text at most once
+// per RETRANSMIT_HOLDOFF, so any number of receivers missing the same text get
+// one repair between them. Positions and heartbeats stay best effort.
+//
+// Each sender followed costs one window, kept until forgetSource() (wired to
+// NodeManager's expiry callback) and capped at MAX_SOURCES. Past that, a new
+// sender's texts are delivered best effort and counted in textsUntracked.
+//
+// Sequence arithmetic is modular throughout, and 0 is never a text's number, so
+// a sender's numbering can wrap past UINT32_MAX.
+//
+// sendText() and tick() run on the reactor thread; the on...() calls and
+// forgetSource() may come from any receive thread.
+class ReliableTextChannel
+{
+public:
+	static constexpr size_t RING_SIZE = 64; // Texts kept for repair; also the receive window (one NACK mask)
+	static constexpr unsigned MAX_NACK_ATTEMPTS = 5;
+	static constexpr size_t MAX_RETRANSMITS_PER_TICK = 16;
+	static constexpr std::chrono::milliseconds NACK_RETRY_INTERVAL{ 500 };
+	static constexpr std::chrono::milliseconds RETRANSMIT_HOLDOFF{ 200 };
+	static constexpr size_t MAX_SOURCES = 16384;
+
+	// 'sequencer' is the one the rest of this node's traffic is stamped from.
+	ReliableTextChannel(Transport& transport, MessageSequencer& sequencer, uint32_t selfNodeId, bool compactWire);
+
+	// --- Sending Side ---
+	// Numbers, keeps and sends one text. Returns false if the transport refused it
+	// (it stays in the ring, so a NACK can still repair it).
+	bool sendText(TextMessage& message, std::chrono::steady_clock::time_point now);
+
+	// For this node's heartbeats.
+	uint32_t getLastTextSequence() const;
+
+	// A NACK addressed to this node.
+	void onNack(const TextNack& nack);
+
+	// --- Receiving Side ---
+	// Returns true if the text should be delivered: best-effort texts always, and
+	// reliable ones the first time each arrives.
+	bool onText(const TextMessage& message);
+
+	// Any heartbeat: its last text sequence can reveal a lost newest text.
+	void onHeartbeat(const HeartbeatMessage& heartbeat);
+
+	// Drops whatever was kept about a sender, e.g. once NodeManager times it out.
+	void forgetSource(uint32_t sourceNodeId);
+
+	// Sends due NACKs, repairs and tail heartbeats. Call every send tick.
+	void tick(std::chrono::steady_clock::time_point now);
+
+	ReliableTextCounters getCounters() const;
+
+	// Disable copy and assignment
+	ReliableTextChannel(const ReliableTextChannel&) = delete;
+	ReliableTextChannel& operator=(const ReliableTextChannel&) = delete;
+
+private:
+	struct SentText
+	{
+		TextMessage message;                                // textSequence 0 = empty
+		std::chrono::steady_clock::time_point lastRepaired; // Epoch until the first repair
+		bool retransmitDue = false;
+	};
+
+	// One sender's texts as this node has seen them.
+	struct SourceWindow
+	{
+		uint32_t highest = 0;   // Highest text sequence seen or advertised
+		uint64_t received = 0;  // Bit i set: highest - i has arrived (or is not wanted)
+		uint32_t newestSendTimeUs = 0; // Latest original send time among its texts, to spot a restart
+		unsigned nackAttempts = 0;
+		std::chrono::steady_clock::time_point nextNack;
+	};
+
+	// Moves the window up to 'sequence'; the numbers skipped become missing.
+	void advance(SourceWindow& window, uint32_t sequence);
+	// The sender's window, created if there is room. Null if MAX_SOURCES are followed already.
+	SourceWindow* findOrAddSource(uint32_t sourceNodeId, bool& added);
+	uint64_t missingMask(const SourceWindow& window, uint32_t& firstSequence) const;
+	template <typename Message>
+	bool send(Message& message); // In the configured wire format; the caller stamps it
+
+	Transport& m_transport;
+	MessageSequencer& m_sequencer;
+	uint32_t m_selfNodeId;
+	bool m_compactWire;
+
+	mutable std::mutex m_mutex; // Everything below
+	std::array<SentText, RING_SIZE> m_ring{}; // By textSequence % RING_SIZE
+	uint32_t m_lastTextSequence = 0;
+	std::chrono::steady_clock::time_point m_nextTailHeartbeat;
+	unsigned m_tailHeartbeatsLeft = 0;
+	std::unordered_map<uint32_t, SourceWindow> m_sources;
+	ReliableTextCounters m_counters;
+
+	std::vector<TextNack> m_nacks; // tick()'s, reused from one tick to the next; reactor thread only
+};
+
+#endif // RELIABLE_TEXT_H
@@ -0,0 +1,476 @@
+// ScanKernels.cpp
+#include "ScanKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SCAN_KERNELS_NEON // Every 64-bit ARM core has NEON with double lanes
+#include <arm_neon.h>
+#endif
+#include "SpatialGrid.h" // distanceMeters(), the scalar flat-earth formula
+
+static constexpr double DEGREES_TO_RADIANS = 3.14159265358979323846 / 180.0;
+static constexpr double HALF_PI = 1.57079632679489661923;
+
+// --- Polynomial Coefficients ---
+// Truncated Taylor series, evaluated by Horner's rule in x^2. Every argument the
+// kernels pass is within [-pi/2, pi/2] (sine, cosine) or [0, 1/2] (arcsine), where
+// these terms leave an error below 1e-12.
+static constexpr size_t SINE_TERMS = 9;    // Through x^17
+static constexpr size_t COSINE_TERMS = 10; // Through x^18
+static constexpr size_t ARCSINE_TERMS = 22;
+
+struct Coefficients
+{
+	double values[ARCSINE_TERMS] = {};
+};
+
+// (-1)^k / (2k + 'offset')!: offset 1 for sine, 0 for cosine.
+static constexpr Coefficients trigCoefficients(size_t terms, size_t offset)
+{
+	Coefficients result;
+	double factorial = 1.0;
+	for (size_t n = 1; n <= offset; ++n)
+	{
+		factorial *= static_cast<double>(n);
+	}
+	for (size_t k = 0; k < terms; ++k)
+	{
+		result.values[k] = ((k % 2) ? -1.0 : 1.0) / factorial;
+		factorial *= static_cast<double>(2 * k + 1 + offset) * static_cast<double>(2 * k + 2 + offset);
+	}
+	return result;
+}
+
+// asin(t) = t * sum of C(2n, n) / (4^n (2n + 1)) t^2n.
+static constexpr Coefficients arcsineCoefficients()
+{
+	Coefficients result;
+	double central = 1.0; // C(2n, n) / 4^n
+	for (size_t n = 0; n < ARCSINE_TERMS; ++n)
+	{
+		result.values[n] = central / static_cast<double>(2 * n + 1);
+		central *= static_cast<double>(2 * n + 1) / static_cast<double>(2 * n + 2);
+	}
+	return result;
+}
+
+static constexpr Coefficients SINE = trigCoefficients(SINE_TERMS, 1);
+static constexpr Coefficients COSINE = trigCoefficients(COSINE_TERMS, 0);
+static constexpr Coefficients ARCSINE = arcsineCoefficients();
+
+// Wraps a longitude difference into [-180, 180].
+static inline double wrapLongitude(double delta)
+{
+	if (delta > 180.0)
+	{
+		return delta - 360.0;
+	}
+	if (delta < -180.0)
+	{
+		return delta + 360.0;
+	}
+	return delta;
+}
+
+// --- Scalar Kernels ---
+void ScanKernels::flatEarthDistancesScalar(const double* latitudes, const double* longitudes, size_t count,
+	double latitude, double longitude, double* meters)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		meters[i] = SpatialGrid::distanceMeters(latitude, longitude, latitudes[i], longitudes[i]);
+	}
+}
+
+void ScanKernels::haversineDistancesScalar(const double* latitudes, const double* longitudes, size_t count,
+	double latitude, double longitude, double* meters)
+{
+	double cosineReference = std::cos(latitude * DEGREES_TO_RADIANS);
+	for (size_t i = 0; i < count; ++i)
+	{
+		double sineHalfNorth = std::sin((latitudes[i] - latitude) * 0.5 * DEGREES_TO_RADIANS);
+		double sineHalfEast = std::sin(wrapLongitude(longitudes[i] - longitude) * 0.5 * DEGREES_TO_RADIANS);
+		double a = sineHalfNorth * sineHalfNorth
+			+ cosineReference * std::cos(latitudes[i] * DEGREES_TO_RADIANS) * sineHalfEast * sineHalfEast;
+		meters[i] = 2.0 * EARTH_RADIUS_METERS * std::asin(std::min(1.0, std::sqrt(a)));
+	}
+}
+
+void ScanKernels::heardBeforeMaskScalar(const int64_t* ticks, size_t count, int64_t cutoff, uint64_t* mask)
+{
+	std::fill(mask, mask + maskWords(count), 0);
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (ticks[i] < cutoff)
+		{
+			mask[i / 64] |= 1ull << (i % 64);
+		}
+	}
+}
+
+void ScanKernels::boundingBoxMaskScalar(const double* latitudes, const double* longitudes, size_t count,
+	double minLatitude, double maxLatitude, double minLongitude, double maxLongitude, uint64_t* mask)
+{
+	std::fill(mask, mask + maskWords(count), 0);
+	bool wraps = minLongitude > maxLongitude;
+	for (size_t i = 0; i < count; ++i)
+	{
+		bool inLatitude = latitudes[i] >= minLatitude && latitudes[i] <= maxLatitude;
+		bool inLongitude = wraps ? (longitudes[i] >= minLongitude || longitudes[i] <= maxLongitude)
+			: (longitudes[i] >= minLongitude && longitudes[i] <= maxLongitude);
+		if (inLatitude && inLongitude)
+		{
+			mask[i / 64] |= 1ull << (i % 64);
+		}
+	}
+}
+
+#if defined(__AVX2__)
+// --- AVX2 Kernels ---
+// Four slots per register. Distance tails are padded out to a full register, so
+// every slot gets exactly the same arithmetic; mask tails finish with the scalar test.
+static inline __m256d hornerLanes(__m256d z, const Coefficients& coefficients, size_t terms)
+{
+	__m256d sum = _mm256_set1_pd(coefficients.values[terms - 1]);
+	for (size_t k = terms - 1; k-- > 0;)
+	{
+		sum = _mm256_add_pd(_mm256_mul_pd(sum, z), _mm256_set1_pd(coefficients.values[k]));
+	}
+	return sum;
+}
+
+static inline __m256d sineLanes(__m256d x)
+{
+	return _mm256_mul_pd(x, hornerLanes(_mm256_mul_pd(x, x), SINE, SINE_TERMS));
+}
+
+static inline __m256d cosineLanes(__m256d x)
+{
+	return hornerLanes(_mm256_mul_pd(x, x), COSINE, COSINE_TERMS);
+}
+
+// For s in [0, 1]. Above 1/2 the series converges too slowly, so use
+// asin(s) = pi/2 - 2 asin(sqrt((1 - s) / 2)) there instead.
+static inline __m256d arcsineLanes(__m256d s)
+{
+	__m256d high = _mm256_cmp_pd(s, _mm256_set1_pd(0.5), _CMP_GT_OQ);
+	__m256d reflected = _mm256_sqrt_pd(_mm256_mul_pd(_mm256_sub_pd(_mm256_set1_pd(1.0), s), _mm256_set1_pd(0.5)));
+	__m256d t = _mm256_blendv_pd(s, reflected, high);
+	__m256d series = _mm256_mul_pd(t, hornerLanes(_mm256_mul_pd(t, t), ARCSINE, ARCSINE_TERMS));
+	__m256d unreflected = _mm256_sub_pd(_mm256_set1_pd(HALF_PI), _mm256_add_pd(series, series));
+	return _mm256_blendv_pd(series, unreflected, high);
+}
+
+static inline __m256d wrapLongitudeLanes(__m256d delta)
+{
+	__m256d turn = _mm256_set1_pd(360.0);
+	delta = _mm256_sub_pd(delta, _mm256_and_pd(_mm256_cmp_pd(delta, _mm256_set1_pd(180.0), _CMP_GT_OQ), turn));
+	return _mm256_add_pd(delta, _mm256_and_pd(_mm256_cmp_pd(delta, _mm256_set1_pd(-180.0), _CMP_LT_OQ), turn));
+}
+
+static inline __m256d flatEarthLanes(__m256d latitudes, __m256d longitudes, __m256d latitude, __m256d longitude)
+{
+	__m256d metersPerDegree = _mm256_set1_pd(SpatialGrid::METERS_PER_DEGREE);
+	__m256d north = _mm256_mul_pd(_mm256_sub_pd(latitudes, latitude), metersPerDegree);
+	__m256d meanLatitude = _mm256_mul_pd(_mm256_add_pd(latitudes, latitude), _mm256_set1_pd(0.5 * DEGREES_TO_RADIANS));
+	__m256d east = _mm256_mul_pd(_mm256_mul_pd(wrapLongitudeLanes(_mm256_sub_pd(longitudes, longitude)), metersPerDegree),
+		cosineLanes(meanLatitude));
+	return _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(north, north), _mm256_mul_pd(east, east)));
+}
+
+static inline __m256d haversineLanes(__m256d latitudes, __m256d longitudes, __m256d latitude, __m256d longitude, __m256d cosineReference)
+{
+	__m256d halfToRadians = _mm256_set1_pd(0.5 * DEGREES_TO_RADIANS);
+	__m256d sineHalfNorth = sineLanes(_mm256_mul_pd(_mm256_sub_pd(latitudes, latitude), halfToRadians));
+	__m256d sineHalfEast = sineLanes(_mm256_mul_pd(wrapLongitudeLanes(_mm256_sub_pd(longitudes, longitude)), halfToRadians));
+	__m256d cosineLatitudes = cosineLanes(_mm256_mul_pd(latitudes, _mm256_set1_pd(DEGREES_TO_RADIANS)));
+	__m256d a = _mm256_add_pd(_mm256_mul_pd(sineHalfNorth, sineHalfNorth),
+		_mm256_mul_pd(_mm256_mul_pd(cosineReference, cosineLatitudes), _mm256_mul_pd(sineHalfEast, sineHalfEast)));
+	__m256d s = _mm256_min_pd(_mm256_set1_pd(1.0), _mm256_sqrt_pd(a));
+	return _mm256_mul_pd(_mm256_set1_pd(2.0 * ScanKernels::EARTH_RADIUS_METERS), arcsineLanes(s));
+}
+
+// Runs 'lanes' (latitudes, longitudes -> meters) over every slot; the last partial
+// register is padded with the reference point.
+template <typename Lanes>
+static void distanceLoop(const double* latitudes, const double* longitudes, size_t count,
+	double latitude, double longitude, double* meters, Lanes&& lanes)
+{
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		_mm256_storeu_pd(meters + i, lanes(_mm256_loadu_pd(latitudes + i), _mm256_loadu_pd(longitudes + i)));
+	}
+	if (i < count)
+	{
+		double tailLatitudes[4] = { latitude, latitude, latitude, latitude };
+		double tailLongitudes[4] = { longitude, longitude, longitude, longitude };
+		double tailMeters[4];
+		memcpy(tailLatitudes, latitudes + i, (count - i) * sizeof(double));
+		memcpy(tailLongitudes, longitudes + i, (count - i) * sizeof(double));
+		_mm256_storeu_pd(tailMeters, lanes(_mm256_loadu_pd(tailLatitudes), _mm256_loadu_pd(tailLongitudes)));
+		memcpy(meters + i, tailMeters, (count - i) * sizeof(double));
+	}
+}
+
+// Builds each full 64-bit mask word from 16 four-lane compares; 'lanes(i)' returns
+// the compare for slots i..i+3 as a 4-bit movemask.
+template <typename Lanes>
+static size_t maskLoop(size_t count, uint64_t* mask, Lanes&& lanes)
+{
+	size_t fullWords = count / 64;
+	for (size_t word = 0; word < fullWords; ++word)
+	{
+		uint64_t bits = 0;
+		for (size_t part = 0; part < 16; ++part)
+		{
+			bits |= static_cast<uint64_t>(lanes(word * 64 + part * 4)) << (part * 4);
+		}
+		mask[word] = bits;
+	}
+	return fullWords * 64; // First slot left for the scalar tail
+}
+#elif defined(SCAN_KERNELS_NEON)
+// --- NEON Kernels ---
+// The AVX2 kernels' arithmetic, two slots per register. NEON has no movemask, so
+// the mask loop gathers each compare's two lanes by hand.
+static inline float64x2_t hornerLanes(float64x2_t z, const Coefficients& coefficients, size_t terms)
+{
+	float64x2_t sum = vdupq_n_f64(coefficients.values[terms - 1]);
+	for (size_t k = terms - 1; k-- > 0;)
+	{
+		sum = vaddq_f64(vmulq_f64(sum, z), vdupq_n_f64(coefficients.values[k]));
+	}
+	return sum;
+}
+
+static inline float64x2_t sineLanes(float64x2_t x)
+{
+	return vmulq_f64(x, hornerLanes(vmulq_f64(x, x), SINE, SINE_TERMS));
+}
+
+static inline float64x2_t cosineLanes(float64x2_t x)
+{
+	return hornerLanes(vmulq_f64(x, x), COSINE, COSINE_TERMS);
+}
+
+// For s in [0, 1], reflected above 1/2 as in the AVX2 version.
+static inline float64x2_t arcsineLanes(float64x2_t s)
+{
+	uint64x2_t high = vcgtq_f64(s, vdupq_n_f64(0.5));
+	float64x2_t reflected = vsqrtq_f64(vmulq_f64(vsubq_f64(vdupq_n_f64(1.0), s), vdupq_n_f64(0.5)));
+	float64x2_t t = vbslq_f64(high, reflected, s);
+	float64x2_t series = vmulq_f64(t, hornerLanes(vmulq_f64(t, t), ARCSINE, ARCSINE_TERMS));
+	float64x2_t unreflected = vsubq_f64(vdupq_n_f64(HALF_PI), vaddq_f64(series, series));
+	return vbslq_f64(high, unreflected, series);
+}
+
+static inline float64x2_t wrapLongitudeLanes(float64x2_t delta)
+{
+	float64x2_t turn = vdupq_n_f64(360.0);
+	delta = vbslq_f64(vcgtq_f64(delta, vdupq_n_f64(180.0)), vsubq_f64(delta, turn), delta);
+	return vbslq_f64(vcltq_f64(delta, vdupq_n_f64(-180.0)), vaddq_f64(delta, turn), delta);
+}
+
+static inline float64x2_t flatEarthLanes(float64x2_t latitudes, float64x2_t longitudes, float64x2_t latitude, float64x2_t longitude)
+{
+	float64x2_t metersPerDegree = vdupq_n_f64(SpatialGrid::METERS_PER_DEGREE);
+	float64x2_t north = vmulq_f64(vsubq_f64(latitudes, latitude), metersPerDegree);
+	float64x2_t meanLatitude = vmulq_f64(vaddq_f64(latitudes, latitude), vdupq_n_f64(0.5 * DEGREES_TO_RADIANS));
+	float64x2_t east = vmulq_f64(vmulq_f64(wrapLongitudeLanes(vsubq_f64(longitudes, longitude)), metersPerDegree),
+		cosineLanes(meanLatitude));
+	return vsqrtq_f64(vaddq_f64(vmulq_f64(north, north), vmulq_f64(east, east)));
+}
+
+static inline float64x2_t haversineLanes(float64x2_t latitudes, float64x2_t longitudes, float64x2_t latitude, float64x2_t longitude,
+	float64x2_t cosineReference)
+{
+	float64x2_t halfToRadians = vdupq_n_f64(0.5 * DEGREES_TO_RADIANS);
+	float64x2_t sineHalfNorth = sineLanes(vmulq_f64(vsubq_f64(latitudes, latitude), halfToRadians));
+	float64x2_t sineHalfEast = sineLanes(vmulq_f64(wrapLongitudeLanes(vsubq_f64(longitudes, longitude)), halfToRadians));
+	float64x2_t cosineLatitudes = cosineLanes(vmulq_f64(latitudes, vdupq_n_f64(DEGREES_TO_RADIANS)));
+	float64x2_t a = vaddq_f64(vmulq_f64(sineHalfNorth, sineHalfNorth),
+		vmulq_f64(vmulq_f64(cosineReference, cosineLatitudes), vmulq_f64(sineHalfEast, sineHalfEast)));
+	float64x2_t s = vminq_f64(vdupq_n_f64(1.0), vsqrtq_f64(a));
+	return vmulq_f64(vdupq_n_f64(2.0 * ScanKernels::EARTH_RADIUS_METERS), arcsineLanes(s));
+}
+
+// Runs 'lanes' over every slot; an odd last slot is paired with the reference point.
+template <typename Lanes>
+static void distanceLoop(const double* latitudes, const double* longitudes, size_t count,
+	double latitude, double longitude, double* meters, Lanes&& lanes)
+{
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2)
+	{
+		vst1q_f64(meters + i, lanes(vld1q_f64(latitudes + i), vld1q_f64(longitudes + i)));
+	}
+	if (i < count)
+	{
+		double tailLatitudes[2] = { latitudes[i], latitude };
+		double tailLongitudes[2] = { longitudes[i], longitude };
+		double tailMeters[2];
+		vst1q_f64(tailMeters, lanes(vld1q_f64(tailLatitudes), vld1q_f64(tailLongitudes)));
+		meters[i] = tailMeters[0];
+	}
+}
+
+// Builds each full 64-bit mask word from 32 two-lane compares; 'lanes(i)' returns
+// the compare for slots i and i + 1.
+template <typename Lanes>
+static size_t maskLoop(size_t count, uint64_t* mask, Lanes&& lanes)
+{
+	size_t fullWords = count / 64;
+	for (size_t word = 0; word < fullWords; ++word)
+	{
+		uint64_t bits = 0;
+		for (size_t part = 0; part < 32; ++part)
+		{
+			uint64x2_t compare = lanes(word * 64 + part * 2);
+			uint64_t pair = (vgetq_lane_u64(compare, 0) & 1) | (vgetq_lane_u64(compare, 1) & 2);
+			bits |= pair << (part * 2);
+		}
+		mask[word] = bits;
+	}
+	return fullWords * 64; // First slot left for the scalar tail
+}
+#endif
+
+// --- Dispatching Kernels ---
+const char* ScanKernels::instructionSet()
+{
+#if defined(__AVX2__)
+	return "AVX2";
+#elif defined(SCAN_KERNELS_NEON)
+	return "NEON";
+#else
+	return "scalar";
+#endif
+}
+
+void ScanKernels::flatEarthDistances(const double* latitudes, const double* longitudes, size_t count,
+	double latitude, double longitude, double* meters)
+{
+#if defined(__AVX2__)
+	__m256d referenceLatitude = _mm256_set1_pd(latitude);
+	__m256d referenceLongitude = _mm256_set1_pd(longitude);
+	distanceLoop(latitudes, longitudes, count, latitude, longitude, meters, [&](__m256d lat, __m256d lon)
+		{
+			return flatEarthLanes(lat, lon, referenceLatitude, referenceLongitude);
+		});
+#elif defined(SCAN_KERNELS_NEON)
+	float64x2_t referenceLatitude = vdupq_n_f64(latitude);
+	float64x2_t referenceLongitude = vdupq_n_f64(longitude);
+	distanceLoop(latitudes, longitudes, count, latitude, longitude, meters, [&](float64x2_t lat, float64x2_t lon)
+		{
+			return flatEarthLanes(lat, lon, referenceLatitude, referenceLongitude);
+		});
+#else
+	flatEarthDistancesScalar(latitudes, longitudes, count, latitude, longitude, meters);
+#endif
+}
+
+void ScanKernels::haversineDistances(const double* latitudes, const double* longitudes, size_t count,
+	double latitude, double longitude, double* meters)
+{
+#if defined(__AVX2__)
+	__m256d referenceLatitude = _mm256_set1_pd(latitude);
+	__m256d referenceLongitude = _mm256_set1_pd(longitude);
+	__m256d cosineReference = _mm256_set1_pd(std::cos(latitude * DEGREES_TO_RADIANS));
+	distanceLoop(latitudes, longitudes, count, latitude, longitude, meters, [&](__m256d lat, __m256d lon)
+		{
+			return haversineLanes(lat, lon, referenceLatitude, referenceLongitude, cosineReference);
+		});
+#elif defined(SCAN_KERNELS_NEON)
+	float64x2_t referenceLatitude = vdupq_n_f64(latitude);
+	float64x2_t referenceLongitude = vdupq_n_f64(longitude);
+	float64x2_t cosineReference = vdupq_n_f64(std::cos(latitude * DEGREES_TO_RADIANS));
+	distanceLoop(latitudes, longitudes, count, latitude, longitude, meters, [&](float64x2_t lat, float64x2_t lon)
+		{
+			return haversineLanes(lat, lon, referenceLatitude, referenceLongitude, cosineReference);
+		});
+#else
+	haversineDistancesScalar(latitudes, longitudes, count, latitude, longitude, meters);
+#endif
+}
+
+void ScanKernels::heardBeforeMask(const int64_t* ticks, size_t count, int64_t cutoff, uint64_t* mask)
+{
+#if defined(__AVX2__)
+	__m256i cutoffLanes = _mm256_set1_epi64x(cutoff);
+	size_t done = maskLoop(count, mask, [&](size_t i)
+		{
+			__m256i before = _mm256_cmpgt_epi64(cutoffLanes, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ticks + i)));
+			return _mm256_movemask_pd(_mm256_castsi256_pd(before));
+		});
+	if (done < count)
+	{
+		heardBeforeMaskScalar(ticks + done, count - done, cutoff, mask + done / 64);
+	}
+#elif defined(SCAN_KERNELS_NEON)
+	int64x2_t cutoffLanes = vdupq_n_s64(cutoff);
+	size_t done = maskLoop(count, mask, [&](size_t i)
+		{
+			return vcltq_s64(vld1q_s64(ticks + i), cutoffLanes);
+		});
+	if (done < count)
+	{
+		heardBeforeMaskScalar(ticks + done, count - done, cutoff, mask + done / 64);
+	}
+#else
+	heardBeforeMaskScalar(ticks, count, cutoff, mask);
+#endif
+}
+
+void ScanKernels::boundingBoxMask(const double* latitudes, const double* longitudes, size_t count,
+	double minLatitude, double maxLatitude, double minLongitude, double maxLongitude, uint64_t* mask)
+{
+#if defined(__AVX2__)
+	__m256d minLat = _mm256_set1_pd(minLatitude);
+	__m256d maxLat = _mm256_set1_pd(maxLatitude);
+	__m256d minLon = _mm256_set1_pd(minLongitude);
+	__m256d maxLon = _mm256_set1_pd(maxLongitude);
+	bool wraps = minLongitude > maxLongitude;
+	size_t done = maskLoop(count, mask, [&](size_t i)
+		{
+			__m256d lat = _mm256_loadu_pd(latitudes + i);
+			__m256d lon = _mm256_loadu_pd(longitudes + i);
+			__m256d inLatitude = _mm256_and_pd(_mm256_cmp_pd(lat, minLat, _CMP_GE_OQ), _mm256_cmp_pd(lat, maxLat, _CMP_LE_OQ));
+			__m256d east = _mm256_cmp_pd(lon, minLon, _CMP_GE_OQ);
+			__m256d west = _mm256_cmp_pd(lon, maxLon, _CMP_LE_OQ);
+			__m256d inLongitude = wraps ? _mm256_or_pd(east, west) : _mm256_and_pd(east, west);
+			return _mm256_movemask_pd(_mm256_and_pd(inLatitude, inLongitude));
+		});
+	if (done < count)
+	{
+		boundingBoxMaskScalar(latitudes + done, longitudes + done, count - done,
+			minLatitude, maxLatitude, minLongitude, maxLongitude, mask + done / 64);
+	}
+#elif defined(SCAN_KERNELS_NEON)
+	float64x2_t minLat = vdupq_n_f64(minLatitude);
+	float64x2_t maxLat = vdupq_n_f64(maxLatitude);
+	float64x2_t minLon = vdupq_n_f64(minLongitude);
+	float64x2_t maxLon = vdupq_n_f64(maxLongitude);
+	bool wraps = minLongitude > maxLongitude;
+	size_t done = maskLoop(count, mask, [&](size_t i)
+		{
+			float64x2_t lat = vld1q_f64(latitudes + i);
+			float64x2_t lon = vld1q_f64(longitudes + i);
+			uint64x2_t inLatitude = vandq_u64(vcgeq_f64(lat, minLat), vcleq_f64(lat, maxLat));
+			uint64x2_t east = vcgeq_f64(lon, minLon);
+			uint64x2_t west = vcleq_f64(lon, maxLon);
+			uint64x2_t inLongitude = wraps ? vorrq_u64(east, west) : vandq_u64(east, west);
+			return vandq_u64(inLatitude, inLongitude);
+		});
+	if (done < count)
+	{
+		boundingBoxMaskScalar(latitudes + done, longitudes + done, count - done,
+			minLatitude, maxLatitude, minLongitude, maxLongitude, mask + done / 64);
+	}
+#else
+	boundingBoxMaskScalar(latitudes, longitudes, count, minLatitude, maxLatitude, minLongitude, maxLongitude, mask);
+#endif
+}
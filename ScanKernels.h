@@ -0,0 +1,81 @@
+// ScanKernels.h
+#ifndef SCAN_KERNELS_H
+#define SCAN_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#if defined(_MSC_VER)
+#include <intrin.h> // _BitScanForward64
+#endif
+
+// --- Scan Kernels ---
+// Whole-column passes over NodeTable's structure-of-arrays fields: one call
+// handles every slot of a shard, four at a time in AVX2 registers when the build
+// enables AVX2 (/arch:AVX2, -mavx2), two at a time in NEON registers on 64-bit
+// ARM, one at a time otherwise. Each kernel's Scalar twin is the plain loop it
+// replaces; both always exist, so benchmarks can compare them in one binary.
+//
+// Masks hold one bit per slot, slot i in bit i % 64 of mask[i / 64], and fill
+// (count + 63) / 64 words; bits past 'count' are zero. The kernels don't know
+// which slots are occupied or have a position, so callers check the set bits.
+struct ScanKernels
+{
+	static constexpr double EARTH_RADIUS_METERS = 6371008.8; // Mean radius, for haversine
+
+	// "AVX2", "NEON" or "scalar": what the dispatching kernels below run.
+	static const char* instructionSet();
+
+	static size_t maskWords(size_t count) { return (count + 63) / 64; }
+
+	// Calls visit(slot) for every set bit, lowest first, skipping empty words whole.
+	template <typename Visit>
+	static void forEachSetBit(const uint64_t* mask, size_t words, Visit&& visit)
+	{
+		for (size_t word = 0; word < words; ++word)
+		{
+			for (uint64_t bits = mask[word]; bits != 0; bits &= bits - 1)
+			{
+				visit(static_cast<uint32_t>(word * 64 + lowestSetBit(bits)));
+			}
+		}
+	}
+
+	// Surface distance from (latitude, longitude) to each slot, by the same
+	// equirectangular formula as SpatialGrid::distanceMeters(). The vector kernels'
+	// cosine is a polynomial, so the two agree to within a nanometre per kilometre.
+	static void flatEarthDistances(const double* latitudes, const double* longitudes, size_t count,
+		double latitude, double longitude, double* meters);
+	static void flatEarthDistancesScalar(const double* latitudes, const double* longitudes, size_t count,
+		double latitude, double longitude, double* meters);
+
+	// Great-circle distance, exact at any range; costs more (sines, an arcsine).
+	static void haversineDistances(const double* latitudes, const double* longitudes, size_t count,
+		double latitude, double longitude, double* meters);
+	static void haversineDistancesScalar(const double* latitudes, const double* longitudes, size_t count,
+		double latitude, double longitude, double* meters);
+
+	// Bit set where ticks[i] < cutoff: last heard before the cutoff time.
+	static void heardBeforeMask(const int64_t* ticks, size_t count, int64_t cutoff, uint64_t* mask);
+	static void heardBeforeMaskScalar(const int64_t* ticks, size_t count, int64_t cutoff, uint64_t* mask);
+
+	// Bit set where the slot lies inside the box (edges included). The box crosses
+	// the antimeridian when minLongitude > maxLongitude.
+	static void boundingBoxMask(const double* latitudes, const double* longitudes, size_t count,
+		double minLatitude, double maxLatitude, double minLongitude, double maxLongitude, uint64_t* mask);
+	static void boundingBoxMaskScalar(const double* latitudes, const double* longitudes, size_t count,
+		double minLatitude, double maxLatitude, double minLongitude, double maxLongitude, uint64_t* mask);
+
+private:
+	static unsigned lowestSetBit(uint64_t bits) // 'bits' is non-zero
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward64(&index, bits);
+		return static_cast<unsigned>(index);
+#else
+		return static_cast<unsigned>(__builtin_ctzll(bits));
+#endif
+	}
+};
+
+#endif // SCAN_KERNELS_H
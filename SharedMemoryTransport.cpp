@@ -0,0 +1,379 @@
+// SharedMemoryTransport.cpp
+#include "SharedMemoryTransport.h"
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include "Logger.h"
+#include "Metrics.h"
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static constexpr int IDLE_SPINS = 2000;        // Polls before the idle reader starts yielding...
+static constexpr int IDLE_YIELDS = 200;        // ...and yields before it falls back to short sleeps
+static constexpr std::chrono::microseconds IDLE_SLEEP{ 500 };
+static constexpr std::chrono::milliseconds ATTACH_TIMEOUT{ 1000 }; // How long an opener waits for the creator to finish
+
+static uint64_t roundUpToPowerOfTwo(uint64_t value)
+{
+	uint64_t result = 1;
+	while (result < value)
+	{
+		result <<= 1;
+	}
+	return result;
+}
+
+// Slots start on a cache line after the header.
+static constexpr size_t SLOTS_OFFSET = 128;
+
+SharedMemoryTransport::SharedMemoryTransport(const std::string& name, size_t slotCount, uint16_t port, int receiveTimeoutMs,
+	size_t heldPackets) :
+	m_receiveTimeoutMs(receiveTimeoutMs),
+	m_packetPool(poolSlotsFor(heldPackets), MAX_DATAGRAM_SIZE)
+{
+	static_assert(sizeof(RingHeader) <= SLOTS_OFFSET, "Ring header overlaps the first slot");
+
+	m_senderAddress.sin_family = AF_INET;
+	m_senderAddress.sin_port = htons(port);
+	m_senderAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+#if defined(_WIN32)
+	m_processId = static_cast<uint32_t>(GetCurrentProcessId());
+#elif defined(__linux__)
+	m_processId = static_cast<uint32_t>(getpid());
+#endif
+
+	if (!mapSegment(name, slotCount))
+	{
+		return; // isInitialized() stays false
+	}
+
+	// Start at the live edge: a new reader sees traffic from now on, not history.
+	m_readPosition = m_ring->writePosition.load(std::memory_order_acquire);
+	TDL_LOG_INFO << "[ShmTransport] Attached to '" << name << "' (" << m_slotCount << " slots).";
+}
+
+SharedMemoryTransport::~SharedMemoryTransport()
+{
+	// The segment itself outlives this process so later peers join the same ring.
+#if defined(_WIN32)
+	if (m_ring)
+	{
+		UnmapViewOfFile(m_ring);
+	}
+	if (m_mapping)
+	{
+		CloseHandle(m_mapping);
+	}
+#elif defined(__linux__)
+	if (m_ring)
+	{
+		munmap(m_ring, m_mappingSize);
+	}
+	if (m_shmFd >= 0)
+	{
+		close(m_shmFd);
+	}
+#endif
+}
+
+// --- Segment Setup ---
+bool SharedMemoryTransport::mapSegment(const std::string& name, size_t slotCount)
+{
+	uint64_t requestedSlots = roundUpToPowerOfTwo(slotCount > 0 ? slotCount : 1);
+	size_t requestedSize = SLOTS_OFFSET + static_cast<size_t>(requestedSlots) * sizeof(Slot);
+	bool created = false;
+	void* view = nullptr;
+
+#if defined(_WIN32)
+	// The "Local\" namespace keeps the ring per login session. Existing mappings are
+	// opened whatever their size, and mapping 0 bytes maps all of it.
+	std::string mappingName = "Local\\BasicTDL_" + name;
+	m_mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+		static_cast<DWORD>(static_cast<uint64_t>(requestedSize) >> 32), static_cast<DWORD>(requestedSize), mappingName.c_str());
+	if (!m_mapping)
+	{
+		TDL_LOG_ERROR << "[ShmTransport] CreateFileMapping failed: " << GetLastError();
+		return false;
+	}
+	created = (GetLastError() != ERROR_ALREADY_EXISTS);
+
+	view = MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+	if (!view)
+	{
+		TDL_LOG_ERROR << "[ShmTransport] MapViewOfFile failed: " << GetLastError();
+		return false;
+	}
+	m_mappingSize = created ? requestedSize : 0; // Checked against the header below
+#elif defined(__linux__)
+	m_shmName = "/BasicTDL_" + name;
+	m_shmFd = shm_open(m_shmName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+	created = (m_shmFd >= 0);
+	if (created)
+	{
+		if (ftruncate(m_shmFd, static_cast<off_t>(requestedSize)) != 0)
+		{
+			TDL_LOG_ERROR << "[ShmTransport] ftruncate failed: " << errno;
+			shm_unlink(m_shmName.c_str()); // Don't leave a zero-sized segment for the next process
+			return false;
+		}
+		m_mappingSize = requestedSize;
+	}
+	else
+	{
+		m_shmFd = shm_open(m_shmName.c_str(), O_RDWR, 0);
+		if (m_shmFd < 0)
+		{
+			TDL_LOG_ERROR << "[ShmTransport] shm_open failed: " << errno;
+			return false;
+		}
+
+		// The creator may not have sized it yet.
+		auto deadline = std::chrono::steady_clock::now() + ATTACH_TIMEOUT;
+		struct stat info = {};
+		while (fstat(m_shmFd, &info) == 0 && static_cast<size_t>(info.st_size) < SLOTS_OFFSET)
+		{
+			if (std::chrono::steady_clock::now() > deadline)
+			{
+				TDL_LOG_ERROR << "[ShmTransport] Segment '" << name << "' was never sized.";
+				return false;
+			}
+			std::this_thread::sleep_for(IDLE_SLEEP);
+		}
+		m_mappingSize = static_cast<size_t>(info.st_size);
+	}
+
+	view = mmap(nullptr, m_mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_shmFd, 0);
+	if (view == MAP_FAILED)
+	{
+		TDL_LOG_ERROR << "[ShmTransport] mmap failed: " << errno;
+		return false;
+	}
+#endif
+
+	RingHeader* ring = static_cast<RingHeader*>(view);
+	m_ring = ring; // From here on the destructor unmaps it, whatever happens below
+	if (created)
+	{
+		// Fresh segments are zero-filled, so every slot already reads as "never written".
+		ring->version = RING_VERSION;
+		ring->slotCount = requestedSlots;
+		ring->writePosition.store(0, std::memory_order_relaxed);
+		ring->magic.store(RING_MAGIC, std::memory_order_release); // Publishes the fields above
+	}
+	else
+	{
+		auto deadline = std::chrono::steady_clock::now() + ATTACH_TIMEOUT;
+		while (ring->magic.load(std::memory_order_acquire) != RING_MAGIC)
+		{
+			if (std::chrono::steady_clock::now() > deadline)
+			{
+				TDL_LOG_ERROR << "[ShmTransport] Segment '" << name << "' was never initialized.";
+				return false;
+			}
+			std::this_thread::sleep_for(IDLE_SLEEP);
+		}
+	}
+
+	size_t neededSize = SLOTS_OFFSET + static_cast<size_t>(ring->slotCount) * sizeof(Slot);
+	if (ring->version != RING_VERSION || ring->slotCount == 0 || (ring->slotCount & (ring->slotCount - 1)) != 0 ||
+		(m_mappingSize != 0 && m_mappingSize < neededSize))
+	{
+		TDL_LOG_ERROR << "[ShmTransport] Segment '" << name << "' has an incompatible layout.";
+		return false;
+	}
+	if (m_mappingSize == 0)
+	{
+		m_mappingSize = neededSize;
+	}
+
+	m_slots = reinterpret_cast<Slot*>(static_cast<uint8_t*>(view) + SLOTS_OFFSET);
+	m_slotCount = ring->slotCount;
+	m_initialized = true;
+	return true;
+}
+
+// --- Sending ---
+bool SharedMemoryTransport::sendBroadcast(const void* data, size_t size)
+{
+	if (!m_initialized || size == 0 || size > MAX_DATAGRAM_SIZE)
+	{
+		Metrics::increment(MetricCounter::SendFailures);
+		return false;
+	}
+
+	// Claim a position, mark the slot busy, fill it, then publish it.
+	uint64_t position = m_ring->writePosition.fetch_add(1, std::memory_order_relaxed);
+	Slot& slot = slotAt(position);
+	slot.sequence.store(2 * position + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release); // Busy marker is visible before any payload byte
+	slot.size = static_cast<uint32_t>(size);
+	slot.senderProcessId = m_processId;
+	memcpy(slot.data, data, size);
+	slot.sequence.store(2 * position + 2, std::memory_order_release);
+
+	Metrics::increment(MetricCounter::PacketsSent);
+	Metrics::increment(MetricCounter::BytesSent, size);
+	return true;
+}
+
+// --- Receiving ---
+SharedMemoryTransport::ReadResult SharedMemoryTransport::readNext(ReceivedPacket& packet)
+{
+	Slot& slot = slotAt(m_readPosition);
+	uint64_t complete = 2 * m_readPosition + 2;
+
+	uint64_t before = slot.sequence.load(std::memory_order_acquire);
+	if (before < complete)
+	{
+		// Not written yet, unless writers have already gone a whole ring past it
+		// (the writer for this slot died mid-copy, or we were lapped before it finished).
+		if (m_ring->writePosition.load(std::memory_order_relaxed) > m_readPosition + m_slotCount)
+		{
+			return ReadResult::Lapped;
+		}
+		return ReadResult::Empty;
+	}
+	if (before > complete)
+	{
+		return ReadResult::Lapped;
+	}
+
+	if (!packet.buffer)
+	{
+		packet.buffer = m_packetPool.acquire();
+		if (!packet.buffer)
+		{
+			m_poolRanDry = true;
+			return ReadResult::Empty; // Pool exhausted; leave it on the ring for the next call
+		}
+	}
+
+	// Seqlock read: copy optimistically, then make sure no writer touched the slot meanwhile.
+	size_t size = slot.size;
+	if (size > MAX_DATAGRAM_SIZE)
+	{
+		size = MAX_DATAGRAM_SIZE; // Torn read; the recheck below throws it away
+	}
+	memcpy(packet.buffer.data(), slot.data, size);
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (slot.sequence.load(std::memory_order_relaxed) != before)
+	{
+		return ReadResult::Lapped;
+	}
+
+	packet.size = size;
+	packet.senderAddress = m_senderAddress;
+	++m_readPosition;
+	return ReadResult::Read;
+}
+
+size_t SharedMemoryTransport::receiveBatch(ReceivedPacket* packets, size_t maxPackets, bool wait)
+{
+	if (!m_initialized)
+	{
+		return 0;
+	}
+	if (wait && !hasPending())
+	{
+		// Same backoff as waitForEvents(), but only data ends the wait.
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_receiveTimeoutMs);
+		for (int idle = 0; !hasPending(); ++idle)
+		{
+			if (idle >= IDLE_SPINS && std::chrono::steady_clock::now() >= deadline)
+			{
+				return 0;
+			}
+			if (idle >= IDLE_SPINS + IDLE_YIELDS)
+			{
+				std::this_thread::sleep_for(IDLE_SLEEP);
+			}
+			else if (idle >= IDLE_SPINS)
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	size_t filled = 0;
+	auto receivedAt = std::chrono::steady_clock::now();
+	while (filled < maxPackets)
+	{
+		ReadResult result = readNext(packets[filled]);
+		if (result == ReadResult::Empty)
+		{
+			break;
+		}
+		if (result == ReadResult::Lapped)
+		{
+			// Skip to half a ring behind the writers, leaving room before they lap us again.
+			uint64_t resume = m_ring->writePosition.load(std::memory_order_acquire) - m_slotCount / 2;
+			if (resume <= m_readPosition)
+			{
+				resume = m_readPosition + 1;
+			}
+			m_lostCount.fetch_add(resume - m_readPosition, std::memory_order_relaxed);
+			Metrics::increment(MetricCounter::PacketsDropped, resume - m_readPosition);
+			m_readPosition = resume;
+			continue;
+		}
+		packets[filled].receivedAt = receivedAt;
+		++filled;
+	}
+
+	m_receivedCount.fetch_add(filled, std::memory_order_relaxed);
+	return filled;
+}
+
+bool SharedMemoryTransport::hasPending()
+{
+	return m_ring->writePosition.load(std::memory_order_acquire) > m_readPosition;
+}
+
+// --- Event-Driven Receive ---
+Transport::WaitResult SharedMemoryTransport::waitForEvents(int timeoutMs)
+{
+	if (!m_initialized)
+	{
+		return WaitResult::Error;
+	}
+
+	// Spin while traffic is likely to be close behind, then back off to short sleeps.
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+	for (int idle = 0;; ++idle)
+	{
+		// Datagrams first; a pending wakeup stays pending for the next call. With the
+		// pool dry they wait on the ring (it may lap us, which is counted) rather than
+		// have the reactor spin on reads that can't take them.
+		if (hasPending() && (!m_poolRanDry || m_packetPool.available() > 0))
+		{
+			m_poolRanDry = false;
+			return WaitResult::Readable;
+		}
+		if (m_wakePending.exchange(false, std::memory_order_acq_rel))
+		{
+			return WaitResult::Woken;
+		}
+		if (idle >= IDLE_SPINS && timeoutMs >= 0 && std::chrono::steady_clock::now() >= deadline)
+		{
+			return WaitResult::Timeout;
+		}
+		if (idle >= IDLE_SPINS + IDLE_YIELDS)
+		{
+			std::this_thread::sleep_for(IDLE_SLEEP);
+		}
+		else if (idle >= IDLE_SPINS)
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void SharedMemoryTransport::wakeup()
+{
+	m_wakePending.store(true, std::memory_order_release);
+}
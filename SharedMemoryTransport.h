@@ -0,0 +1,128 @@
+// SharedMemoryTransport.h
+#ifndef SHARED_MEMORY_TRANSPORT_H
+#define SHARED_MEMORY_TRANSPORT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "PacketPool.h"
+#include "Transport.h"
+
+// --- Shared-Memory Transport ---
+// A Transport for TDL processes on the same host (gateways, displays, recorders).
+// Every process that opens the same segment name attaches to one broadcast ring in
+// shared memory: sendBroadcast() claims the next slot with a single atomic add and
+// copies the datagram in; every attached reader walks the ring with its own cursor.
+// No datagram goes near the network stack and neither side makes a system call
+// while traffic is flowing, so local peers exchange messages at memory speed.
+//
+// Like UDP broadcast, the ring never waits for slow readers. Each slot carries a
+// sequence number written after the payload (a seqlock): a reader that sees a
+// sequence ahead of its cursor knows it was lapped, counts the overwritten
+// datagrams as lost and skips forward to the oldest one still intact.
+//
+// Idle readers back off from spinning to short sleeps inside waitForEvents(), so
+// an idle process costs almost nothing and a busy one never enters the kernel.
+// The sender also receives its own datagrams, the same as a UDP broadcast socket.
+class SharedMemoryTransport : public Transport
+{
+public:
+	// Opens the segment 'name', creating it with 'slotCount' slots (rounded up to a
+	// power of two) if no other process has yet. Processes that open an existing
+	// segment use its slot count. 'port' only fills in the sender address, and
+	// 'heldPackets' sizes the pool (see Transport::poolSlotsFor()).
+	SharedMemoryTransport(const std::string& name, size_t slotCount, uint16_t port, int receiveTimeoutMs = 1000,
+		size_t heldPackets = 0);
+
+	~SharedMemoryTransport() override;
+
+	bool isInitialized() const override { return m_initialized; }
+
+	// Safe from any thread of any attached process.
+	bool sendBroadcast(const void* data, size_t size) override;
+
+	size_t receiveBatch(ReceivedPacket* packets, size_t maxPackets, bool wait = true) override;
+
+	PacketPool& getPacketPool() override { return m_packetPool; }
+
+	WaitResult waitForEvents(int timeoutMs) override;
+	void wakeup() override;
+
+	// Largest datagram a slot can carry.
+	static constexpr size_t MAX_DATAGRAM_SIZE = 2048 - 16;
+
+	// Datagrams this reader took off the ring / lost because writers lapped it.
+	uint64_t getReceivedCount() const { return m_receivedCount.load(std::memory_order_relaxed); }
+	uint64_t getLostCount() const { return m_lostCount.load(std::memory_order_relaxed); }
+
+	// Disable copy and assignment (owns the mapping)
+	SharedMemoryTransport(const SharedMemoryTransport&) = delete;
+	SharedMemoryTransport& operator=(const SharedMemoryTransport&) = delete;
+
+private:
+	// --- Shared Layout ---
+	// Everything below lives in the segment and is shared by every process, so it
+	// may only hold plain data and address-free lock-free atomics.
+	struct Slot
+	{
+		// 2 * position + 1 while a writer is filling the slot for 'position',
+		// 2 * position + 2 once it is complete. Zero means never written.
+		std::atomic<uint64_t> sequence;
+		uint32_t size;
+		uint32_t senderProcessId;
+		uint8_t data[MAX_DATAGRAM_SIZE];
+	};
+
+	struct RingHeader
+	{
+		std::atomic<uint32_t> magic;        // Set last by the creator; openers wait for it
+		uint32_t version;
+		uint64_t slotCount;                 // Power of two
+		alignas(64) std::atomic<uint64_t> writePosition; // Next position a writer will claim
+	};
+
+	static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared-memory atomics must be lock-free");
+	static_assert(sizeof(Slot) == 2048, "Slots are sized to match the datagram pool");
+
+	static constexpr uint32_t RING_MAGIC = 0x4C44545Au; // "ZTDL"
+	static constexpr uint32_t RING_VERSION = 1;
+
+	bool mapSegment(const std::string& name, size_t slotCount);
+	Slot& slotAt(uint64_t position) { return m_slots[position & (m_slotCount - 1)]; }
+
+	// Copies the datagram at m_readPosition into 'packet' if one is ready.
+	enum class ReadResult { Read, Empty, Lapped };
+	ReadResult readNext(ReceivedPacket& packet);
+
+	bool hasPending();
+
+	bool m_initialized = false;
+	RingHeader* m_ring = nullptr;
+	Slot* m_slots = nullptr;
+	uint64_t m_slotCount = 0;
+	size_t m_mappingSize = 0;
+
+#if defined(_WIN32)
+	HANDLE m_mapping = nullptr;
+#elif defined(__linux__)
+	std::string m_shmName;
+	int m_shmFd = -1;
+#endif
+
+	// Process-local state. The cursor and wake flag belong to the receive thread;
+	// wakeup() may set the flag from any thread.
+	uint64_t m_readPosition = 0;
+	std::atomic<bool> m_wakePending{ false };
+	uint32_t m_processId = 0;
+	sockaddr_in m_senderAddress = {};
+	int m_receiveTimeoutMs = 0;
+	bool m_poolRanDry = false; // The last read found the pool empty; not readable again until a slot is back
+
+	PacketPool m_packetPool;
+
+	std::atomic<uint64_t> m_receivedCount{ 0 };
+	std::atomic<uint64_t> m_lostCount{ 0 };
+};
+
+#endif // SHARED_MEMORY_TRANSPORT_H
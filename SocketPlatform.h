@@ -0,0 +1,40 @@
+// SocketPlatform.h
+#ifndef SOCKET_PLATFORM_H
+#define SOCKET_PLATFORM_H
+
+// --- Socket Platform ---
+// The one place that knows whether sockets come from Winsock or from POSIX. On
+// Windows it is just the Winsock headers; elsewhere it supplies the few Winsock
+// names the common socket code is written against (SOCKET, INVALID_SOCKET,
+// SOCKET_ERROR, closesocket), so that code reads the same on every platform.
+// Only the parts that really differ (the receive ring, timeouts) stay under
+// #if in NetworkManager.cpp.
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib") // Link Winsock library
+#else
+#include <arpa/inet.h>  // inet_pton, inet_ntop, htons
+#include <cerrno>
+#include <netinet/in.h> // sockaddr_in, ip_mreq
+#include <sys/socket.h>
+#include <unistd.h>     // close
+
+using SOCKET = int;
+static constexpr SOCKET INVALID_SOCKET = -1;
+static constexpr int SOCKET_ERROR = -1;
+
+inline int closesocket(SOCKET socket) { return close(socket); }
+#endif
+
+// The error code of the last failed socket call on this thread, for logging.
+inline int lastSocketError()
+{
+#if defined(_WIN32)
+	return WSAGetLastError();
+#else
+	return errno;
+#endif
+}
+
+#endif // SOCKET_PLATFORM_H
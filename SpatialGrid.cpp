@@ -0,0 +1,120 @@
+// SpatialGrid.cpp
+#include "SpatialGrid.h"
+#include <cmath>
+
+static constexpr double DEGREES_TO_RADIANS = 3.14159265358979323846 / 180.0;
+
+SpatialGrid::SpatialGrid(size_t bucketCount) :
+	m_bucketMask(bucketCount - 1),
+	m_bucketHeads(bucketCount, INVALID_SLOT)
+{
+}
+
+// Both clamp or wrap before converting, since a double outside int32's range
+// (NaN included) has no defined conversion. NodeManager only stores positions on
+// the Earth, but query centres and boxes come straight from callers.
+int32_t SpatialGrid::latitudeCell(double latitude)
+{
+	if (!(latitude >= -90.0)) // NaN lands here too
+	{
+		latitude = -90.0;
+	}
+	else if (latitude > 90.0)
+	{
+		latitude = 90.0;
+	}
+	return static_cast<int32_t>(std::floor((latitude + 90.0) / CELL_DEGREES));
+}
+
+int32_t SpatialGrid::longitudeCell(double longitude)
+{
+	double wrapped = std::fmod(longitude + 180.0, 360.0); // NaN for NaN or infinity
+	if (std::isnan(wrapped))
+	{
+		wrapped = 0.0;
+	}
+	int32_t column = static_cast<int32_t>(std::floor(wrapped / CELL_DEGREES));
+	column %= LONGITUDE_CELLS;
+	return column < 0 ? column + LONGITUDE_CELLS : column;
+}
+
+void SpatialGrid::ensureSlot(uint32_t slot)
+{
+	if (slot >= m_next.size())
+	{
+		size_t newSize = static_cast<size_t>(slot) + 1;
+		m_next.resize(newSize, INVALID_SLOT);
+		m_prev.resize(newSize, INVALID_SLOT);
+		m_cell.resize(newSize, 0);
+		m_linked.resize(newSize, 0);
+	}
+}
+
+void SpatialGrid::update(uint32_t slot, double latitude, double longitude)
+{
+	ensureSlot(slot);
+	uint64_t key = cellKey(latitudeCell(latitude), longitudeCell(longitude));
+
+	if (m_linked[slot])
+	{
+		if (m_cell[slot] == key)
+		{
+			return; // Still in the same cell (the common case between two reports)
+		}
+		remove(slot);
+	}
+
+	// Push onto the front of the bucket's list.
+	size_t bucket = bucketOf(key);
+	m_prev[slot] = INVALID_SLOT;
+	m_next[slot] = m_bucketHeads[bucket];
+	if (m_bucketHeads[bucket] != INVALID_SLOT)
+	{
+		m_prev[m_bucketHeads[bucket]] = slot;
+	}
+	m_bucketHeads[bucket] = slot;
+
+	m_cell[slot] = key;
+	m_linked[slot] = 1;
+}
+
+void SpatialGrid::remove(uint32_t slot)
+{
+	if (slot >= m_linked.size() || !m_linked[slot])
+	{
+		return;
+	}
+
+	if (m_prev[slot] != INVALID_SLOT)
+	{
+		m_next[m_prev[slot]] = m_next[slot];
+	}
+	else
+	{
+		m_bucketHeads[bucketOf(m_cell[slot])] = m_next[slot];
+	}
+	if (m_next[slot] != INVALID_SLOT)
+	{
+		m_prev[m_next[slot]] = m_prev[slot];
+	}
+
+	m_next[slot] = INVALID_SLOT;
+	m_prev[slot] = INVALID_SLOT;
+	m_linked[slot] = 0;
+}
+
+double SpatialGrid::distanceMeters(double latitudeA, double longitudeA, double latitudeB, double longitudeB)
+{
+	double deltaLongitude = longitudeA - longitudeB;
+	if (deltaLongitude > 180.0)
+	{
+		deltaLongitude -= 360.0;
+	}
+	else if (deltaLongitude < -180.0)
+	{
+		deltaLongitude += 360.0;
+	}
+	double north = (latitudeA - latitudeB) * METERS_PER_DEGREE;
+	double east = deltaLongitude * METERS_PER_DEGREE * std::cos((latitudeA + latitudeB) * 0.5 * DEGREES_TO_RADIANS);
+	return std::sqrt(north * north + east * east);
+}
@@ -0,0 +1,139 @@
+// SpatialGrid.h
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// --- Spatial Grid ---
+// A hashed lat/lon grid over NodeTable slots. The globe is cut into fixed cells of
+// CELL_DEGREES on a side; each cell hashes to one of a power-of-two number of
+// buckets, and each bucket is an intrusive doubly linked list of slots, threaded
+// through per-slot next/prev arrays exactly like TimerWheel. Moving a node within
+// its cell is a compare; moving it to another cell is an O(1) unlink/link; nothing
+// allocates once the per-slot arrays have grown with the node table.
+//
+// A region query visits only the cells overlapping the region's bounding box, and
+// skips slots that merely share a bucket with one of them, so its cost follows the
+// number of nodes nearby rather than the size of the table. Not thread-safe;
+// NodeManager keeps one per shard, under the shard lock.
+class SpatialGrid
+{
+public:
+	static constexpr uint32_t INVALID_SLOT = 0xFFFFFFFFu;
+
+	// About 5.5 km north-south: a city-sized query touches a handful of cells.
+	static constexpr double CELL_DEGREES = 0.05;
+
+	// 'bucketCount' must be a power of two.
+	explicit SpatialGrid(size_t bucketCount = 1024);
+
+	// Files 'slot' under the cell containing (latitude, longitude), moving it if needed.
+	void update(uint32_t slot, double latitude, double longitude);
+
+	// Removes 'slot' from the grid (no-op if it isn't filed).
+	void remove(uint32_t slot);
+
+	// Sizes the per-slot arrays for slots below 'slotCount' now, so filing them never allocates.
+	void reserveSlots(size_t slotCount)
+	{
+		if (slotCount > 0)
+		{
+			ensureSlot(static_cast<uint32_t>(slotCount - 1));
+		}
+	}
+
+	// Calls visitor(slot) for every filed slot whose cell overlaps the box. The box
+	// may cross the antimeridian (minLongitude > maxLongitude). Slots outside the
+	// box but in an overlapping cell are included; callers filter exactly.
+	template <typename Visitor>
+	void visitBox(double minLatitude, double maxLatitude, double minLongitude, double maxLongitude, Visitor&& visitor) const;
+
+	// Approximate surface distance (equirectangular, so good to well under 1% at
+	// the ranges TDL cares about). Handles the antimeridian.
+	static double distanceMeters(double latitudeA, double longitudeA, double latitudeB, double longitudeB);
+
+	static constexpr double METERS_PER_DEGREE = 111320.0;
+
+private:
+	static constexpr int32_t LONGITUDE_CELLS = static_cast<int32_t>(360.0 / CELL_DEGREES + 0.5);
+
+	static int32_t latitudeCell(double latitude);
+	static int32_t longitudeCell(double longitude); // Wrapped to [0, LONGITUDE_CELLS)
+	static uint64_t cellKey(int32_t latitudeCell, int32_t longitudeCell)
+	{
+		return (static_cast<uint64_t>(static_cast<uint32_t>(latitudeCell)) << 32) | static_cast<uint32_t>(longitudeCell);
+	}
+	size_t bucketOf(uint64_t key) const
+	{
+		return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 40) & m_bucketMask;
+	}
+
+	void ensureSlot(uint32_t slot);
+
+	size_t m_bucketMask;
+	std::vector<uint32_t> m_bucketHeads;  // First slot in each bucket, INVALID_SLOT if empty
+
+	// --- Per-slot intrusive links ---
+	std::vector<uint32_t> m_next;
+	std::vector<uint32_t> m_prev;
+	std::vector<uint64_t> m_cell;         // Cell the slot is filed under
+	std::vector<uint8_t> m_linked;
+};
+
+template <typename Visitor>
+void SpatialGrid::visitBox(double minLatitude, double maxLatitude, double minLongitude, double maxLongitude, Visitor&& visitor) const
+{
+	int32_t firstRow = latitudeCell(minLatitude);
+	int32_t lastRow = latitudeCell(maxLatitude);
+	int32_t firstColumn = longitudeCell(minLongitude);
+	int32_t columns = longitudeCell(maxLongitude) - firstColumn + 1;
+	if (columns <= 0 || minLongitude > maxLongitude)
+	{
+		columns += LONGITUDE_CELLS; // Crosses the antimeridian
+	}
+	if (columns > LONGITUDE_CELLS || maxLongitude - minLongitude >= 360.0)
+	{
+		columns = LONGITUDE_CELLS;
+	}
+
+	auto visitBucketCells = [&](size_t bucket, auto&& wanted)
+		{
+			for (uint32_t slot = m_bucketHeads[bucket]; slot != INVALID_SLOT; slot = m_next[slot])
+			{
+				if (wanted(m_cell[slot]))
+				{
+					visitor(slot);
+				}
+			}
+		};
+
+	// A huge box covers more cells than there are buckets: walk every bucket once instead.
+	uint64_t cellCount = static_cast<uint64_t>(lastRow - firstRow + 1) * static_cast<uint64_t>(columns);
+	if (cellCount > m_bucketHeads.size())
+	{
+		for (size_t bucket = 0; bucket < m_bucketHeads.size(); ++bucket)
+		{
+			visitBucketCells(bucket, [&](uint64_t cell)
+				{
+					int32_t row = static_cast<int32_t>(static_cast<uint32_t>(cell >> 32));
+					int32_t column = static_cast<int32_t>(static_cast<uint32_t>(cell));
+					int32_t offset = (column - firstColumn + LONGITUDE_CELLS) % LONGITUDE_CELLS;
+					return row >= firstRow && row <= lastRow && offset < columns;
+				});
+		}
+		return;
+	}
+
+	for (int32_t row = firstRow; row <= lastRow; ++row)
+	{
+		for (int32_t i = 0; i < columns; ++i)
+		{
+			uint64_t key = cellKey(row, (firstColumn + i) % LONGITUDE_CELLS);
+			visitBucketCells(bucketOf(key), [key](uint64_t cell) { return cell == key; });
+		}
+	}
+}
+
+#endif // SPATIAL_GRID_H
@@ -0,0 +1,390 @@
+// TdlCodec.cpp
+#include "TdlCodec.h"
+#include <cmath>
+#include <cstring>
+#include <initializer_list>
+
+// --- Little-endian helpers ---
+// Bytes are assembled with shifts, so the output is identical on any host.
+
+static void putU32(uint8_t* out, uint32_t value)
+{
+	out[0] = static_cast<uint8_t>(value);
+	out[1] = static_cast<uint8_t>(value >> 8);
+	out[2] = static_cast<uint8_t>(value >> 16);
+	out[3] = static_cast<uint8_t>(value >> 24);
+}
+
+static uint32_t getU32(const uint8_t* in)
+{
+	return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+		(static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+static void putF64(uint8_t* out, double value)
+{
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	putU32(out, static_cast<uint32_t>(bits));
+	putU32(out + 4, static_cast<uint32_t>(bits >> 32));
+}
+
+static double getF64(const uint8_t* in)
+{
+	uint64_t bits = static_cast<uint64_t>(getU32(in)) | (static_cast<uint64_t>(getU32(in + 4)) << 32);
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+// Writes 'value' as a LEB128 varint. Returns bytes written, 0 if it doesn't fit.
+static size_t putVarint(uint8_t* out, size_t capacity, uint32_t value)
+{
+	size_t written = 0;
+	do
+	{
+		if (written == capacity)
+		{
+			return 0;
+		}
+		uint8_t byte = static_cast<uint8_t>(value & 0x7F);
+		value >>= 7;
+		out[written++] = static_cast<uint8_t>(byte | (value ? 0x80 : 0));
+	} while (value);
+	return written;
+}
+
+// Reads a LEB128 varint of at most 5 bytes. Returns bytes consumed, 0 if malformed.
+static size_t getVarint(const uint8_t* in, size_t size, uint32_t& value)
+{
+	value = 0;
+	for (size_t i = 0; i < size && i < 5; ++i)
+	{
+		value |= static_cast<uint32_t>(in[i] & 0x7F) << (7 * i);
+		if ((in[i] & 0x80) == 0)
+		{
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+// Appends each value as a varint at 'offset'. Returns false if they don't all fit.
+static bool putVarints(uint8_t* out, size_t capacity, size_t& offset, std::initializer_list<uint32_t> values)
+{
+	for (uint32_t value : values)
+	{
+		size_t written = putVarint(out + offset, capacity - offset, value);
+		if (written == 0)
+		{
+			return false;
+		}
+		offset += written;
+	}
+	return true;
+}
+
+// Reads one varint at 'offset' into 'value'. Returns false if malformed.
+static bool getVarintAt(const uint8_t* data, size_t size, size_t& offset, uint32_t& value)
+{
+	size_t consumed = getVarint(data + offset, size - offset, value);
+	offset += consumed;
+	return consumed != 0;
+}
+
+// Converts to a scaled int32, clamping anything out of range.
+static int32_t toFixedPoint(double value, double scale)
+{
+	double scaled = std::round(value * scale);
+	if (scaled > 2147483647.0) return 2147483647;
+	if (scaled < -2147483648.0) return -2147483647 - 1;
+	return static_cast<int32_t>(scaled);
+}
+
+// Writes the common compact header. Returns bytes written, 0 if it doesn't fit.
+static size_t putHeader(const MessageHeader& header, uint8_t flags, uint8_t* out, size_t capacity)
+{
+	if (capacity < 3)
+	{
+		return 0;
+	}
+	out[0] = TdlCodec::COMPACT_MAGIC;
+	out[1] = static_cast<uint8_t>((TdlCodec::CODEC_VERSION << 4) | (flags & 0x0F));
+	out[2] = static_cast<uint8_t>(header.messageType);
+	size_t offset = 3;
+	if (!putVarints(out, capacity, offset, { header.sourceNodeId, header.sequenceNumber }) || capacity - offset < 4)
+	{
+		return 0;
+	}
+	putU32(out + offset, header.sendTimeUs);
+	return offset + 4;
+}
+
+// --- Encoding ---
+
+size_t TdlCodec::encode(const PositionReport& report, bool fixedPoint, uint8_t* out, size_t capacity)
+{
+	size_t offset = putHeader(report.header, fixedPoint ? FLAG_FIXED_POINT : 0, out, capacity);
+	if (offset == 0)
+	{
+		return 0;
+	}
+
+	if (fixedPoint)
+	{
+		if (capacity - offset < 12)
+		{
+			return 0;
+		}
+		putU32(out + offset, static_cast<uint32_t>(toFixedPoint(report.latitude, FIXED_POINT_DEGREE_SCALE)));
+		putU32(out + offset + 4, static_cast<uint32_t>(toFixedPoint(report.longitude, FIXED_POINT_DEGREE_SCALE)));
+		putU32(out + offset + 8, static_cast<uint32_t>(toFixedPoint(report.altitude, FIXED_POINT_ALTITUDE_SCALE)));
+		return offset + 12;
+	}
+
+	if (capacity - offset < 24)
+	{
+		return 0;
+	}
+	putF64(out + offset, report.latitude);
+	putF64(out + offset + 8, report.longitude);
+	putF64(out + offset + 16, report.altitude);
+	return offset + 24;
+}
+
+size_t TdlCodec::encode(const HeartbeatMessage& heartbeat, uint8_t* out, size_t capacity)
+{
+	size_t offset = putHeader(heartbeat.header, 0, out, capacity);
+	if (offset == 0 || !putVarints(out, capacity, offset, { heartbeat.lastTextSequence }))
+	{
+		return 0;
+	}
+	return offset;
+}
+
+size_t TdlCodec::encode(const TextMessage& message, uint8_t* out, size_t capacity)
+{
+	size_t offset = putHeader(message.header, 0, out, capacity);
+	if (offset == 0 || !putVarints(out, capacity, offset, { message.textSequence }))
+	{
+		return 0;
+	}
+
+	// Only the characters actually used go on the wire.
+	const void* terminator = memchr(message.text, '\0', MAX_TEXT_MSG_LENGTH);
+	size_t length = terminator ? static_cast<const char*>(terminator) - message.text : MAX_TEXT_MSG_LENGTH;
+
+	size_t lengthBytes = putVarint(out + offset, capacity - offset, static_cast<uint32_t>(length));
+	if (lengthBytes == 0 || capacity - offset - lengthBytes < length)
+	{
+		return 0;
+	}
+	offset += lengthBytes;
+	memcpy(out + offset, message.text, length);
+	return offset + length;
+}
+
+size_t TdlCodec::encode(const SyncRequest& request, uint8_t* out, size_t capacity)
+{
+	size_t offset = putHeader(request.header, 0, out, capacity);
+	if (offset == 0 || !putVarints(out, capacity, offset, { request.targetNodeId, request.requestId }))
+	{
+		return 0;
+	}
+	return offset;
+}
+
+size_t TdlCodec::encode(const SyncResponse& response, uint8_t* out, size_t capacity)
+{
+	size_t offset = putHeader(response.header, 0, out, capacity);
+	if (offset == 0 || response.entryCount > MAX_SYNC_ENTRIES
+		|| !putVarints(out, capacity, offset, { response.targetNodeId, response.requestId, response.chunkIndex, response.chunkCount, response.entryCount }))
+	{
+		return 0;
+	}
+
+	for (uint16_t i = 0; i < response.entryCount; ++i)
+	{
+		const SyncEntry& entry = response.entries[i];
+		bool hasPosition = (entry.flags & SYNC_ENTRY_HAS_POSITION) != 0;
+		if (!putVarints(out, capacity, offset, { entry.nodeId, entry.ageMs }) || capacity - offset < (hasPosition ? 13u : 1u))
+		{
+			return 0;
+		}
+		out[offset++] = static_cast<uint8_t>(entry.flags);
+		if (hasPosition) // Nodes we have no position for cost only their ID, age and flags
+		{
+			putU32(out + offset, static_cast<uint32_t>(entry.latitudeE7));
+			putU32(out + offset + 4, static_cast<uint32_t>(entry.longitudeE7));
+			putU32(out + offset + 8, static_cast<uint32_t>(entry.altitudeCm));
+			offset += 12;
+		}
+	}
+	return offset;
+}
+
+size_t TdlCodec::encode(const TextNack& nack, uint8_t* out, size_t capacity)
+{
+	size_t offset = putHeader(nack.header, 0, out, capacity);
+	if (offset == 0 || !putVarints(out, capacity, offset, { nack.targetNodeId, nack.firstSequence }) || capacity - offset < 8)
+	{
+		return 0;
+	}
+	putU32(out + offset, static_cast<uint32_t>(nack.missingMask));
+	putU32(out + offset + 4, static_cast<uint32_t>(nack.missingMask >> 32));
+	return offset + 8;
+}
+
+// --- Decoding ---
+
+bool TdlCodec::isCompact(const uint8_t* data, size_t size)
+{
+	return size >= 4 && data[0] == COMPACT_MAGIC && (data[1] >> 4) == CODEC_VERSION;
+}
+
+bool TdlCodec::decodeHeader(const uint8_t* data, size_t size, MessageHeader& header, size_t& bodyOffset)
+{
+	if (!isCompact(data, size))
+	{
+		return false;
+	}
+	size_t offset = 3;
+	if (!getVarintAt(data, size, offset, header.sourceNodeId) || !getVarintAt(data, size, offset, header.sequenceNumber)
+		|| size - offset < 4)
+	{
+		return false;
+	}
+	header.messageType = static_cast<MessageType>(data[2]);
+	header.sendTimeUs = getU32(data + offset);
+	bodyOffset = offset + 4;
+	return true;
+}
+
+bool TdlCodec::decode(const uint8_t* data, size_t size, PositionReport& report)
+{
+	size_t offset = 0;
+	if (!decodeHeader(data, size, report.header, offset) || report.header.messageType != POSITION_REPORT_TYPE)
+	{
+		return false;
+	}
+
+	if (data[1] & FLAG_FIXED_POINT)
+	{
+		if (size - offset != 12)
+		{
+			return false;
+		}
+		report.latitude = static_cast<int32_t>(getU32(data + offset)) / FIXED_POINT_DEGREE_SCALE;
+		report.longitude = static_cast<int32_t>(getU32(data + offset + 4)) / FIXED_POINT_DEGREE_SCALE;
+		report.altitude = static_cast<int32_t>(getU32(data + offset + 8)) / FIXED_POINT_ALTITUDE_SCALE;
+		return true;
+	}
+
+	if (size - offset != 24)
+	{
+		return false;
+	}
+	report.latitude = getF64(data + offset);
+	report.longitude = getF64(data + offset + 8);
+	report.altitude = getF64(data + offset + 16);
+	return true;
+}
+
+bool TdlCodec::decode(const uint8_t* data, size_t size, HeartbeatMessage& heartbeat)
+{
+	size_t offset = 0;
+	return decodeHeader(data, size, heartbeat.header, offset) && heartbeat.header.messageType == HEARTBEAT_TYPE
+		&& getVarintAt(data, size, offset, heartbeat.lastTextSequence) && offset == size;
+}
+
+bool TdlCodec::decode(const uint8_t* data, size_t size, TextMessage& message)
+{
+	size_t offset = 0;
+	if (!decodeHeader(data, size, message.header, offset) || message.header.messageType != TEXT_MESSAGE_TYPE
+		|| !getVarintAt(data, size, offset, message.textSequence))
+	{
+		return false;
+	}
+
+	uint32_t length = 0;
+	size_t lengthBytes = getVarint(data + offset, size - offset, length);
+	if (lengthBytes == 0 || size - offset - lengthBytes != length)
+	{
+		return false;
+	}
+	offset += lengthBytes;
+
+	size_t copied = length < MAX_TEXT_MSG_LENGTH - 1 ? length : MAX_TEXT_MSG_LENGTH - 1;
+	memcpy(message.text, data + offset, copied);
+	message.text[copied] = '\0';
+	return true;
+}
+
+bool TdlCodec::decode(const uint8_t* data, size_t size, SyncRequest& request)
+{
+	size_t offset = 0;
+	if (!decodeHeader(data, size, request.header, offset) || request.header.messageType != SYNC_REQUEST_TYPE)
+	{
+		return false;
+	}
+	return getVarintAt(data, size, offset, request.targetNodeId) && getVarintAt(data, size, offset, request.requestId)
+		&& offset == size;
+}
+
+bool TdlCodec::decode(const uint8_t* data, size_t size, SyncResponse& response)
+{
+	size_t offset = 0;
+	if (!decodeHeader(data, size, response.header, offset) || response.header.messageType != SYNC_RESPONSE_TYPE)
+	{
+		return false;
+	}
+
+	uint32_t chunkIndex = 0;
+	uint32_t chunkCount = 0;
+	uint32_t entryCount = 0;
+	if (!getVarintAt(data, size, offset, response.targetNodeId) || !getVarintAt(data, size, offset, response.requestId)
+		|| !getVarintAt(data, size, offset, chunkIndex) || !getVarintAt(data, size, offset, chunkCount)
+		|| !getVarintAt(data, size, offset, entryCount) || entryCount > MAX_SYNC_ENTRIES
+		|| chunkCount > 0xFFFF || chunkIndex >= chunkCount)
+	{
+		return false;
+	}
+	response.chunkIndex = static_cast<uint16_t>(chunkIndex);
+	response.chunkCount = static_cast<uint16_t>(chunkCount);
+	response.entryCount = static_cast<uint16_t>(entryCount);
+
+	for (uint32_t i = 0; i < entryCount; ++i)
+	{
+		SyncEntry& entry = response.entries[i];
+		if (!getVarintAt(data, size, offset, entry.nodeId) || !getVarintAt(data, size, offset, entry.ageMs) || offset >= size)
+		{
+			return false;
+		}
+		entry.flags = data[offset++];
+		if (entry.flags & SYNC_ENTRY_HAS_POSITION)
+		{
+			if (size - offset < 12)
+			{
+				return false;
+			}
+			entry.latitudeE7 = static_cast<int32_t>(getU32(data + offset));
+			entry.longitudeE7 = static_cast<int32_t>(getU32(data + offset + 4));
+			entry.altitudeCm = static_cast<int32_t>(getU32(data + offset + 8));
+			offset += 12;
+		}
+	}
+	return offset == size;
+}
+
+bool TdlCodec::decode(const uint8_t* data, size_t size, TextNack& nack)
+{
+	size_t offset = 0;
+	if (!decodeHeader(data, size, nack.header, offset) || nack.header.messageType != TEXT_NACK_TYPE
+		|| !getVarintAt(data, size, offset, nack.targetNodeId) || !getVarintAt(data, size, offset, nack.firstSequence)
+		|| size - offset != 8)
+	{
+		return false;
+	}
+	nack.missingMask = static_cast<uint64_t>(getU32(data + offset)) | (static_cast<uint64_t>(getU32(data + offset + 4)) << 32);
+	return true;
+}
@@ -0,0 +1,84 @@
+// TdlCodec.h
+#ifndef TDL_CODEC_H
+#define TDL_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include "TdlMessages.h"
+
+// --- Compact Wire Format ---
+// The raw message structs in TdlMessages.h go on the wire exactly as laid out in
+// memory, which depends on compiler padding and host endianness and wastes bytes on
+// padding and unused text. This codec packs them into an explicit, versioned,
+// little-endian format instead:
+//
+//   byte 0       COMPACT_MAGIC. A raw struct message starts with the low byte of
+//                its messageType, which is always a small enum value, so the two
+//                formats can share a socket and be told apart by this byte.
+//   byte 1       high nibble: codec version, low nibble: flags (see CompactFlags)
+//   byte 2       message type
+//   bytes 3..    source node ID as a LEB128 varint (1 byte for IDs below 128), then
+//                the sequence number as a varint and the send time as a uint32
+//   body         per message type:
+//                  PositionReport   3 x float64, or 3 x int32 with FLAG_FIXED_POINT
+//                  HeartbeatMessage varint last text sequence
+//                  TextMessage      varint text sequence, varint length + text bytes
+//                                   (no terminator)
+//                  TextNack         varint target, varint first sequence, uint64 mask
+//                  SyncRequest      varint target, varint request ID
+//                  SyncResponse     varint target, request ID, chunk index, chunk count
+//                                   and entry count, then per entry: varint node ID,
+//                                   varint age, flags byte, and 3 x int32 if it has
+//                                   a position
+//
+// With fixed-point positions a report from a small node ID is 22 to 24 bytes for
+// most of its sender's life, against 40 for the raw struct. The encoders return
+// the number of bytes written, or 0 if 'capacity' is too small; the decoders
+// return false for anything malformed.
+class TdlCodec
+{
+public:
+	static constexpr uint8_t COMPACT_MAGIC = 0xD7;
+	static constexpr uint8_t CODEC_VERSION = 3; // 2: sequence number and send time in the header, 3: reliable text
+
+	enum CompactFlags : uint8_t
+	{
+		FLAG_FIXED_POINT = 0x1, // Position body is scaled int32s instead of float64s
+	};
+
+	// Fixed-point scales: 1e-7 degree (about 1 cm) and 1 cm of altitude.
+	static constexpr double FIXED_POINT_DEGREE_SCALE = 1e7;
+	static constexpr double FIXED_POINT_ALTITUDE_SCALE = 100.0;
+
+	// Largest encoded header, of any per-node message (header + longest body)...
+	static constexpr size_t MAX_HEADER_SIZE = 3 + 5 + 5 + 4;
+	static constexpr size_t MAX_ENCODED_SIZE = MAX_HEADER_SIZE + 5 + 5 + MAX_TEXT_MSG_LENGTH;
+	// ...and of a sync response chunk, which is much bigger.
+	static constexpr size_t MAX_SYNC_ENCODED_SIZE = MAX_HEADER_SIZE + 5 * 5 + MAX_SYNC_ENTRIES * (5 + 5 + 1 + 12);
+
+	// --- Encoding ---
+	static size_t encode(const PositionReport& report, bool fixedPoint, uint8_t* out, size_t capacity);
+	static size_t encode(const HeartbeatMessage& heartbeat, uint8_t* out, size_t capacity);
+	static size_t encode(const TextMessage& message, uint8_t* out, size_t capacity);
+	static size_t encode(const SyncRequest& request, uint8_t* out, size_t capacity);
+	static size_t encode(const SyncResponse& response, uint8_t* out, size_t capacity);
+	static size_t encode(const TextNack& nack, uint8_t* out, size_t capacity);
+
+	// --- Decoding ---
+	// True if the bytes start with the compact-format magic and a version we understand.
+	static bool isCompact(const uint8_t* data, size_t size);
+
+	// Reads the compact header. On success fills 'header' and sets 'bodyOffset' to
+	// where the message body starts.
+	static bool decodeHeader(const uint8_t* data, size_t size, MessageHeader& header, size_t& bodyOffset);
+
+	static bool decode(const uint8_t* data, size_t size, PositionReport& report);
+	static bool decode(const uint8_t* data, size_t size, HeartbeatMessage& heartbeat);
+	// The decoded text is always null-terminated (and truncated to fit if necessary).
+	static bool decode(const uint8_t* data, size_t size, TextMessage& message);
+	static bool decode(const uint8_t* data, size_t size, SyncRequest& request);
+	static bool decode(const uint8_t* data, size_t size, SyncResponse& response);
+	static bool decode(const uint8_t* data, size_t size, TextNack& nack);
+};
+
+#endif // TDL_CODEC_H
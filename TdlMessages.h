@@ -11,18 +11,26 @@ enum MessageType : uint32_t
 {
 	POSITION_REPORT_TYPE = 1, // ID for position updates
 	HEARTBEAT_TYPE = 2, // ID for simple "I'm alive" messages
-	TEXT_MESSAGE_TYPE = 3  // ID for chat messages
-	// Add more types here later if needed...
+	TEXT_MESSAGE_TYPE = 3, // ID for chat messages
+	SYNC_REQUEST_TYPE = 4, // "Send me your node table" (to one neighbour)
+	SYNC_RESPONSE_TYPE = 5, // One chunk of that neighbour's table
+	TEXT_NACK_TYPE = 6 // "Resend these reliable texts" (to their sender)
+	// Add more types here later if needed: give the new struct its MESSAGE_TYPE and
+	// MESSAGE_NAME and list it in RegisteredMessages (MessageRegistry.h).
 };
 
 // --- Common Message Header ---
 // Every message we send starts with this structure.
 // This allows the receiver to know who sent the message and what type it is
-// before reading the rest of the data.
+// before reading the rest of the data. The sequence number and send time are
+// stamped by a MessageSequencer just before sending, and let the receiver see loss,
+// reordering and delay per sender (see NodeLinkStats).
 struct MessageHeader
 {
 	MessageType messageType = static_cast<MessageType>(0); // What kind of message is this?
 	uint32_t sourceNodeId = 0; // Which node sent this message?
+	uint32_t sequenceNumber = 0; // Counts every message this source sends, of any type; 0 = not sequenced
+	uint32_t sendTimeUs = 0;     // Low 32 bits of the sender's wall clock in microseconds (wraps every ~71 min)
 };
 
 // --- Specific Message Structures ---
@@ -31,34 +39,136 @@ struct MessageHeader
 // Position Report: Contains location data.
 struct PositionReport
 {
+	static constexpr MessageType MESSAGE_TYPE = POSITION_REPORT_TYPE;
+	static constexpr const char* MESSAGE_NAME = "PositionReport";
+
 	MessageHeader header; // All messages include the header first.
 	double latitude = 0.0;
 	double longitude = 0.0;
 	double altitude = 0.0;
 
 	// Constructor to automatically set the correct message type when created.
-	PositionReport() { header.messageType = POSITION_REPORT_TYPE; }
+	PositionReport() { header.messageType = MESSAGE_TYPE; }
 };
 
 // Heartbeat: A very simple message, might just contain the header.
 struct HeartbeatMessage
 {
+	static constexpr MessageType MESSAGE_TYPE = HEARTBEAT_TYPE;
+	static constexpr const char* MESSAGE_NAME = "Heartbeat";
+
 	MessageHeader header; // Contains type and source ID.
-	// Could add other basic status info here later.
+	uint32_t lastTextSequence = 0; // Newest reliable text this node has sent, so receivers notice a lost last one
 
 	// Constructor to automatically set the correct message type.
-	HeartbeatMessage() { header.messageType = HEARTBEAT_TYPE; }
+	HeartbeatMessage() { header.messageType = MESSAGE_TYPE; }
 };
 
 // Text Message: Contains a short text string.
 #define MAX_TEXT_MSG_LENGTH 64 // Define maximum length for the text content.
 struct TextMessage
 {
+	static constexpr MessageType MESSAGE_TYPE = TEXT_MESSAGE_TYPE;
+	static constexpr const char* MESSAGE_NAME = "TextMessage";
+
 	MessageHeader header; // Contains type and source ID.
+	uint32_t textSequence = 0; // Per-sender number of a reliable text (see ReliableTextChannel); 0 = best effort
 	char text[MAX_TEXT_MSG_LENGTH] = {0}; // Fixed-size buffer for the text. Initialize to zeros.
 
 	// Constructor to automatically set the correct message type.
-	TextMessage() { header.messageType = TEXT_MESSAGE_TYPE; }
+	TextMessage() { header.messageType = MESSAGE_TYPE; }
+};
+
+// Text NACK: a receiver's list of reliable texts it is missing from one sender,
+// as a 64-bit window starting at 'firstSequence'. Broadcast like everything else;
+// only the named sender acts on it.
+struct TextNack
+{
+	static constexpr MessageType MESSAGE_TYPE = TEXT_NACK_TYPE;
+	static constexpr const char* MESSAGE_NAME = "TextNack";
+
+	MessageHeader header;
+	uint32_t targetNodeId = 0;  // The sender of the missing texts
+	uint32_t firstSequence = 0; // Text sequence of bit 0
+	uint64_t missingMask = 0;   // Bit i set: firstSequence + i is missing
+
+	TextNack() { header.messageType = MESSAGE_TYPE; }
+};
+
+// --- Peer Sync Messages ---
+// A joining node asks one neighbour for its whole picture instead of waiting for
+// every peer's next broadcast. Only that neighbour answers, with a few large
+// SyncResponse chunks; they are broadcast like everything else, but only the
+// requester applies them.
+
+// Sync Request: sent by a joining node to the neighbour named in targetNodeId.
+struct SyncRequest
+{
+	static constexpr MessageType MESSAGE_TYPE = SYNC_REQUEST_TYPE;
+	static constexpr const char* MESSAGE_NAME = "SyncRequest";
+
+	MessageHeader header;
+	uint32_t targetNodeId = 0; // The one neighbour that should answer
+	uint32_t requestId = 0;    // Echoed in every chunk of the answer
+
+	SyncRequest() { header.messageType = MESSAGE_TYPE; }
+};
+
+// One node as the answering neighbour knows it. Positions use TdlCodec's fixed-point scales.
+#define SYNC_ENTRY_HAS_POSITION 0x1
+struct SyncEntry
+{
+	uint32_t nodeId = 0;
+	uint32_t ageMs = 0;        // How long ago the neighbour last heard from it
+	int32_t latitudeE7 = 0;    // Degrees x 1e7
+	int32_t longitudeE7 = 0;   // Degrees x 1e7
+	int32_t altitudeCm = 0;
+	uint32_t flags = 0;        // SYNC_ENTRY_HAS_POSITION
+};
+
+// Sync Response: one chunk of the answer. A raw chunk is always sent whole, so it
+// has one fixed size like every other raw message; the compact form only carries
+// the entries in use.
+#define MAX_SYNC_ENTRIES 48 // 48 x 24 bytes: a chunk stays inside one Ethernet MTU
+struct SyncResponse
+{
+	static constexpr MessageType MESSAGE_TYPE = SYNC_RESPONSE_TYPE;
+	static constexpr const char* MESSAGE_NAME = "SyncResponse";
+
+	MessageHeader header;
+	uint32_t targetNodeId = 0; // The requester; everyone else ignores the chunk
+	uint32_t requestId = 0;    // From the SyncRequest being answered
+	uint16_t chunkIndex = 0;
+	uint16_t chunkCount = 0;   // Chunks in the whole answer (at least 1, even for an empty table)
+	uint16_t entryCount = 0;   // Valid entries in 'entries'
+	uint16_t reserved = 0;
+	SyncEntry entries[MAX_SYNC_ENTRIES];
+
+	SyncResponse() { header.messageType = MESSAGE_TYPE; }
+};
+
+
+// --- Link Statistics ---
+// What the sequence numbers and send times in one sender's headers say about the
+// path from it to us. Every skipped sequence number is counted lost until it turns
+// up late (then it counts as reordered instead), so 'lost' is the real loss so far.
+struct NodeLinkStats
+{
+	uint32_t received = 0;    // Sequenced messages, duplicates excluded
+	uint32_t lost = 0;        // Skipped sequence numbers that never arrived
+	uint32_t reordered = 0;   // Arrived after a higher-numbered message
+	uint32_t duplicates = 0;
+	uint32_t restarts = 0;    // The sender's sequence started over
+	uint32_t latencySamples = 0;
+	int32_t latencyMinUs = 0; // One-way: our wall clock minus its send time, so any clock
+	int32_t latencyMaxUs = 0; // offset between the two nodes is included (and may make it
+	int32_t latencyAvgUs = 0; // negative). The average is an EWMA (1/16 weight per sample).
+
+	double lossRatio() const
+	{
+		uint64_t expected = static_cast<uint64_t>(received) + lost;
+		return expected ? static_cast<double>(lost) / static_cast<double>(expected) : 0.0;
+	}
 };
 
 
@@ -69,6 +179,9 @@ struct NodeInfo
 	uint32_t nodeId;                     // The unique ID of the other node.
 	PositionReport lastPosition;         // Store the last known position report received from this node.
 	std::chrono::steady_clock::time_point lastHeardTime; // When did we last receive *any* message from this node?
+	bool hasPosition = false;            // Has a PositionReport (first- or second-hand) ever been received?
+	bool stale = false;                  // Learned second-hand (checkpoint or peer sync) and not heard from since.
+	NodeLinkStats link;                  // Loss, reordering and latency of its messages to us.
 
 	// Default constructor (needed for use in std::map).
 	NodeInfo() : nodeId(0) {}
@@ -0,0 +1,204 @@
+// AuthTests.cpp
+// MessageAuthenticator's SipHash-2-4 against the reference vectors, seal and
+// verifyBatch (lockstep lanes included) round trips, the ReplayFilter, and
+// AuthenticatedTransport's handling of datagrams too short to be sealed.
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "Tests.h"
+#include "../LoopbackTransport.h"
+#include "../MessageAuth.h"
+#include "../Metrics.h"
+
+// SipHash-2-4 with key 00 01 .. 0f over the message 00 01 .. (length - 1), from
+// the reference implementation's vectors.h (read as little-endian words).
+struct SipHashVector
+{
+	size_t length;
+	uint64_t tag;
+};
+
+static const SipHashVector SIPHASH_VECTORS[] = {
+	{ 0, 0x726fdb47dd0e0e31ull },
+	{ 1, 0x74f839c593dc67fdull },
+	{ 2, 0x0d6c8009d9a94f5aull },
+	{ 3, 0x85676696d7fb7e2dull },
+	{ 7, 0xab0200f58b01d137ull },
+	{ 8, 0x93f5f5799a932462ull },
+	{ 15, 0xa129ca6149be45e5ull },
+	{ 16, 0x3f2acc7f57c29bdbull },
+	{ 31, 0x32d892fad841c342ull },
+	{ 63, 0x958a324ceb064572ull },
+};
+
+static const char* const REFERENCE_KEY = "000102030405060708090a0b0c0d0e0f";
+
+static void testReferenceVectors()
+{
+	MessageKey key{};
+	TDL_CHECK(MessageAuthenticator::parseKey(REFERENCE_KEY, key));
+	TDL_CHECK(key[0] == 0x0706050403020100ull && key[1] == 0x0f0e0d0c0b0a0908ull);
+	MessageAuthenticator authenticator(key);
+
+	uint8_t message[64];
+	for (size_t i = 0; i < sizeof(message); ++i)
+	{
+		message[i] = static_cast<uint8_t>(i);
+	}
+	for (const SipHashVector& vector : SIPHASH_VECTORS)
+	{
+		TDL_CHECK(authenticator.tag(message, vector.length) == vector.tag);
+	}
+
+	MessageKey untouched = key;
+	TDL_CHECK(!MessageAuthenticator::parseKey("000102030405060708090a0b0c0d0e0", untouched)); // 31 digits
+	TDL_CHECK(!MessageAuthenticator::parseKey("000102030405060708090a0b0c0d0e0g", untouched));
+	TDL_CHECK(untouched == key);
+}
+
+static void testSealAndVerify()
+{
+	MessageKey key{};
+	MessageAuthenticator::parseKey(REFERENCE_KEY, key);
+	MessageAuthenticator authenticator(key);
+	MessageKey otherKey = key;
+	otherKey[1] ^= 1;
+	MessageAuthenticator stranger(otherKey);
+
+	// Batches around BATCH_LANES, of payloads of every length up to a few words.
+	const size_t payloadLimit = 40;
+	const size_t capacity = payloadLimit + MessageAuthenticator::TRAILER_SIZE;
+	for (size_t count = 1; count <= 2 * MessageAuthenticator::BATCH_LANES + 1; ++count)
+	{
+		std::vector<std::vector<uint8_t>> datagrams(count, std::vector<uint8_t>(capacity));
+		std::vector<const uint8_t*> data(count);
+		std::vector<size_t> sizes(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			size_t payload = (i * 7 + count) % payloadLimit;
+			for (size_t b = 0; b < payload; ++b)
+			{
+				datagrams[i][b] = static_cast<uint8_t>(b * 31 + i);
+			}
+			sizes[i] = authenticator.seal(datagrams[i].data(), payload, capacity, 1000 + static_cast<uint32_t>(i), 5000 + i, 9000 + i);
+			TDL_CHECK(sizes[i] == payload + MessageAuthenticator::TRAILER_SIZE);
+			data[i] = datagrams[i].data();
+		}
+		// Tamper with every third one; they alone must fail.
+		for (size_t i = 2; i < count; i += 3)
+		{
+			datagrams[i][(i * 5) % sizes[i]] ^= 0x10;
+		}
+
+		bool results[2 * MessageAuthenticator::BATCH_LANES + 1];
+		uint32_t sources[2 * MessageAuthenticator::BATCH_LANES + 1];
+		uint64_t sequences[2 * MessageAuthenticator::BATCH_LANES + 1];
+		uint64_t sealedTimes[2 * MessageAuthenticator::BATCH_LANES + 1];
+		authenticator.verifyBatch(data.data(), sizes.data(), count, results, sources, sequences, sealedTimes);
+		for (size_t i = 0; i < count; ++i)
+		{
+			bool tampered = (i >= 2 && (i - 2) % 3 == 0);
+			TDL_CHECK(results[i] == !tampered);
+			if (!tampered)
+			{
+				TDL_CHECK(sources[i] == 1000 + i && sequences[i] == 5000 + i && sealedTimes[i] == 9000 + i);
+			}
+		}
+
+		// Under another key nothing verifies.
+		stranger.verifyBatch(data.data(), sizes.data(), count, results, sources, sequences, sealedTimes);
+		for (size_t i = 0; i < count; ++i)
+		{
+			TDL_CHECK(!results[i]);
+		}
+	}
+
+	// Too short to hold a trailer, and no room to seal.
+	uint8_t tiny[MessageAuthenticator::TRAILER_SIZE] = {};
+	const uint8_t* tinyData = tiny;
+	size_t tinySize = sizeof(tiny) - 1;
+	bool result = true;
+	uint32_t source = 0;
+	uint64_t sequence = 0;
+	uint64_t sealedAt = 0;
+	authenticator.verifyBatch(&tinyData, &tinySize, 1, &result, &source, &sequence, &sealedAt);
+	TDL_CHECK(!result);
+	TDL_CHECK(authenticator.seal(tiny, 1, sizeof(tiny), 1, 1, 1) == 0);
+}
+
+static void testReplayFilter()
+{
+	ReplayFilter filter;
+	const uint64_t now = 1000000000000ull;
+	const uint64_t start = now - 3600000000ull; // Sequences count up from the sender's start-up
+
+	TDL_CHECK(filter.accept(7, start + 100, now, now));
+	TDL_CHECK(!filter.accept(7, start + 100, now, now));      // The same datagram again
+	TDL_CHECK(filter.accept(7, start + 90, now - 5000, now)); // Reordered behind ten later datagrams
+	TDL_CHECK(!filter.accept(7, start + 90, now - 5000, now));
+	TDL_CHECK(filter.accept(8, start + 100, now, now));       // Another sender's sequences are its own
+	TDL_CHECK(filter.accept(7, start + 200, now, now));
+	TDL_CHECK(filter.accept(7, start + 200 - ReplayFilter::WINDOW + 1, now - 1000, now)); // The oldest it still tells apart
+	TDL_CHECK(!filter.accept(7, start + 200 - ReplayFilter::WINDOW, now, now)); // Fell out of the window
+
+	// However slowly a sender sends, the window counts its datagrams, not time.
+	for (uint64_t i = 1; i <= ReplayFilter::WINDOW - 1; ++i)
+	{
+		TDL_CHECK(filter.accept(10, start + i, now - 1000000 + i * 10000, now)); // One every 10 ms
+	}
+	TDL_CHECK(filter.accept(10, start, now - 1000000, now));   // Reordered behind all the rest
+	TDL_CHECK(!filter.accept(10, start, now - 1000000, now));
+
+	// Sealed far from our own clock either way: a stale capture, or a forged future.
+	TDL_CHECK(!filter.accept(9, start, now - ReplayFilter::MAX_CLOCK_SKEW_US - 1, now));
+	TDL_CHECK(!filter.accept(9, start, now + ReplayFilter::MAX_CLOCK_SKEW_US + 1, now));
+
+	// More senders than the table has windows, so some are evicted: none of them
+	// may be accepted twice all the same, although their sequences (each from its
+	// own start-up) say nothing about one another.
+	const uint32_t senders = static_cast<uint32_t>(ReplayFilter::SET_COUNT * ReplayFilter::WAYS) + 1000;
+	size_t replaysAccepted = 0;
+	for (uint32_t sender = 0; sender < senders; ++sender)
+	{
+		TDL_CHECK(filter.accept(100 + sender, start + (sender * 7919) % 100000, now + sender, now));
+	}
+	for (uint32_t sender = 0; sender < senders; ++sender)
+	{
+		replaysAccepted += filter.accept(100 + sender, start + (sender * 7919) % 100000, now + sender, now) ? 1 : 0;
+	}
+	TDL_CHECK(replaysAccepted == 0);
+}
+
+// Datagrams shorter than a trailer are refused before anything reads a header
+// out of them, and the sealed one behind them still gets through.
+static void testShortDatagrams()
+{
+	MessageKey key{};
+	MessageAuthenticator::parseKey(REFERENCE_KEY, key);
+	LoopbackTransport* loopback = new LoopbackTransport(16, 30918);
+	AuthenticatedTransport transport(std::unique_ptr<Transport>(loopback), key, 1);
+	uint64_t failuresBefore = Metrics::snapshot().counters[static_cast<size_t>(MetricCounter::AuthFailures)];
+
+	const uint8_t stub[MessageAuthenticator::TRAILER_SIZE] = { 0xEE, 0xEE, 0xEE };
+	for (size_t size = 1; size < sizeof(stub); size += 7)
+	{
+		TDL_CHECK(loopback->sendBroadcast(stub, size)); // Unsealed, straight onto the inner transport
+	}
+	const uint8_t payload[4] = { 0xEE, 1, 2, 3 }; // No header, so it is labelled as this node's
+	TDL_CHECK(transport.sendBroadcast(payload, sizeof(payload)));
+
+	ReceivedPacket packets[8];
+	TDL_CHECK(transport.receiveBatch(packets, 8, false) == 1);
+	TDL_CHECK(packets[0].size == sizeof(payload) && memcmp(packets[0].buffer.data(), payload, sizeof(payload)) == 0);
+	TDL_CHECK(Metrics::snapshot().counters[static_cast<size_t>(MetricCounter::AuthFailures)] - failuresBefore == 5);
+}
+
+void runAuthTests()
+{
+	testReferenceVectors();
+	testSealAndVerify();
+	testReplayFilter();
+	testShortDatagrams();
+}
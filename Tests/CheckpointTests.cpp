@@ -0,0 +1,148 @@
+// CheckpointTests.cpp
+// NodeManager checkpoints: a save and warm start round trip, then damaged files,
+// every one of which must leave the table empty rather than crash or misread.
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "Tests.h"
+#include "../NodeManager.h"
+
+static const char* const CHECKPOINT_PATH = "BasicTDLTests.checkpoint";
+static const size_t HEADER_SIZE = 24;     // CheckpointHeader, in NodeManager.cpp
+static const size_t RECORD_SIZE = 40;     // CheckpointRecord
+static const size_t NODE_COUNT_OFFSET = 12;
+
+static std::vector<uint8_t> readFile(const char* path)
+{
+	std::vector<uint8_t> bytes;
+	FILE* file = fopen(path, "rb");
+	if (file != nullptr)
+	{
+		uint8_t buffer[4096];
+		size_t got;
+		while ((got = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		{
+			bytes.insert(bytes.end(), buffer, buffer + got);
+		}
+		fclose(file);
+	}
+	return bytes;
+}
+
+static void writeFile(const char* path, const uint8_t* data, size_t size)
+{
+	FILE* file = fopen(path, "wb");
+	TDL_CHECK(file != nullptr);
+	if (file != nullptr)
+	{
+		TDL_CHECK(size == 0 || fwrite(data, 1, size, file) == size);
+		fclose(file);
+	}
+}
+
+// How many nodes a fresh manager restores from 'bytes'.
+static size_t restoreFrom(const std::vector<uint8_t>& bytes, size_t size)
+{
+	writeFile(CHECKPOINT_PATH, bytes.data(), size);
+	NodeManager manager(1);
+	size_t restored = manager.loadCheckpoint(CHECKPOINT_PATH, std::chrono::seconds(3600));
+	TDL_CHECK(manager.getNodeList().size() == restored);
+	return restored;
+}
+
+static void putUint32(std::vector<uint8_t>& bytes, size_t offset, uint32_t value)
+{
+	memcpy(bytes.data() + offset, &value, sizeof(value));
+}
+
+void runCheckpointTests()
+{
+	// --- Round Trip ---
+	const uint32_t nodeCount = 50;
+	{
+		NodeManager manager(1);
+		for (uint32_t id = 2; id < 2 + nodeCount; ++id)
+		{
+			PositionReport report;
+			report.header.sourceNodeId = id;
+			report.latitude = 50.0 + id * 1e-3;
+			report.longitude = -1.0 - id * 1e-3;
+			report.altitude = id;
+			manager.updateNodePosition(report);
+		}
+		TDL_CHECK(manager.saveCheckpoint(CHECKPOINT_PATH));
+	}
+	std::vector<uint8_t> saved = readFile(CHECKPOINT_PATH);
+	TDL_CHECK(saved.size() == HEADER_SIZE + nodeCount * RECORD_SIZE);
+	if (saved.size() != HEADER_SIZE + nodeCount * RECORD_SIZE)
+	{
+		std::remove(CHECKPOINT_PATH);
+		return;
+	}
+	{
+		NodeManager manager(1);
+		TDL_CHECK(manager.loadCheckpoint(CHECKPOINT_PATH, std::chrono::seconds(3600)) == nodeCount);
+		size_t matched = 0;
+		for (const NodeInfo& node : manager.getNodeList())
+		{
+			matched += (node.stale && node.hasPosition && node.lastPosition.latitude == 50.0 + node.nodeId * 1e-3
+				&& node.lastPosition.longitude == -1.0 - node.nodeId * 1e-3 && node.lastPosition.altitude == node.nodeId) ? 1 : 0;
+		}
+		TDL_CHECK(matched == nodeCount);
+	}
+
+	// A node last heard longer ago than the maximum age is left out.
+	std::vector<uint8_t> aged = saved;
+	uint64_t twoHoursMs = 2 * 3600 * 1000;
+	memcpy(aged.data() + HEADER_SIZE + RECORD_SIZE + 8, &twoHoursMs, sizeof(twoHoursMs)); // The second record's ageMs
+	TDL_CHECK(restoreFrom(aged, aged.size()) == nodeCount - 1);
+
+	// --- Damaged Files ---
+	TDL_CHECK(restoreFrom(saved, 0) == 0);                           // Empty
+	TDL_CHECK(restoreFrom(saved, HEADER_SIZE - 1) == 0);             // Torn header
+	TDL_CHECK(restoreFrom(saved, saved.size() - RECORD_SIZE / 2) == 0); // Torn last record
+
+	std::vector<uint8_t> corrupt = saved;
+	corrupt[0] ^= 0xFF;                                              // Bad magic
+	TDL_CHECK(restoreFrom(corrupt, corrupt.size()) == 0);
+
+	corrupt = saved;
+	putUint32(corrupt, 8, 99);                                       // Unknown version
+	TDL_CHECK(restoreFrom(corrupt, corrupt.size()) == 0);
+
+	corrupt = saved;
+	putUint32(corrupt, NODE_COUNT_OFFSET, 0xFFFFFFFFu);              // Count far beyond the file
+	TDL_CHECK(restoreFrom(corrupt, corrupt.size()) == 0);
+	putUint32(corrupt, NODE_COUNT_OFFSET, nodeCount + 1);            // ...or just one beyond it
+	TDL_CHECK(restoreFrom(corrupt, corrupt.size()) == 0);
+
+	// Garbage inside a well-formed file: the node is kept, its impossible position isn't.
+	corrupt = saved;
+	double nan = std::numeric_limits<double>::quiet_NaN();
+	double farAway = 1e300;
+	memcpy(corrupt.data() + HEADER_SIZE + 16, &nan, sizeof(nan));
+	memcpy(corrupt.data() + HEADER_SIZE + RECORD_SIZE + 24, &farAway, sizeof(farAway));
+	writeFile(CHECKPOINT_PATH, corrupt.data(), corrupt.size());
+	{
+		NodeManager manager(1);
+		TDL_CHECK(manager.loadCheckpoint(CHECKPOINT_PATH, std::chrono::seconds(3600)) == nodeCount);
+		size_t withPosition = 0;
+		for (const NodeInfo& node : manager.getNodeList())
+		{
+			withPosition += node.hasPosition ? 1 : 0;
+			TDL_CHECK(std::isfinite(node.lastPosition.latitude) && std::fabs(node.lastPosition.longitude) <= 180.0);
+		}
+		TDL_CHECK(withPosition == nodeCount - 2);
+	}
+
+	// No file at all.
+	std::remove(CHECKPOINT_PATH);
+	NodeManager manager(1);
+	TDL_CHECK(manager.loadCheckpoint(CHECKPOINT_PATH, std::chrono::seconds(3600)) == 0);
+}
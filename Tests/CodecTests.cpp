@@ -0,0 +1,202 @@
+// CodecTests.cpp
+// TdlCodec round trips for every message type, and the decoders' answer to every
+// truncation of a valid message.
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "Tests.h"
+#include "../TdlCodec.h"
+
+static void fillHeader(MessageHeader& header, uint32_t sourceNodeId)
+{
+	header.sourceNodeId = sourceNodeId;
+	header.sequenceNumber = 123456;
+	header.sendTimeUs = 0xDEADBEEF;
+}
+
+static bool sameHeader(const MessageHeader& a, const MessageHeader& b)
+{
+	return a.messageType == b.messageType && a.sourceNodeId == b.sourceNodeId
+		&& a.sequenceNumber == b.sequenceNumber && a.sendTimeUs == b.sendTimeUs;
+}
+
+// Every strict prefix of an encoded message must be rejected.
+template <typename Message>
+static void checkTruncations(const uint8_t* encoded, size_t size)
+{
+	for (size_t prefix = 0; prefix < size; ++prefix)
+	{
+		Message decoded;
+		TDL_CHECK(!TdlCodec::decode(encoded, prefix, decoded));
+	}
+}
+
+// ...and one byte short of the room it needs, the encoder must write nothing.
+template <typename Message>
+static void checkTooSmall(const Message& message, size_t size)
+{
+	uint8_t small[TdlCodec::MAX_SYNC_ENCODED_SIZE];
+	TDL_CHECK(TdlCodec::encode(message, small, size - 1) == 0);
+}
+
+static void testPositionReports()
+{
+	uint8_t buffer[TdlCodec::MAX_ENCODED_SIZE];
+	const uint32_t sources[] = { 1, 127, 128, 0xFFFFFFFFu };
+	for (uint32_t source : sources)
+	{
+		PositionReport report;
+		fillHeader(report.header, source);
+		report.latitude = -33.8567844;
+		report.longitude = 151.2152967;
+		report.altitude = 58.25;
+
+		size_t size = TdlCodec::encode(report, false, buffer, sizeof(buffer));
+		PositionReport decoded;
+		TDL_CHECK(size > 0 && TdlCodec::isCompact(buffer, size));
+		TDL_CHECK(TdlCodec::decode(buffer, size, decoded));
+		TDL_CHECK(sameHeader(decoded.header, report.header));
+		TDL_CHECK(decoded.latitude == report.latitude && decoded.longitude == report.longitude && decoded.altitude == report.altitude);
+		checkTruncations<PositionReport>(buffer, size);
+		TDL_CHECK(TdlCodec::encode(report, false, buffer, size - 1) == 0);
+
+		// Fixed point: 1e-7 degree and 1 cm steps, and smaller on the wire.
+		size_t fixedSize = TdlCodec::encode(report, true, buffer, sizeof(buffer));
+		TDL_CHECK(fixedSize > 0 && fixedSize < size);
+		TDL_CHECK(TdlCodec::decode(buffer, fixedSize, decoded));
+		TDL_CHECK(sameHeader(decoded.header, report.header));
+		TDL_CHECK(std::fabs(decoded.latitude - report.latitude) <= 0.5e-7 + 1e-12);
+		TDL_CHECK(std::fabs(decoded.longitude - report.longitude) <= 0.5e-7 + 1e-12);
+		TDL_CHECK(std::fabs(decoded.altitude - report.altitude) <= 0.005 + 1e-9);
+		checkTruncations<PositionReport>(buffer, fixedSize);
+		TDL_CHECK(TdlCodec::encode(report, true, buffer, fixedSize - 1) == 0);
+	}
+}
+
+static void testHeartbeatsAndTexts()
+{
+	uint8_t buffer[TdlCodec::MAX_ENCODED_SIZE];
+
+	HeartbeatMessage heartbeat;
+	fillHeader(heartbeat.header, 42);
+	heartbeat.lastTextSequence = 300;
+	size_t size = TdlCodec::encode(heartbeat, buffer, sizeof(buffer));
+	HeartbeatMessage decodedHeartbeat;
+	TDL_CHECK(size > 0 && TdlCodec::decode(buffer, size, decodedHeartbeat));
+	TDL_CHECK(sameHeader(decodedHeartbeat.header, heartbeat.header) && decodedHeartbeat.lastTextSequence == 300);
+	checkTruncations<HeartbeatMessage>(buffer, size);
+	checkTooSmall(heartbeat, size);
+
+	// Some other type's bytes are not a heartbeat.
+	PositionReport notHeartbeat;
+	TDL_CHECK(!TdlCodec::decode(buffer, size, notHeartbeat));
+
+	// Empty, ordinary and full-length texts; a full one loses its last byte to the terminator.
+	const size_t lengths[] = { 0, 11, MAX_TEXT_MSG_LENGTH - 1, MAX_TEXT_MSG_LENGTH };
+	for (size_t length : lengths)
+	{
+		TextMessage message;
+		fillHeader(message.header, 7);
+		message.textSequence = 9;
+		for (size_t i = 0; i < length; ++i)
+		{
+			message.text[i] = static_cast<char>('a' + i % 26);
+		}
+		size = TdlCodec::encode(message, buffer, sizeof(buffer));
+		TextMessage decoded;
+		TDL_CHECK(size > 0 && TdlCodec::decode(buffer, size, decoded));
+		TDL_CHECK(sameHeader(decoded.header, message.header) && decoded.textSequence == 9);
+		size_t kept = length < MAX_TEXT_MSG_LENGTH ? length : MAX_TEXT_MSG_LENGTH - 1;
+		TDL_CHECK(strlen(decoded.text) == kept && memcmp(decoded.text, message.text, kept) == 0);
+		checkTruncations<TextMessage>(buffer, size);
+		checkTooSmall(message, size);
+	}
+}
+
+static void testControlMessages()
+{
+	uint8_t buffer[TdlCodec::MAX_SYNC_ENCODED_SIZE];
+
+	TextNack nack;
+	fillHeader(nack.header, 5);
+	nack.targetNodeId = 6;
+	nack.firstSequence = 0xFFFFFFF0u;
+	nack.missingMask = 0x8000000000000005ull;
+	size_t size = TdlCodec::encode(nack, buffer, sizeof(buffer));
+	TextNack decodedNack;
+	TDL_CHECK(size > 0 && TdlCodec::decode(buffer, size, decodedNack));
+	TDL_CHECK(sameHeader(decodedNack.header, nack.header) && decodedNack.targetNodeId == 6
+		&& decodedNack.firstSequence == nack.firstSequence && decodedNack.missingMask == nack.missingMask);
+	checkTruncations<TextNack>(buffer, size);
+	checkTooSmall(nack, size);
+
+	SyncRequest request;
+	fillHeader(request.header, 5);
+	request.targetNodeId = 800;
+	request.requestId = 77;
+	size = TdlCodec::encode(request, buffer, sizeof(buffer));
+	SyncRequest decodedRequest;
+	TDL_CHECK(size > 0 && TdlCodec::decode(buffer, size, decodedRequest));
+	TDL_CHECK(sameHeader(decodedRequest.header, request.header) && decodedRequest.targetNodeId == 800 && decodedRequest.requestId == 77);
+	checkTruncations<SyncRequest>(buffer, size);
+	checkTooSmall(request, size);
+
+	// A full chunk, alternating entries with and without a position.
+	SyncResponse response;
+	fillHeader(response.header, 800);
+	response.targetNodeId = 5;
+	response.requestId = 77;
+	response.chunkIndex = 2;
+	response.chunkCount = 3;
+	response.entryCount = MAX_SYNC_ENTRIES;
+	for (uint16_t i = 0; i < MAX_SYNC_ENTRIES; ++i)
+	{
+		SyncEntry& entry = response.entries[i];
+		entry.nodeId = 1000u + i * 70000u;
+		entry.ageMs = i * 1500u;
+		if (i % 2 == 0)
+		{
+			entry.flags = SYNC_ENTRY_HAS_POSITION;
+			entry.latitudeE7 = -900000000 + i * 12345;
+			entry.longitudeE7 = 1800000000 - i * 54321;
+			entry.altitudeCm = -1000 + i;
+		}
+	}
+	size = TdlCodec::encode(response, buffer, sizeof(buffer));
+	SyncResponse decoded;
+	TDL_CHECK(size > 0 && size <= TdlCodec::MAX_SYNC_ENCODED_SIZE && TdlCodec::decode(buffer, size, decoded));
+	TDL_CHECK(sameHeader(decoded.header, response.header) && decoded.targetNodeId == 5 && decoded.requestId == 77
+		&& decoded.chunkIndex == 2 && decoded.chunkCount == 3 && decoded.entryCount == MAX_SYNC_ENTRIES);
+	for (uint16_t i = 0; i < decoded.entryCount; ++i)
+	{
+		const SyncEntry& a = response.entries[i];
+		const SyncEntry& b = decoded.entries[i];
+		TDL_CHECK(a.nodeId == b.nodeId && a.ageMs == b.ageMs && a.flags == b.flags && a.latitudeE7 == b.latitudeE7
+			&& a.longitudeE7 == b.longitudeE7 && a.altitudeCm == b.altitudeCm);
+	}
+	checkTruncations<SyncResponse>(buffer, size);
+	checkTooSmall(response, size);
+}
+
+static void testRejectsOtherFormats()
+{
+	// A raw struct starts with its small message type, never the compact magic.
+	PositionReport raw;
+	TDL_CHECK(!TdlCodec::isCompact(reinterpret_cast<const uint8_t*>(&raw), sizeof(raw)));
+
+	// A version from the future.
+	uint8_t buffer[TdlCodec::MAX_ENCODED_SIZE];
+	size_t size = TdlCodec::encode(raw, false, buffer, sizeof(buffer));
+	buffer[1] = static_cast<uint8_t>(((TdlCodec::CODEC_VERSION + 1) << 4) | (buffer[1] & 0x0F));
+	PositionReport decoded;
+	TDL_CHECK(!TdlCodec::isCompact(buffer, size) && !TdlCodec::decode(buffer, size, decoded));
+}
+
+void runCodecTests()
+{
+	testPositionReports();
+	testHeartbeatsAndTexts();
+	testControlMessages();
+	testRejectsOtherFormats();
+}
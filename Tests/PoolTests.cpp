@@ -0,0 +1,196 @@
+// PoolTests.cpp
+// PacketPool exhaustion and its replenished callback, ReceiveWorkerPool overflow
+// against a pool sized by Transport::poolSlotsFor(), and (on Linux) NetworkManager
+// leaving a readable socket alone while it has no buffer to receive into.
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Tests.h"
+#include "../NetworkManager.h"
+#include "../PacketPool.h"
+#include "../ReceiveWorkers.h"
+
+static void testExhaustion()
+{
+	PacketPool pool(4, 64);
+	int replenished = 0;
+	pool.setReplenishedCallback([&replenished]() { ++replenished; });
+
+	std::vector<PacketBuffer> held;
+	for (int i = 0; i < 4; ++i)
+	{
+		held.push_back(pool.acquire());
+		TDL_CHECK(held.back());
+	}
+	TDL_CHECK(!pool.acquire() && pool.getExhaustedCount() == 1 && pool.available() == 0);
+
+	// Only the first slot back after running dry is news.
+	held[0].reset();
+	held[1].reset();
+	TDL_CHECK(replenished == 1 && pool.available() == 2);
+	held.clear();
+	TDL_CHECK(replenished == 1 && pool.available() == 4);
+
+	// Slots are reused, and handles moved around still give theirs back once.
+	PacketBuffer a = pool.acquire();
+	PacketBuffer b = std::move(a);
+	TDL_CHECK(!a && b && pool.available() == 3);
+	b = PacketBuffer();
+	TDL_CHECK(pool.available() == 4 && pool.getExhaustedCount() == 1);
+}
+
+// Workers that hold every packet until released, so queues fill up on demand.
+struct BlockedHandler
+{
+	std::mutex mutex;
+	std::condition_variable released;
+	bool open = false;
+
+	void handle()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		released.wait(lock, [this]() { return open; });
+	}
+
+	void release()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			open = true;
+		}
+		released.notify_all();
+	}
+};
+
+// Floods blocked workers from a pool sized for them: the queues must overflow (and
+// be counted) while the pool still has slots to spare.
+static void testWorkerOverflow(OverflowPolicy policy)
+{
+	const size_t workerCount = 4;
+	const size_t queueCapacity = 16;
+	const size_t held = ReceiveWorkerPool::maxHeldPackets(workerCount, queueCapacity);
+	PacketPool pool(Transport::poolSlotsFor(held), 64);
+	BlockedHandler blocked;
+	std::atomic<size_t> handled{ 0 };
+	{
+		ReceiveWorkerPool workers(workerCount, queueCapacity, [&](const ReceivedPacket&)
+			{
+				blocked.handle();
+				++handled;
+			}, policy, false);
+
+		const size_t sent = held * 3;
+		size_t refused = 0;
+		for (size_t i = 0; i < sent; ++i)
+		{
+			ReceivedPacket packet;
+			packet.buffer = pool.acquire();
+			TDL_CHECK(packet.buffer);
+			packet.size = 1;
+			refused += workers.dispatch(packet, i) ? 0 : 1;
+		}
+		TDL_CHECK(pool.getExhaustedCount() == 0);
+		TDL_CHECK(pool.available() >= pool.slotCount() - held);
+
+		uint64_t dropped = 0;
+		for (size_t i = 0; i < workerCount; ++i)
+		{
+			ReceiveWorkerCounters counters = workers.getWorkerCounters(i);
+			dropped += counters.packetsDropped;
+			TDL_CHECK(counters.queueHighWater == queueCapacity);
+		}
+		// Each worker holds its full queue, plus perhaps the packet it is stuck on.
+		TDL_CHECK(dropped >= sent - held && dropped <= sent - workerCount * queueCapacity);
+		if (policy == OverflowPolicy::DropNewest)
+		{
+			TDL_CHECK(refused == dropped);
+		}
+		else
+		{
+			TDL_CHECK(refused == 0); // The oldest went instead
+		}
+
+		blocked.release();
+		workers.stop();
+		TDL_CHECK(handled + dropped == sent);
+	}
+	TDL_CHECK(pool.available() == pool.slotCount());
+}
+
+#if defined(__linux__)
+// Keeps every buffer of a NetworkManager's pool while datagrams wait on its
+// socket: the socket must stop reading as readable, and freeing a buffer must wake
+// the waiter and make it readable again.
+static void testReceivePausesWhenDry()
+{
+	NetworkManager network(30917, "127.0.0.1", 100);
+	TDL_CHECK(network.isInitialized());
+	if (!network.isInitialized())
+	{
+		return;
+	}
+	// Hold all but a few of the pool's buffers, then queue more datagrams than that
+	// (few enough for any socket receive buffer).
+	PacketPool& pool = network.getPacketPool();
+	const size_t spare = 8;
+	std::vector<PacketBuffer> kept;
+	while (pool.available() > spare)
+	{
+		kept.push_back(pool.acquire());
+	}
+	const uint8_t datagram[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+	for (size_t i = 0; i < spare * 4; ++i)
+	{
+		network.sendBroadcast(datagram, sizeof(datagram));
+	}
+
+	std::vector<ReceivedPacket> batch(Transport::MAX_BATCH_SIZE);
+	size_t received = 0;
+	if (network.waitForEvents(1000) == Transport::WaitResult::Readable)
+	{
+		received = network.receiveBatch(batch.data(), batch.size(), false);
+	}
+	TDL_CHECK(received == spare && pool.available() == 0);
+	std::vector<ReceivedPacket> more(Transport::MAX_BATCH_SIZE);
+	TDL_CHECK(network.waitForEvents(1000) == Transport::WaitResult::Readable);
+	TDL_CHECK(network.receiveBatch(more.data(), more.size(), false) == 0); // No buffer to take one with
+
+	// Datagrams are still queued, but with nothing to receive into the socket isn't watched.
+	TDL_CHECK(network.waitForEvents(50) == Transport::WaitResult::Timeout);
+
+	// One buffer back wakes a waiter long before its timeout, and the socket is read again.
+	Transport::WaitResult woke = Transport::WaitResult::Error;
+	auto waitStarted = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::duration waited{};
+	std::thread waiter([&]()
+		{
+			woke = network.waitForEvents(5000);
+			waited = std::chrono::steady_clock::now() - waitStarted;
+		});
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	kept.front().reset();
+	waiter.join();
+	TDL_CHECK(woke != Transport::WaitResult::Timeout && woke != Transport::WaitResult::Error);
+	TDL_CHECK(waited < std::chrono::seconds(2));
+	if (woke == Transport::WaitResult::Woken)
+	{
+		TDL_CHECK(network.waitForEvents(1000) == Transport::WaitResult::Readable);
+	}
+	TDL_CHECK(network.receiveBatch(more.data(), 1, false) == 1 && more[0].size == sizeof(datagram));
+}
+#endif
+
+void runPoolTests()
+{
+	testExhaustion();
+	testWorkerOverflow(OverflowPolicy::DropNewest);
+	testWorkerOverflow(OverflowPolicy::DropOldest);
+#if defined(__linux__)
+	testReceivePausesWhenDry();
+#endif
+}
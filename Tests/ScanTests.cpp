@@ -0,0 +1,117 @@
+// ScanTests.cpp
+// ScanKernels: each dispatching kernel (AVX2 or NEON when built with it) against
+// its Scalar twin at every tail length a register can leave, plus a few known answers.
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "Tests.h"
+#include "../ScanKernels.h"
+#include "../SpatialGrid.h"
+
+static const double PI = 3.14159265358979323846;
+
+// Near-equal to what the header promises: the vector kernels' polynomials differ
+// from the C library's functions in the last few digits.
+static bool closeMeters(double a, double b, double absolute)
+{
+	return std::fabs(a - b) <= absolute + 1e-12 * std::fabs(b);
+}
+
+static void testKnownAnswers()
+{
+	double latitudes[] = { 1.0, -50.0, 0.0 };
+	double longitudes[] = { 0.0, 179.0, 180.0 };
+	double meters[3];
+
+	// One degree north, and the wrap across the antimeridian.
+	ScanKernels::flatEarthDistances(latitudes, longitudes, 1, 0.0, 0.0, meters);
+	TDL_CHECK(closeMeters(meters[0], SpatialGrid::METERS_PER_DEGREE, 1e-6));
+	ScanKernels::haversineDistances(latitudes + 1, longitudes + 1, 1, -50.0, -179.0, meters);
+	TDL_CHECK(closeMeters(meters[0], 2.0 * ScanKernels::EARTH_RADIUS_METERS * std::asin(std::cos(50.0 * PI / 180.0) * std::sin(PI / 180.0)), 1e-4));
+
+	// Half way round the equator.
+	ScanKernels::haversineDistances(latitudes + 2, longitudes + 2, 1, 0.0, 0.0, meters);
+	TDL_CHECK(closeMeters(meters[0], PI * ScanKernels::EARTH_RADIUS_METERS, 1e-4));
+}
+
+static void testMatchesScalar()
+{
+	std::mt19937 rng(4242);
+	std::uniform_real_distribution<double> latitudes(-89.0, 89.0);
+	std::uniform_real_distribution<double> longitudes(-180.0, 180.0);
+	std::uniform_int_distribution<int64_t> ticks(0, 1000);
+
+	// Every remainder modulo 4 and modulo 64, around a few whole mask words.
+	const size_t counts[] = { 0, 1, 2, 3, 4, 5, 63, 64, 65, 127, 128, 129, 130, 131, 1001 };
+	for (size_t count : counts)
+	{
+		std::vector<double> lat(count), lon(count), vector(count), scalar(count);
+		std::vector<int64_t> heard(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			lat[i] = latitudes(rng);
+			lon[i] = longitudes(rng);
+			heard[i] = ticks(rng);
+		}
+		if (count > 2)
+		{
+			lat[1] = 40.0;  // On the box edges, which count as inside
+			lon[1] = 170.0;
+			heard[2] = 500; // Exactly at the cutoff, which doesn't count as before
+		}
+
+		ScanKernels::flatEarthDistances(lat.data(), lon.data(), count, 10.0, 170.0, vector.data());
+		ScanKernels::flatEarthDistancesScalar(lat.data(), lon.data(), count, 10.0, 170.0, scalar.data());
+		for (size_t i = 0; i < count; ++i)
+		{
+			TDL_CHECK(closeMeters(vector[i], scalar[i], 1e-6));
+		}
+
+		ScanKernels::haversineDistances(lat.data(), lon.data(), count, 10.0, 170.0, vector.data());
+		ScanKernels::haversineDistancesScalar(lat.data(), lon.data(), count, 10.0, 170.0, scalar.data());
+		for (size_t i = 0; i < count; ++i)
+		{
+			TDL_CHECK(closeMeters(vector[i], scalar[i], 1e-4));
+		}
+
+		// One spare word each, pre-filled, to catch writes past the mask.
+		size_t words = ScanKernels::maskWords(count);
+		std::vector<uint64_t> vectorMask(words + 1, ~0ull), scalarMask(words + 1, ~0ull);
+		ScanKernels::heardBeforeMask(heard.data(), count, 500, vectorMask.data());
+		ScanKernels::heardBeforeMaskScalar(heard.data(), count, 500, scalarMask.data());
+		TDL_CHECK(vectorMask == scalarMask && vectorMask[words] == ~0ull);
+		if (count > 0 && count % 64 != 0)
+		{
+			TDL_CHECK((vectorMask[words - 1] >> (count % 64)) == 0); // Bits past 'count' are zero
+		}
+
+		// A box across the antimeridian, and an ordinary one.
+		ScanKernels::boundingBoxMask(lat.data(), lon.data(), count, -30.0, 40.0, 170.0, -150.0, vectorMask.data());
+		ScanKernels::boundingBoxMaskScalar(lat.data(), lon.data(), count, -30.0, 40.0, 170.0, -150.0, scalarMask.data());
+		TDL_CHECK(vectorMask == scalarMask);
+		if (count > 2)
+		{
+			TDL_CHECK((vectorMask[0] & 2) != 0);
+		}
+		ScanKernels::boundingBoxMask(lat.data(), lon.data(), count, -30.0, 40.0, -20.0, 60.0, vectorMask.data());
+		ScanKernels::boundingBoxMaskScalar(lat.data(), lon.data(), count, -30.0, 40.0, -20.0, 60.0, scalarMask.data());
+		TDL_CHECK(vectorMask == scalarMask);
+	}
+}
+
+static void testForEachSetBit()
+{
+	uint64_t mask[3] = { 0x8000000000000001ull, 0, 0x5ull };
+	std::vector<uint32_t> slots;
+	ScanKernels::forEachSetBit(mask, 3, [&](uint32_t slot) { slots.push_back(slot); });
+	TDL_CHECK((slots == std::vector<uint32_t>{ 0, 63, 128, 130 }));
+}
+
+void runScanTests()
+{
+	testKnownAnswers();
+	testMatchesScalar();
+	testForEachSetBit();
+}
@@ -0,0 +1,61 @@
+// TestMain.cpp
+// Usage: BasicTDLTests [suite names...]   (no names = run everything)
+#include <cstring>
+#include <iostream>
+
+#include "Tests.h"
+#include "../Logger.h"
+
+struct TestSuite
+{
+	const char* name;
+	void (*run)();
+};
+
+static const TestSuite g_suites[] = {
+	{ "codec", runCodecTests },
+	{ "scan", runScanTests },
+	{ "auth", runAuthTests },
+	{ "checkpoint", runCheckpointTests },
+	{ "pool", runPoolTests },
+	{ "window", runWindowTests },
+	{ "text", runTextTests },
+};
+
+static size_t g_failures = 0;
+
+void reportFailure(const char* condition, const char* file, int line)
+{
+	std::cerr << file << ":" << line << ": check failed: " << condition << std::endl;
+	++g_failures;
+}
+
+int main(int argc, char* argv[])
+{
+	// The code under test logs (e.g. every node added); keep only warnings and errors.
+	Logger::instance().setMinimumLevel(LogLevel::Warning);
+
+	size_t ran = 0;
+	for (const TestSuite& suite : g_suites)
+	{
+		bool selected = (argc == 1);
+		for (int i = 1; i < argc && !selected; ++i)
+		{
+			selected = (strcmp(argv[i], suite.name) == 0);
+		}
+		if (selected)
+		{
+			size_t failuresBefore = g_failures;
+			suite.run();
+			std::cout << suite.name << ": " << (g_failures == failuresBefore ? "passed" : "FAILED") << std::endl;
+			++ran;
+		}
+	}
+
+	if (ran == 0)
+	{
+		std::cerr << "No such test suite." << std::endl;
+		return 1;
+	}
+	return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,23 @@
+// Tests.h
+#ifndef TESTS_H
+#define TESTS_H
+
+// --- Test Suites ---
+// Each suite checks one module against known answers; TestMain.cpp runs them by
+// name, and CMake registers each name with CTest. A failed check is reported with
+// its file and line and makes the run exit non-zero, but the suite carries on.
+void runCodecTests();
+void runScanTests();
+void runAuthTests();
+void runCheckpointTests();
+void runPoolTests();
+void runWindowTests();
+void runTextTests();
+
+// Records a failed check; use TDL_CHECK rather than calling this directly.
+void reportFailure(const char* condition, const char* file, int line);
+
+// Evaluates to 'condition', reporting it if it is false.
+#define TDL_CHECK(condition) ((condition) ? true : (reportFailure(#condition, __FILE__, __LINE__), false))
+
+#endif // TESTS_H
@@ -0,0 +1,190 @@
+// TextTests.cpp
+// ReliableTextChannel over a LoopbackTransport: a lost text is NACKed, repaired
+// once and delivered once, and gaps are still found when a sender's numbering
+// wraps past UINT32_MAX.
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "Tests.h"
+#include "../LoopbackTransport.h"
+#include "../MessageSequencer.h"
+#include "../ReliableText.h"
+
+static const uint32_t RECEIVER_NODE_ID = 1;
+static const uint32_t SENDER_NODE_ID = 2;
+
+// Everything queued on the loopback, split by type (raw wire format).
+struct Traffic
+{
+	std::vector<TextMessage> texts;
+	std::vector<TextNack> nacks;
+	size_t other = 0;
+};
+
+static Traffic drain(LoopbackTransport& transport)
+{
+	Traffic traffic;
+	ReceivedPacket packets[16];
+	size_t received;
+	while ((received = transport.receiveBatch(packets, 16, false)) > 0)
+	{
+		for (size_t i = 0; i < received; ++i)
+		{
+			const ReceivedPacket& packet = packets[i];
+			if (packet.size == sizeof(TextMessage) && packet.view().as<MessageHeader>()->messageType == TEXT_MESSAGE_TYPE)
+			{
+				traffic.texts.push_back(*packet.view().as<TextMessage>());
+			}
+			else if (packet.size == sizeof(TextNack) && packet.view().as<MessageHeader>()->messageType == TEXT_NACK_TYPE)
+			{
+				traffic.nacks.push_back(*packet.view().as<TextNack>());
+			}
+			else
+			{
+				++traffic.other;
+			}
+		}
+	}
+	return traffic;
+}
+
+static bool nackAsksFor(const TextNack& nack, uint32_t sequence)
+{
+	uint32_t offset = sequence - nack.firstSequence;
+	return offset < 64 && (nack.missingMask & (1ull << offset)) != 0;
+}
+
+static size_t bitsSet(uint64_t mask)
+{
+	size_t count = 0;
+	for (; mask != 0; mask &= mask - 1)
+	{
+		++count;
+	}
+	return count;
+}
+
+static void testNackAndRepair()
+{
+	LoopbackTransport transport(64, 30920);
+	MessageSequencer senderSequencer;
+	MessageSequencer receiverSequencer;
+	ReliableTextChannel sender(transport, senderSequencer, SENDER_NODE_ID, false);
+	ReliableTextChannel receiver(transport, receiverSequencer, RECEIVER_NODE_ID, false);
+	auto now = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < 4; ++i)
+	{
+		TextMessage text;
+		strcpy(text.text, "reliable");
+		TDL_CHECK(sender.sendText(text, now));
+	}
+	Traffic sent = drain(transport);
+	TDL_CHECK(sent.texts.size() == 4);
+	if (sent.texts.size() != 4)
+	{
+		return;
+	}
+
+	// The third is lost on the way.
+	TDL_CHECK(receiver.onText(sent.texts[0]) && receiver.onText(sent.texts[1]) && receiver.onText(sent.texts[3]));
+	now = std::chrono::steady_clock::now(); // The first NACK is due from when the gap was seen
+	receiver.tick(now);
+	Traffic asked = drain(transport);
+	TDL_CHECK(asked.nacks.size() == 1);
+	if (asked.nacks.size() != 1)
+	{
+		return;
+	}
+	const TextNack& nack = asked.nacks[0];
+	TDL_CHECK(nack.header.sourceNodeId == RECEIVER_NODE_ID && nack.targetNodeId == SENDER_NODE_ID);
+	TDL_CHECK(nackAsksFor(nack, sent.texts[2].textSequence) && bitsSet(nack.missingMask) == 1);
+	receiver.tick(now);
+	TDL_CHECK(drain(transport).nacks.empty()); // Not again before NACK_RETRY_INTERVAL
+
+	// One repair, however many receivers ask for it within the holdoff.
+	sender.onNack(nack);
+	sender.onNack(nack);
+	sender.tick(now);
+	Traffic repaired = drain(transport);
+	TDL_CHECK(repaired.texts.size() == 1);
+	if (repaired.texts.size() != 1)
+	{
+		return;
+	}
+	TDL_CHECK(repaired.texts[0].textSequence == sent.texts[2].textSequence);
+	TDL_CHECK(strcmp(repaired.texts[0].text, "reliable") == 0);
+	TDL_CHECK(repaired.texts[0].header.sendTimeUs == sent.texts[2].header.sendTimeUs); // Its original send time
+	sender.onNack(nack);
+	sender.tick(now);
+	TDL_CHECK(drain(transport).texts.empty());
+
+	TDL_CHECK(receiver.onText(repaired.texts[0]));
+	TDL_CHECK(!receiver.onText(repaired.texts[0])); // Delivered once only
+	receiver.tick(now + ReliableTextChannel::NACK_RETRY_INTERVAL);
+	TDL_CHECK(drain(transport).nacks.empty()); // Nothing missing any more
+
+	ReliableTextCounters senderCounters = sender.getCounters();
+	ReliableTextCounters receiverCounters = receiver.getCounters();
+	TDL_CHECK(senderCounters.textsSent == 4 && senderCounters.nacksReceived == 3 && senderCounters.retransmits == 1);
+	TDL_CHECK(receiverCounters.nacksSent == 1 && receiverCounters.textsRepaired == 1 && receiverCounters.duplicatesDropped == 1);
+}
+
+// A text as it would arrive from SENDER_NODE_ID with the given text sequence.
+static TextMessage textNumbered(uint32_t textSequence, uint32_t sendTimeUs)
+{
+	TextMessage text;
+	text.header.sourceNodeId = SENDER_NODE_ID;
+	text.header.sendTimeUs = sendTimeUs;
+	text.textSequence = textSequence;
+	return text;
+}
+
+static void testGapsAcrossTheWrap()
+{
+	LoopbackTransport transport(64, 30921);
+	MessageSequencer sequencer;
+	ReliableTextChannel receiver(transport, sequencer, RECEIVER_NODE_ID, false);
+	std::chrono::steady_clock::time_point now;
+
+	TDL_CHECK(receiver.onText(textNumbered(0xFFFFFFFEu, 100)));
+	TDL_CHECK(receiver.onText(textNumbered(0xFFFFFFFFu, 200)));
+	TDL_CHECK(receiver.onText(textNumbered(2, 400))); // 0 is never a text's number, so only 1 is missing
+	now = std::chrono::steady_clock::now();
+	receiver.tick(now);
+	Traffic asked = drain(transport);
+	TDL_CHECK(asked.nacks.size() == 1);
+	if (asked.nacks.size() == 1)
+	{
+		TDL_CHECK(nackAsksFor(asked.nacks[0], 1) && bitsSet(asked.nacks[0].missingMask) == 1);
+	}
+
+	// A heartbeat reveals that the newest text, 3, never arrived either.
+	HeartbeatMessage heartbeat;
+	heartbeat.header.sourceNodeId = SENDER_NODE_ID;
+	heartbeat.lastTextSequence = 3;
+	receiver.onHeartbeat(heartbeat);
+	receiver.tick(now + ReliableTextChannel::NACK_RETRY_INTERVAL);
+	asked = drain(transport);
+	TDL_CHECK(asked.nacks.size() == 1);
+	if (asked.nacks.size() == 1)
+	{
+		TDL_CHECK(nackAsksFor(asked.nacks[0], 1) && nackAsksFor(asked.nacks[0], 3) && bitsSet(asked.nacks[0].missingMask) == 2);
+	}
+
+	// Both repaired: the window is whole again, across the wrap.
+	TDL_CHECK(receiver.onText(textNumbered(1, 300)));
+	TDL_CHECK(receiver.onText(textNumbered(3, 500)));
+	TDL_CHECK(!receiver.onText(textNumbered(0xFFFFFFFFu, 200)));
+	receiver.tick(now + 2 * ReliableTextChannel::NACK_RETRY_INTERVAL);
+	TDL_CHECK(drain(transport).nacks.empty());
+	TDL_CHECK(receiver.getCounters().textsRepaired == 2);
+}
+
+void runTextTests()
+{
+	testNackAndRepair();
+	testGapsAcrossTheWrap();
+}
@@ -0,0 +1,113 @@
+// WindowTests.cpp
+// NodeManager's per-sender sequence window (duplicates, reordering, restarts), and
+// PacketDispatcher only letting a well-formed message move that window.
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "Tests.h"
+#include "../ApplicationStage.h"
+#include "../NodeManager.h"
+#include "../PacketDispatcher.h"
+#include "../TdlCodec.h"
+
+static const uint32_t SELF_NODE_ID = 1;
+static const uint32_t PEER_NODE_ID = 7;
+
+static MessageHeader sequencedHeader(uint32_t sequence, uint32_t sendTimeUs)
+{
+	MessageHeader header;
+	header.messageType = HEARTBEAT_TYPE;
+	header.sourceNodeId = PEER_NODE_ID;
+	header.sequenceNumber = sequence;
+	header.sendTimeUs = sendTimeUs;
+	return header;
+}
+
+static bool findLinkStats(NodeManager& nodeManager, NodeLinkStats& stats)
+{
+	for (const NodeInfo& node : nodeManager.getNodeList())
+	{
+		if (node.nodeId == PEER_NODE_ID)
+		{
+			stats = node.link;
+			return true;
+		}
+	}
+	return false;
+}
+
+static void testSequenceWindow()
+{
+	NodeManager nodeManager(SELF_NODE_ID);
+	TDL_CHECK(nodeManager.updateLastHeardTime(sequencedHeader(100, 1000)));
+	TDL_CHECK(!nodeManager.updateLastHeardTime(sequencedHeader(100, 1000))); // The same message again
+	TDL_CHECK(nodeManager.updateLastHeardTime(sequencedHeader(110, 2000)));  // Nine lost...
+	TDL_CHECK(nodeManager.updateLastHeardTime(sequencedHeader(105, 1500)));  // ...one of them only late
+	TDL_CHECK(!nodeManager.updateLastHeardTime(sequencedHeader(105, 1500)));
+	TDL_CHECK(nodeManager.updateLastHeardTime(sequencedHeader(200, 3000)));
+	TDL_CHECK(nodeManager.updateLastHeardTime(sequencedHeader(200 - 63, 2500))); // The oldest the window tells apart
+	TDL_CHECK(!nodeManager.updateLastHeardTime(sequencedHeader(200 - 64, 2500))); // Too far behind to tell
+	TDL_CHECK(nodeManager.updateLastHeardTime(sequencedHeader(0, 0)));            // Unsequenced: never a duplicate
+	TDL_CHECK(nodeManager.updateLastHeardTime(sequencedHeader(0, 0)));
+
+	NodeLinkStats stats;
+	TDL_CHECK(findLinkStats(nodeManager, stats));
+	TDL_CHECK(stats.received == 5 && stats.duplicates == 3 && stats.reordered == 2 && stats.restarts == 0);
+	TDL_CHECK(stats.lost == 9 - 1 + 89 - 1);
+
+	// A lower number sent later by the sender's clock: it restarted, so it is taken.
+	TDL_CHECK(nodeManager.updateLastHeardTime(sequencedHeader(3, 4000)));
+	TDL_CHECK(nodeManager.updateLastHeardTime(sequencedHeader(4, 4100)));
+	TDL_CHECK(!nodeManager.updateLastHeardTime(sequencedHeader(3, 4000)));
+	TDL_CHECK(findLinkStats(nodeManager, stats));
+	TDL_CHECK(stats.restarts == 1);
+}
+
+// Hands 'size' bytes of 'datagram' to the dispatcher.
+static void dispatch(const PacketDispatcher& dispatcher, const uint8_t* datagram, size_t size)
+{
+	sockaddr_in sender = {};
+	dispatcher.processDatagram(PacketView{ datagram, size }, sender, std::chrono::steady_clock::now());
+}
+
+// A record that fails its size or decode check must not use up its sequence
+// number: the intact copy that follows still gets through.
+static void testMalformedRecordsKeepTheirSequence()
+{
+	NodeManager nodeManager(SELF_NODE_ID);
+	ApplicationStage applicationStage(16, OverflowPolicy::DropNewest, [](const ApplicationRecord&) {});
+	PacketDispatcher dispatcher(nodeManager, applicationStage);
+
+	HeartbeatMessage heartbeat;
+	heartbeat.header = sequencedHeader(5, 1000);
+	heartbeat.lastTextSequence = 0;
+	uint8_t raw[sizeof(HeartbeatMessage)];
+	memcpy(raw, &heartbeat, sizeof(raw));
+	dispatch(dispatcher, raw, sizeof(raw) - 1); // Holds a header, but not a heartbeat's worth
+	dispatch(dispatcher, raw, sizeof(raw));
+
+	NodeLinkStats stats;
+	TDL_CHECK(findLinkStats(nodeManager, stats));
+	TDL_CHECK(stats.received == 1 && stats.duplicates == 0);
+	dispatch(dispatcher, raw, sizeof(raw));
+	TDL_CHECK(findLinkStats(nodeManager, stats));
+	TDL_CHECK(stats.received == 1 && stats.duplicates == 1); // The intact copy's sequence did count
+
+	heartbeat.header = sequencedHeader(6, 1100);
+	heartbeat.lastTextSequence = 0; // An empty body: the varint is a single byte
+	uint8_t compact[TdlCodec::MAX_ENCODED_SIZE];
+	size_t compactSize = TdlCodec::encode(heartbeat, compact, sizeof(compact));
+	TDL_CHECK(compactSize > 0);
+	dispatch(dispatcher, compact, compactSize - 1); // The body cut off: the header decodes, the message doesn't
+	dispatch(dispatcher, compact, compactSize);
+	TDL_CHECK(findLinkStats(nodeManager, stats));
+	TDL_CHECK(stats.received == 2 && stats.duplicates == 1);
+}
+
+void runWindowTests()
+{
+	testSequenceWindow();
+	testMalformedRecordsKeepTheirSequence();
+}
@@ -0,0 +1,130 @@
+// TimerWheel.cpp
+#include "TimerWheel.h"
+
+TimerWheel::TimerWheel(int64_t tickLength, size_t bucketCount) :
+	m_tickLength(tickLength > 0 ? tickLength : 1),
+	m_bucketMask(bucketCount - 1),
+	m_bucketHeads(bucketCount, INVALID_SLOT)
+{
+}
+
+void TimerWheel::ensureSlot(uint32_t slot)
+{
+	if (slot >= m_next.size())
+	{
+		size_t newSize = static_cast<size_t>(slot) + 1;
+		m_next.resize(newSize, INVALID_SLOT);
+		m_prev.resize(newSize, INVALID_SLOT);
+		m_tick.resize(newSize, 0);
+		m_linked.resize(newSize, 0);
+	}
+}
+
+void TimerWheel::link(uint32_t slot, int64_t tick)
+{
+	size_t bucket = static_cast<size_t>(tick) & m_bucketMask;
+
+	// Push onto the front of the bucket's list.
+	m_prev[slot] = INVALID_SLOT;
+	m_next[slot] = m_bucketHeads[bucket];
+	if (m_bucketHeads[bucket] != INVALID_SLOT)
+	{
+		m_prev[m_bucketHeads[bucket]] = slot;
+	}
+	m_bucketHeads[bucket] = slot;
+
+	m_tick[slot] = tick;
+	m_linked[slot] = 1;
+
+	if (m_oldestTick < 0 || tick < m_oldestTick)
+	{
+		m_oldestTick = tick;
+	}
+}
+
+void TimerWheel::schedule(uint32_t slot, int64_t time)
+{
+	ensureSlot(slot);
+	int64_t tick = tickOf(time);
+
+	if (m_linked[slot])
+	{
+		if (m_tick[slot] == tick)
+		{
+			return; // Already in the right bucket (the common case for chatty nodes)
+		}
+		cancel(slot);
+	}
+	link(slot, tick);
+}
+
+void TimerWheel::cancel(uint32_t slot)
+{
+	if (slot >= m_linked.size() || !m_linked[slot])
+	{
+		return;
+	}
+
+	if (m_prev[slot] != INVALID_SLOT)
+	{
+		m_next[m_prev[slot]] = m_next[slot];
+	}
+	else
+	{
+		m_bucketHeads[static_cast<size_t>(m_tick[slot]) & m_bucketMask] = m_next[slot];
+	}
+	if (m_next[slot] != INVALID_SLOT)
+	{
+		m_prev[m_next[slot]] = m_prev[slot];
+	}
+
+	m_next[slot] = INVALID_SLOT;
+	m_prev[slot] = INVALID_SLOT;
+	m_linked[slot] = 0;
+}
+
+size_t TimerWheel::collectExpired(int64_t cutoffTime, uint32_t* outSlots, size_t maxSlots)
+{
+	if (m_oldestTick < 0)
+	{
+		return 0; // Nothing has ever been filed
+	}
+
+	int64_t cutoffTick = tickOf(cutoffTime);
+	int64_t bucketCount = static_cast<int64_t>(m_bucketMask + 1);
+
+	// Each bucket only needs visiting once per sweep, however far behind we are.
+	int64_t firstTick = m_oldestTick;
+	if (cutoffTick - firstTick > bucketCount)
+	{
+		firstTick = cutoffTick - bucketCount;
+	}
+
+	size_t count = 0;
+	for (int64_t tick = firstTick; tick < cutoffTick; ++tick)
+	{
+		uint32_t slot = m_bucketHeads[static_cast<size_t>(tick) & m_bucketMask];
+		while (slot != INVALID_SLOT)
+		{
+			uint32_t next = m_next[slot];
+			// Entries that wrapped around from a later tick stay where they are.
+			if (m_tick[slot] < cutoffTick)
+			{
+				if (count == maxSlots)
+				{
+					m_oldestTick = tick; // Resume from this bucket next time
+					return count;
+				}
+				cancel(slot);
+				outSlots[count++] = slot;
+			}
+			slot = next;
+		}
+	}
+
+	if (cutoffTick > m_oldestTick)
+	{
+		m_oldestTick = cutoffTick;
+	}
+	return count;
+}
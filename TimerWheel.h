@@ -0,0 +1,71 @@
+// TimerWheel.h
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// --- Timer Wheel ---
+// A hashed timing wheel that files NodeTable slots by the wheel tick in which the
+// node was last heard. Every node shares the same timeout, so "deadline order" is
+// just "last-heard order", and all the nodes in a bucket older than the cutoff tick
+// have expired. An expiry sweep therefore only visits buckets that are due, and
+// only the nodes that are actually expiring in them - it never walks live nodes.
+//
+// Buckets are intrusive doubly linked lists threaded through per-slot next/prev
+// arrays, so scheduling, rescheduling and expiring never allocate (the per-slot
+// arrays only grow when the node table itself grows).
+//
+// Resolution is one wheel tick: a node expires once its last-heard tick is older
+// than the cutoff's tick. As long as the timeout is shorter than the wheel span
+// (bucketCount ticks), each sweep is O(expired). Longer timeouts still work, just
+// with some extra bucket visits for entries that wrapped around.
+class TimerWheel
+{
+public:
+	static constexpr uint32_t INVALID_SLOT = 0xFFFFFFFFu;
+
+	// 'tickLength' is in the same units as the times passed in (steady_clock ticks).
+	// 'bucketCount' must be a power of two.
+	TimerWheel(int64_t tickLength, size_t bucketCount);
+
+	// Files 'slot' under the tick containing 'time', moving it if it was filed before.
+	void schedule(uint32_t slot, int64_t time);
+
+	// Removes 'slot' from the wheel (no-op if it isn't filed).
+	void cancel(uint32_t slot);
+
+	// Sizes the per-slot arrays for slots below 'slotCount' now, so filing them never allocates.
+	void reserveSlots(size_t slotCount)
+	{
+		if (slotCount > 0)
+		{
+			ensureSlot(static_cast<uint32_t>(slotCount - 1));
+		}
+	}
+
+	// Unlinks up to 'maxSlots' slots whose tick is older than the tick of 'cutoffTime'
+	// and writes them to 'outSlots'. Returns how many were written. If the result
+	// equals 'maxSlots' there may be more; call again.
+	size_t collectExpired(int64_t cutoffTime, uint32_t* outSlots, size_t maxSlots);
+
+private:
+	int64_t tickOf(int64_t time) const { return time / m_tickLength; }
+	void ensureSlot(uint32_t slot);
+	void link(uint32_t slot, int64_t tick);
+
+	int64_t m_tickLength;
+	size_t m_bucketMask;
+	std::vector<uint32_t> m_bucketHeads;  // First slot in each bucket, INVALID_SLOT if empty
+
+	// --- Per-slot intrusive links ---
+	std::vector<uint32_t> m_next;
+	std::vector<uint32_t> m_prev;
+	std::vector<int64_t> m_tick;          // Tick the slot is filed under
+	std::vector<uint8_t> m_linked;
+
+	int64_t m_oldestTick = -1;            // No filed slot has an older tick (-1: nothing filed yet)
+};
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,297 @@
+// TrafficCapture.cpp
+#include "TrafficCapture.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include "Logger.h"
+#include "PacketDispatcher.h"
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static constexpr size_t MAPPING_GRANULARITY = 64 * 1024; // Windows' allocation granularity; a multiple of the page size elsewhere
+
+static size_t alignUp(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+// --- Traffic Recorder ---
+TrafficRecorder::TrafficRecorder(const std::string& path, size_t segmentSize) :
+	m_path(path),
+	m_segmentSize(alignUp(std::max(segmentSize, MAPPING_GRANULARITY), MAPPING_GRANULARITY)),
+	m_startTime(std::chrono::steady_clock::now())
+{
+#if defined(_WIN32)
+	m_file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+	{
+		TDL_LOG_ERROR << "[Capture] Could not create '" << path << "': " << GetLastError();
+		return;
+	}
+#elif defined(__linux__)
+	m_fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (m_fd < 0)
+	{
+		TDL_LOG_ERROR << "[Capture] Could not create '" << path << "': " << errno;
+		return;
+	}
+#endif
+
+	if (!mapSegment(0))
+	{
+		return; // isOpen() stays false
+	}
+
+	CaptureFileHeader header = {};
+	header.magic = CAPTURE_MAGIC;
+	header.version = CAPTURE_VERSION;
+	header.headerSize = sizeof(CaptureFileHeader);
+	header.segmentSize = m_segmentSize;
+	memcpy(m_segment, &header, sizeof(header));
+	m_segmentOffset = sizeof(header);
+	TDL_LOG_INFO << "[Capture] Recording received traffic to '" << path << "'.";
+}
+
+TrafficRecorder::~TrafficRecorder()
+{
+	close();
+}
+
+bool TrafficRecorder::mapSegment(uint64_t segmentIndex)
+{
+	uint64_t segmentStart = segmentIndex * m_segmentSize;
+	uint64_t segmentEnd = segmentStart + m_segmentSize;
+	void* view = nullptr;
+
+#if defined(_WIN32)
+	// A mapping larger than the file grows the file to match.
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READWRITE, static_cast<DWORD>(segmentEnd >> 32), static_cast<DWORD>(segmentEnd), nullptr);
+	if (!m_mapping)
+	{
+		TDL_LOG_ERROR << "[Capture] Could not grow '" << m_path << "': " << GetLastError();
+		return false;
+	}
+	view = MapViewOfFile(m_mapping, FILE_MAP_WRITE, static_cast<DWORD>(segmentStart >> 32), static_cast<DWORD>(segmentStart), m_segmentSize);
+	if (!view)
+	{
+		TDL_LOG_ERROR << "[Capture] MapViewOfFile failed: " << GetLastError();
+		CloseHandle(m_mapping);
+		m_mapping = nullptr;
+		return false;
+	}
+#elif defined(__linux__)
+	if (ftruncate(m_fd, static_cast<off_t>(segmentEnd)) != 0)
+	{
+		TDL_LOG_ERROR << "[Capture] Could not grow '" << m_path << "': " << errno;
+		return false;
+	}
+	view = mmap(nullptr, m_segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, static_cast<off_t>(segmentStart));
+	if (view == MAP_FAILED)
+	{
+		TDL_LOG_ERROR << "[Capture] mmap failed: " << errno;
+		return false;
+	}
+	madvise(view, m_segmentSize, MADV_SEQUENTIAL);
+#endif
+
+	m_segment = static_cast<uint8_t*>(view);
+	m_segmentIndex = segmentIndex;
+	m_segmentOffset = 0;
+	return true;
+}
+
+void TrafficRecorder::unmapSegment()
+{
+	if (!m_segment)
+	{
+		return;
+	}
+#if defined(_WIN32)
+	UnmapViewOfFile(m_segment);
+	CloseHandle(m_mapping);
+	m_mapping = nullptr;
+#elif defined(__linux__)
+	munmap(m_segment, m_segmentSize);
+#endif
+	m_segment = nullptr;
+}
+
+bool TrafficRecorder::record(const ReceivedPacket& packet)
+{
+	if (!m_segment)
+	{
+		return false;
+	}
+
+	size_t recordSize = sizeof(CaptureRecordHeader) + alignUp(packet.size, 8);
+	if (recordSize > m_segmentSize - sizeof(CaptureFileHeader))
+	{
+		return false; // Can't happen with real datagrams and any sensible segment size
+	}
+
+	// Move to the next segment if this record wouldn't fit in the rest of this one.
+	if (m_segmentOffset + recordSize > m_segmentSize)
+	{
+		if (m_segmentSize - m_segmentOffset >= sizeof(CaptureRecordHeader))
+		{
+			CaptureRecordHeader pad = {};
+			pad.size = CAPTURE_PAD_RECORD;
+			memcpy(m_segment + m_segmentOffset, &pad, sizeof(pad));
+		}
+		uint64_t nextSegment = m_segmentIndex + 1;
+		unmapSegment();
+		m_segmentIndex = nextSegment; // close() trims to the start of it if mapping fails
+		m_segmentOffset = 0;
+		if (!mapSegment(nextSegment))
+		{
+			TDL_LOG_ERROR << "[Capture] Recording stopped after " << m_recordedCount << " datagrams.";
+			return false;
+		}
+	}
+
+	CaptureRecordHeader header = {};
+	header.size = static_cast<uint32_t>(packet.size);
+	header.senderAddress = packet.senderAddress.sin_addr.s_addr;
+	header.senderPort = packet.senderAddress.sin_port;
+	auto sinceStart = std::chrono::duration_cast<std::chrono::nanoseconds>(packet.receivedAt - m_startTime).count();
+	header.timestampNs = sinceStart > 0 ? static_cast<uint64_t>(sinceStart) : 0;
+
+	// The padding after the payload is already zero: the file grew with zeroes.
+	uint8_t* out = m_segment + m_segmentOffset;
+	memcpy(out, &header, sizeof(header));
+	memcpy(out + sizeof(header), packet.buffer.data(), packet.size);
+	m_segmentOffset += recordSize;
+
+	++m_recordedCount;
+	m_recordedBytes += packet.size;
+	return true;
+}
+
+void TrafficRecorder::close()
+{
+	uint64_t dataEnd = m_segmentIndex * m_segmentSize + m_segmentOffset;
+	unmapSegment();
+
+	// Trim the unused tail of the last segment away.
+#if defined(_WIN32)
+	if (m_file != INVALID_HANDLE_VALUE)
+	{
+		LARGE_INTEGER end;
+		end.QuadPart = static_cast<long long>(dataEnd);
+		if (!SetFilePointerEx(m_file, end, nullptr, FILE_BEGIN) || !SetEndOfFile(m_file))
+		{
+			TDL_LOG_WARNING << "[Capture] Could not trim '" << m_path << "': " << GetLastError();
+		}
+		CloseHandle(m_file);
+		m_file = INVALID_HANDLE_VALUE;
+	}
+#elif defined(__linux__)
+	if (m_fd >= 0)
+	{
+		if (ftruncate(m_fd, static_cast<off_t>(dataEnd)) != 0)
+		{
+			TDL_LOG_WARNING << "[Capture] Could not trim '" << m_path << "': " << errno;
+		}
+		::close(m_fd);
+		m_fd = -1;
+	}
+#endif
+}
+
+// --- Traffic Replayer ---
+TrafficReplayer::TrafficReplayer(const std::string& path) :
+	m_file(path)
+{
+	if (!m_file.isOpen() || m_file.size() < sizeof(CaptureFileHeader))
+	{
+		TDL_LOG_ERROR << "[Replay] Could not map '" << path << "' (error " << m_file.errorCode() << ", " << m_file.size() << " bytes).";
+		return;
+	}
+
+	CaptureFileHeader header;
+	memcpy(&header, m_file.data(), sizeof(header));
+	if (header.magic != CAPTURE_MAGIC || header.version != CAPTURE_VERSION || header.headerSize < sizeof(CaptureFileHeader)
+		|| header.segmentSize == 0 || header.segmentSize % 8 != 0)
+	{
+		TDL_LOG_ERROR << "[Replay] '" << path << "' is not a capture this build can read.";
+		return;
+	}
+	m_segmentSize = header.segmentSize;
+	m_valid = true;
+}
+
+ReplayStats TrafficReplayer::replay(const PacketDispatcher& dispatcher, bool atRecordedSpeed) const
+{
+	ReplayStats stats;
+	if (!m_valid)
+	{
+		return stats;
+	}
+	const uint8_t* data = m_file.data();
+	size_t size = m_file.size();
+
+	auto start = std::chrono::steady_clock::now();
+	uint64_t firstTimestamp = 0;
+	uint64_t lastTimestamp = 0;
+
+	CaptureFileHeader fileHeader;
+	memcpy(&fileHeader, data, sizeof(fileHeader));
+	size_t offset = fileHeader.headerSize;
+	while (offset + sizeof(CaptureRecordHeader) <= size)
+	{
+		size_t segmentEnd = static_cast<size_t>((offset / m_segmentSize + 1) * m_segmentSize);
+		if (segmentEnd - offset < sizeof(CaptureRecordHeader))
+		{
+			offset = segmentEnd; // Too little room left for the recorder to have used it
+			continue;
+		}
+
+		CaptureRecordHeader record;
+		memcpy(&record, data + offset, sizeof(record));
+		if (record.size == 0)
+		{
+			break; // End of the capture (or of what was written before a crash)
+		}
+		if (record.size == CAPTURE_PAD_RECORD)
+		{
+			offset = segmentEnd;
+			continue;
+		}
+
+		size_t payloadOffset = offset + sizeof(record);
+		if (record.size > segmentEnd - payloadOffset || record.size > size - payloadOffset)
+		{
+			TDL_LOG_WARNING << "[Replay] Capture is truncated after " << stats.datagrams << " datagrams.";
+			break;
+		}
+
+		if (stats.datagrams == 0)
+		{
+			firstTimestamp = record.timestampNs;
+		}
+		lastTimestamp = std::max(lastTimestamp, record.timestampNs);
+		if (atRecordedSpeed && record.timestampNs > firstTimestamp)
+		{
+			std::this_thread::sleep_until(start + std::chrono::nanoseconds(record.timestampNs - firstTimestamp));
+		}
+
+		sockaddr_in senderAddress = {};
+		senderAddress.sin_family = AF_INET;
+		senderAddress.sin_addr.s_addr = record.senderAddress;
+		senderAddress.sin_port = record.senderPort;
+
+		// Straight out of the mapping: records start 8-byte aligned, like pool slots.
+		dispatcher.processDatagram(PacketView{ data + payloadOffset, record.size }, senderAddress, std::chrono::steady_clock::now());
+
+		++stats.datagrams;
+		stats.bytes += record.size;
+		offset = payloadOffset + alignUp(record.size, 8);
+	}
+
+	stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	stats.recordedSeconds = static_cast<double>(lastTimestamp - firstTimestamp) * 1e-9;
+	return stats;
+}
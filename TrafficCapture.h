@@ -0,0 +1,129 @@
+// TrafficCapture.h
+#ifndef TRAFFIC_CAPTURE_H
+#define TRAFFIC_CAPTURE_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "MappedFile.h"
+#include "Transport.h" // ReceivedPacket, sockaddr_in
+
+class PacketDispatcher;
+
+// --- Capture File Format ---
+// A capture is a CaptureFileHeader followed by records, each a CaptureRecordHeader
+// and the datagram bytes, padded so the next record starts on 8 bytes. That keeps
+// raw message structs aligned when replay reads them straight out of the mapping.
+// The file is written in fixed-size segments and a record never straddles two:
+// a record with size CAPTURE_PAD_RECORD says "the rest of this segment is empty".
+// A size of 0 marks the end, so a capture cut short by a crash (whose unused tail
+// is still zero) reads back cleanly up to its last complete record.
+static constexpr uint64_t CAPTURE_MAGIC = 0x31305041434C4454ull; // "TDLCAP01" in file byte order
+static constexpr uint32_t CAPTURE_VERSION = 1;
+static constexpr uint32_t CAPTURE_PAD_RECORD = 0xFFFFFFFFu;
+
+struct CaptureFileHeader
+{
+	uint64_t magic;
+	uint32_t version;
+	uint32_t headerSize;  // sizeof(CaptureFileHeader): where the first record starts
+	uint64_t segmentSize; // Records never cross a multiple of this
+	uint8_t reserved[40];
+};
+
+struct CaptureRecordHeader
+{
+	uint32_t size;          // Datagram bytes that follow; 0 = end, CAPTURE_PAD_RECORD = skip to next segment
+	uint32_t senderAddress; // IPv4, network byte order (as in sockaddr_in)
+	uint16_t senderPort;    // Network byte order
+	uint16_t reserved;
+	uint32_t reserved2;
+	uint64_t timestampNs;   // Steady-clock receive time, relative to the start of the capture
+};
+
+static_assert(sizeof(CaptureFileHeader) == 64, "Capture header layout is part of the file format");
+static_assert(sizeof(CaptureRecordHeader) == 24, "Capture record layout is part of the file format");
+
+// --- Traffic Recorder ---
+// Appends every received datagram, with its sender and a steady-clock timestamp, to
+// a capture file. The file is grown and mapped a segment at a time, so recording a
+// datagram is a memcpy into the mapping: no system call per packet, and the OS
+// writes dirty pages back in large sequential runs. Closing trims the file to what
+// was recorded. Meant for the receive thread; not thread-safe.
+class TrafficRecorder
+{
+public:
+	static constexpr size_t DEFAULT_SEGMENT_SIZE = 64 * 1024 * 1024; // A multiple of every platform's mapping granularity
+
+	explicit TrafficRecorder(const std::string& path, size_t segmentSize = DEFAULT_SEGMENT_SIZE);
+	~TrafficRecorder();
+
+	bool isOpen() const { return m_segment != nullptr; }
+
+	// Appends one datagram. Returns false (and stops recording) if the file can't grow.
+	bool record(const ReceivedPacket& packet);
+
+	// Unmaps the last segment and trims the file. Also done by the destructor.
+	void close();
+
+	uint64_t getRecordedCount() const { return m_recordedCount; }
+	uint64_t getRecordedBytes() const { return m_recordedBytes; }
+
+	// Disable copy and assignment (owns the file and its mapping)
+	TrafficRecorder(const TrafficRecorder&) = delete;
+	TrafficRecorder& operator=(const TrafficRecorder&) = delete;
+
+private:
+	bool mapSegment(uint64_t segmentIndex); // Grows the file to cover the segment and maps it
+	void unmapSegment();
+
+	std::string m_path;
+	size_t m_segmentSize;
+	uint8_t* m_segment = nullptr;  // Mapping of the current segment
+	uint64_t m_segmentIndex = 0;
+	size_t m_segmentOffset = 0;    // Write position within the segment
+	std::chrono::steady_clock::time_point m_startTime;
+
+#if defined(_WIN32)
+	HANDLE m_file = INVALID_HANDLE_VALUE;
+	HANDLE m_mapping = nullptr;    // Per segment
+#elif defined(__linux__)
+	int m_fd = -1;
+#endif
+
+	uint64_t m_recordedCount = 0;
+	uint64_t m_recordedBytes = 0;
+};
+
+// --- Traffic Replayer ---
+// Maps a capture read-only and feeds its datagrams, in order, through the same
+// PacketDispatcher path live traffic takes. Replaying as fast as possible measures
+// the receive pipeline's throughput on real traffic; replaying at recorded speed
+// reproduces the original timing (bursts included) for debugging.
+struct ReplayStats
+{
+	uint64_t datagrams = 0;
+	uint64_t bytes = 0;
+	double seconds = 0.0;         // Wall time the replay took
+	double recordedSeconds = 0.0; // Span of the capture's timestamps
+};
+
+class TrafficReplayer
+{
+public:
+	explicit TrafficReplayer(const std::string& path);
+
+	bool isOpen() const { return m_valid; }
+
+	// Dispatches every record. With 'atRecordedSpeed', sleeps so each datagram is
+	// delivered at its recorded offset from the start of the replay.
+	ReplayStats replay(const PacketDispatcher& dispatcher, bool atRecordedSpeed) const;
+
+private:
+	MappedFile m_file;
+	bool m_valid = false;     // Mapped, with a header this build understands
+	uint64_t m_segmentSize = 0;
+};
+
+#endif // TRAFFIC_CAPTURE_H
@@ -0,0 +1,113 @@
+// TransmissionScheduler.cpp
+#include "TransmissionScheduler.h"
+#include <algorithm>
+#include <cmath>
+
+static constexpr double METERS_PER_DEGREE = 111320.0;
+static constexpr double DEGREES_TO_RADIANS = 3.14159265358979323846 / 180.0;
+
+TransmissionScheduler::TransmissionScheduler(const TransmissionPolicy& policy) :
+	m_policy(policy),
+	m_currentPositionInterval(policy.positionInterval)
+{
+}
+
+void TransmissionScheduler::setPolicy(const TransmissionPolicy& policy)
+{
+	m_policy = policy;
+	m_currentPositionInterval = policy.positionInterval; // Restart the back-off from the new base rate
+}
+
+double TransmissionScheduler::distanceMeters(const PositionReport& a, const PositionReport& b)
+{
+	double north = (a.latitude - b.latitude) * METERS_PER_DEGREE;
+	double east = (a.longitude - b.longitude) * METERS_PER_DEGREE * std::cos(a.latitude * DEGREES_TO_RADIANS);
+	double up = a.altitude - b.altitude;
+	return std::sqrt(north * north + east * east + up * up);
+}
+
+bool TransmissionScheduler::shouldSendHeartbeat(std::chrono::steady_clock::time_point now)
+{
+	if (m_sentAnything && now - m_lastSendTime < m_policy.livenessWindow)
+	{
+		// Something else went out recently and already told everyone we're alive.
+		m_heartbeatsSuppressed.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	return true;
+}
+
+bool TransmissionScheduler::shouldSendPosition(std::chrono::steady_clock::time_point now, const PositionReport& current)
+{
+	if (!m_sentPosition)
+	{
+		return true; // Always announce where we are once
+	}
+
+	auto elapsed = now - m_lastPositionTime;
+	if (elapsed < m_policy.positionInterval)
+	{
+		return false; // Not due yet at even the fastest rate (not counted as suppressed)
+	}
+
+	// Moving: send at the base rate.
+	double moved = distanceMeters(current, m_lastSentPosition);
+	if (moved >= m_policy.motionThresholdMeters)
+	{
+		m_currentPositionInterval = m_policy.positionInterval;
+		return true;
+	}
+
+	// Stationary: receivers can keep using the last report, so only refresh at the backed-off rate.
+	if (elapsed >= m_currentPositionInterval)
+	{
+		m_currentPositionInterval = std::min(m_currentPositionInterval * 2, m_policy.maxPositionInterval);
+		return true;
+	}
+
+	// Held back: counted only if there is a change to report at all, and once per
+	// base interval, i.e. once for each report the fixed rate would have sent, not
+	// once per pass of the send loop.
+	if (moved > 0.0 && now - m_lastSuppressedTime >= m_policy.positionInterval)
+	{
+		m_lastSuppressedTime = now;
+		m_positionsSuppressed.fetch_add(1, std::memory_order_relaxed);
+	}
+	return false;
+}
+
+void TransmissionScheduler::onHeartbeatSent(std::chrono::steady_clock::time_point now)
+{
+	m_sentAnything = true;
+	m_lastSendTime = now;
+	m_heartbeatsSent.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TransmissionScheduler::onPositionSent(std::chrono::steady_clock::time_point now, const PositionReport& sent)
+{
+	m_sentAnything = true;
+	m_lastSendTime = now;
+	m_sentPosition = true;
+	m_lastPositionTime = now;
+	m_lastSuppressedTime = now; // The next base interval starts from this report
+	m_lastSentPosition = sent;
+	m_positionsSent.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TransmissionScheduler::onMessageSent(std::chrono::steady_clock::time_point now)
+{
+	m_sentAnything = true;
+	m_lastSendTime = now;
+	m_otherMessagesSent.fetch_add(1, std::memory_order_relaxed);
+}
+
+TransmissionCounters TransmissionScheduler::getCounters() const
+{
+	TransmissionCounters counters;
+	counters.heartbeatsSent = m_heartbeatsSent.load(std::memory_order_relaxed);
+	counters.heartbeatsSuppressed = m_heartbeatsSuppressed.load(std::memory_order_relaxed);
+	counters.positionsSent = m_positionsSent.load(std::memory_order_relaxed);
+	counters.positionsSuppressed = m_positionsSuppressed.load(std::memory_order_relaxed);
+	counters.otherMessagesSent = m_otherMessagesSent.load(std::memory_order_relaxed);
+	return counters;
+}
@@ -0,0 +1,91 @@
+// TransmissionScheduler.h
+#ifndef TRANSMISSION_SCHEDULER_H
+#define TRANSMISSION_SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "TdlMessages.h"
+
+// --- Transmission Policy ---
+// Tunables for TransmissionScheduler. Every message a receiver gets refreshes our
+// lastHeardTime there, so a heartbeat is only needed when nothing else has gone out
+// lately, and a position report is only needed when we've actually moved.
+struct TransmissionPolicy
+{
+	// A heartbeat is sent only if nothing at all was sent within this window.
+	// Must stay well below the receivers' node timeout.
+	std::chrono::milliseconds livenessWindow{ 1000 };
+
+	// Position reports go out at this rate while the node is moving...
+	std::chrono::milliseconds positionInterval{ 5000 };
+	// ...and back off (doubling each time) up to this rate while it is not.
+	std::chrono::milliseconds maxPositionInterval{ 20000 };
+
+	// Movement since the last sent report below this distance counts as "not moving".
+	double motionThresholdMeters = 10.0;
+};
+
+// --- Transmission Counters ---
+// Snapshot of what the scheduler has sent and suppressed so far.
+struct TransmissionCounters
+{
+	uint64_t heartbeatsSent = 0;
+	uint64_t heartbeatsSuppressed = 0;
+	uint64_t positionsSent = 0;
+	uint64_t positionsSuppressed = 0; // Reports the base rate would have sent with a (sub-threshold) change held back
+	uint64_t otherMessagesSent = 0;
+};
+
+// --- Transmission Scheduler ---
+// Decides, on each pass of the send loop, whether a heartbeat and/or position report
+// actually needs to go out. Used from the sender thread only; getCounters() may be
+// called from any thread.
+class TransmissionScheduler
+{
+public:
+	explicit TransmissionScheduler(const TransmissionPolicy& policy = TransmissionPolicy());
+
+	// True if a heartbeat is due, i.e. nothing has been sent within the liveness window.
+	bool shouldSendHeartbeat(std::chrono::steady_clock::time_point now);
+
+	// True if 'current' should be broadcast: either we moved past the motion threshold
+	// and a position interval has passed, or the (backed-off) refresh interval expired.
+	bool shouldSendPosition(std::chrono::steady_clock::time_point now, const PositionReport& current);
+
+	// Tell the scheduler what actually went out.
+	void onHeartbeatSent(std::chrono::steady_clock::time_point now);
+	void onPositionSent(std::chrono::steady_clock::time_point now, const PositionReport& sent);
+	void onMessageSent(std::chrono::steady_clock::time_point now); // Any other message type
+
+	const TransmissionPolicy& getPolicy() const { return m_policy; }
+	void setPolicy(const TransmissionPolicy& policy);
+
+	// Current back-off interval for stationary position refreshes.
+	std::chrono::milliseconds getCurrentPositionInterval() const { return m_currentPositionInterval; }
+
+	TransmissionCounters getCounters() const;
+
+private:
+	// Approximate distance between two reports (flat-earth, fine at these scales).
+	static double distanceMeters(const PositionReport& a, const PositionReport& b);
+
+	TransmissionPolicy m_policy;
+
+	bool m_sentAnything = false;
+	bool m_sentPosition = false;
+	std::chrono::steady_clock::time_point m_lastSendTime;
+	std::chrono::steady_clock::time_point m_lastPositionTime;
+	std::chrono::steady_clock::time_point m_lastSuppressedTime; // Last time a held-back report was counted
+	PositionReport m_lastSentPosition;
+	std::chrono::milliseconds m_currentPositionInterval;
+
+	// Relaxed atomics so a stats reader on another thread sees sane values.
+	std::atomic<uint64_t> m_heartbeatsSent{ 0 };
+	std::atomic<uint64_t> m_heartbeatsSuppressed{ 0 };
+	std::atomic<uint64_t> m_positionsSent{ 0 };
+	std::atomic<uint64_t> m_positionsSuppressed{ 0 };
+	std::atomic<uint64_t> m_otherMessagesSent{ 0 };
+};
+
+#endif // TRANSMISSION_SCHEDULER_H
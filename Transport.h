@@ -0,0 +1,85 @@
+// Transport.h
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "PacketPool.h"
+#include "SocketPlatform.h" // sockaddr_in
+#include "TdlMessages.h" // MessageType, for channel routing
+
+// Structure to hold received packet details
+struct ReceivedPacket
+{
+	PacketBuffer buffer;       // Pool slot the datagram was received into
+	size_t size = 0;           // Number of valid bytes in 'buffer'
+	sockaddr_in senderAddress = {};
+	std::chrono::steady_clock::time_point receivedAt; // When receiveBatch() handed it out (for latency metrics)
+
+	// Non-owning view of the received bytes (valid while 'buffer' is held).
+	PacketView view() const { return PacketView{ buffer.data(), size }; }
+};
+
+// --- Transport ---
+// What the reactor, the sender and the aggregator need from "the network":
+// broadcast a datagram, pull received datagrams in batches, and sleep until some
+// arrive. NetworkManager implements it over UDP; LoopbackTransport implements it
+// in memory so one process can be both the traffic source and the receiver.
+//
+// receiveBatch() and waitForEvents() belong to one receive thread;
+// sendBroadcast() and wakeup() may be called from any thread.
+class Transport
+{
+public:
+	virtual ~Transport() = default;
+
+	virtual bool isInitialized() const = 0;
+
+	virtual bool sendBroadcast(const void* data, size_t size) = 0;
+
+	// Sends a datagram that carries messages of 'type' only. Transports that can
+	// route by type (NetworkManager with multicast channels) override this; the
+	// rest, and any type without a channel of its own, just broadcast.
+	virtual bool sendOnChannel(MessageType type, const void* data, size_t size)
+	{
+		(void)type;
+		return sendBroadcast(data, size);
+	}
+
+	// Fills up to 'maxPackets' entries and returns how many. Entries keep their pool
+	// slot between calls, so the caller should reuse the same array. With 'wait'
+	// false it returns only what is already queued.
+	virtual size_t receiveBatch(ReceivedPacket* packets, size_t maxPackets, bool wait = true) = 0;
+
+	// Upper bound on how many datagrams a single receiveBatch() call can return.
+	static constexpr size_t MAX_BATCH_SIZE = 32;
+
+	// Packet pool size for a receiver that may hold 'heldPackets' datagrams beyond
+	// its own batch (ReceiveWorkerPool::maxHeldPackets()): the batch, a receive
+	// ring's worth in flight and headroom, plus those. Any smaller and the pool runs
+	// dry before the queues downstream fill, so the drops happen, uncounted, in the
+	// kernel instead of where the overflow policy can see them.
+	static size_t poolSlotsFor(size_t heldPackets) { return MAX_BATCH_SIZE * 8 + heldPackets; }
+
+	// The pool every received datagram lives in. Exposed for its usage counters.
+	virtual PacketPool& getPacketPool() = 0;
+
+	// --- Event-Driven Receive ---
+	enum class WaitResult
+	{
+		Readable, // Datagrams are waiting; drain them with receiveBatch(..., false)
+		Woken,    // wakeup() was called
+		Timeout,  // Nothing happened within the timeout
+		Error
+	};
+
+	// Blocks until datagrams are waiting, wakeup() is called, or 'timeoutMs'
+	// passes (-1 waits forever).
+	virtual WaitResult waitForEvents(int timeoutMs) = 0;
+
+	// Makes the current (or next) waitForEvents() call return Woken.
+	virtual void wakeup() = 0;
+};
+
+#endif // TRANSPORT_H
@@ -1,16 +1,44 @@
 // main.cpp
 #include <atomic>
+#include <charconv> // std::from_chars for numeric options
 #include <chrono>
-#include <iostream>
+#include <cctype>
+#include <cmath>
+#include <cstdio>  // snprintf
+#include <cstdlib> // std::strtod
+#include <cstring>
+#include <iostream> // std::cin for the shutdown prompt
 #include <memory>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 // Only include message and manager headers now
+#include "AllocationCounter.h"
+#include "ApplicationStage.h"
+#include "EventLoop.h"
+#include "LoadGenerator.h"
+#include "Logger.h"
+#include "LoopbackTransport.h"
+#include "MessageAuth.h"
+#include "MessageFrame.h"
+#include "MessageSequencer.h"
+#include "Metrics.h"
 #include "NetworkManager.h"
 #include "NodeManager.h"
+#include "NodeSync.h"
+#include "PacketDispatcher.h"
+#include "ReceiveWorkers.h"
+#include "ReliableText.h"
+#include "SharedMemoryTransport.h"
+#include "TdlCodec.h"
 #include "TdlMessages.h"
+#include "TrafficCapture.h"
+#include "TransmissionScheduler.h"
+#include "Transport.h"
 
 // Remove Winsock includes and pragma comment if NetworkManager handles it
 // #include <winsock2.h>
@@ -23,230 +51,927 @@ const char* BROADCAST_ADDRESS_STR = "255.255.255.255"; // Use a const char*
 
 #define SEND_INTERVAL_SECONDS 5
 #define NODE_TIMEOUT_SECONDS (SEND_INTERVAL_SECONDS * 3)
-
-std::atomic<bool> g_shutdown_flag(false); // Keep global shutdown flag for threads
-
-// --- Receiver Thread Function ---
-void receiverThreadFunc(NetworkManager& netMgr, NodeManager& nodeManager)
+#define SEND_TICK_MS 100              // How often the scheduler is asked what is due
+#define COALESCE_MAX_DELAY_MS 20      // Backstop only: each send tick closes its own frames
+#define MAINTENANCE_INTERVAL_MS 1000  // Prune, publish snapshot, print node list
+#define RECEIVE_DRAIN_MAX_BATCHES 8   // Batches per readable event before timers get a turn
+#define RECEIVE_WORKER_QUEUE_SIZE 64  // Packets that may wait per receive worker
+#define APPLICATION_QUEUE_SIZE 256    // Records that may wait for the application stage
+#define LOOPBACK_QUEUE_SIZE 4096      // Datagrams the in-memory transport buffers, like a socket receive buffer
+#define SHARED_RING_SLOTS 8192        // Slots in a newly created shared-memory ring (16 MB)
+#define CHECKPOINT_INTERVAL_MS 10000  // How often the node table is saved with --checkpoint
+
+bool g_useCompactWire = false;            // Send in the TdlCodec compact format (--compact)
+bool g_coalesceMessages = false;          // Pack each loop's messages into one frame (--coalesce)
+size_t g_receiveWorkerCount = 0;          // Receive workers (--rx-workers=N); 0 processes on the reactor thread
+OverflowPolicy g_overflowPolicy = OverflowPolicy::DropNewest; // Full-queue policy for both stages (--drop-oldest)
+unsigned g_metricsIntervalSeconds = 0;    // Export metrics every N seconds (--metrics=N); 0 only on demand
+std::string g_metricsFile;                // Append exports here as JSON lines (--metrics-file=PATH) instead of logging them
+bool g_useLoopback = false;               // Send to and receive from an in-memory transport instead of UDP (--loopback)
+std::string g_sharedRingName;             // Talk to co-located nodes over this shared-memory ring instead of UDP (--shm=NAME)
+LoadProfile g_loadProfile;                // Shape of the generated traffic (--loadgen-rate=N, --loadgen-threads=N)
+bool g_generateLoad = false;              // Simulate a swarm of virtual nodes (--loadgen=NODES)
+std::string g_multicastBase;              // Send type N to group BASE+N instead of broadcasting (--mcast=BASE)
+uint32_t g_subscribedChannels = ~0u;      // Bit per message type: which groups to join (--subscribe=position,heartbeat,text)
+std::string g_recordPath;                 // Append every received datagram to this capture file (--record=PATH)
+std::string g_replayPath;                 // Run a capture through the receive path instead of starting a node (--replay=PATH)
+bool g_replayFast = false;                // Replay as fast as possible rather than at recorded speed (--replay-fast)
+std::string g_checkpointPath;             // Save the node table here periodically and warm start from it (--checkpoint=PATH)
+bool g_syncOnJoin = false;                // Ask the first neighbour heard for its node table (--sync-on-join)
+bool g_reliableText = false;              // Send texts numbered, so receivers can NACK lost ones (--reliable-text)
+std::string g_authKeyHex;                 // Seal every datagram and drop any that fail (--auth-key=32 hex digits)
+uint32_t g_authRateLimit = AuthenticatedTransport::DEFAULT_RATE_LIMIT; // Datagrams per second per sender with --auth-key (--auth-rate=N)
+size_t g_maxNodes = 0;                    // Preallocate for and cap the node table at N nodes (--max-nodes=N); 0 grows freely
+
+// --- Application Handlers ---
+// Run on the application stage's own thread, so console output never holds up the socket.
+
+static void printTextMessage(const ApplicationRecord& record)
 {
-	std::cout << "[Receiver] Thread started." << std::endl;
-	// No socket setup needed here
+	// Get sender IP for logging
+	char senderIp[INET_ADDRSTRLEN];
+	inet_ntop(AF_INET, &record.senderAddress.sin_addr, senderIp, INET_ADDRSTRLEN);
+
+	TDL_LOG_REPORT << "\n--- Text Message Received ---";
+	TDL_LOG_REPORT << "  From Node: " << record.sourceNodeId << " [" << senderIp << "]";
+	TDL_LOG_REPORT << "  Message:   " << std::string_view(record.text, record.textLength);
+	TDL_LOG_REPORT << "-----------------------------";
+}
 
-	while (!g_shutdown_flag)
+static void handleApplicationRecord(const ApplicationRecord& record)
+{
+	switch (record.messageType)
 	{
-		// Use NetworkManager::receive()
-		auto receivedOpt = netMgr.receive();
-
-		if (!receivedOpt)
-			continue;
+		case TEXT_MESSAGE_TYPE:
+			if (!g_generateLoad && !g_replayFast) // Generated or replayed text arrives by the hundred per second; it is only counted
+			{
+				printTextMessage(record);
+			}
+			break;
+		default:
+			break;
+	}
+}
 
-		const ReceivedPacket& packet = receivedOpt.value();
+// --- Sending ---
+// Sends a message in whichever wire format this node was started with, stamped with
+// this node's next sequence number. With coalescing enabled the message is queued
+// on the aggregator instead of being sent as its own datagram.
+template <typename Message>
+static bool sendMessage(Transport& transport, MessageSequencer& sequencer, MessageAggregator* aggregator, Message& message)
+{
+	sequencer.stamp(message.header);
+	const void* bytes = &message;
+	size_t size = sizeof(message);
 
-		if (packet.data.size() < sizeof(MessageHeader))
+	uint8_t encoded[TdlCodec::MAX_ENCODED_SIZE];
+	if (g_useCompactWire)
+	{
+		if constexpr (std::is_same_v<Message, PositionReport>)
 		{
-			std::cerr << "[Receiver] Warning: Received packet too small (" << packet.data.size() << " bytes). Discarding." << std::endl;
-			continue;
+			size = TdlCodec::encode(message, true /* fixed-point */, encoded, sizeof(encoded));
 		}
-
-		// --- Message Parsing ---
-		// 1. Get header pointer (use packet.data.data())
-		const MessageHeader* header = reinterpret_cast<const MessageHeader*>(packet.data.data());
-
-		// Get sender IP for logging
-		char senderIp[INET_ADDRSTRLEN];
-		inet_ntop(AF_INET, &packet.senderAddress.sin_addr, senderIp, INET_ADDRSTRLEN);
-
-		// Ignore self - USE NodeManager's self ID
-		if (header->sourceNodeId == nodeManager.getSelfNodeId())
-		{ // Need to add getSelfNodeId() to NodeManager
-			continue;
+		else
+		{
+			size = TdlCodec::encode(message, encoded, sizeof(encoded));
+		}
+		if (size == 0)
+		{
+			return false;
 		}
+		bytes = encoded;
+	}
 
-		// 2. Update last heard time for ANY valid message from another node
-		nodeManager.updateLastHeardTime(header->sourceNodeId);
+	if (aggregator)
+	{
+		return aggregator->add(bytes, size);
+	}
+	return transport.sendOnChannel(message.header.messageType, bytes, size);
+}
 
-		// 3. Switch based on message type
-		switch (header->messageType)
+// --- Receive Handling ---
+// State for the event loop's readable handler.
+struct ReceiveContext
+{
+	// Reused for every batch; each entry keeps its pool slot between calls.
+	std::vector<ReceivedPacket> batch = std::vector<ReceivedPacket>(Transport::MAX_BATCH_SIZE);
+
+	// Steady-state allocation check: heap allocations made while receiving and
+	// processing packets, once the first packets have warmed everything up. Only
+	// the receive work is measured, not the timers sharing the reactor thread; with
+	// --rx-workers each worker adds what its own handling allocates. Adding a node
+	// allocates its table entries, so work that added one is counted apart.
+	uint64_t messagesProcessed = 0;
+	uint64_t reactorAllocations = 0;
+	std::atomic<uint64_t> workerAllocations{ 0 };
+	std::atomic<uint64_t> nodeJoinAllocations{ 0 };
+
+	// Slow handling (console output) happens here, off the socket stage.
+	// Declared before 'workers' so it (and the dispatcher) outlive them.
+	std::unique_ptr<ApplicationStage> applicationStage;
+	std::unique_ptr<NodeSync> nodeSync; // Always present, so this node answers other nodes' join syncs
+	std::unique_ptr<ReliableTextChannel> reliableText; // Always present, so other nodes' reliable texts get repaired here
+	std::unique_ptr<PacketDispatcher> dispatcher;
+
+	// With --rx-workers, packets are handed off here instead of processed inline.
+	std::unique_ptr<ReceiveWorkerPool> workers;
+
+	// With --record, every datagram is captured before it is dispatched.
+	std::unique_ptr<TrafficRecorder> recorder;
+};
+
+// Readable handler: pulls everything the kernel has queued, a batch at a time,
+// without blocking. Bounded so a flood cannot starve the timers.
+static void drainReceived(ReceiveContext& context, Transport& transport)
+{
+	bool warmedUp = context.messagesProcessed > 0;
+	uint64_t allocationsBefore = getThreadHeapAllocationCount();
+	uint64_t nodesAddedBefore = Metrics::threadCount(MetricCounter::NodesAdded);
+	for (int pass = 0; pass < RECEIVE_DRAIN_MAX_BATCHES; ++pass)
+	{
+		size_t received = transport.receiveBatch(context.batch.data(), context.batch.size(), false /* don't wait */);
+
+		uint64_t bytesReceived = 0;
+		for (size_t i = 0; i < received; ++i)
 		{
-			case POSITION_REPORT_TYPE:
+			bytesReceived += context.batch[i].size;
+			if (context.recorder)
 			{
-				if (packet.data.size() == sizeof(PositionReport))
-				{
-					PositionReport receivedReport;
-					// Copy from packet.data into the struct
-					memcpy(&receivedReport, packet.data.data(), sizeof(PositionReport));
-					nodeManager.updateNodePosition(receivedReport);
-					// std::cout << "[Receiver] Processed PositionReport from Node " << header->sourceNodeId << std::endl;
-				}
-				else
-				{ /* Size mismatch warning */
-				}
-				break;
+				context.recorder->record(context.batch[i]); // A memcpy into the mapped capture file
 			}
-			case HEARTBEAT_TYPE:
+			if (!context.workers)
 			{
-				if (packet.data.size() == sizeof(HeartbeatMessage))
-				{
-					// std::cout << "[Receiver] Processed Heartbeat from Node " << header->sourceNodeId << std::endl;
-				}
-				else
-				{ /* Size mismatch warning */
-				}
-				break;
+				context.dispatcher->processPacket(context.batch[i]);
+				continue;
 			}
-			case TEXT_MESSAGE_TYPE:
+
+			// Route by the sender's shard so each worker owns its own shards.
+			uint32_t sourceNodeId = 0;
+			if (!PacketDispatcher::peekSourceNodeId(context.batch[i].view(), sourceNodeId))
 			{
-				if (packet.data.size() == sizeof(TextMessage))
-				{
-					TextMessage receivedMsg;
-					memcpy(&receivedMsg, packet.data.data(), sizeof(TextMessage));
-					receivedMsg.text[MAX_TEXT_MSG_LENGTH - 1] = '\0'; // Ensure null termination
-
-					std::cout << "\n--- Text Message Received ---" << std::endl;
-					std::cout << "  From Node: " << receivedMsg.header.sourceNodeId << " [" << senderIp << "]" << std::endl;
-					std::cout << "  Message:   " << receivedMsg.text << std::endl;
-					std::cout << "-----------------------------" << std::endl;
-				}
-				else
-				{ /* Size mismatch warning */
-				}
-				break;
+				Metrics::increment(MetricCounter::MalformedPackets);
+			}
+			else if (!context.workers->dispatch(context.batch[i], NodeManager::shardIndexOf(sourceNodeId)))
+			{
+				Metrics::increment(MetricCounter::PacketsDropped);
 			}
-			default:
-				break;
 		}
+		Metrics::increment(MetricCounter::PacketsReceived, received);
+		Metrics::increment(MetricCounter::BytesReceived, bytesReceived);
+		context.messagesProcessed += received;
 
+		if (received < context.batch.size())
+		{
+			break; // Queue is empty
+		}
+	}
+	uint64_t allocations = getThreadHeapAllocationCount() - allocationsBefore;
+	if (Metrics::threadCount(MetricCounter::NodesAdded) != nodesAddedBefore)
+	{
+		context.nodeJoinAllocations.fetch_add(allocations, std::memory_order_relaxed);
+	}
+	else if (warmedUp)
+	{
+		context.reactorAllocations += allocations;
 	}
-
-	std::cout << "[Receiver] Shutdown signal received. Thread finished." << std::endl;
 }
 
-// --- Sender Thread Function ---
-void senderThreadFunc(NetworkManager& netMgr, NodeManager& nodeManager)
+// --- Send Handling ---
+// State for the event loop's send timer.
+struct SenderContext
 {
-	uint32_t myNodeId = nodeManager.getSelfNodeId();
-	std::cout << "[Sender] Thread started (Node ID: " << myNodeId << ")." << std::endl;
-
 	PositionReport myPosReport;
-	myPosReport.header.sourceNodeId = myNodeId;
 	HeartbeatMessage myHeartbeat;
-	myHeartbeat.header.sourceNodeId = myNodeId;
+	MessageSequencer* sequencer = nullptr; // This node's, shared with NodeSync
+	ReliableTextChannel* reliableText = nullptr;
 
-	// Timing logic remains the same
-	auto lastPosSendTime = std::chrono::steady_clock::now();
-	const auto posSendInterval = std::chrono::seconds(SEND_INTERVAL_SECONDS);
+	// Decides when heartbeats and position reports actually need to go out.
+	TransmissionScheduler scheduler;
 	bool sentTestTextMessage = false;
 
-	while (!g_shutdown_flag)
+	// With --coalesce, each tick's messages are queued here and go out together in one frame.
+	// With --mcast a frame can only go to one group, so each message type gets its
+	// own aggregator; otherwise they all share entry 0.
+	std::unique_ptr<MessageAggregator> aggregators[NetworkManager::MAX_CHANNELS];
+
+	MessageAggregator* aggregatorFor(MessageType type)
 	{
-		auto now = std::chrono::steady_clock::now();
+		if (type < NetworkManager::MAX_CHANNELS && aggregators[type])
+		{
+			return aggregators[type].get();
+		}
+		return aggregators[0].get();
+	}
+
+	// For the send tick jitter histogram.
+	std::chrono::steady_clock::time_point lastTick;
+	bool ticked = false;
+};
 
-		// --- Send Position Report ---
-		if (now - lastPosSendTime >= posSendInterval)
+// Send timer: runs every SEND_TICK_MS and sends whatever the scheduler says is due.
+static void sendTick(SenderContext& context, Transport& transport, uint32_t myNodeId, std::chrono::steady_clock::time_point now)
+{
+	// Jitter: how far this tick is from exactly one period after the last one.
+	if (context.ticked)
+	{
+		auto deviation = (now - context.lastTick) - std::chrono::milliseconds(SEND_TICK_MS);
+		Metrics::recordLatency(MetricHistogram::SendTickJitter, deviation.count() < 0 ? -deviation : deviation);
+	}
+	context.lastTick = now;
+	context.ticked = true;
+
+	// --- Send Position Report ---
+	// ... update report fields ...
+	context.myPosReport.latitude = 50.0 + (myNodeId * 0.01) + ((/*time calc*/ 0 % 100) * 0.001);
+	context.myPosReport.longitude = -1.0 + (myNodeId * 0.01) + ((/*time calc*/ 0 % 100) * 0.001);
+	context.myPosReport.altitude = 100.0 + myNodeId;
+
+	// Sent at the base rate while moving, backed off while stationary.
+	if (context.scheduler.shouldSendPosition(now, context.myPosReport))
+	{
+		// Send through sendMessage() so the configured wire format is used
+		if (sendMessage(transport, *context.sequencer, context.aggregatorFor(POSITION_REPORT_TYPE), context.myPosReport))
 		{
-			// ... update report fields ...
-			myPosReport.latitude = 50.0 + (myNodeId * 0.01) + ((/*time calc*/ 0 % 100) * 0.001);
-			myPosReport.longitude = -1.0 + (myNodeId * 0.01) + ((/*time calc*/ 0 % 100) * 0.001);
-			myPosReport.altitude = 100.0 + myNodeId;
+			// TDL_LOG_INFO << "[Sender] Sent PositionReport.";
+			context.scheduler.onPositionSent(now, context.myPosReport);
+		}
+		else
+		{ /* Handle send error if needed */
+		}
+	}
 
-			// Use NetworkManager::sendBroadcast
-			if (netMgr.sendBroadcast(&myPosReport, sizeof(myPosReport)))
+	// --- Send Test Text Message ---
+	if (!context.sentTestTextMessage)
+	{
+		TextMessage testMsg;
+		testMsg.header.sourceNodeId = myNodeId;
+		std::string msgContent = "Hello from Node " + std::to_string(myNodeId) + " via NetMgr!";
+		snprintf(testMsg.text, MAX_TEXT_MSG_LENGTH, "%s", msgContent.c_str()); // Truncates, always terminated
+
+		// A reliable text goes straight out rather than through an aggregator: it is
+		// kept for repair as sent.
+		bool sent = g_reliableText ? context.reliableText->sendText(testMsg, now)
+			: sendMessage(transport, *context.sequencer, context.aggregatorFor(TEXT_MESSAGE_TYPE), testMsg);
+		if (sent)
+		{
+			TDL_LOG_INFO << "[Sender] Sent Test TextMessage.";
+			context.sentTestTextMessage = true;
+			context.scheduler.onMessageSent(now);
+		}
+		else
+		{ /* Handle send error */
+		}
+	}
+
+	// --- Send Heartbeat ---
+	// Checked last: anything sent above already proves we're alive.
+	if (context.scheduler.shouldSendHeartbeat(now))
+	{
+		context.myHeartbeat.lastTextSequence = context.reliableText->getLastTextSequence(); // Lets receivers spot a lost newest text
+		if (sendMessage(transport, *context.sequencer, context.aggregatorFor(HEARTBEAT_TYPE), context.myHeartbeat))
+		{
+			context.scheduler.onHeartbeatSent(now);
+		}
+		else
+		{
+			/* Handle send error */
+		}
+	}
+
+	// --- Close This Tick's Frames ---
+	// Everything above was queued in the last few microseconds, so a deadline
+	// flush would hold it until the next tick; the frame is complete now.
+	for (std::unique_ptr<MessageAggregator>& aggregator : context.aggregators)
+	{
+		if (aggregator)
+		{
+			aggregator->flush();
+		}
+	}
+}
+
+// --- Reactor Thread Function ---
+// One thread does everything: receive, send and node maintenance are all events
+// on the same EventLoop, so nothing polls and nothing sleeps a fixed interval.
+void reactorThreadFunc(EventLoop& eventLoop, Transport& transport, NodeManager& nodeManager)
+{
+	uint32_t myNodeId = nodeManager.getSelfNodeId();
+	TDL_LOG_INFO << "[Reactor] Thread started (Node ID: " << myNodeId << ").";
+	MessageSequencer sequencer; // Everything this node sends counts from here
+
+	ReceiveContext receiveContext;
+	receiveContext.applicationStage = std::make_unique<ApplicationStage>(APPLICATION_QUEUE_SIZE, g_overflowPolicy, handleApplicationRecord);
+	receiveContext.nodeSync = std::make_unique<NodeSync>(transport, nodeManager, sequencer, g_useCompactWire, std::chrono::seconds(NODE_TIMEOUT_SECONDS));
+	receiveContext.reliableText = std::make_unique<ReliableTextChannel>(transport, sequencer, myNodeId, g_useCompactWire);
+	ReliableTextChannel* reliableText = receiveContext.reliableText.get();
+	nodeManager.setExpiryCallback([reliableText](uint32_t nodeId) { reliableText->forgetSource(nodeId); }); // Only this thread prunes
+	receiveContext.dispatcher = std::make_unique<PacketDispatcher>(nodeManager, *receiveContext.applicationStage, receiveContext.nodeSync.get(),
+		receiveContext.reliableText.get());
+	if (g_syncOnJoin)
+	{
+		receiveContext.nodeSync->startJoin();
+	}
+	if (g_receiveWorkerCount > 0)
+	{
+		const PacketDispatcher& dispatcher = *receiveContext.dispatcher;
+		ReceiveContext& context = receiveContext;
+		receiveContext.workers = std::make_unique<ReceiveWorkerPool>(g_receiveWorkerCount, RECEIVE_WORKER_QUEUE_SIZE,
+			[&dispatcher, &context](const ReceivedPacket& packet)
 			{
-				// std::cout << "[Sender] Sent PositionReport." << std::endl;
-				lastPosSendTime = now;
-			}
-			else
-			{ /* Handle send error if needed */
+				thread_local bool warmedUp = false; // Each worker's first packet is its warm-up
+				uint64_t allocationsBefore = getThreadHeapAllocationCount();
+				uint64_t nodesAddedBefore = Metrics::threadCount(MetricCounter::NodesAdded);
+				dispatcher.processPacket(packet);
+				uint64_t allocations = getThreadHeapAllocationCount() - allocationsBefore;
+				if (allocations > 0 && Metrics::threadCount(MetricCounter::NodesAdded) != nodesAddedBefore)
+				{
+					context.nodeJoinAllocations.fetch_add(allocations, std::memory_order_relaxed);
+				}
+				else if (allocations > 0 && warmedUp)
+				{
+					context.workerAllocations.fetch_add(allocations, std::memory_order_relaxed);
+				}
+				warmedUp = true;
+			}, g_overflowPolicy);
+	}
+	if (!g_recordPath.empty())
+	{
+		receiveContext.recorder = std::make_unique<TrafficRecorder>(g_recordPath);
+	}
+
+	SenderContext senderContext;
+	senderContext.myPosReport.header.sourceNodeId = myNodeId;
+	senderContext.myHeartbeat.header.sourceNodeId = myNodeId;
+	senderContext.sequencer = &sequencer;
+	senderContext.reliableText = receiveContext.reliableText.get();
+	TransmissionPolicy policy;
+	policy.positionInterval = std::chrono::seconds(SEND_INTERVAL_SECONDS);
+	policy.maxPositionInterval = policy.positionInterval * 4;
+	senderContext.scheduler.setPolicy(policy);
+	if (g_coalesceMessages)
+	{
+		if (g_multicastBase.empty())
+		{
+			senderContext.aggregators[0] = std::make_unique<MessageAggregator>(transport, std::chrono::milliseconds(COALESCE_MAX_DELAY_MS));
+		}
+		else
+		{
+			for (MessageType type : { POSITION_REPORT_TYPE, HEARTBEAT_TYPE, TEXT_MESSAGE_TYPE })
+			{
+				senderContext.aggregators[type] = std::make_unique<MessageAggregator>(transport, std::chrono::milliseconds(COALESCE_MAX_DELAY_MS),
+					MessageAggregator::DEFAULT_MAX_FRAME_SIZE, type);
 			}
 		}
+	}
 
-		// --- Send Heartbeat ---
-		// ... check timer ...
+	// --- Register Events ---
+	eventLoop.setReadableHandler([&]()
+		{
+			drainReceived(receiveContext, transport);
+		});
+	eventLoop.addTimer(std::chrono::milliseconds(SEND_TICK_MS), [&](std::chrono::steady_clock::time_point now)
 		{
-			if (netMgr.sendBroadcast(&myHeartbeat, sizeof(myHeartbeat)))
+			sendTick(senderContext, transport, myNodeId, now);
+			receiveContext.nodeSync->tick(now); // Join requests and answer chunks, a bounded number per tick
+			receiveContext.reliableText->tick(now); // NACKs, repairs and tail heartbeats
+		});
+	uint64_t lastPrintedEpoch = 0; // Console's position in the change feed
+	eventLoop.addTimer(std::chrono::milliseconds(MAINTENANCE_INTERVAL_MS), [&](std::chrono::steady_clock::time_point)
+		{
+			// --- Perform Periodic Tasks (Pruning, Publishing, Printing Changes) ---
+			nodeManager.pruneTimeouts(std::chrono::seconds(NODE_TIMEOUT_SECONDS));
+			nodeManager.publishSnapshot(); // Readers such as printNodeList() see the new picture from here on
+			nodeManager.publishChanges();  // Always, so the dirty sets never outgrow one interval
+			if (!g_generateLoad)
 			{
-				// lastHtbSendTime = now;
+				nodeManager.printChanges(lastPrintedEpoch);
 			}
 			else
 			{
-				/* Handle send error */
+				// Thousands of virtual nodes: a count is all the console can usefully show.
+				TDL_LOG_REPORT << "[Load] " << nodeManager.getSnapshot()->nodes.size() << " nodes known.";
 			}
-		}
+		});
+	if (!g_checkpointPath.empty())
+	{
+		eventLoop.addTimer(std::chrono::milliseconds(CHECKPOINT_INTERVAL_MS), [&](std::chrono::steady_clock::time_point)
+			{
+				// A few dozen bytes per node, written sequentially: cheap enough for the reactor.
+				nodeManager.saveCheckpoint(g_checkpointPath);
+			});
+	}
+	if (g_metricsIntervalSeconds > 0)
+	{
+		eventLoop.addTimer(std::chrono::seconds(g_metricsIntervalSeconds), [](std::chrono::steady_clock::time_point)
+			{
+				// --- Periodic Metrics Export ---
+				if (g_metricsFile.empty())
+				{
+					Metrics::dump();
+				}
+				else if (!Metrics::exportJsonLine(g_metricsFile))
+				{
+					TDL_LOG_ERROR << "[Metrics] Could not write to " << g_metricsFile;
+				}
+			});
+	}
+
+	eventLoop.run();
+	nodeManager.setExpiryCallback(nullptr); // The channel goes with this thread
 
-		// --- Send Test Text Message ---
-		if (!sentTestTextMessage)
+	// --- Shutdown Reporting ---
+	if (receiveContext.workers)
+	{
+		receiveContext.workers->stop(); // Finish what is queued before reading the counters
+	}
+	uint64_t workerAllocations = receiveContext.workerAllocations.load(std::memory_order_relaxed);
+	TDL_LOG_REPORT << "[Receiver] Processed " << receiveContext.messagesProcessed << " packets; "
+		<< (receiveContext.reactorAllocations + workerAllocations) << " heap allocations on the receive path after warm-up ("
+		<< receiveContext.reactorAllocations << " reactor, " << workerAllocations << " workers) plus "
+		<< receiveContext.nodeJoinAllocations.load(std::memory_order_relaxed) << " adding nodes, "
+		<< transport.getPacketPool().getExhaustedCount() << " packet pool exhaustions.";
+	if (receiveContext.workers)
+	{
+		for (size_t i = 0; i < receiveContext.workers->getWorkerCount(); ++i)
 		{
-			TextMessage testMsg;
-			testMsg.header.sourceNodeId = myNodeId;
-			std::string msgContent = "Hello from Node " + std::to_string(myNodeId) + " via NetMgr!";
-			strncpy_s(testMsg.text, MAX_TEXT_MSG_LENGTH, msgContent.c_str(), _TRUNCATE);
+			ReceiveWorkerCounters workerCounters = receiveContext.workers->getWorkerCounters(i);
+			TDL_LOG_REPORT << "[RxWorkers] Worker " << i << ": " << workerCounters.packetsProcessed << " processed, "
+				<< workerCounters.packetsDropped << " dropped, queue high-water " << workerCounters.queueHighWater;
+		}
+	}
+	if (receiveContext.recorder)
+	{
+		receiveContext.recorder->close();
+		TDL_LOG_REPORT << "[Capture] Recorded " << receiveContext.recorder->getRecordedCount() << " datagrams ("
+			<< receiveContext.recorder->getRecordedBytes() << " bytes) to '" << g_recordPath << "'.";
+	}
+	NodeSyncCounters syncCounters = receiveContext.nodeSync->getCounters();
+	if (syncCounters.requestsSent > 0 || syncCounters.requestsAnswered > 0)
+	{
+		TDL_LOG_REPORT << "[Sync] Requests sent/answered/rate-limited: " << syncCounters.requestsSent << "/" << syncCounters.requestsAnswered
+			<< "/" << syncCounters.requestsRateLimited << ", chunks sent/received: " << syncCounters.chunksSent << "/" << syncCounters.chunksReceived
+			<< ", nodes learned: " << syncCounters.nodesMerged;
+	}
+	ReliableTextCounters textCounters = receiveContext.reliableText->getCounters();
+	if (textCounters.textsSent > 0 || textCounters.nacksSent > 0 || textCounters.nacksReceived > 0)
+	{
+		TDL_LOG_REPORT << "[ReliableText] Texts sent: " << textCounters.textsSent << ", NACKs received/sent: " << textCounters.nacksReceived
+			<< "/" << textCounters.nacksSent << ", retransmits: " << textCounters.retransmits << " (" << textCounters.unrepairable
+			<< " unrepairable), repaired: " << textCounters.textsRepaired << ", abandoned: " << textCounters.textsAbandoned
+			<< ", duplicates dropped: " << textCounters.duplicatesDropped << ", untracked: " << textCounters.textsUntracked;
+	}
+	MessageRingCounters applicationCounters = receiveContext.applicationStage->getCounters();
+	TDL_LOG_REPORT << "[AppStage] Records queued/handled: " << applicationCounters.pushed << "/" << applicationCounters.popped
+		<< ", dropped newest/oldest: " << applicationCounters.droppedNewest << "/" << applicationCounters.droppedOldest;
 
-			if (netMgr.sendBroadcast(&testMsg, sizeof(testMsg)))
+	TransmissionCounters counters = senderContext.scheduler.getCounters();
+	TDL_LOG_REPORT << "[Sender] Heartbeats sent/suppressed: " << counters.heartbeatsSent << "/" << counters.heartbeatsSuppressed
+		<< ", positions sent/suppressed: " << counters.positionsSent << "/" << counters.positionsSuppressed
+		<< ", other messages: " << counters.otherMessagesSent;
+
+	if (g_coalesceMessages)
+	{
+		uint64_t coalescedMessages = 0;
+		uint64_t coalescedFrames = 0;
+		for (std::unique_ptr<MessageAggregator>& aggregator : senderContext.aggregators)
+		{
+			if (aggregator)
 			{
-				std::cout << "[Sender] Sent Test TextMessage." << std::endl;
-				sentTestTextMessage = true;
-			}
-			else
-			{ /* Handle send error */
+				aggregator->flush();
+				coalescedMessages += aggregator->getMessagesSent();
+				coalescedFrames += aggregator->getFramesSent();
 			}
 		}
+		TDL_LOG_REPORT << "[Sender] Coalesced " << coalescedMessages << " messages into " << coalescedFrames << " frames.";
+	}
 
-		// --- Perform Periodic Tasks (Pruning, Printing List) ---
-		// ... check timers ...
-		nodeManager.pruneTimeouts(std::chrono::seconds(NODE_TIMEOUT_SECONDS));
-		nodeManager.printNodeList();
-		// ... update lastPruneTime, lastPrintTime ...
+	TDL_LOG_INFO << "[Reactor] Shutdown signal received. Thread finished.";
+}
 
+// --- Multicast Setup ---
+// --mcast=BASE gives message type N the group BASE+N (239.255.30.0 puts positions
+// on 239.255.30.1, heartbeats on .2, text on .3, sync on .4 and .5, text NACKs on
+// .6), then joins only the subscribed ones.
+static uint32_t parseSubscriptions(const std::string& list)
+{
+	uint32_t channels = (1u << SYNC_REQUEST_TYPE) | (1u << SYNC_RESPONSE_TYPE) | (1u << TEXT_NACK_TYPE); // Control traffic: always joined
+	size_t start = 0;
+	while (start <= list.size())
+	{
+		size_t end = list.find(',', start);
+		std::string name = list.substr(start, end == std::string::npos ? std::string::npos : end - start);
+		if (name == "position")
+		{
+			channels |= 1u << POSITION_REPORT_TYPE;
+		}
+		else if (name == "heartbeat")
+		{
+			channels |= 1u << HEARTBEAT_TYPE;
+		}
+		else if (name == "text")
+		{
+			channels |= 1u << TEXT_MESSAGE_TYPE;
+		}
+		else if (!name.empty())
+		{
+			TDL_LOG_WARNING << "[Main] Unknown channel '" << name << "' in --subscribe (expected position, heartbeat, text).";
+		}
+		if (end == std::string::npos)
+		{
+			break;
+		}
+		start = end + 1;
+	}
+	return channels;
+}
 
-		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+static bool configureMulticast(NetworkManager& netMgr)
+{
+	in_addr base = {};
+	if (inet_pton(AF_INET, g_multicastBase.c_str(), &base) != 1)
+	{
+		TDL_LOG_ERROR << "[Main] Bad --mcast base address: " << g_multicastBase;
+		return false;
 	}
+	for (MessageType type : { POSITION_REPORT_TYPE, HEARTBEAT_TYPE, TEXT_MESSAGE_TYPE, SYNC_REQUEST_TYPE, SYNC_RESPONSE_TYPE, TEXT_NACK_TYPE })
+	{
+		in_addr group = {};
+		group.s_addr = htonl(ntohl(base.s_addr) + type);
+		char groupText[INET_ADDRSTRLEN];
+		inet_ntop(AF_INET, &group, groupText, INET_ADDRSTRLEN);
+		if (!netMgr.setChannelGroup(type, groupText))
+		{
+			return false;
+		}
+		if ((g_subscribedChannels & (1u << type)) != 0 && !netMgr.joinChannel(type))
+		{
+			return false;
+		}
+	}
+	return true;
+}
 
-	std::cout << "[Sender] Shutdown signal received. Thread finished." << std::endl;
-	// No socket cleanup needed here
+// --- Command Line ---
+static void printUsage(const char* program)
+{
+	static const char* const OPTIONS[] = {
+		"  --compact  --coalesce  --drop-oldest  --loopback  --sync-on-join  --reliable-text  --replay-fast",
+		"  --metrics=SECONDS  --metrics-file=PATH  --max-nodes=N  --rx-workers=N",
+		"  --shm=NAME  --mcast=BASE_ADDRESS  --subscribe=position,heartbeat,text",
+		"  --loadgen=NODES  --loadgen-rate=MESSAGES_PER_SECOND  --loadgen-threads=N",
+		"  --auth-key=32_HEX_DIGITS  --auth-rate=DATAGRAMS_PER_SECOND",
+		"  --checkpoint=PATH  --record=PATH  --replay=PATH",
+	};
+	TDL_LOG_REPORT << "Usage: " << program << " [NODE_ID] [options]";
+	for (const char* line : OPTIONS)
+	{
+		TDL_LOG_REPORT << line;
+	}
+}
+
+// Whole-string parses: no sign on unsigned values, no trailing junk, nothing out
+// of the type's range or below 'minimum'. std::stoul would throw on most of that
+// (and quietly accept "-1" or "12abc").
+template <typename Unsigned>
+static bool parseNumber(std::string_view text, Unsigned& value, Unsigned minimum = 0)
+{
+	Unsigned parsed = 0;
+	auto result = std::from_chars(text.data(), text.data() + text.size(), parsed);
+	if (text.empty() || result.ec != std::errc() || result.ptr != text.data() + text.size() || parsed < minimum)
+	{
+		return false;
+	}
+	value = parsed;
+	return true;
+}
+
+static bool parseNumber(std::string_view text, double& value, double minimum)
+{
+	std::string copy(text); // strtod wants a terminated string
+	char* end = nullptr;
+	double parsed = std::strtod(copy.c_str(), &end);
+	if (copy.empty() || std::isspace(static_cast<unsigned char>(copy[0])) || end != copy.c_str() + copy.size()
+		|| !std::isfinite(parsed) || parsed < minimum)
+	{
+		return false;
+	}
+	value = parsed;
+	return true;
+}
+
+// For an option of the form --name=VALUE whose value didn't parse.
+static int badOption(const char* program, const std::string& arg, const char* expected)
+{
+	TDL_LOG_ERROR << "[Main] Bad value in '" << arg << "': expected " << expected << ".";
+	printUsage(program);
+	return 1;
+}
+
+// --- Capture Replay ---
+// --replay=PATH feeds a capture made with --record through the receive path instead
+// of starting a node: at recorded speed, or flat out with --replay-fast, which
+// makes it a throughput benchmark on real traffic.
+static int runReplay(uint32_t myNodeId)
+{
+	TrafficReplayer replayer(g_replayPath);
+	if (!replayer.isOpen())
+	{
+		return 1;
+	}
+
+	NodeManager nodeManager(myNodeId, g_maxNodes);
+	ApplicationStage applicationStage(APPLICATION_QUEUE_SIZE, g_overflowPolicy, handleApplicationRecord);
+	PacketDispatcher dispatcher(nodeManager, applicationStage);
+
+	TDL_LOG_INFO << "[Replay] Replaying '" << g_replayPath << "' " << (g_replayFast ? "as fast as possible..." : "at recorded speed...");
+	ReplayStats stats = replayer.replay(dispatcher, !g_replayFast);
+	nodeManager.publishSnapshot();
+
+	TDL_LOG_REPORT << "[Replay] " << stats.datagrams << " datagrams (" << stats.bytes << " bytes) in " << stats.seconds
+		<< " s, recorded over " << stats.recordedSeconds << " s: " << (stats.seconds > 0.0 ? stats.datagrams / stats.seconds : 0.0)
+		<< " datagrams/s; " << nodeManager.getSnapshot()->nodes.size() << " nodes known.";
+	Metrics::dump();
+	return 0;
 }
 
 // --- Main Function ---
 int main(int argc, char* argv[])
 {
-	uint32_t myNodeId = (argc > 1) ? std::stoul(argv[1]) : 1;
-	std::cout << "[Main] Starting Simple TDL Node (ID: " << myNodeId << ") using NetworkManager." << std::endl;
+	uint32_t myNodeId = 1;
+	int firstOption = 1;
+	if (argc > 1 && argv[1][0] != '-')
+	{
+		firstOption = 2;
+		if (!parseNumber(argv[1], myNodeId))
+		{
+			TDL_LOG_ERROR << "[Main] Bad node ID '" << argv[1] << "': expected a number from 0 to 4294967295.";
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+	for (int i = firstOption; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		size_t equals = arg.find('=');
+		std::string_view value = equals == std::string::npos ? std::string_view() : std::string_view(arg).substr(equals + 1); // of --name=VALUE
+		if (arg == "--help" || arg == "-h")
+		{
+			printUsage(argv[0]);
+			return 0;
+		}
+		if (arg == "--compact")
+		{
+			g_useCompactWire = true; // Receivers accept both formats, so this can be mixed per node
+		}
+		else if (arg == "--coalesce")
+		{
+			g_coalesceMessages = true; // Receivers accept frames and single messages alike
+		}
+		else if (arg == "--drop-oldest")
+		{
+			g_overflowPolicy = OverflowPolicy::DropOldest; // Favour fresh data over queued data when a stage falls behind
+		}
+		else if (arg.rfind("--metrics=", 0) == 0)
+		{
+			if (!parseNumber(value, g_metricsIntervalSeconds))
+			{
+				return badOption(argv[0], arg, "a whole number of seconds");
+			}
+		}
+		else if (arg.rfind("--metrics-file=", 0) == 0)
+		{
+			g_metricsFile = arg.substr(strlen("--metrics-file="));
+		}
+		else if (arg == "--loopback")
+		{
+			g_useLoopback = true; // Only this process hears what it sends; pairs with --loadgen
+		}
+		else if (arg.rfind("--shm=", 0) == 0)
+		{
+			g_sharedRingName = arg.substr(strlen("--shm=")); // Every process started with the same NAME shares one ring
+		}
+		else if (arg.rfind("--mcast=", 0) == 0)
+		{
+			g_multicastBase = arg.substr(strlen("--mcast="));
+		}
+		else if (arg.rfind("--subscribe=", 0) == 0)
+		{
+			g_subscribedChannels = parseSubscriptions(arg.substr(strlen("--subscribe=")));
+		}
+		else if (arg.rfind("--loadgen=", 0) == 0)
+		{
+			g_generateLoad = true;
+			if (!parseNumber(value, g_loadProfile.virtualNodes, size_t(1)))
+			{
+				return badOption(argv[0], arg, "a node count of at least 1");
+			}
+		}
+		else if (arg.rfind("--loadgen-rate=", 0) == 0)
+		{
+			if (!parseNumber(value, g_loadProfile.messagesPerSecond, 1e-3))
+			{
+				return badOption(argv[0], arg, "a positive number of messages per second");
+			}
+		}
+		else if (arg.rfind("--loadgen-threads=", 0) == 0)
+		{
+			if (!parseNumber(value, g_loadProfile.threads, size_t(1)))
+			{
+				return badOption(argv[0], arg, "a thread count of at least 1");
+			}
+		}
+		else if (arg.rfind("--checkpoint=", 0) == 0)
+		{
+			g_checkpointPath = arg.substr(strlen("--checkpoint="));
+		}
+		else if (arg == "--sync-on-join")
+		{
+			g_syncOnJoin = true;
+		}
+		else if (arg == "--reliable-text")
+		{
+			g_reliableText = true;
+		}
+		else if (arg.rfind("--auth-key=", 0) == 0)
+		{
+			g_authKeyHex = arg.substr(strlen("--auth-key="));
+		}
+		else if (arg.rfind("--auth-rate=", 0) == 0)
+		{
+			if (!parseNumber(value, g_authRateLimit, 1u))
+			{
+				return badOption(argv[0], arg, "at least 1 datagram per second");
+			}
+		}
+		else if (arg.rfind("--max-nodes=", 0) == 0)
+		{
+			if (!parseNumber(value, g_maxNodes))
+			{
+				return badOption(argv[0], arg, "a node count (0 for no limit)");
+			}
+		}
+		else if (arg.rfind("--record=", 0) == 0)
+		{
+			g_recordPath = arg.substr(strlen("--record="));
+		}
+		else if (arg.rfind("--replay=", 0) == 0)
+		{
+			g_replayPath = arg.substr(strlen("--replay="));
+		}
+		else if (arg == "--replay-fast")
+		{
+			g_replayFast = true;
+		}
+		else if (arg.rfind("--rx-workers=", 0) == 0)
+		{
+			// More workers than shards would leave the extras idle.
+			if (!parseNumber(value, g_receiveWorkerCount))
+			{
+				return badOption(argv[0], arg, "a worker count (0 to process on the reactor thread)");
+			}
+			if (g_receiveWorkerCount > NodeManager::NUM_SHARDS)
+			{
+				g_receiveWorkerCount = NodeManager::NUM_SHARDS;
+			}
+		}
+	}
+	g_loadProfile.compactWire = g_useCompactWire;
+	if (!g_replayPath.empty())
+	{
+		return runReplay(myNodeId); // No transport, no reactor: just the receive path
+	}
+	TDL_LOG_INFO << "[Main] Starting Simple TDL Node (ID: " << myNodeId << ") using "
+		<< (g_useLoopback ? "LoopbackTransport" : !g_sharedRingName.empty() ? "SharedMemoryTransport" : "NetworkManager") << (g_useCompactWire ? " (compact wire format)." : ".");
 
 	// --- Create Managers ---
-	std::unique_ptr<NetworkManager> networkManager = std::make_unique<NetworkManager>(TDL_PORT, BROADCAST_ADDRESS_STR);
+	// Give every transport's pool room for full worker queues, so a backlog shows up
+	// as worker drops (and DropOldest applies) instead of as a pool gone dry.
+	size_t heldPackets = g_receiveWorkerCount > 0 ? ReceiveWorkerPool::maxHeldPackets(g_receiveWorkerCount, RECEIVE_WORKER_QUEUE_SIZE) : 0;
+	std::unique_ptr<Transport> transport;
+	LoopbackTransport* loopback = nullptr; // Same object as 'transport' with --loopback, for its drop counters
+	SharedMemoryTransport* sharedRing = nullptr; // ...and with --shm
+	if (g_useLoopback)
+	{
+		auto loopbackTransport = std::make_unique<LoopbackTransport>(LOOPBACK_QUEUE_SIZE, static_cast<uint16_t>(TDL_PORT), 1000, heldPackets);
+		loopback = loopbackTransport.get();
+		transport = std::move(loopbackTransport);
+	}
+	else if (!g_sharedRingName.empty())
+	{
+		auto sharedTransport = std::make_unique<SharedMemoryTransport>(g_sharedRingName, SHARED_RING_SLOTS, static_cast<uint16_t>(TDL_PORT), 1000,
+			heldPackets);
+		sharedRing = sharedTransport.get();
+		transport = std::move(sharedTransport);
+	}
+	else
+	{
+		auto networkManager = std::make_unique<NetworkManager>(TDL_PORT, BROADCAST_ADDRESS_STR, 1000, heldPackets);
+		if (!g_multicastBase.empty() && networkManager->isInitialized() && !configureMulticast(*networkManager))
+		{
+			TDL_LOG_ERROR << "[Main] Failed to set up multicast channels. Exiting.";
+			return 1;
+		}
+		transport = std::move(networkManager);
+	}
+	if (!g_authKeyHex.empty())
+	{
+		// Wraps whichever transport was chosen, so everything (the load generator
+		// included) sends sealed and nothing unsealed gets past receiveBatch().
+		MessageKey key;
+		if (!MessageAuthenticator::parseKey(g_authKeyHex, key))
+		{
+			TDL_LOG_ERROR << "[Main] --auth-key needs 32 hex digits. Exiting.";
+			return 1;
+		}
+		transport = std::make_unique<AuthenticatedTransport>(std::move(transport), key, myNodeId, g_authRateLimit);
+		TDL_LOG_INFO << "[Main] Authenticated messages on; " << g_authRateLimit << " datagrams/s per sender.";
+	}
 
-	if (!networkManager || !networkManager->isInitialized())
+	if (!transport || !transport->isInitialized())
 	{
-		std::cerr << "[Main] Failed to initialize Network Manager. Exiting." << std::endl;
+		TDL_LOG_ERROR << "[Main] Failed to initialize the transport. Exiting.";
 		return 1; // Exit if network setup failed
 	}
 
-	NodeManager nodeManager(myNodeId);
+	NodeManager nodeManager(myNodeId, g_maxNodes);
 	// Add getSelfNodeId() to NodeManager if receiver needs it
+	if (!g_checkpointPath.empty())
+	{
+		// Warm start: the last saved picture, marked stale until each node is heard again.
+		nodeManager.loadCheckpoint(g_checkpointPath, std::chrono::seconds(NODE_TIMEOUT_SECONDS));
+		nodeManager.publishSnapshot();
+	}
 
-	// --- Create and Launch Threads ---
-	std::cout << "[Main] Launching Sender and Receiver threads..." << std::endl;
+	// --- Create Event Loop and Launch Reactor Thread ---
+	EventLoop eventLoop(*transport);
+	TDL_LOG_INFO << "[Main] Launching reactor thread...";
 	// Pass references using std::ref() or raw pointer from unique_ptr.get()
-	std::thread rxThread(receiverThreadFunc, std::ref(*networkManager), std::ref(nodeManager));
-	std::thread txThread(senderThreadFunc, std::ref(*networkManager), std::ref(nodeManager));
+	std::thread reactorThread(reactorThreadFunc, std::ref(eventLoop), std::ref(*transport), std::ref(nodeManager));
+
+	// --- Start Load Generator ---
+	// Shares the transport with the reactor: over UDP every node on the LAN
+	// (this one included) hears the swarm; over loopback only this process does.
+	std::unique_ptr<LoadGenerator> loadGenerator;
+	auto loadStart = std::chrono::steady_clock::now();
+	if (g_generateLoad)
+	{
+		loadGenerator = std::make_unique<LoadGenerator>(*transport, g_loadProfile);
+		TDL_LOG_INFO << "[Load] Simulating " << g_loadProfile.virtualNodes << " nodes at "
+			<< g_loadProfile.messagesPerSecond << " messages/s on " << loadGenerator->getProfile().threads << " thread(s).";
+		loadGenerator->start();
+	}
 
 	// --- Wait for user input to shut down ---
-	std::cout << "[Main] Threads running. Press Enter to stop..." << std::endl;
-	std::cin.get();
+	TDL_LOG_INFO << "[Main] Reactor running. Type 'm' + Enter to dump metrics, or just Enter to stop...";
+	Logger::instance().flush(); // Make sure the prompt is on screen before we block
+	std::string command;
+	while (std::getline(std::cin, command) && command == "m")
+	{
+		Metrics::dump(); // On demand; merges every thread's counters without stopping them
+	}
 
-	// --- Signal threads to shut down ---
-	std::cout << "[Main] Shutdown signal sent. Waiting for threads to join..." << std::endl;
-	g_shutdown_flag = true;
+	// --- Load Test Report ---
+	// Offered vs. received shows where the pipeline saturates; the drop counters show where it sheds load.
+	if (loadGenerator)
+	{
+		loadGenerator->stop();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loadStart).count();
+		LoadGeneratorCounters loadCounters = loadGenerator->getCounters();
+		uint64_t sent = loadCounters.positionsSent + loadCounters.heartbeatsSent + loadCounters.textsSent;
+		TDL_LOG_REPORT << "[Load] Sent " << sent << " messages in " << seconds << " s (" << (seconds > 0.0 ? sent / seconds : 0.0)
+			<< "/s): positions " << loadCounters.positionsSent << ", heartbeats " << loadCounters.heartbeatsSent
+			<< ", texts " << loadCounters.textsSent << "; " << loadCounters.sendFailures << " send failures, "
+			<< loadCounters.behindSchedule << " skipped behind schedule.";
+		if (loopback)
+		{
+			TDL_LOG_REPORT << "[Load] Loopback delivered " << loopback->getDeliveredCount() << ", dropped "
+				<< loopback->getDroppedCount() << ", queue high-water " << loopback->getQueueHighWater() << "/" << LOOPBACK_QUEUE_SIZE;
+		}
+	}
+
+	// --- Signal reactor to shut down ---
+	TDL_LOG_INFO << "[Main] Shutdown signal sent. Waiting for reactor to join...";
+	eventLoop.stop(); // Wakes the reactor immediately, wherever it is waiting
 
-	// --- Wait for threads to complete ---
-	rxThread.join();
-	txThread.join();
-	std::cout << "[Main] Threads joined." << std::endl;
+	// --- Wait for reactor to complete ---
+	reactorThread.join();
+	TDL_LOG_INFO << "[Main] Reactor joined.";
+	if (!g_checkpointPath.empty())
+	{
+		nodeManager.saveCheckpoint(g_checkpointPath); // So a quick restart picks up exactly where this run left off
+	}
+	if (sharedRing)
+	{
+		TDL_LOG_REPORT << "[ShmTransport] Received " << sharedRing->getReceivedCount() << " datagrams, lost "
+			<< sharedRing->getLostCount() << " to writers lapping this reader.";
+	}
+	Metrics::dump();
 
 	// --- Cleanup ---
-	// NetworkManager destructor called automatically when unique_ptr goes out of scope.
+	// Transport (NetworkManager or LoopbackTransport) destructor called automatically when unique_ptr goes out of scope.
 	// NodeManager cleaned up as it goes out of scope.
 	// No need for explicit WSACleanup here.
 
-	std::cout << "[Main] Exiting." << std::endl;
+	TDL_LOG_INFO << "[Main] Exiting.";
 	return 0;
 }
\ No newline at end of file